@@ -0,0 +1,20 @@
+#include <benchmark/benchmark.h>
+#include <drogon/utils/Utilities.h>
+#include <string>
+
+using namespace drogon;
+
+static void BM_BrotliCompress(benchmark::State &state)
+{
+    std::string text;
+    while (text.length() < static_cast<size_t>(state.range(0)))
+        text.append("drogon is a C++14/17 based HTTP application framework. ");
+    text.resize(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            utils::brotliCompress(text.data(), text.length()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_BrotliCompress)->Arg(1024)->Arg(65536);
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <drogon/CacheMap.h>
+#include <trantor/net/EventLoop.h>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+std::vector<std::string> makeKeys(size_t number)
+{
+    std::vector<std::string> keys;
+    keys.reserve(number);
+    for (size_t i = 0; i < number; ++i)
+        keys.push_back("session-" + std::to_string(i));
+    return keys;
+}
+}  // namespace
+
+static void BM_CacheMapFind(benchmark::State &state)
+{
+    trantor::EventLoop loop;
+    CacheMap<std::string, std::string> cache(&loop, 1.0, 4, 200);
+    auto keys = makeKeys(state.range(0));
+    for (auto &key : keys)
+        cache.insert(key, std::string("value"), 0);
+    size_t i = 0;
+    std::string value;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            cache.findAndFetch(keys[i++ % keys.size()], value));
+    }
+}
+BENCHMARK(BM_CacheMapFind)->Arg(1000)->Arg(100000);
+
+// Entries with timeouts are also put in the timing wheels.
+static void BM_CacheMapInsertWithTimeout(benchmark::State &state)
+{
+    trantor::EventLoop loop;
+    CacheMap<std::string, std::string> cache(&loop, 1.0, 4, 200);
+    auto keys = makeKeys(10000);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        cache.insert(keys[i++ % keys.size()], std::string("value"), 600);
+    }
+}
+BENCHMARK(BM_CacheMapInsertWithTimeout);
+
+static void BM_CacheMapFindWithTimeout(benchmark::State &state)
+{
+    trantor::EventLoop loop;
+    CacheMap<std::string, std::string> cache(&loop, 1.0, 4, 200);
+    auto keys = makeKeys(10000);
+    for (auto &key : keys)
+        cache.insert(key, std::string("value"), 600);
+    size_t i = 0;
+    std::string value;
+    for (auto _ : state)
+    {
+        // Every access extends the life of the entry.
+        benchmark::DoNotOptimize(
+            cache.findAndFetch(keys[i++ % keys.size()], value));
+    }
+}
+BENCHMARK(BM_CacheMapFindWithTimeout);
@@ -0,0 +1,112 @@
+#include "../lib/src/HttpControllersRouter.h"
+#include "../lib/src/HttpRequestImpl.h"
+#include "../lib/src/StaticFileRouter.h"
+#include <benchmark/benchmark.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoop.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+using Advice = std::function<
+    void(const HttpRequestPtr &, AdviceCallback &&, AdviceChainCallback &&)>;
+using Observer = std::function<void(const HttpRequestPtr &)>;
+using PostHandlingAdvice =
+    std::function<void(const HttpRequestPtr &, const HttpResponsePtr &)>;
+
+// Routes like those of a REST API, half of them with path parameters that
+// are matched by regular expressions.
+struct RouterContext
+{
+    RouterContext()
+        : router(fileRouter,
+                 postRoutingAdvices,
+                 postRoutingObservers,
+                 preHandlingAdvices,
+                 preHandlingObservers,
+                 postHandlingAdvices)
+    {
+        // IOThreadStorage uses the index of the loop.
+        loop.setIndex(0);
+        response = HttpResponse::newHttpResponse();
+        auto resp = response;
+        auto handler = [resp](const HttpRequestPtr &,
+                              std::function<void(const HttpResponsePtr &)>
+                                  &&callback) { callback(resp); };
+        auto paramHandler =
+            [resp](const HttpRequestPtr &,
+                   std::function<void(const HttpResponsePtr &)> &&callback,
+                   int) { callback(resp); };
+        for (int i = 0; i < 32; ++i)
+        {
+            auto prefix = "/api/v1/resource" + std::to_string(i);
+            auto binder =
+                std::make_shared<internal::HttpBinder<decltype(handler)>>(
+                    decltype(handler)(handler));
+            binder->createHandlerInstance();
+            router.addHttpPath(prefix, binder, {Get}, {});
+            auto paramBinder =
+                std::make_shared<internal::HttpBinder<decltype(paramHandler)>>(
+                    decltype(paramHandler)(paramHandler));
+            paramBinder->createHandlerInstance();
+            router.addHttpPath(prefix + "/{id}", paramBinder, {Get}, {});
+        }
+        router.init({&loop});
+    }
+    trantor::EventLoop loop;
+    StaticFileRouter fileRouter;
+    std::vector<Advice> postRoutingAdvices;
+    std::vector<Observer> postRoutingObservers;
+    std::vector<Advice> preHandlingAdvices;
+    std::vector<Observer> preHandlingObservers;
+    std::vector<PostHandlingAdvice> postHandlingAdvices;
+    HttpControllersRouter router;
+    HttpResponsePtr response;
+};
+
+RouterContext &context()
+{
+    static thread_local RouterContext ctx;
+    return ctx;
+}
+}  // namespace
+
+static void routeRequests(benchmark::State &state, const std::string &path)
+{
+    auto &ctx = context();
+    benchmark::IterationCount handled = 0;
+    for (auto _ : state)
+    {
+        auto req = std::make_shared<HttpRequestImpl>(&ctx.loop);
+        req->setMethod(Get);
+        req->setPath(path);
+        ctx.router.route(req, [&handled](const HttpResponsePtr &resp) {
+            benchmark::DoNotOptimize(resp);
+            ++handled;
+        });
+    }
+    if (handled != state.iterations())
+        state.SkipWithError("Some requests are not handled");
+}
+
+static void BM_RouteStaticPath(benchmark::State &state)
+{
+    routeRequests(state, "/api/v1/resource16");
+}
+BENCHMARK(BM_RouteStaticPath);
+
+static void BM_RouteFirstParameterPath(benchmark::State &state)
+{
+    routeRequests(state, "/api/v1/resource0/42");
+}
+BENCHMARK(BM_RouteFirstParameterPath);
+
+static void BM_RouteLastParameterPath(benchmark::State &state)
+{
+    routeRequests(state, "/api/v1/resource31/42");
+}
+BENCHMARK(BM_RouteLastParameterPath);
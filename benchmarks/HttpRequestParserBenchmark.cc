@@ -0,0 +1,134 @@
+#include "../lib/src/HttpRequestParser.h"
+#include "../lib/src/HttpRequestImpl.h"
+#include <benchmark/benchmark.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/inner/TcpConnectionImpl.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace drogon;
+
+namespace
+{
+// The parser needs a connection in the loop of the current thread, the
+// connection is never established.
+struct ParserContext
+{
+    ParserContext()
+    {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0)
+        {
+            ::close(fds[1]);
+            conn = std::make_shared<trantor::TcpConnectionImpl>(
+                &loop, fds[0], trantor::InetAddress(), trantor::InetAddress());
+        }
+    }
+    trantor::EventLoop loop;
+    trantor::TcpConnectionPtr conn;
+};
+
+ParserContext &context()
+{
+    static thread_local ParserContext ctx;
+    return ctx;
+}
+
+const std::string smallRequest =
+    "GET /api/v1/users?id=42&name=drogon HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: benchmark\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+std::string largeRequest()
+{
+    std::string request =
+        "POST /api/v1/upload HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: en-US,en;q=0.9\r\n"
+        "Cookie: JSESSIONID=0123456789abcdef; theme=dark; lang=en\r\n"
+        "Content-Type: application/json\r\n";
+    std::string body(4096, 'x');
+    request.append("Content-Length: ");
+    request.append(std::to_string(body.length()));
+    request.append("\r\n\r\n");
+    request.append(body);
+    return request;
+}
+}  // namespace
+
+static void parseRequests(benchmark::State &state, const std::string &request)
+{
+    auto &ctx = context();
+    if (!ctx.conn)
+    {
+        state.SkipWithError("Failed to create the connection");
+        return;
+    }
+    auto parser = std::make_shared<HttpRequestParser>(ctx.conn);
+    parser->reset();
+    trantor::MsgBuffer buffer;
+    for (auto _ : state)
+    {
+        buffer.append(request);
+        if (!parser->parseRequest(&buffer) || !parser->gotAll())
+        {
+            state.SkipWithError("Failed to parse the request");
+            return;
+        }
+        benchmark::DoNotOptimize(parser->requestImpl());
+        parser->reset();
+    }
+    state.SetBytesProcessed(state.iterations() * request.length());
+}
+
+static void BM_ParseSmallRequest(benchmark::State &state)
+{
+    parseRequests(state, smallRequest);
+}
+BENCHMARK(BM_ParseSmallRequest);
+
+static void BM_ParseLargeRequest(benchmark::State &state)
+{
+    parseRequests(state, largeRequest());
+}
+BENCHMARK(BM_ParseLargeRequest);
+
+// Many requests arriving in one read, as with HTTP pipelining.
+static void BM_ParsePipelinedRequests(benchmark::State &state)
+{
+    auto &ctx = context();
+    if (!ctx.conn)
+    {
+        state.SkipWithError("Failed to create the connection");
+        return;
+    }
+    auto parser = std::make_shared<HttpRequestParser>(ctx.conn);
+    parser->reset();
+    std::string requests;
+    for (int i = 0; i < state.range(0); ++i)
+        requests.append(smallRequest);
+    trantor::MsgBuffer buffer;
+    for (auto _ : state)
+    {
+        buffer.append(requests);
+        while (buffer.readableBytes() > 0)
+        {
+            if (!parser->parseRequest(&buffer) || !parser->gotAll())
+            {
+                state.SkipWithError("Failed to parse the requests");
+                return;
+            }
+            benchmark::DoNotOptimize(parser->requestImpl());
+            parser->reset();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParsePipelinedRequests)->Arg(16)->Arg(128);
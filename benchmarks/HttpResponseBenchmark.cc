@@ -0,0 +1,56 @@
+#include "../lib/src/HttpResponseImpl.h"
+#include <benchmark/benchmark.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <string>
+
+using namespace drogon;
+
+static void BM_RenderResponse(benchmark::State &state)
+{
+    std::string body(state.range(0), 'x');
+    trantor::MsgBuffer buffer;
+    for (auto _ : state)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setBody(body);
+        resp->addHeader("x-request-id", "0123456789abcdef");
+        static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer(buffer);
+        benchmark::DoNotOptimize(buffer.peek());
+        buffer.retrieveAll();
+    }
+    state.SetBytesProcessed(state.iterations() * body.length());
+}
+BENCHMARK(BM_RenderResponse)->Arg(16)->Arg(4096)->Arg(65536);
+
+static void BM_RenderResponseWithCookies(benchmark::State &state)
+{
+    trantor::MsgBuffer buffer;
+    for (auto _ : state)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setBody("<p>Hello, world!</p>");
+        resp->addCookie("session", "0123456789abcdef");
+        resp->addCookie("theme", "dark");
+        static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer(buffer);
+        benchmark::DoNotOptimize(buffer.peek());
+        buffer.retrieveAll();
+    }
+}
+BENCHMARK(BM_RenderResponseWithCookies);
+
+// Responses cached by handlers are rendered once and then copied.
+static void BM_RenderCachedResponse(benchmark::State &state)
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody("<p>Hello, world!</p>");
+    resp->setExpiredTime(0);
+    auto impl = static_cast<HttpResponseImpl *>(resp.get());
+    trantor::MsgBuffer buffer;
+    for (auto _ : state)
+    {
+        impl->renderToBuffer(buffer);
+        benchmark::DoNotOptimize(buffer.peek());
+        buffer.retrieveAll();
+    }
+}
+BENCHMARK(BM_RenderCachedResponse);
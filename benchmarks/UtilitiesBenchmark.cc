@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+#include <drogon/utils/Utilities.h>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+std::string makeText(size_t length)
+{
+    static const std::string words =
+        "drogon is a C++14/17 based HTTP application framework. ";
+    std::string text;
+    text.reserve(length);
+    while (text.length() < length)
+        text.append(words);
+    text.resize(length);
+    return text;
+}
+}  // namespace
+
+static void BM_UrlDecode(benchmark::State &state)
+{
+    const std::string encoded =
+        "/search?q=%E4%B8%AD%E6%96%87+text&page=2&filter=a%2Cb%2Cc&"
+        "redirect=https%3A%2F%2Fexample.com%2Fpath%3Fx%3D1";
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(utils::urlDecode(encoded));
+    }
+    state.SetBytesProcessed(state.iterations() * encoded.length());
+}
+BENCHMARK(BM_UrlDecode);
+
+static void BM_UrlDecodePlain(benchmark::State &state)
+{
+    const std::string plain = "/api/v1/users/profile/settings";
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(utils::urlDecode(plain));
+    }
+    state.SetBytesProcessed(state.iterations() * plain.length());
+}
+BENCHMARK(BM_UrlDecodePlain);
+
+static void BM_Base64Encode(benchmark::State &state)
+{
+    auto text = makeText(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(utils::base64Encode(
+            reinterpret_cast<const unsigned char *>(text.data()),
+            static_cast<unsigned int>(text.length())));
+    }
+    state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_Base64Encode)->Arg(64)->Arg(4096);
+
+static void BM_Base64Decode(benchmark::State &state)
+{
+    auto text = makeText(state.range(0));
+    auto encoded = utils::base64Encode(
+        reinterpret_cast<const unsigned char *>(text.data()),
+        static_cast<unsigned int>(text.length()));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(utils::base64Decode(encoded));
+    }
+    state.SetBytesProcessed(state.iterations() * encoded.length());
+}
+BENCHMARK(BM_Base64Decode)->Arg(64)->Arg(4096);
+
+static void BM_GzipCompress(benchmark::State &state)
+{
+    auto text = makeText(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            utils::gzipCompress(text.data(), text.length()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_GzipCompress)->Arg(1024)->Arg(65536);
+
+static void BM_GzipDecompress(benchmark::State &state)
+{
+    auto text = makeText(state.range(0));
+    auto compressed = utils::gzipCompress(text.data(), text.length());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            utils::gzipDecompress(compressed.data(), compressed.length()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_GzipDecompress)->Arg(1024)->Arg(65536);
@@ -0,0 +1,83 @@
+#!/bin/sh
+# Run the example benchmark server and load it with drogon_ctl press.
+# Usage: loopback.sh <benchmark server> <drogon_ctl> <output directory>
+# The results are written to loopback_closed.json (closed-loop, maximum
+# throughput) and loopback_open.json (open-loop, latency at a fixed rate).
+# If LOOPBACK_SYSCALLS is set, the system calls of the server are counted
+# with strace in loopback_syscalls.txt.
+# If LOOPBACK_IO_URING is set, the benchmarks are run again with the server
+# using io_uring, the names of those files end with _io_uring.
+
+set -e
+
+server=$1
+ctl=$2
+output=$3
+url=http://127.0.0.1:7770/
+requests=${LOOPBACK_REQUESTS:-200000}
+rate=${LOOPBACK_RATE:-20000}
+pid=
+
+cd "$output"
+trap '[ -z "$pid" ] || kill $pid' EXIT
+
+# Count the system calls of the running server. strace slows the server down
+# a lot, so they are counted in a separate and shorter run.
+count_syscalls() {
+    if ! command -v strace > /dev/null 2>&1; then
+        echo "strace is not found, the system calls are not counted"
+        return
+    fi
+    syscall_requests=${LOOPBACK_SYSCALL_REQUESTS:-20000}
+    strace -c -f -q -p $pid -o "loopback_syscalls$1.txt" &
+    strace_pid=$!
+    sleep 1
+    "$ctl" press -n "$syscall_requests" -c 64 -t 4 -q "$url"
+    kill $strace_pid
+    wait $strace_pid || true
+    cat "loopback_syscalls$1.txt"
+    awk -v n="$syscall_requests" '$NF == "total" {
+        printf "system calls per request: %.2f\n", $4 / n }' \
+        "loopback_syscalls$1.txt"
+}
+
+# Run the benchmarks against the server started with the arguments after the
+# suffix of the result files.
+run_benchmarks() {
+    suffix=$1
+    shift
+    "$server" "$@" &
+    pid=$!
+
+    # Wait for the server to listen.
+    i=0
+    until "$ctl" press -n 1 -q "$url" > /dev/null 2>&1; do
+        i=$((i + 1))
+        if [ $i -gt 50 ]; then
+            echo "The benchmark server is not started"
+            exit 1
+        fi
+        sleep 0.1
+    done
+
+    "$ctl" press -n "$requests" -c 64 -t 4 --json "$url" \
+        > "loopback_closed$suffix.json"
+    "$ctl" press -n "$requests" -c 64 -t 4 -r "$rate" --json "$url" \
+        > "loopback_open$suffix.json"
+    cat "loopback_closed$suffix.json" "loopback_open$suffix.json"
+
+    # The system calls per request are the cost of the I/O backend of the
+    # listeners, epoll with read/writev or io_uring.
+    if [ -n "$LOOPBACK_SYSCALLS" ]; then
+        count_syscalls "$suffix"
+    fi
+
+    kill $pid
+    wait $pid || true
+    pid=
+}
+
+run_benchmarks ""
+if [ -n "$LOOPBACK_IO_URING" ]; then
+    run_benchmarks _io_uring --io-uring
+fi
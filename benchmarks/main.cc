@@ -0,0 +1,13 @@
+#include <benchmark/benchmark.h>
+#include <trantor/utils/Logger.h>
+
+int main(int argc, char **argv)
+{
+    // Logging would dominate the measured time.
+    trantor::Logger::setLogLevel(trantor::Logger::kFatal);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <libpq-fe.h>
+
+int main()
+{
+    PQpipelineStatus(NULL);
+    PQenterPipelineMode(NULL);
+    PQexitPipelineMode(NULL);
+    PQpipelineSync(NULL);
+    PGresult *res = NULL;
+    return PQresultStatus(res) == PGRES_PIPELINE_ABORTED ||
+           PQresultStatus(res) == PGRES_PIPELINE_SYNC;
+}
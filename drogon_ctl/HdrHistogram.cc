@@ -0,0 +1,169 @@
+/**
+ *
+ *  HdrHistogram.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HdrHistogram.h"
+#include <assert.h>
+#include <cmath>
+
+using namespace drogon_ctl;
+
+// 2048 sub-buckets cover 3 significant decimal digits, the lower half of the
+// sub-buckets of every bucket but the first overlaps with the previous one.
+static const int subBucketHalfCountMagnitude = 10;
+static const int64_t subBucketHalfCount = 1 << subBucketHalfCountMagnitude;
+static const int64_t subBucketMask = 2 * subBucketHalfCount - 1;
+
+static int bucketIndexOf(int64_t value)
+{
+    // The number of bits of value | subBucketMask minus the bits of the
+    // sub-buckets.
+    auto bits = static_cast<uint64_t>(value | subBucketMask);
+    int magnitude = 0;
+    while (bits >>= 1)
+        ++magnitude;
+    return magnitude - subBucketHalfCountMagnitude;
+}
+
+HdrHistogram::HdrHistogram(int64_t highestValue) : highestValue_(highestValue)
+{
+    assert(highestValue_ > 0);
+    auto bucketsNumber = bucketIndexOf(highestValue_) + 1;
+    counts_.resize((bucketsNumber + 1) * subBucketHalfCount, 0);
+}
+
+size_t HdrHistogram::indexOf(int64_t value) const
+{
+    auto bucketIndex = bucketIndexOf(value);
+    auto subBucketIndex = value >> bucketIndex;
+    return static_cast<size_t>(
+        ((bucketIndex + 1) << subBucketHalfCountMagnitude) + subBucketIndex -
+        subBucketHalfCount);
+}
+
+int64_t HdrHistogram::valueFromIndex(size_t index) const
+{
+    auto bucketIndex =
+        static_cast<int>(index >> subBucketHalfCountMagnitude) - 1;
+    auto subBucketIndex =
+        static_cast<int64_t>(index & (subBucketHalfCount - 1)) +
+        subBucketHalfCount;
+    if (bucketIndex < 0)
+    {
+        subBucketIndex -= subBucketHalfCount;
+        bucketIndex = 0;
+    }
+    return subBucketIndex << bucketIndex;
+}
+
+int64_t HdrHistogram::highestEquivalentValue(size_t index) const
+{
+    auto value = valueFromIndex(index);
+    return value + (int64_t(1) << bucketIndexOf(value)) - 1;
+}
+
+int64_t HdrHistogram::medianEquivalentValue(size_t index) const
+{
+    auto value = valueFromIndex(index);
+    return value + ((int64_t(1) << bucketIndexOf(value)) >> 1);
+}
+
+void HdrHistogram::record(int64_t value)
+{
+    if (value < 0)
+        value = 0;
+    else if (value > highestValue_)
+        value = highestValue_;
+    ++counts_[indexOf(value)];
+    ++totalCount_;
+    if (value < minValue_)
+        minValue_ = value;
+    if (value > maxValue_)
+        maxValue_ = value;
+}
+
+void HdrHistogram::add(const HdrHistogram &other)
+{
+    assert(counts_.size() == other.counts_.size());
+    for (size_t i = 0; i < counts_.size(); ++i)
+        counts_[i] += other.counts_[i];
+    totalCount_ += other.totalCount_;
+    if (other.minValue_ < minValue_)
+        minValue_ = other.minValue_;
+    if (other.maxValue_ > maxValue_)
+        maxValue_ = other.maxValue_;
+}
+
+int64_t HdrHistogram::min() const
+{
+    return totalCount_ == 0 ? 0 : minValue_;
+}
+
+int64_t HdrHistogram::max() const
+{
+    return maxValue_;
+}
+
+double HdrHistogram::mean() const
+{
+    if (totalCount_ == 0)
+        return 0;
+    double total = 0;
+    for (size_t i = 0; i < counts_.size(); ++i)
+    {
+        if (counts_[i] > 0)
+            total += static_cast<double>(medianEquivalentValue(i)) * counts_[i];
+    }
+    return total / totalCount_;
+}
+
+double HdrHistogram::stddev() const
+{
+    if (totalCount_ == 0)
+        return 0;
+    auto average = mean();
+    double total = 0;
+    for (size_t i = 0; i < counts_.size(); ++i)
+    {
+        if (counts_[i] > 0)
+        {
+            auto deviation =
+                static_cast<double>(medianEquivalentValue(i)) - average;
+            total += deviation * deviation * counts_[i];
+        }
+    }
+    return std::sqrt(total / totalCount_);
+}
+
+int64_t HdrHistogram::valueAtPercentile(double percentile) const
+{
+    if (totalCount_ == 0)
+        return 0;
+    if (percentile > 100)
+        percentile = 100;
+    auto countAtPercentile =
+        static_cast<uint64_t>(std::ceil(percentile / 100 * totalCount_));
+    if (countAtPercentile == 0)
+        countAtPercentile = 1;
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts_.size(); ++i)
+    {
+        total += counts_[i];
+        if (total >= countAtPercentile)
+        {
+            auto value = highestEquivalentValue(i);
+            return value < maxValue_ ? value : maxValue_;
+        }
+    }
+    return maxValue_;
+}
@@ -0,0 +1,65 @@
+/**
+ *
+ *  HdrHistogram.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace drogon_ctl
+{
+/**
+ * @brief A high dynamic range histogram of non-negative integers (latencies
+ * in microseconds), which records values with 3 significant decimal digits
+ * in constant time and memory.
+ *
+ * Values are grouped in buckets of doubling ranges, each bucket is split into
+ * 1024 linear sub-buckets, so the error of a recorded value is less than
+ * 1/1024 of it.
+ */
+class HdrHistogram
+{
+  public:
+    /// @param highestValue The highest trackable value, larger values are
+    /// recorded as this value.
+    explicit HdrHistogram(int64_t highestValue = 3600LL * 1000 * 1000);
+    void record(int64_t value);
+    /// Add the values recorded by another histogram with the same range.
+    void add(const HdrHistogram &other);
+
+    uint64_t count() const
+    {
+        return totalCount_;
+    }
+    int64_t min() const;
+    int64_t max() const;
+    double mean() const;
+    double stddev() const;
+    /// @param percentile 0 to 100.
+    int64_t valueAtPercentile(double percentile) const;
+
+  private:
+    size_t indexOf(int64_t value) const;
+    int64_t valueFromIndex(size_t index) const;
+    int64_t highestEquivalentValue(size_t index) const;
+    int64_t medianEquivalentValue(size_t index) const;
+
+    int64_t highestValue_;
+    std::vector<uint64_t> counts_;
+    uint64_t totalCount_{0};
+    int64_t minValue_{INT64_MAX};
+    int64_t maxValue_{0};
+};
+}  // namespace drogon_ctl
@@ -33,6 +33,10 @@ static const std::string sub_view_end = "%>";
 
 using namespace drogon_ctl;
 
+// The literal text not written yet. Adjacent literal segments are merged into
+// one append to the output buffer.
+static std::string pendingLiteral;
+
 static std::string &replace_all(std::string &str,
                                 const std::string &old_value,
                                 const std::string &new_value)
@@ -53,6 +57,40 @@ static std::string &replace_all(std::string &str,
     }
     return str;
 }
+static void flushLiteral(std::ofstream &oSrcFile,
+                         const std::string &streamName)
+{
+    if (pendingLiteral.empty())
+        return;
+    // Write one string literal per line of the view, the compiler concatenates
+    // them.
+    oSrcFile << "\t" << streamName << " <<";
+    std::string::size_type pos = 0;
+    while (pos < pendingLiteral.length())
+    {
+        auto end = pendingLiteral.find('\n', pos);
+        end = (end == std::string::npos) ? pendingLiteral.length() : end + 1;
+        std::string segment = pendingLiteral.substr(pos, end - pos);
+        replace_all(segment, "\\", "\\\\");
+        replace_all(segment, "\"", "\\\"");
+        replace_all(segment, "\n", "\\n");
+        oSrcFile << "\n\t\t\"" << segment << "\"";
+        pos = end;
+    }
+    oSrcFile << ";\n";
+    pendingLiteral.clear();
+}
+
+static void outputLiteral(std::ofstream &oSrcFile,
+                          const std::string &streamName,
+                          const std::string &text)
+{
+    pendingLiteral.append(text);
+    // Some compilers limit the length of string literals.
+    if (pendingLiteral.length() > 8192)
+        flushLiteral(oSrcFile, streamName);
+}
+
 static void parseCxxLine(std::ofstream &oSrcFile,
                          const std::string &line,
                          const std::string &streamName,
@@ -60,6 +98,7 @@ static void parseCxxLine(std::ofstream &oSrcFile,
 {
     if (line.length() > 0)
     {
+        flushLiteral(oSrcFile, streamName);
         std::string tmp = line;
         replace_all(tmp, cxx_output, streamName);
         replace_all(tmp, cxx_view_data, viewDataName);
@@ -71,18 +110,12 @@ static void outputVal(std::ofstream &oSrcFile,
                       const std::string &viewDataName,
                       const std::string &keyName)
 {
+    flushLiteral(oSrcFile, streamName);
+    // The key is constructed only once.
     oSrcFile << "{\n";
-    oSrcFile << "    auto & val=" << viewDataName << "[\"" << keyName
-             << "\"];\n";
-    oSrcFile << "    if(val.type()==typeid(const char *)){\n";
-    oSrcFile << "        " << streamName
-             << "<<*any_cast<const char *>(&val);\n";
-    oSrcFile << "    }else "
-                "if(val.type()==typeid(std::string)||val.type()==typeid(const "
-                "std::string)){\n";
-    oSrcFile << "        " << streamName
-             << "<<*any_cast<const std::string>(&val);\n";
-    oSrcFile << "    }\n";
+    oSrcFile << "    static const std::string key{\"" << keyName << "\"};\n";
+    oSrcFile << "    " << streamName << "<<" << viewDataName
+             << ".getStringView(key);\n";
     oSrcFile << "}\n";
 }
 
@@ -91,6 +124,7 @@ static void outputSubView(std::ofstream &oSrcFile,
                           const std::string &viewDataName,
                           const std::string &keyName)
 {
+    flushLiteral(oSrcFile, streamName);
     oSrcFile << "{\n";
     oSrcFile << "    auto templ=DrTemplateBase::newTemplate(\"" << keyName
              << "\");\n";
@@ -119,7 +153,7 @@ static void parseLine(std::ofstream &oSrcFile,
         // std::cout<<"blank line!"<<std::endl;
         // std::cout<<streamName<<"<<\"\\n\";\n";
         if (returnFlag)
-            oSrcFile << streamName << "<<\"\\n\";\n";
+            outputLiteral(oSrcFile, streamName, "\n");
         return;
     }
     if (cxx_flag == 0)
@@ -210,16 +244,9 @@ static void parseLine(std::ofstream &oSrcFile,
             }
             else
             {
-                if (line.length() > 0)
-                {
-                    replace_all(line, "\\", "\\\\");
-                    replace_all(line, "\"", "\\\"");
-                    oSrcFile << "\t" << streamName << " << \"" << line;
-                }
+                outputLiteral(oSrcFile, streamName, line);
                 if (returnFlag)
-                    oSrcFile << "\\n\";\n";
-                else
-                    oSrcFile << "\";\n";
+                    outputLiteral(oSrcFile, streamName, "\n");
             }
         }
     }
@@ -406,6 +433,7 @@ void create_view::newViewSourceFile(std::ofstream &file,
             "automatically,don't modify it!\n";
     file << "#include \"" << namespacePrefix << className << ".h\"\n";
     file << "#include <drogon/utils/OStringStream.h>\n";
+    file << "#include <atomic>\n";
     file << "#include <string>\n";
     file << "#include <map>\n";
     file << "#include <vector>\n";
@@ -511,8 +539,14 @@ void create_view::newViewSourceFile(std::ofstream &file,
     // std::string bodyName=className+"_bodystr";
     std::string streamName = className + "_tmp_stream";
 
+    // The size of the last rendered text is used to reserve the buffer.
+    std::string sizeHintName = className + "_size_hint";
+
     // oSrcFile <<"\tstd::string "<<bodyName<<";\n";
+    file << "\tstatic std::atomic<size_t> " << sizeHintName << "{0};\n";
     file << "\tdrogon::OStringStream " << streamName << ";\n";
+    file << "\t" << streamName << ".reserve(" << sizeHintName
+         << ".load(std::memory_order_relaxed));\n";
     file << "\tstd::string layoutName{\"" << layoutName << "\"};\n";
     int cxx_flag = 0;
     for (std::string buffer; std::getline(infile, buffer);)
@@ -533,6 +567,9 @@ void create_view::newViewSourceFile(std::ofstream &file,
         }
         parseLine(file, buffer, streamName, viewDataName, cxx_flag);
     }
+    flushLiteral(file, streamName);
+    file << sizeHintName << ".store(" << streamName
+         << ".str().size(), std::memory_order_relaxed);\n";
     file << "if(layoutName.empty())\n{\n";
     file << "std::string ret{std::move(" << streamName << ".str())};\n";
     file << "return ret;\n}else\n{\n";
@@ -15,6 +15,8 @@
 #include "press.h"
 #include "cmd.h"
 #include <drogon/DrClassMap.h>
+#include <json/json.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <iomanip>
@@ -31,10 +33,22 @@ std::string press::detail()
            "  -n num    number of requests(default : 1)\n"
            "  -t num    number of threads(default : 1)\n"
            "  -c num    concurrent connections(default : 1)\n"
-           //  "  -k        keep alive(default: no)\n"
-           "  -q        no progress indication(default: no)\n\n"
+           "  -r num    send num requests per second in total without "
+           "waiting for\n"
+           "            responses, the latencies are measured from the "
+           "scheduled\n"
+           "            sending time(default : 0, every connection sends a "
+           "request\n"
+           "            after receiving the previous response)\n"
+           "  -p num    pipelining depth of every connection(default : 1)\n"
+           "  -q        no progress indication(default: no)\n"
+           "  --close   use a new connection for every request(default: "
+           "no)\n"
+           "  --json    output the results in json(default: no)\n\n"
            "example: drogon_ctl press -n 10000 -c 100 -t 4 -q "
-           "http://localhost:8080/index.html\n";
+           "http://localhost:8080/index.html\n"
+           "         drogon_ctl press -n 100000 -c 10 -r 5000 --json "
+           "http://localhost:8080/\n";
 }
 
 void outputErrorAndExit(const string_view &err)
@@ -42,118 +56,80 @@ void outputErrorAndExit(const string_view &err)
     std::cout << err << std::endl;
     exit(1);
 }
+
+// Parse the number of an option given as "-n 100" or "-n100".
+static size_t parseNumber(std::vector<std::string>::iterator &iter,
+                          const std::vector<std::string> &parameters,
+                          const std::string &option,
+                          const std::string &name)
+{
+    std::string num;
+    if (*iter == option)
+    {
+        ++iter;
+        if (iter == parameters.end())
+        {
+            outputErrorAndExit("No " + name + "!");
+        }
+        num = *iter;
+    }
+    else
+    {
+        num = iter->substr(option.length());
+    }
+    try
+    {
+        return std::stoull(num);
+    }
+    catch (...)
+    {
+        outputErrorAndExit("Invalid " + name + "!");
+    }
+    return 0;
+}
+
 void press::handleCommand(std::vector<std::string> &parameters)
 {
     for (auto iter = parameters.begin(); iter != parameters.end(); iter++)
     {
         auto &param = *iter;
-        if (param.find("-n") == 0)
+        if (param == "--close")
         {
-            if (param == "-n")
-            {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No number of requests!");
-                }
-                auto &num = *iter;
-                try
-                {
-                    numOfRequests_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of requests!");
-                }
-                continue;
-            }
-            else
-            {
-                auto num = param.substr(2);
-                try
-                {
-                    numOfRequests_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of requests!");
-                }
-                continue;
-            }
+            keepAlive_ = false;
+        }
+        else if (param == "--json")
+        {
+            jsonOutput_ = true;
+            processIndication_ = false;
+        }
+        else if (param.find("-n") == 0)
+        {
+            numOfRequests_ =
+                parseNumber(iter, parameters, "-n", "number of requests");
         }
         else if (param.find("-t") == 0)
         {
-            if (param == "-t")
-            {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No number of threads!");
-                }
-                auto &num = *iter;
-                try
-                {
-                    numOfThreads_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of threads!");
-                }
-                continue;
-            }
-            else
-            {
-                auto num = param.substr(2);
-                try
-                {
-                    numOfThreads_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of threads!");
-                }
-                continue;
-            }
+            numOfThreads_ =
+                parseNumber(iter, parameters, "-t", "number of threads");
         }
         else if (param.find("-c") == 0)
         {
-            if (param == "-c")
-            {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No number of connections!");
-                }
-                auto &num = *iter;
-                try
-                {
-                    numOfConnections_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of connections!");
-                }
-                continue;
-            }
-            else
+            numOfConnections_ =
+                parseNumber(iter, parameters, "-c", "number of connections");
+        }
+        else if (param.find("-r") == 0)
+        {
+            rate_ = parseNumber(iter, parameters, "-r", "request rate");
+        }
+        else if (param.find("-p") == 0)
+        {
+            pipeliningDepth_ =
+                parseNumber(iter, parameters, "-p", "pipelining depth");
+            if (pipeliningDepth_ == 0)
             {
-                auto num = param.substr(2);
-                try
-                {
-                    numOfConnections_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of connections!");
-                }
-                continue;
+                outputErrorAndExit("Invalid pipelining depth!");
             }
         }
-        // else if (param == "-k")
-        // {
-        //     keepAlive_ = true;
-        //     continue;
-        // }
         else if (param == "-q")
         {
             processIndication_ = false;
@@ -163,11 +139,6 @@ void press::handleCommand(std::vector<std::string> &parameters)
             url_ = param;
         }
     }
-    // std::cout << "n=" << numOfRequests_ << std::endl;
-    // std::cout << "t=" << numOfThreads_ << std::endl;
-    // std::cout << "c=" << numOfConnections_ << std::endl;
-    // std::cout << "q=" << processIndication_ << std::endl;
-    // std::cout << "url=" << url_ << std::endl;
     if (url_.empty() || url_.compare(0, 4, "http") != 0 ||
         (url_.compare(4, 3, "://") != 0 && url_.compare(4, 4, "s://") != 0))
     {
@@ -188,22 +159,22 @@ void press::handleCommand(std::vector<std::string> &parameters)
             path_ = url_.substr(posOfPath);
         }
     }
-    // std::cout << "host=" << host_ << std::endl;
-    // std::cout << "path=" << path_ << std::endl;
     doTesting();
 }
 
 void press::doTesting()
 {
     createRequestAndClients();
-    if (clients_.empty())
+    if (connections_.empty())
     {
         outputErrorAndExit("No connection!");
     }
     statistics_.startDate_ = trantor::Date::now();
-    for (auto &client : clients_)
+    for (auto &connection : connections_)
     {
-        sendRequest(client);
+        auto connPtr = connection.get();
+        connPtr->loop->queueInLoop(
+            [this, connPtr]() { startSending(*connPtr); });
     }
     loopPool_->wait();
 }
@@ -212,39 +183,100 @@ void press::createRequestAndClients()
 {
     loopPool_ = std::make_unique<trantor::EventLoopThreadPool>(numOfThreads_);
     loopPool_->start();
+    for (size_t i = 0; i < numOfThreads_; ++i)
+    {
+        latencies_.emplace_back(std::make_unique<HdrHistogram>());
+    }
     for (size_t i = 0; i < numOfConnections_; ++i)
     {
-        auto client =
-            HttpClient::newHttpClient(host_, loopPool_->getNextLoop());
-        client->enableCookies();
-        clients_.push_back(client);
+        auto connection = std::make_unique<Connection>();
+        connection->index = i;
+        connection->loop = loopPool_->getLoop(i % numOfThreads_);
+        connection->latencies = latencies_[i % numOfThreads_].get();
+        if (keepAlive_)
+        {
+            connection->client =
+                HttpClient::newHttpClient(host_, connection->loop);
+            connection->client->enableCookies();
+            connection->client->setPipeliningDepth(pipeliningDepth_);
+        }
+        connections_.push_back(std::move(connection));
     }
 }
 
-void press::sendRequest(const HttpClientPtr &client)
+void press::startSending(Connection &connection)
 {
-    auto numOfRequest = statistics_.numOfRequestsSent_++;
-    if (numOfRequest >= numOfRequests_)
+    if (rate_ == 0)
     {
+        for (size_t i = 0; i < pipeliningDepth_; ++i)
+        {
+            if (statistics_.numOfRequestsSent_++ >= numOfRequests_)
+                return;
+            sendRequest(connection, trantor::Date::now());
+        }
         return;
     }
+    // Sending requests in a timer of less than 1ms costs too much, the
+    // requests due are sent together.
+    auto interval = static_cast<double>(numOfConnections_) / rate_;
+    connection.timerId =
+        connection.loop->runEvery(std::max(interval, 0.001),
+                                  [this, &connection]() {
+                                      sendScheduledRequests(connection);
+                                  });
+    sendScheduledRequests(connection);
+}
+
+void press::sendScheduledRequests(Connection &connection)
+{
+    auto now = trantor::Date::now();
+    while (connection.timerId != trantor::InvalidTimerId)
+    {
+        // The k-th request of the i-th connection is scheduled at
+        // (i + k * connections) / rate seconds after the start.
+        auto offset = static_cast<int64_t>(
+            (connection.index + connection.scheduled * numOfConnections_) *
+            1000000.0 / rate_);
+        trantor::Date intendedTime(
+            statistics_.startDate_.microSecondsSinceEpoch() + offset);
+        if (intendedTime > now)
+            return;
+        if (statistics_.numOfRequestsSent_++ >= numOfRequests_)
+        {
+            connection.loop->invalidateTimer(connection.timerId);
+            connection.timerId = trantor::InvalidTimerId;
+            return;
+        }
+        ++connection.scheduled;
+        sendRequest(connection, intendedTime);
+    }
+}
+
+void press::sendRequest(Connection &connection,
+                        const trantor::Date &intendedTime)
+{
+    auto client = connection.client;
+    if (!client)
+    {
+        client = HttpClient::newHttpClient(host_, connection.loop);
+        client->enableCookies();
+    }
     auto request = HttpRequest::newHttpRequest();
     request->setPath(path_);
     request->setMethod(Get);
-    // std::cout << "send!" << std::endl;
     client->sendRequest(
         request,
-        [this, client, request](ReqResult r, const HttpResponsePtr &resp) {
+        [this, &connection, client, intendedTime](
+            ReqResult r, const HttpResponsePtr &resp) {
             size_t goodNum, badNum;
             if (r == ReqResult::Ok)
             {
-                // std::cout << "OK" << std::endl;
+                statistics_.bytesRecieved_ += resp->body().length();
+                connection.latencies->record(
+                    trantor::Date::now().microSecondsSinceEpoch() -
+                    intendedTime.microSecondsSinceEpoch());
                 goodNum = ++statistics_.numOfGoodResponse_;
                 badNum = statistics_.numOfBadResponse_;
-                statistics_.bytesRecieved_ += resp->body().length();
-                auto delay = trantor::Date::now().microSecondsSinceEpoch() -
-                             request->creationDate().microSecondsSinceEpoch();
-                statistics_.totalDelay_ += delay;
             }
             else
             {
@@ -255,17 +287,32 @@ void press::sendRequest(const HttpClientPtr &client)
                     outputErrorAndExit("Too many errors");
                 }
             }
+            if (!connection.client)
+            {
+                statistics_.bytesSentByClosedClients_ += client->bytesSent();
+                statistics_.bytesReceivedByClosedClients_ +=
+                    client->bytesReceived();
+                // The client can't be destroyed in its own callback.
+                connection.loop->queueInLoop([client]() {});
+            }
             if (goodNum + badNum >= numOfRequests_)
             {
                 outputResults();
             }
-            if (r == ReqResult::Ok)
-                sendRequest(client);
-            else
+            if (rate_ == 0)
             {
-                client->getLoop()->runAfter(1, [this, client]() {
-                    sendRequest(client);
-                });
+                if (r == ReqResult::Ok)
+                {
+                    if (statistics_.numOfRequestsSent_++ < numOfRequests_)
+                        sendRequest(connection, trantor::Date::now());
+                }
+                else
+                {
+                    connection.loop->runAfter(1, [this, &connection]() {
+                        if (statistics_.numOfRequestsSent_++ < numOfRequests_)
+                            sendRequest(connection, trantor::Date::now());
+                    });
+                }
             }
 
             if (processIndication_)
@@ -283,17 +330,31 @@ void press::sendRequest(const HttpClientPtr &client)
 void press::outputResults()
 {
     static std::mutex mtx;
-    size_t totalSent = 0;
-    size_t totalRecv = 0;
-    for (auto &client : clients_)
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t totalSent = statistics_.bytesSentByClosedClients_;
+    size_t totalRecv = statistics_.bytesReceivedByClosedClients_;
+    for (auto &connection : connections_)
+    {
+        if (connection->client)
+        {
+            totalSent += connection->client->bytesSent();
+            totalRecv += connection->client->bytesReceived();
+        }
+    }
+    for (size_t i = 1; i < latencies_.size(); ++i)
     {
-        totalSent += client->bytesSent();
-        totalRecv += client->bytesReceived();
+        latencies_[0]->add(*latencies_[i]);
     }
+    auto &latencies = *latencies_[0];
     auto now = trantor::Date::now();
     auto microSecs = now.microSecondsSinceEpoch() -
                      statistics_.startDate_.microSecondsSinceEpoch();
     double seconds = (double)microSecs / 1000000.0;
+    if (jsonOutput_)
+    {
+        outputJson(seconds, totalSent, totalRecv);
+        exit(0);
+    }
     size_t rps = static_cast<size_t>(statistics_.numOfGoodResponse_ / seconds);
     std::cout << std::endl;
     std::cout << "TOTALS:   " << numOfConnections_ << " connect, "
@@ -312,9 +373,15 @@ void press::outputResults()
 
     std::cout << std::setiosflags(std::ios::fixed) << std::setprecision(3)
               << "TIMING:   " << seconds << " seconds, " << rps << " rps, "
-              << (double)(statistics_.totalDelay_) /
-                     statistics_.numOfGoodResponse_ / 1000
-              << " ms avg req time" << std::endl;
+              << latencies.mean() / 1000 << " ms avg req time" << std::endl;
+
+    std::cout << "LATENCY:  " << latencies.min() / 1000.0 << " min, "
+              << latencies.valueAtPercentile(50) / 1000.0 << " p50, "
+              << latencies.valueAtPercentile(90) / 1000.0 << " p90, "
+              << latencies.valueAtPercentile(99) / 1000.0 << " p99, "
+              << latencies.valueAtPercentile(99.9) / 1000.0 << " p999, "
+              << latencies.max() / 1000.0 << " max, "
+              << latencies.stddev() / 1000 << " stddev (ms)" << std::endl;
 
     std::cout << "SPEED:    download " << totalRecv / seconds / 1000
               << " kBps, upload " << totalSent / seconds / 1000 << " kBps"
@@ -322,3 +389,41 @@ void press::outputResults()
               << std::endl;
     exit(0);
 }
+
+void press::outputJson(double seconds, size_t totalSent, size_t totalRecv)
+{
+    auto &latencies = *latencies_[0];
+    Json::Value result;
+    result["url"] = url_;
+    result["threads"] = static_cast<Json::UInt64>(numOfThreads_);
+    result["connections"] = static_cast<Json::UInt64>(numOfConnections_);
+    result["requests"] = static_cast<Json::UInt64>(numOfRequests_);
+    result["rate"] = static_cast<Json::UInt64>(rate_);
+    result["pipelining_depth"] = static_cast<Json::UInt64>(pipeliningDepth_);
+    result["keep_alive"] = keepAlive_;
+    result["success"] =
+        static_cast<Json::UInt64>(statistics_.numOfGoodResponse_);
+    result["fail"] = static_cast<Json::UInt64>(statistics_.numOfBadResponse_);
+    result["seconds"] = seconds;
+    result["rps"] = statistics_.numOfGoodResponse_ / seconds;
+    result["body_bytes"] =
+        static_cast<Json::UInt64>(statistics_.bytesRecieved_);
+    result["received_bytes"] = static_cast<Json::UInt64>(totalRecv);
+    result["sent_bytes"] = static_cast<Json::UInt64>(totalSent);
+    auto &latency = result["latency_us"];
+    latency["min"] = static_cast<Json::Int64>(latencies.min());
+    latency["mean"] = latencies.mean();
+    latency["stddev"] = latencies.stddev();
+    latency["p50"] = static_cast<Json::Int64>(latencies.valueAtPercentile(50));
+    latency["p75"] = static_cast<Json::Int64>(latencies.valueAtPercentile(75));
+    latency["p90"] = static_cast<Json::Int64>(latencies.valueAtPercentile(90));
+    latency["p99"] = static_cast<Json::Int64>(latencies.valueAtPercentile(99));
+    latency["p999"] =
+        static_cast<Json::Int64>(latencies.valueAtPercentile(99.9));
+    latency["p9999"] =
+        static_cast<Json::Int64>(latencies.valueAtPercentile(99.99));
+    latency["max"] = static_cast<Json::Int64>(latencies.max());
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    std::cout << Json::writeString(builder, result) << std::endl;
+}
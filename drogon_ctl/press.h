@@ -15,6 +15,7 @@
 #pragma once
 
 #include "CommandHandler.h"
+#include "HdrHistogram.h"
 #include <drogon/DrObject.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/HttpClient.h>
@@ -35,7 +36,9 @@ struct Statistics
     std::atomic_size_t bytesRecieved_{0};
     std::atomic_size_t numOfGoodResponse_{0};
     std::atomic_size_t numOfBadResponse_{0};
-    std::atomic_size_t totalDelay_{0};
+    // The traffic of the clients that are closed after their requests.
+    std::atomic_size_t bytesSentByClosedClients_{0};
+    std::atomic_size_t bytesReceivedByClosedClients_{0};
     trantor::Date startDate_;
     trantor::Date endDate_;
 };
@@ -58,17 +61,45 @@ class press : public DrObject<press>, public CommandHandler
     size_t numOfThreads_{1};
     size_t numOfRequests_{1};
     size_t numOfConnections_{1};
-    // bool keepAlive_ = false;
+    // Requests per second of all connections, 0 means that every connection
+    // sends a new request when it receives a response.
+    size_t rate_{0};
+    size_t pipeliningDepth_{1};
+    bool keepAlive_{true};
+    bool jsonOutput_{false};
     bool processIndication_{true};
     std::string url_;
     std::string host_;
     std::string path_;
+    // A connection and the state of the requests it sends.
+    struct Connection
+    {
+        size_t index;
+        // Null in the new-connection mode, every request uses a new client.
+        HttpClientPtr client;
+        trantor::EventLoop *loop;
+        // The latencies of the responses received in the loop of the
+        // connection.
+        HdrHistogram *latencies;
+        // The number of requests scheduled in the open-loop mode.
+        size_t scheduled{0};
+        trantor::TimerId timerId{trantor::InvalidTimerId};
+    };
     void doTesting();
     void createRequestAndClients();
-    void sendRequest(const HttpClientPtr &client);
+    void startSending(Connection &connection);
+    void sendScheduledRequests(Connection &connection);
+    // The latency is measured from the intended sending time. In the
+    // open-loop mode, it is the time the request is scheduled to be sent, so
+    // responses delayed by the server don't delay the following requests
+    // and their latencies are not omitted.
+    void sendRequest(Connection &connection, const trantor::Date &intendedTime);
     void outputResults();
+    void outputJson(double seconds, size_t totalSent, size_t totalRecv);
     std::unique_ptr<trantor::EventLoopThreadPool> loopPool_;
-    std::vector<HttpClientPtr> clients_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    // One histogram for each thread, they are merged at the end.
+    std::vector<std::unique_ptr<HdrHistogram>> latencies_;
     Statistics statistics_;
 };
 }  // namespace drogon_ctl
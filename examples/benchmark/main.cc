@@ -1,9 +1,12 @@
 #include <drogon/drogon.h>
 
 using namespace drogon;
-int main()
+int main(int argc, char *argv[])
 {
+    // The listener uses io_uring instead of epoll with --io-uring.
+    bool useIoUring = argc > 1 && std::string(argv[1]) == "--io-uring";
     app()
+        .enableIoUring(useIoUring)
         .setLogPath("./")
         .setLogLevel(trantor::Logger::kWarn)
         .addListener("0.0.0.0", 7770)
@@ -19,10 +19,12 @@
 #include <drogon/CacheMap.h>
 #include <drogon/DrObject.h>
 #include <drogon/HttpBinder.h>
+#include <drogon/JsonCodec.h>
 #include <drogon/IntranetIpFilter.h>
 #include <drogon/LocalHostFilter.h>
 #include <drogon/MultiPart.h>
 #include <drogon/NotFound.h>
+#include <drogon/RequestTrace.h>
 #include <drogon/drogon_callbacks.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/plugins/Plugin.h>
@@ -674,6 +676,31 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         const std::vector<std::pair<std::string, std::string>>
             &sslConfCmds) = 0;
 
+    /// Share the TLS sessions among all the https listeners
+    /**
+     * By default, each listener of each IO thread resumes only the sessions
+     * established by itself. With the sharing, a reconnecting client resumes
+     * its session on any of them, by the session ID or the session ticket.
+     *
+     * @param cacheSize The number of sessions cached for the resumption by
+     * session IDs, 0 disables the cache.
+     * @param ticketKeyRotation The interval in seconds between two rotations
+     * of the key encrypting the session tickets, 0 means the key is never
+     * rotated. A ticket can be resumed until the key is rotated twice.
+     * @param ticketKeyFile If it's not empty, the ticket keys are read from
+     * and rotated in the file, so the processes using the same file (e.g.
+     * behind a load balancer) resume the tickets issued by each other.
+     *
+     * @note
+     * The full and resumed handshakes are counted in the
+     * drogon_tls_handshakes_total metric if the built-in metrics are enabled.
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableSSLSessionSharing(
+        size_t cacheSize = 20480,
+        size_t ticketKeyRotation = 3600,
+        const std::string &ticketKeyFile = "") = 0;
+
     /// Add a listener for http or https service
     /**
      * @param ip is the ip that the listener listens on.
@@ -1010,6 +1037,33 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &enableDateHeader(bool flag) = 0;
 
+    /// Enable tracing the stages of requests.
+    /**
+     * @param sampleRatio The ratio of requests that are traced, from 0 to 1.
+     * @param forceHeader Requests with this header are always traced. Set it
+     * to an empty string to trace sampled requests only.
+     *
+     * A traced request gets the trace id in its W3C traceparent header if
+     * there is one. The traces are passed to the exporter set by the
+     * setRequestTraceExporter() method after the responses are sent.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableRequestTracing(
+        double sampleRatio,
+        const std::string &forceHeader = "x-drogon-trace") = 0;
+
+    /// Set the function that exports the traces of requests.
+    /**
+     * @note
+     * The exporter is called in the IO threads, so it should not block. See
+     * newOtlpFileTraceExporter() and newOtlpHttpTraceExporter() for the
+     * built-in exporters.
+     */
+    virtual HttpAppFramework &setRequestTraceExporter(
+        const RequestTraceExporter &exporter) = 0;
+
     /// Set the maximum number of requests that can be served through one
     /// keep-alive connection.
     /**
@@ -1227,6 +1281,22 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual const std::pair<unsigned int, std::string>
         &getFloatPrecisionInJson() const noexcept = 0;
+
+    /**
+     * @brief Set the codec used to serialize and parse the JSON bodies of HTTP
+     * requests and responses.
+     *
+     * @note The default codec is a drogon::DefaultJsonCodec object created
+     * with the settings of the above methods.
+     * This method must be called before any JSON body is processed.
+     */
+    virtual HttpAppFramework &setJsonCodec(
+        const std::shared_ptr<JsonCodec> &codec) = 0;
+
+    /**
+     * @brief Get the codec of JSON bodies.
+     */
+    virtual const std::shared_ptr<JsonCodec> &getJsonCodec() const = 0;
     /// Create a database client
     /**
      * @param dbType The database type is one of
@@ -1244,6 +1314,15 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      * @param characterSet The character set of the database server.
      * @param timeout The timeout in seconds for executing SQL queries. zero or
      * negative value means no timeout.
+     * @param maxPendingQueries The maximum number of SQL queries waiting for
+     * idle connections, new queries fail immediately when it is reached. Zero
+     * means the default limit of the client.
+     * @param replicas The hosts and ports of the replica servers. Read-only
+     * select statements are sent to the replicas, other statements and
+     * transactions are sent to the server specified by @param host.
+     * @param maxReplicationLag Replicas lagging behind more than this number of
+     * seconds receive no queries until they catch up. Zero or negative value
+     * disables lag checks.
      *
      * @note
      * This operation can be performed by an option in the configuration file.
@@ -1260,7 +1339,11 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         const std::string &name = "default",
         const bool isFast = false,
         const std::string &characterSet = "",
-        double timeout = -1.0) = 0;
+        double timeout = -1.0,
+        size_t maxPendingQueries = 0,
+        const std::vector<std::pair<std::string, unsigned short>> &replicas =
+            {},
+        double maxReplicationLag = 0.0) = 0;
 
     /// Create a redis client
     /**
@@ -1336,6 +1419,45 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual bool reusePort() const = 0;
 
+    /**
+     * @brief Enable HTTP/2 on the listeners. A client that knows the server
+     * supports HTTP/2 starts the connection with the HTTP/2 connection
+     * preface instead of a HTTP/1.x request (RFC 7540 3.4, prior knowledge),
+     * other connections are served with HTTP/1.x as usual. On the HTTPS
+     * listeners, "h2" is also selected by ALPN for the clients offering it.
+     * The requests of a HTTP/2 connection are handled concurrently, each on
+     * its own stream. The feature is disabled by default.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The h2c upgrade from HTTP/1.1 is not supported.
+     */
+    virtual HttpAppFramework &enableHttp2(bool enable = true) = 0;
+
+    /**
+     * @brief Return if HTTP/2 is enabled.
+     */
+    virtual bool isHttp2Enabled() const = 0;
+
+    /**
+     * @brief Do the socket I/O of the HTTP listeners with io_uring instead of
+     * epoll. Each IO loop accepts the connections with a multishot accept
+     * request, receives the data into a ring of provided buffers, and sends
+     * the files by splice, so the busy connections need fewer system calls.
+     * The feature is disabled by default.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * It needs Linux 6.0 or later and a build with io_uring, epoll is used
+     * otherwise. The HTTPS listeners always use epoll.
+     */
+    virtual HttpAppFramework &enableIoUring(bool enable = true) = 0;
+
+    /**
+     * @brief Return if io_uring is enabled.
+     */
+    virtual bool isIoUringEnabled() const = 0;
+
     /**
      * @brief handler will be called upon an exception escapes a request handler
      */
@@ -22,10 +22,19 @@
 #include <drogon/DrObject.h>
 #include <drogon/utils/FunctionTraits.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/utils/string_view.h>
+#include <cctype>
 #include <deque>
+#include <limits>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
+#if __cplusplus >= 201703L || (defined _MSC_VER && _MSC_VER > 1900)
+#include <charconv>
+#define DROGON_HAS_FROM_CHARS 1
+#endif
 
 namespace drogon
 {
@@ -64,11 +73,111 @@ struct BinderArgTypeTraits<const T &>
     static const bool isValid = true;
 };
 
+// Skip leading white spaces and a plus sign as std::stol() does.
+inline string_view trimNumber(string_view p)
+{
+    size_t pos = 0;
+    while (pos < p.size() && isspace(static_cast<unsigned char>(p[pos])))
+        ++pos;
+    if (pos + 1 < p.size() && p[pos] == '+' && p[pos + 1] != '-')
+        ++pos;
+    return p.substr(pos);
+}
+
+#ifndef DROGON_HAS_FROM_CHARS
+template <typename T>
+T stringToInteger(const std::string &str, std::true_type /*isSigned*/)
+{
+    auto value = std::stoll(str);
+    if (value < static_cast<long long>((std::numeric_limits<T>::min)()) ||
+        value > static_cast<long long>((std::numeric_limits<T>::max)()))
+        throw std::out_of_range("Integer out of range: " + str);
+    return static_cast<T>(value);
+}
+
+template <typename T>
+T stringToInteger(const std::string &str, std::false_type /*isSigned*/)
+{
+    auto value = std::stoull(str);
+    if (value >
+        static_cast<unsigned long long>((std::numeric_limits<T>::max)()))
+        throw std::out_of_range("Integer out of range: " + str);
+    return static_cast<T>(value);
+}
+#endif
+
+#ifndef __cpp_lib_to_chars
+inline void stringToFloat(const std::string &str, float &value)
+{
+    value = std::stof(str);
+}
+
+inline void stringToFloat(const std::string &str, double &value)
+{
+    value = std::stod(str);
+}
+
+inline void stringToFloat(const std::string &str, long double &value)
+{
+    value = std::stold(str);
+}
+#endif
+
+/**
+ * @brief Convert a handler argument to a number without a std::stringstream.
+ * Like std::stol(), trailing characters are ignored and the
+ * std::invalid_argument or std::out_of_range exception is thrown on failure.
+ */
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, T>::type stringToNumber(
+    const string_view &p)
+{
+#ifdef DROGON_HAS_FROM_CHARS
+    auto str = trimNumber(p);
+    T value{};
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec == std::errc::invalid_argument)
+        throw std::invalid_argument("Invalid integer: " +
+                                    std::string(p.data(), p.size()));
+    if (result.ec == std::errc::result_out_of_range)
+        throw std::out_of_range("Integer out of range: " +
+                                std::string(p.data(), p.size()));
+    return value;
+#else
+    return stringToInteger<T>(std::string(p.data(), p.size()),
+                              std::is_signed<T>());
+#endif
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, T>::type
+stringToNumber(const string_view &p)
+{
+    T value{};
+#ifdef __cpp_lib_to_chars
+    auto str = trimNumber(p);
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec == std::errc::invalid_argument)
+        throw std::invalid_argument("Invalid number: " +
+                                    std::string(p.data(), p.size()));
+    if (result.ec == std::errc::result_out_of_range)
+        throw std::out_of_range("Number out of range: " +
+                                std::string(p.data(), p.size()));
+#else
+    stringToFloat(std::string(p.data(), p.size()), value);
+#endif
+    return value;
+}
+
 class HttpBinderBase
 {
   public:
+    /**
+     * @param pathArguments The arguments captured from the path and the query
+     * string, which refer to the request and are valid as long as it is.
+     */
     virtual void handleHttpRequest(
-        std::deque<std::string> &pathArguments,
+        const std::vector<string_view> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback) = 0;
     virtual size_t paramCount() = 0;
@@ -102,7 +211,7 @@ class HttpBinder : public HttpBinderBase
     using traits = FunctionTraits<FUNCTION>;
     using FunctionType = FUNCTION;
     void handleHttpRequest(
-        std::deque<std::string> &pathArguments,
+        const std::vector<string_view> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback) override
     {
@@ -178,71 +287,111 @@ class HttpBinder : public HttpBinderBase
                          yes>::value;
     };
 
+    // Numbers, strings and enums are converted without a std::stringstream,
+    // which is only used for other types.
     template <typename T>
     typename std::enable_if<CanConvertFromStringStream<T>::value, void>::type
-    getHandlerArgumentValue(T &value, std::string &&p)
+    getHandlerArgumentValue(T &value, const string_view &p)
     {
         if (!p.empty())
         {
-            std::stringstream ss(std::move(p));
+            std::stringstream ss(std::string(p.data(), p.size()));
             ss >> value;
         }
     }
 
     template <typename T>
-    typename std::enable_if<!(CanConvertFromStringStream<T>::value), void>::type
-    getHandlerArgumentValue(T &value, std::string &&p)
+    typename std::enable_if<std::is_enum<T>::value &&
+                                !(CanConvertFromStringStream<T>::value),
+                            void>::type
+    getHandlerArgumentValue(T &value, const string_view &p)
+    {
+        value = static_cast<T>(
+            stringToNumber<typename std::underlying_type<T>::type>(p));
+    }
+
+    template <typename T>
+    typename std::enable_if<!std::is_enum<T>::value &&
+                                !(CanConvertFromStringStream<T>::value),
+                            void>::type
+    getHandlerArgumentValue(T &, const string_view &)
+    {
+    }
+
+    void getHandlerArgumentValue(std::string &value, const string_view &p)
+    {
+        value.assign(p.data(), p.size());
+    }
+
+    void getHandlerArgumentValue(string_view &value, const string_view &p)
+    {
+        value = p;
+    }
+
+    void getHandlerArgumentValue(bool &value, const string_view &p)
+    {
+        value = (p == "1" || p == "true");
+    }
+
+    void getHandlerArgumentValue(short &value, const string_view &p)
+    {
+        value = stringToNumber<short>(p);
+    }
+
+    void getHandlerArgumentValue(unsigned short &value, const string_view &p)
     {
+        value = stringToNumber<unsigned short>(p);
     }
 
-    void getHandlerArgumentValue(std::string &value, std::string &&p)
+    void getHandlerArgumentValue(int &value, const string_view &p)
     {
-        value = std::move(p);
+        value = stringToNumber<int>(p);
     }
 
-    void getHandlerArgumentValue(int &value, std::string &&p)
+    void getHandlerArgumentValue(unsigned int &value, const string_view &p)
     {
-        value = std::stoi(p);
+        value = stringToNumber<unsigned int>(p);
     }
 
-    void getHandlerArgumentValue(long &value, std::string &&p)
+    void getHandlerArgumentValue(long &value, const string_view &p)
     {
-        value = std::stol(p);
+        value = stringToNumber<long>(p);
     }
 
-    void getHandlerArgumentValue(long long &value, std::string &&p)
+    void getHandlerArgumentValue(long long &value, const string_view &p)
     {
-        value = std::stoll(p);
+        value = stringToNumber<long long>(p);
     }
 
-    void getHandlerArgumentValue(unsigned long &value, std::string &&p)
+    void getHandlerArgumentValue(unsigned long &value, const string_view &p)
     {
-        value = std::stoul(p);
+        value = stringToNumber<unsigned long>(p);
     }
 
-    void getHandlerArgumentValue(unsigned long long &value, std::string &&p)
+    void getHandlerArgumentValue(unsigned long long &value,
+                                 const string_view &p)
     {
-        value = std::stoull(p);
+        value = stringToNumber<unsigned long long>(p);
     }
 
-    void getHandlerArgumentValue(float &value, std::string &&p)
+    void getHandlerArgumentValue(float &value, const string_view &p)
     {
-        value = std::stof(p);
+        value = stringToNumber<float>(p);
     }
 
-    void getHandlerArgumentValue(double &value, std::string &&p)
+    void getHandlerArgumentValue(double &value, const string_view &p)
     {
-        value = std::stod(p);
+        value = stringToNumber<double>(p);
     }
 
-    void getHandlerArgumentValue(long double &value, std::string &&p)
+    void getHandlerArgumentValue(long double &value, const string_view &p)
     {
-        value = std::stold(p);
+        value = stringToNumber<long double>(p);
     }
 
     template <typename... Values, std::size_t Boundary = argument_count>
     typename std::enable_if<(sizeof...(Values) < Boundary), void>::type run(
-        std::deque<std::string> &pathArguments,
+        const std::vector<string_view> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback,
         Values &&...values)
@@ -257,14 +406,13 @@ class HttpBinder : public HttpBinderBase
             typename std::remove_cv<typename std::remove_reference<
                 nth_argument_type<sizeof...(Values)>>::type>::type;
         ValueType value = ValueType();
-        if (!pathArguments.empty())
+        if (sizeof...(Values) < pathArguments.size())
         {
-            std::string v = std::move(pathArguments.front());
-            pathArguments.pop_front();
+            auto &v = pathArguments[sizeof...(Values)];
             try
             {
                 if (v.empty() == false)
-                    getHandlerArgumentValue(value, std::move(v));
+                    getHandlerArgumentValue(value, v);
             }
             catch (const std::exception &e)
             {
@@ -301,7 +449,7 @@ class HttpBinder : public HttpBinderBase
               bool isCoroutine = traits::isCoroutine>
     typename std::enable_if<(sizeof...(Values) == Boundary) && !isCoroutine,
                             void>::type
-    run(std::deque<std::string> &,
+    run(const std::vector<string_view> &,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback,
         Values &&...values)
@@ -328,7 +476,7 @@ class HttpBinder : public HttpBinderBase
               bool isCoroutine = traits::isCoroutine>
     typename std::enable_if<(sizeof...(Values) == Boundary) && isCoroutine,
                             void>::type
-    run(std::deque<std::string> &,
+    run(const std::vector<string_view> &,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback,
         Values &&...values)
@@ -169,6 +169,33 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
      */
     virtual void setPipeliningDepth(size_t depth) = 0;
 
+    /// Enable HTTP/2 for the client
+    /**
+     * The requests are multiplexed on one connection. Over TLS, HTTP/2 is
+     * used if the server selects "h2" by ALPN. Over TCP, the connection is
+     * opened with the connection preface of HTTP/2 directly (prior knowledge,
+     * rfc7540-3.4), and if the server answers it with HTTP/1.x, the client
+     * falls back to HTTP/1.1 and resends the requests. The pipelining depth
+     * applies to the connections of HTTP/1.1. It's disabled by default.
+     */
+    virtual void enableHttp2(bool flag = true) = 0;
+
+    /// Connect to the server ahead of the first request
+    /**
+     * The name resolution, the connection and the TLS handshake are done
+     * now, so the first request doesn't wait for them. The callback, if any,
+     * is called with `ReqResult::Ok` when the connection is established, or
+     * with the error otherwise.
+     *
+     * @note
+     * A client keeps one connection, so warm up N clients to have N
+     * connections ready. The TLS sessions are cached per origin in the
+     * process, and every new connection (of any client or after a
+     * reconnection) resumes the session of a previous one if the server
+     * allows it, which makes it much cheaper than the first handshake.
+     */
+    virtual void warmUp(std::function<void(ReqResult)> callback = nullptr) = 0;
+
     /// Enable cookies for the client
     /**
      * @param flag if the parameter is true, all requests sent by the client
@@ -18,6 +18,7 @@
 #include <drogon/utils/string_view.h>
 #include <drogon/DrClassMap.h>
 #include <drogon/HttpTypes.h>
+#include <drogon/JsonTraits.h>
 #include <drogon/Session.h>
 #include <drogon/Attribute.h>
 #include <drogon/UploadFile.h>
@@ -227,6 +228,7 @@ class DROGON_EXPORT HttpRequest
     /**
      * kHttp10 means Http version is 1.0
      * kHttp11 means Http verison is 1.1
+     * kHttp2 means Http version is 2
      */
     virtual Version version() const = 0;
 
@@ -303,6 +305,36 @@ class DROGON_EXPORT HttpRequest
         return jsonObject();
     }
 
+    /**
+     * @brief Read an object from the JSON body with the typed JSON
+     * serialization (see JsonTraits.h).
+     *
+     * @param errs The error message when the body can't be read.
+     * @return An empty shared_ptr object if the content type of the request is
+     * not 'application/json' or the body can't be read.
+     */
+    template <typename T>
+    std::shared_ptr<T> getJsonObject(std::string *errs = nullptr) const
+    {
+        if (contentType() != CT_APPLICATION_JSON &&
+            getHeader("content-type").find("application/json") ==
+                std::string::npos)
+        {
+            if (errs)
+                *errs = "content type error";
+            return nullptr;
+        }
+        auto obj = std::make_shared<T>();
+        std::string err;
+        if (!readJson(body(), *obj, err))
+        {
+            if (errs)
+                *errs = std::move(err);
+            return nullptr;
+        }
+        return obj;
+    }
+
     /**
      * @brief Get the error message of parsing the JSON body received from peer.
      * This method usually is called after getting a empty shared_ptr object
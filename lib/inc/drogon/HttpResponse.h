@@ -19,9 +19,11 @@
 #include <drogon/Cookie.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/JsonTraits.h>
 #include <json/json.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace drogon
 {
@@ -258,6 +260,7 @@ class DROGON_EXPORT HttpResponse
     /**
      * kHttp10 means Http version is 1.0
      * kHttp11 means Http verison is 1.1
+     * kHttp2 means Http version is 2
      */
     virtual Version version() const = 0;
 
@@ -291,6 +294,27 @@ class DROGON_EXPORT HttpResponse
         return jsonObject();
     }
 
+    /**
+     * @brief Read an object from the JSON body with the typed JSON
+     * serialization (see JsonTraits.h).
+     *
+     * @param errs The error message when the body can't be read.
+     * @return An empty shared_ptr object if the body can't be read.
+     */
+    template <typename T>
+    std::shared_ptr<T> getJsonObject(std::string *errs = nullptr) const
+    {
+        auto obj = std::make_shared<T>();
+        std::string err;
+        if (!readJson(body(), *obj, err))
+        {
+            if (errs)
+                *errs = std::move(err);
+            return nullptr;
+        }
+        return obj;
+    }
+
     /**
      * @brief Get the error message of parsing the JSON body received from peer.
      * This method usually is called after getting a empty shared_ptr object
@@ -324,6 +348,23 @@ class DROGON_EXPORT HttpResponse
     /// to set/json.
     static HttpResponsePtr newHttpJsonResponse(const Json::Value &data);
     static HttpResponsePtr newHttpJsonResponse(Json::Value &&data);
+    /**
+     * @brief Create a response with the JSON body written straight from the
+     * object, whose type is supported by the typed JSON serialization (see
+     * JsonTraits.h), without building a Json::Value.
+     */
+    template <typename T,
+              typename = typename std::enable_if<
+                  !std::is_convertible<const T &, Json::Value>::value>::type>
+    static HttpResponsePtr newHttpJsonResponse(const T &obj)
+    {
+        std::string body;
+        writeJson(obj, body);
+        auto resp = newHttpResponse();
+        resp->setContentTypeCode(CT_APPLICATION_JSON);
+        resp->setBody(std::move(body));
+        return resp;
+    }
     /// Create a response that returns a page rendered by a view named
     /// viewName.
     /**
@@ -335,6 +376,22 @@ class DROGON_EXPORT HttpResponse
         const std::string &viewName,
         const HttpViewData &data = HttpViewData());
 
+    /// Create a response that returns a page rendered by a view named
+    /// viewName, the page is cached by the ViewCache.
+    /**
+     * @param viewName The name of the view
+     * @param data is the data displayed on the page.
+     * @param keys The keys of the items in the data that the page depends on,
+     * see ViewCache for details.
+     * @param timeout The number of seconds the page is cached for, 0 means
+     * the page never expires.
+     */
+    static HttpResponsePtr newHttpViewResponse(
+        const std::string &viewName,
+        const HttpViewData &data,
+        const std::vector<std::string> &keys,
+        double timeout);
+
     /// Create a response that returns a redirection page, redirecting to
     /// another page located in the location parameter.
     /**
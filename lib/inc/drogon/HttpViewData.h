@@ -53,6 +53,24 @@ class DROGON_EXPORT HttpViewData
         return nullVal;
     }
 
+    /// Get an item that is a std::string or a const char * as a string view,
+    /// an empty string view is returned for items of other types.
+    string_view getStringView(const std::string &key) const
+    {
+        auto it = viewData_.find(key);
+        if (it == viewData_.end())
+            return string_view();
+        auto &val = it->second;
+        if (val.type() == typeid(std::string))
+            return *any_cast<std::string>(&val);
+        if (val.type() == typeid(const char *))
+        {
+            auto str = *any_cast<const char *>(&val);
+            return str ? string_view(str) : string_view();
+        }
+        return string_view();
+    }
+
     /// Insert an item identified by the key parameter into the data set;
     void insert(const std::string &key, any &&obj)
     {
@@ -131,6 +149,16 @@ class DROGON_EXPORT HttpViewData
         return viewData_[key];
     }
 
+    /// Get the 'any' object by the key parameter, nullptr is returned if the
+    /// key doesn't exist.
+    const any *find(const std::string &key) const
+    {
+        auto it = viewData_.find(key);
+        if (it == viewData_.end())
+            return nullptr;
+        return &it->second;
+    }
+
     /// Translate some special characters to HTML format
     /**
      * such as:
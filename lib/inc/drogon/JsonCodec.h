@@ -0,0 +1,99 @@
+/**
+ *
+ *  @file JsonCodec.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <json/json.h>
+#include <stdint.h>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief The interface used by the framework to serialize and parse the JSON
+ * bodies of HTTP requests and responses. Set a custom codec by the
+ * HttpAppFramework::setJsonCodec() method to use another JSON library.
+ *
+ * @note The methods are called concurrently in all IO threads, so they must be
+ * thread-safe.
+ */
+class DROGON_EXPORT JsonCodec
+{
+  public:
+    virtual ~JsonCodec() = default;
+
+    /**
+     * @brief Serialize the value to a compact JSON string.
+     *
+     * @param value The value to be serialized.
+     * @param output The string that the JSON text is appended to.
+     */
+    virtual void serialize(const Json::Value &value, std::string &output) = 0;
+
+    /**
+     * @brief Parse the JSON text in [begin, end).
+     *
+     * @param value The parsed value.
+     * @param errs The error message when parsing fails.
+     * @return true if the text is parsed successfully.
+     */
+    virtual bool parse(const char *begin,
+                       const char *end,
+                       Json::Value &value,
+                       std::string &errs) = 0;
+};
+
+/**
+ * @brief The built-in codec. The writer appends the JSON text directly to the
+ * output without a std::ostringstream, and its output is the same as that of
+ * the compact Json::StreamWriter. The parser reuses one Json::CharReader per
+ * thread.
+ */
+class DROGON_EXPORT DefaultJsonCodec : public JsonCodec
+{
+  public:
+    /**
+     * @param escapeUnicode Escape non-ASCII characters as \uXXXX.
+     * @param precision The float precision, 0 means 17 significant digits.
+     * @param precisionType "significant" or "decimal", see the
+     * HttpAppFramework::setFloatPrecisionInJson() method.
+     */
+    explicit DefaultJsonCodec(
+        bool escapeUnicode = true,
+        unsigned int precision = 0,
+        const std::string &precisionType = "significant");
+    void serialize(const Json::Value &value, std::string &output) override;
+    bool parse(const char *begin,
+               const char *end,
+               Json::Value &value,
+               std::string &errs) override;
+
+    // The following methods append JSON text to the output and are also used
+    // by the typed serialization, see JsonTraits.h.
+    void writeValue(const Json::Value &value, std::string &output) const;
+    void writeString(const char *begin,
+                     const char *end,
+                     std::string &output) const;
+    void writeDouble(double value, std::string &output) const;
+    static void writeInt(int64_t value, std::string &output);
+    static void writeUInt(uint64_t value, std::string &output);
+
+  private:
+    bool escapeUnicode_;
+    unsigned int precision_;
+    bool decimalPlaces_;
+};
+
+}  // namespace drogon
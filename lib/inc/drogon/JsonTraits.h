@@ -0,0 +1,638 @@
+/**
+ *
+ *  @file JsonTraits.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/JsonCodec.h>
+#include <drogon/utils/optional.h>
+#include <drogon/utils/string_view.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Date.h>
+#include <json/json.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * The typed JSON serialization writes objects straight to JSON text and reads
+ * them back without building a Json::Value tree. The fields of a type are
+ * described by specializing the drogon::JsonFields template, for example:
+ * @code
+   struct User
+   {
+       std::string name;
+       int age{0};
+       std::vector<std::string> tags;
+   };
+   namespace drogon
+   {
+   template <>
+   struct JsonFields<User>
+   {
+       static auto fields()
+       {
+           return std::make_tuple(DROGON_JSON_FIELD(User, name),
+                                  DROGON_JSON_FIELD(User, age),
+                                  DROGON_JSON_FIELD(User, tags));
+       }
+   };
+   }  // namespace drogon
+
+   auto resp = HttpResponse::newHttpJsonResponse(user);
+   auto userPtr = req->getJsonObject<User>();
+   @endcode
+ * Besides types with fields, numbers, strings, enums, bool, trantor::Date,
+ * Json::Value, std::vector, std::map and std::unordered_map with string keys,
+ * std::shared_ptr and drogon::optional are supported. Empty pointers and
+ * optionals are null. A std::vector<char> is a base64 string as the blob
+ * columns of ORM models.
+ */
+#define DROGON_JSON_FIELD(Class, member) \
+    ::drogon::makeJsonField(#member, &Class::member)
+
+namespace drogon
+{
+/**
+ * @brief Specialize the template with a static fields() method returning a
+ * tuple of fields made by makeJsonField() to serialize a type to JSON.
+ */
+template <typename T>
+struct JsonFields
+{
+};
+
+/**
+ * @brief The reader of JSON text used by the typed deserialization. All
+ * methods throw a std::runtime_error with the position on a syntax error.
+ */
+class DROGON_EXPORT JsonReader
+{
+  public:
+    JsonReader(const char *begin, const char *end)
+        : begin_(begin), pos_(begin), end_(end)
+    {
+    }
+    /// Skip white spaces and return the next character, or 0 at the end.
+    char peek();
+    /// Consume the next character if it is c.
+    bool consume(char c);
+    void expect(char c);
+    /// Consume a null if the next value is null.
+    bool readNull();
+    bool readBool();
+    void readString(std::string &str);
+    int64_t readInt();
+    uint64_t readUInt();
+    double readDouble();
+    void readValue(Json::Value &value);
+    void skipValue();
+    /// Check that nothing but white spaces is left.
+    void finish();
+    /// Enter an object or an array, the nesting depth is limited.
+    void enter();
+    void leave()
+    {
+        --depth_;
+    }
+    [[noreturn]] void fail(const char *message) const;
+
+  private:
+    const char *begin_;
+    const char *pos_;
+    const char *end_;
+    size_t depth_{0};
+};
+
+template <typename T, typename Enable = void>
+struct JsonSerializer;
+
+template <typename Class, typename Member>
+struct JsonMemberField
+{
+    const char *name_;
+    Member Class::*member_;
+    const Member &get(const Class &obj) const
+    {
+        return obj.*member_;
+    }
+    void read(JsonReader &reader, Class &obj) const
+    {
+        JsonSerializer<Member>::read(reader, obj.*member_);
+    }
+};
+
+template <typename Getter, typename Setter>
+struct JsonAccessorField
+{
+    const char *name_;
+    Getter getter_;
+    Setter setter_;
+    template <typename Class>
+    decltype(auto) get(const Class &obj) const
+    {
+        return getter_(obj);
+    }
+    template <typename Class>
+    void read(JsonReader &reader, Class &obj) const
+    {
+        using ValueType =
+            typename std::decay<decltype(getter_(std::declval<Class &>()))>::
+                type;
+        ValueType value{};
+        JsonSerializer<ValueType>::read(reader, value);
+        setter_(obj, std::move(value));
+    }
+};
+
+/// Make a field of a data member.
+template <typename Class, typename Member>
+constexpr JsonMemberField<Class, Member> makeJsonField(const char *name,
+                                                       Member Class::*member)
+{
+    return {name, member};
+}
+
+/**
+ * @brief Make a field accessed by a getter that takes the object and a setter
+ * that takes the object and the value.
+ */
+template <typename Getter, typename Setter>
+constexpr JsonAccessorField<Getter, Setter> makeJsonField(const char *name,
+                                                          Getter getter,
+                                                          Setter setter)
+{
+    return {name, getter, setter};
+}
+
+namespace internal
+{
+/// The codec created with the JSON settings of the application.
+DROGON_EXPORT const DefaultJsonCodec &getDefaultJsonCodec();
+
+template <typename T>
+struct HasJsonFields
+{
+  private:
+    template <typename U>
+    static auto test(U *)
+        -> decltype(JsonFields<U>::fields(), std::true_type());
+    template <typename>
+    static std::false_type test(...);
+
+  public:
+    static constexpr bool value = decltype(test<T>(nullptr))::value;
+};
+
+template <typename Tuple, typename Function, size_t... Indexes>
+void forEachField(const Tuple &fields,
+                  Function &&function,
+                  std::index_sequence<Indexes...>)
+{
+    (void)std::initializer_list<int>{
+        (function(std::get<Indexes>(fields)), 0)...};
+}
+
+template <typename Tuple, typename Function>
+void forEachField(const Tuple &fields, Function &&function)
+{
+    forEachField(fields,
+                 std::forward<Function>(function),
+                 std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+}  // namespace internal
+
+/// Types with fields are JSON objects.
+template <typename T, typename Enable>
+struct JsonSerializer
+{
+    static_assert(internal::HasJsonFields<T>::value,
+                  "Specialize drogon::JsonFields to serialize the type");
+    static void write(const DefaultJsonCodec &codec,
+                      const T &obj,
+                      std::string &output)
+    {
+        output.push_back('{');
+        bool first = true;
+        internal::forEachField(
+            JsonFields<T>::fields(), [&](const auto &field) {
+                if (!first)
+                    output.push_back(',');
+                first = false;
+                codec.writeString(field.name_,
+                                  field.name_ + strlen(field.name_),
+                                  output);
+                output.push_back(':');
+                using FieldType =
+                    typename std::decay<decltype(field.get(obj))>::type;
+                JsonSerializer<FieldType>::write(codec, field.get(obj), output);
+            });
+        output.push_back('}');
+    }
+    static void read(JsonReader &reader, T &obj)
+    {
+        reader.expect('{');
+        reader.enter();
+        auto fields = JsonFields<T>::fields();
+        std::string name;
+        if (!reader.consume('}'))
+        {
+            do
+            {
+                reader.readString(name);
+                reader.expect(':');
+                bool found = false;
+                internal::forEachField(fields, [&](const auto &field) {
+                    if (!found && name == field.name_)
+                    {
+                        found = true;
+                        field.read(reader, obj);
+                    }
+                });
+                // Unknown members are ignored.
+                if (!found)
+                    reader.skipValue();
+            } while (reader.consume(','));
+            reader.expect('}');
+        }
+        reader.leave();
+    }
+};
+
+template <>
+struct JsonSerializer<bool>
+{
+    static void write(const DefaultJsonCodec &,
+                      bool value,
+                      std::string &output)
+    {
+        if (value)
+            output.append("true", 4);
+        else
+            output.append("false", 5);
+    }
+    static void read(JsonReader &reader, bool &value)
+    {
+        value = reader.readBool();
+    }
+};
+
+template <typename T>
+struct JsonSerializer<
+    T,
+    typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_same<T, bool>::value>::type>
+{
+    static void write(const DefaultJsonCodec &, T value, std::string &output)
+    {
+        if (std::is_signed<T>::value)
+            DefaultJsonCodec::writeInt(static_cast<int64_t>(value), output);
+        else
+            DefaultJsonCodec::writeUInt(static_cast<uint64_t>(value), output);
+    }
+    static void read(JsonReader &reader, T &value)
+    {
+        if (std::is_signed<T>::value)
+        {
+            auto v = reader.readInt();
+            if (v < static_cast<int64_t>((std::numeric_limits<T>::min)()) ||
+                v > static_cast<int64_t>((std::numeric_limits<T>::max)()))
+                reader.fail("Integer out of range");
+            value = static_cast<T>(v);
+        }
+        else
+        {
+            auto v = reader.readUInt();
+            if (v > static_cast<uint64_t>((std::numeric_limits<T>::max)()))
+                reader.fail("Integer out of range");
+            value = static_cast<T>(v);
+        }
+    }
+};
+
+template <typename T>
+struct JsonSerializer<T, typename std::enable_if<std::is_enum<T>::value>::type>
+{
+    using UnderlyingType = typename std::underlying_type<T>::type;
+    static void write(const DefaultJsonCodec &codec,
+                      T value,
+                      std::string &output)
+    {
+        JsonSerializer<UnderlyingType>::write(
+            codec, static_cast<UnderlyingType>(value), output);
+    }
+    static void read(JsonReader &reader, T &value)
+    {
+        UnderlyingType v{};
+        JsonSerializer<UnderlyingType>::read(reader, v);
+        value = static_cast<T>(v);
+    }
+};
+
+template <typename T>
+struct JsonSerializer<
+    T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      T value,
+                      std::string &output)
+    {
+        codec.writeDouble(static_cast<double>(value), output);
+    }
+    static void read(JsonReader &reader, T &value)
+    {
+        value = static_cast<T>(reader.readDouble());
+    }
+};
+
+template <>
+struct JsonSerializer<std::string>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const std::string &value,
+                      std::string &output)
+    {
+        codec.writeString(value.data(), value.data() + value.size(), output);
+    }
+    static void read(JsonReader &reader, std::string &value)
+    {
+        reader.readString(value);
+    }
+};
+
+/// string_view and C strings can only be written.
+template <>
+struct JsonSerializer<string_view>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const string_view &value,
+                      std::string &output)
+    {
+        codec.writeString(value.data(), value.data() + value.size(), output);
+    }
+};
+
+template <>
+struct JsonSerializer<const char *>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const char *value,
+                      std::string &output)
+    {
+        if (!value)
+            output.append("null", 4);
+        else
+            codec.writeString(value, value + strlen(value), output);
+    }
+};
+
+template <>
+struct JsonSerializer<Json::Value>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const Json::Value &value,
+                      std::string &output)
+    {
+        codec.writeValue(value, output);
+    }
+    static void read(JsonReader &reader, Json::Value &value)
+    {
+        reader.readValue(value);
+    }
+};
+
+/// The same format as the date and time columns of ORM models.
+template <>
+struct JsonSerializer<trantor::Date>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const trantor::Date &value,
+                      std::string &output)
+    {
+        JsonSerializer<std::string>::write(codec,
+                                           value.toDbStringLocal(),
+                                           output);
+    }
+    static void read(JsonReader &reader, trantor::Date &value)
+    {
+        std::string str;
+        reader.readString(str);
+        value = trantor::Date::fromDbStringLocal(str);
+    }
+};
+
+template <>
+struct JsonSerializer<std::vector<char>>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const std::vector<char> &value,
+                      std::string &output)
+    {
+        JsonSerializer<std::string>::write(
+            codec,
+            utils::base64Encode(
+                reinterpret_cast<const unsigned char *>(value.data()),
+                static_cast<unsigned int>(value.size())),
+            output);
+    }
+    static void read(JsonReader &reader, std::vector<char> &value)
+    {
+        std::string str;
+        reader.readString(str);
+        value = utils::base64DecodeToVector(str);
+    }
+};
+
+template <typename T>
+struct JsonSerializer<std::vector<T>>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const std::vector<T> &value,
+                      std::string &output)
+    {
+        output.push_back('[');
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            if (i > 0)
+                output.push_back(',');
+            JsonSerializer<T>::write(codec, value[i], output);
+        }
+        output.push_back(']');
+    }
+    static void read(JsonReader &reader, std::vector<T> &value)
+    {
+        value.clear();
+        reader.expect('[');
+        reader.enter();
+        if (!reader.consume(']'))
+        {
+            do
+            {
+                value.emplace_back();
+                JsonSerializer<T>::read(reader, value.back());
+            } while (reader.consume(','));
+            reader.expect(']');
+        }
+        reader.leave();
+    }
+};
+
+namespace internal
+{
+template <typename Map>
+struct JsonMapSerializer
+{
+    using ValueType = typename Map::mapped_type;
+    static void write(const DefaultJsonCodec &codec,
+                      const Map &value,
+                      std::string &output)
+    {
+        output.push_back('{');
+        bool first = true;
+        for (auto &pair : value)
+        {
+            if (!first)
+                output.push_back(',');
+            first = false;
+            JsonSerializer<std::string>::write(codec, pair.first, output);
+            output.push_back(':');
+            JsonSerializer<ValueType>::write(codec, pair.second, output);
+        }
+        output.push_back('}');
+    }
+    static void read(JsonReader &reader, Map &value)
+    {
+        value.clear();
+        reader.expect('{');
+        reader.enter();
+        if (!reader.consume('}'))
+        {
+            std::string name;
+            do
+            {
+                reader.readString(name);
+                reader.expect(':');
+                JsonSerializer<ValueType>::read(reader, value[name]);
+            } while (reader.consume(','));
+            reader.expect('}');
+        }
+        reader.leave();
+    }
+};
+}  // namespace internal
+
+template <typename T>
+struct JsonSerializer<std::map<std::string, T>>
+    : internal::JsonMapSerializer<std::map<std::string, T>>
+{
+};
+
+template <typename T>
+struct JsonSerializer<std::unordered_map<std::string, T>>
+    : internal::JsonMapSerializer<std::unordered_map<std::string, T>>
+{
+};
+
+template <typename T>
+struct JsonSerializer<std::shared_ptr<T>>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const std::shared_ptr<T> &value,
+                      std::string &output)
+    {
+        if (value)
+            JsonSerializer<T>::write(codec, *value, output);
+        else
+            output.append("null", 4);
+    }
+    static void read(JsonReader &reader, std::shared_ptr<T> &value)
+    {
+        if (reader.readNull())
+        {
+            value.reset();
+            return;
+        }
+        value = std::make_shared<T>();
+        JsonSerializer<T>::read(reader, *value);
+    }
+};
+
+template <typename T>
+struct JsonSerializer<optional<T>>
+{
+    static void write(const DefaultJsonCodec &codec,
+                      const optional<T> &value,
+                      std::string &output)
+    {
+        if (value)
+            JsonSerializer<T>::write(codec, *value, output);
+        else
+            output.append("null", 4);
+    }
+    static void read(JsonReader &reader, optional<T> &value)
+    {
+        if (reader.readNull())
+        {
+            value = optional<T>();
+            return;
+        }
+        T v{};
+        JsonSerializer<T>::read(reader, v);
+        value = std::move(v);
+    }
+};
+
+/**
+ * @brief Append the JSON text of the object to the output. The settings of
+ * unicode escaping and float precision of the application are used.
+ */
+template <typename T>
+void writeJson(const T &obj, std::string &output)
+{
+    JsonSerializer<T>::write(internal::getDefaultJsonCodec(), obj, output);
+}
+
+/**
+ * @brief Read the object from the JSON text.
+ *
+ * @param errs The error message when the text can't be read.
+ * @return true if the object is read successfully.
+ */
+template <typename T>
+bool readJson(const string_view &text, T &obj, std::string &errs)
+{
+    JsonReader reader(text.data(), text.data() + text.size());
+    try
+    {
+        JsonSerializer<T>::read(reader, obj);
+        reader.finish();
+    }
+    catch (const std::exception &e)
+    {
+        errs = e.what();
+        return false;
+    }
+    return true;
+}
+
+}  // namespace drogon
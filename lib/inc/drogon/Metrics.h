@@ -0,0 +1,292 @@
+/**
+ *
+ *  @file Metrics.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Metrics in the data model of Prometheus. Metrics are registered in
+ * the Registry and exposed in the Prometheus text format by the PromExporter
+ * plugin, for example:
+ * @code
+   auto &requests = drogon::metrics::Registry::instance()
+                        .counter("app_logins_total", "Logins", {"result"})
+                        .get({"ok"});
+   requests.increment();
+   @endcode
+ *
+ * The value of a metric is split into shards that are updated by different
+ * threads with relaxed atomic operations, so updating a metric takes no lock
+ * and threads don't contend for the same cache line. The shards are summed
+ * when the metrics are scraped.
+ */
+namespace metrics
+{
+namespace internal
+{
+/// The number of shards of every metric.
+constexpr size_t kShardsNumber = 16;
+
+/// The shard updated by the current thread.
+DROGON_EXPORT size_t shardIndex();
+
+inline void atomicAdd(std::atomic<double> &target, double value)
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current,
+                                         current + value,
+                                         std::memory_order_relaxed))
+    {
+    }
+}
+}  // namespace internal
+
+/// A value that only increases, e.g. the number of handled requests.
+class DROGON_EXPORT Counter : public trantor::NonCopyable
+{
+  public:
+    void increment(uint64_t value = 1)
+    {
+        shards_[internal::shardIndex()].value.fetch_add(
+            value, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+    void render(std::string &output,
+                const std::string &name,
+                const std::string &labels) const;
+
+  private:
+    struct Shard
+    {
+        std::atomic<uint64_t> value{0};
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    Shard shards_[internal::kShardsNumber];
+};
+
+/// A value that goes up and down, e.g. the number of connections.
+class DROGON_EXPORT Gauge : public trantor::NonCopyable
+{
+  public:
+    void increment(double value = 1)
+    {
+        internal::atomicAdd(shards_[internal::shardIndex()].value, value);
+    }
+    void decrement(double value = 1)
+    {
+        increment(-value);
+    }
+    /// Set the value, it races with increments in other threads.
+    void set(double value);
+    double value() const;
+    void render(std::string &output,
+                const std::string &name,
+                const std::string &labels) const;
+
+  private:
+    struct Shard
+    {
+        std::atomic<double> value{0};
+        char padding[64 - sizeof(std::atomic<double>)];
+    };
+    Shard shards_[internal::kShardsNumber];
+};
+
+/// The distribution of observed values, e.g. the latencies of requests.
+class DROGON_EXPORT Histogram : public trantor::NonCopyable
+{
+  public:
+    /// @param bounds The ascending upper bounds of the buckets.
+    explicit Histogram(const std::vector<double> &bounds);
+    void observe(double value);
+    /// The number of observed values not greater than each bound, plus the
+    /// total count.
+    std::vector<uint64_t> cumulativeCounts() const;
+    double sum() const;
+    void render(std::string &output,
+                const std::string &name,
+                const std::string &labels) const;
+
+  private:
+    std::vector<double> bounds_;
+    // The count of each bucket and of +Inf in all shards, a shard uses
+    // stride_ counters.
+    size_t stride_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    struct SumShard
+    {
+        std::atomic<double> value{0};
+        char padding[64 - sizeof(std::atomic<double>)];
+    };
+    SumShard sums_[internal::kShardsNumber];
+};
+
+class DROGON_EXPORT FamilyBase : public trantor::NonCopyable
+{
+  public:
+    FamilyBase(std::string name,
+               std::string help,
+               std::string type,
+               std::vector<std::string> labelNames)
+        : name_(std::move(name)),
+          help_(std::move(help)),
+          type_(std::move(type)),
+          labelNames_(std::move(labelNames))
+    {
+    }
+    virtual ~FamilyBase() = default;
+    const std::string &name() const
+    {
+        return name_;
+    }
+    const std::string &type() const
+    {
+        return type_;
+    }
+    /// Append the metrics in the Prometheus text format.
+    void render(std::string &output) const;
+
+  protected:
+    virtual void renderMetrics(std::string &output) const = 0;
+    /// Format the labels as name1="value1",name2="value2".
+    std::string formatLabels(const std::vector<std::string> &values) const;
+
+    std::string name_;
+    std::string help_;
+    std::string type_;
+    std::vector<std::string> labelNames_;
+};
+
+/**
+ * @brief Metrics of the same name with different label values. The metrics
+ * are never removed, so the reference returned by get() can be kept to avoid
+ * looking up the metric each time.
+ */
+template <typename MetricType>
+class Family : public FamilyBase
+{
+  public:
+    Family(std::string name,
+           std::string help,
+           std::string type,
+           std::vector<std::string> labelNames,
+           std::function<std::unique_ptr<MetricType>()> factory)
+        : FamilyBase(std::move(name),
+                     std::move(help),
+                     std::move(type),
+                     std::move(labelNames)),
+          factory_(std::move(factory))
+    {
+    }
+    MetricType &get(const std::vector<std::string> &labelValues = {})
+    {
+        if (labelValues.size() != labelNames_.size())
+            throw std::invalid_argument("Wrong number of labels of " + name_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = metrics_.find(labelValues);
+        if (iter != metrics_.end())
+            return *iter->second.second;
+        auto &value = metrics_[labelValues];
+        value.first = formatLabels(labelValues);
+        value.second = factory_();
+        return *value.second;
+    }
+
+  protected:
+    void renderMetrics(std::string &output) const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &metric : metrics_)
+        {
+            metric.second.second->render(output, name_, metric.second.first);
+        }
+    }
+
+  private:
+    std::function<std::unique_ptr<MetricType>()> factory_;
+    mutable std::mutex mutex_;
+    // Label values -> (formatted labels, metric)
+    std::map<std::vector<std::string>,
+             std::pair<std::string, std::unique_ptr<MetricType>>>
+        metrics_;
+};
+
+/// The registry of all metrics.
+class DROGON_EXPORT Registry : public trantor::NonCopyable
+{
+  public:
+    static Registry &instance();
+
+    /**
+     * @brief Get the family of counters of the name, it is created if it
+     * doesn't exist.
+     *
+     * @throw std::invalid_argument if a metric of another type has the name.
+     */
+    Family<Counter> &counter(const std::string &name,
+                             const std::string &help,
+                             const std::vector<std::string> &labelNames = {});
+    Family<Gauge> &gauge(const std::string &name,
+                         const std::string &help,
+                         const std::vector<std::string> &labelNames = {});
+    Family<Histogram> &histogram(
+        const std::string &name,
+        const std::string &help,
+        const std::vector<std::string> &labelNames = {},
+        const std::vector<double> &bounds = defaultBounds());
+
+    /// The default bounds of histogram buckets, in seconds.
+    static const std::vector<double> &defaultBounds();
+
+    /// Append all metrics in the Prometheus text format.
+    void render(std::string &output) const;
+
+    /**
+     * @brief Enable the metrics of HTTP requests, connections, database
+     * clients and redis clients collected by the framework. It should be
+     * called before the application runs, the PromExporter plugin calls it
+     * when it is initialized.
+     */
+    void enableBuiltinMetrics();
+
+  private:
+    Registry() = default;
+    template <typename MetricType>
+    Family<MetricType> &getFamily(
+        const std::string &name,
+        const std::string &help,
+        const char *type,
+        const std::vector<std::string> &labelNames,
+        std::function<std::unique_ptr<MetricType>()> &&factory);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<FamilyBase>> families_;
+    std::once_flag builtinFlag_;
+};
+
+}  // namespace metrics
+}  // namespace drogon
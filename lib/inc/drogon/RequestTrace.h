@@ -0,0 +1,170 @@
+/**
+ *
+ *  @file RequestTrace.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <json/json.h>
+#include <trantor/utils/Date.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief The timestamps of the stages a traced request goes through. Requests
+ * are traced when tracing is enabled by
+ * HttpAppFramework::enableRequestTracing(), the traces are passed to the
+ * exporter set by HttpAppFramework::setRequestTraceExporter() after the
+ * responses are sent.
+ *
+ * A stage the request skips, e.g. filtering when the handler has no filters,
+ * has no timestamp. The time spent in a stage is the time from its timestamp
+ * to the next recorded one.
+ */
+class DROGON_EXPORT RequestTrace
+{
+  public:
+    enum Stage
+    {
+        /// The request is parsed, the synchronous advices are called.
+        kParsed = 0,
+        /// The pre-routing advices are called.
+        kPreRouting,
+        /// The handler of the request is looked up.
+        kRouting,
+        /// The filters of the handler are called.
+        kFiltering,
+        /// The pre-handling advices are called.
+        kPreHandling,
+        /// The handler is called.
+        kHandling,
+        /// The handler returns a response, the post-handling advices are
+        /// called.
+        kHandled,
+        /// The pre-sending advices are called and the response is compressed.
+        kResponding,
+        /// The response is passed to the connection, or queued after the
+        /// responses of earlier pipelined requests.
+        kSent,
+        kStagesNumber
+    };
+
+    RequestTrace();
+
+    void mark(Stage stage)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        timestamps_[stage] =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count() +
+            1;
+    }
+    bool reached(Stage stage) const
+    {
+        return timestamps_[stage] != 0;
+    }
+    /// The nanoseconds from the time the request was parsed to the stage, or
+    /// -1 if the request didn't go through the stage.
+    int64_t elapsed(Stage stage) const
+    {
+        return timestamps_[stage] - 1;
+    }
+    /// The wall-clock time when the request was parsed.
+    const trantor::Date &startDate() const
+    {
+        return startDate_;
+    }
+    /// The W3C trace id (32 hex digits), taken from the traceparent header
+    /// of the request if there is a valid one.
+    const std::string &traceId() const
+    {
+        return traceId_;
+    }
+    /// The id (16 hex digits) of the span of the request.
+    const std::string &spanId() const
+    {
+        return spanId_;
+    }
+    /// The parent span id in the traceparent header, or empty.
+    const std::string &parentSpanId() const
+    {
+        return parentSpanId_;
+    }
+    void setTraceParent(const std::string &traceparent);
+
+    static const char *stageName(Stage stage);
+
+    /**
+     * @brief Return the trace in the OTLP/JSON format of OpenTelemetry (an
+     * ExportTraceServiceRequest object), the request is a span and every stage
+     * it goes through is a child span.
+     */
+    std::string toOtlpJson(const HttpRequest &req,
+                           const HttpResponse &resp) const;
+    /// Append the spans of the trace in the OTLP/JSON format to a JSON array,
+    /// so that several traces can be exported in one request.
+    void appendOtlpSpans(Json::Value &spans,
+                         const HttpRequest &req,
+                         const HttpResponse &resp) const;
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+    trantor::Date startDate_;
+    // Nanoseconds from start_ plus 1, 0 means the stage is not reached.
+    int64_t timestamps_[kStagesNumber]{0};
+    std::string traceId_;
+    std::string spanId_;
+    std::string parentSpanId_;
+};
+
+using RequestTraceExporter = std::function<void(const HttpRequestPtr &,
+                                                const HttpResponsePtr &,
+                                                const RequestTrace &)>;
+
+/**
+ * @brief Create an exporter that appends traces in the OTLP/JSON format to
+ * files, one trace per line. The files can be read by the otlpjsonfile
+ * receiver of the OpenTelemetry collector.
+ *
+ * @param path The directory of the files.
+ * @param baseName The base name of the files, a new file is created when the
+ * size of the current one exceeds sizeLimit.
+ */
+DROGON_EXPORT RequestTraceExporter
+newOtlpFileTraceExporter(const std::string &path = "./",
+                         const std::string &baseName = "traces",
+                         uint64_t sizeLimit = 100 * 1024 * 1024);
+
+/**
+ * @brief Create an exporter that posts traces in the OTLP/JSON format to a
+ * collector, e.g. "http://127.0.0.1:4318/v1/traces".
+ *
+ * Like the batch span processor of OpenTelemetry, the spans are buffered and
+ * posted in one request when maxBatchSize spans are buffered or every
+ * batchInterval seconds. Traces are dropped with a warning when maxQueueSize
+ * spans are buffered or being posted.
+ */
+DROGON_EXPORT RequestTraceExporter
+newOtlpHttpTraceExporter(const std::string &url,
+                         size_t maxBatchSize = 512,
+                         double batchInterval = 5.0,
+                         size_t maxQueueSize = 2048);
+
+}  // namespace drogon
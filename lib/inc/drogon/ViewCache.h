@@ -0,0 +1,102 @@
+/**
+ *
+ *  @file ViewCache.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpViewData.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The cache of rendered views and fragments of views.
+ *
+ * A text is cached by its name and the values of the selected keys in the
+ * view data, items not selected by the keys must not change the text. Only
+ * items of string, integer, bool and floating point types can be selected,
+ * the text is rendered without caching if a selected item is of other types.
+ *
+ * Every IO thread has its own cache, so looking up a text needs no lock. The
+ * total size of the cached texts in all threads is limited by the capacity,
+ * the least recently used texts of the current thread are removed when the
+ * capacity is exhausted.
+ *
+ * A fragment is cached in a view like this:
+ * @code
+   <%c++
+   $$ << drogon::ViewCache::renderFragment("sidebar", @@, {"user"}, 60, [&]() {
+       drogon::OStringStream sidebar;
+       // render the sidebar
+       return std::move(sidebar.str());
+   });
+   %>
+   @endcode
+ */
+class DROGON_EXPORT ViewCache
+{
+  public:
+    /**
+     * @brief Set the total size in bytes of cached texts in all threads. 64MB
+     * by default. 0 disables the cache.
+     */
+    static void setCapacity(size_t bytes);
+
+    /**
+     * @brief Render a view, or get the text from the cache.
+     *
+     * @param viewName The name of the view.
+     * @param data The data displayed in the view.
+     * @param keys The keys of the items that the text depends on.
+     * @param timeout The number of seconds the text is cached for, 0 means the
+     * text never expires.
+     * @param text The rendered text.
+     * @return false if the view doesn't exist.
+     */
+    static bool renderView(const std::string &viewName,
+                           const HttpViewData &data,
+                           const std::vector<std::string> &keys,
+                           double timeout,
+                           std::string &text);
+
+    /**
+     * @brief Get the text of a fragment from the cache, or render it by the
+     * renderer and cache it.
+     *
+     * @param name The name of the fragment. Fragments and views share the
+     * names.
+     */
+    static std::string renderFragment(
+        const std::string &name,
+        const HttpViewData &data,
+        const std::vector<std::string> &keys,
+        double timeout,
+        const std::function<std::string()> &renderer);
+
+    /**
+     * @brief Remove all texts of the view or fragment from the caches of all
+     * threads.
+     *
+     * @note Other threads drop the texts when they look up the cache next
+     * time, so the memory is not released immediately.
+     */
+    static void invalidate(const std::string &name);
+
+    /// Remove all texts from the caches of all threads.
+    static void clear();
+};
+
+}  // namespace drogon
@@ -29,10 +29,14 @@
 #include <drogon/plugins/Plugin.h>
 #include <drogon/plugins/SecureSSLRedirector.h>
 #include <drogon/plugins/AccessLogger.h>
+#include <drogon/plugins/PromExporter.h>
 #include <drogon/Cookie.h>
 #include <drogon/Session.h>
 #include <drogon/IOThreadStorage.h>
 #include <drogon/UploadFile.h>
+#include <drogon/ViewCache.h>
+#include <drogon/Metrics.h>
+#include <drogon/RequestTrace.h>
 #include <drogon/orm/DbClient.h>
 
 /**
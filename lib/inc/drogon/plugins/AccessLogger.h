@@ -10,10 +10,18 @@
 #include <drogon/HttpResponse.h>
 #include <drogon/plugins/Plugin.h>
 #include <trantor/utils/AsyncFileLogger.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace drogon
 {
+class AccessLogRecordRing;
+class AccessLogFormatter;
+
 namespace plugin
 {
 /**
@@ -31,7 +39,11 @@ namespace plugin
             "log_file": "access.log",
             "log_size_limit": 0,
             "use_local_time": true,
-            "log_index": 0
+            "log_index": 0,
+            "batched": false,
+            "batch_format": "text",
+            "batch_ring_size": 4096,
+            "batch_interval": 0.1
       }
    }
    @endcode
@@ -74,6 +86,22 @@ namespace plugin
  *
  * log_index: The index of log output, 0 by default.
  *
+ * batched: false by default. When it's true, the threads sending responses
+ * only copy the logged fields to fixed-size records in their own lock-free
+ * ring buffers, a background thread formats the records and writes them in
+ * batches every batch_interval seconds (0.1 by default). If the ring of a
+ * thread is full, the record is dropped instead of blocking the thread, and
+ * the drogon_access_log_dropped_records_total metric is increased. The
+ * $http_, $cookie_ and $upstream_http_ placeholders (except the content type)
+ * are not supported in this mode, the URL is truncated to 240 bytes.
+ *
+ * batch_format: "text" by default, the records are formatted with log_format.
+ * When it's "json", every record is a JSON object in a line, the names of the
+ * placeholders in log_format are the keys.
+ *
+ * batch_ring_size: The number of records in the ring of each thread, 4096 by
+ * default.
+ *
  * Enable the plugin by adding the configuration to the list of plugins in the
  * configuration file.
  *
@@ -89,6 +117,7 @@ class DROGON_EXPORT AccessLogger : public drogon::Plugin<AccessLogger>
 
   private:
     trantor::AsyncFileLogger asyncFileLogger_;
+    bool useFileLogger_{false};
     int logIndex_{0};
     bool useLocalTime_{true};
     using LogFunction = std::function<void(trantor::LogStream &,
@@ -173,6 +202,22 @@ class DROGON_EXPORT AccessLogger : public drogon::Plugin<AccessLogger>
     static void outputRespContentType(trantor::LogStream &,
                                       const drogon::HttpRequestPtr &,
                                       const drogon::HttpResponsePtr &);
+    static uint64_t threadNumber();
+
+    // The batched mode
+    bool batched_{false};
+    size_t batchRingSize_{4096};
+    double batchInterval_{0.1};
+    std::shared_ptr<AccessLogFormatter> formatter_;
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<AccessLogRecordRing>> rings_;
+    std::condition_variable stopCond_;
+    bool stopping_{false};
+    std::thread writerThread_;
+    AccessLogRecordRing &threadRing();
+    void pushRecord(const drogon::HttpRequestPtr &req,
+                    const drogon::HttpResponsePtr &resp);
+    void writeRecords();
 };
 }  // namespace plugin
 }  // namespace drogon
@@ -0,0 +1,62 @@
+/**
+ *
+ *  PromExporter.h
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/plugins/Plugin.h>
+#include <string>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin exposes the metrics in drogon::metrics::Registry in the
+ * Prometheus text format.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::PromExporter",
+      "dependencies": [],
+      "config": {
+            "path": "/metrics",
+            "builtin_metrics": true
+      }
+   }
+   @endcode
+ *
+ * path: The path of the metrics, the default value is "/metrics".
+ * builtin_metrics: If true, the metrics of HTTP requests, connections,
+ * database clients and redis clients are collected by the framework. The
+ * default value is true.
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class DROGON_EXPORT PromExporter : public drogon::Plugin<PromExporter>
+{
+  public:
+    PromExporter()
+    {
+    }
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    void shutdown() override;
+
+  private:
+    std::string path_{"/metrics"};
+};
+
+}  // namespace plugin
+}  // namespace drogon
@@ -15,7 +15,13 @@
 #pragma once
 #include <string>
 #include <sstream>
+#include <stdint.h>
+#include <stdio.h>
+#include <type_traits>
 #include <drogon/utils/string_view.h>
+#if __cplusplus >= 201703L || (defined _MSC_VER && _MSC_VER > 1900)
+#include <charconv>
+#endif
 
 namespace drogon
 {
@@ -62,7 +68,7 @@ class OStringStream
     std::enable_if_t<internal::CanConvertToString<T>::value, OStringStream&>
     operator<<(T&& value)
     {
-        buffer_.append(std::to_string(std::forward<T>(value)));
+        appendNumber(value, std::is_integral<std::decay_t<T>>());
         return *this;
     }
     template <int N>
@@ -95,33 +101,32 @@ class OStringStream
 
     OStringStream& operator<<(const double& d)
     {
-        std::stringstream ss;
-        ss << d;
-        buffer_.append(ss.str());
+        appendDouble(d);
         return *this;
     }
 
     OStringStream& operator<<(const float& f)
     {
-        std::stringstream ss;
-        ss << f;
-        buffer_.append(ss.str());
+        appendDouble(f);
         return *this;
     }
 
     OStringStream& operator<<(double&& d)
     {
-        std::stringstream ss;
-        ss << d;
-        buffer_.append(ss.str());
+        appendDouble(d);
         return *this;
     }
 
     OStringStream& operator<<(float&& f)
     {
-        std::stringstream ss;
-        ss << f;
-        buffer_.append(ss.str());
+        appendDouble(f);
+        return *this;
+    }
+
+    /// Append the characters in [data, data + length) to the buffer.
+    OStringStream& append(const char* data, size_t length)
+    {
+        buffer_.append(data, length);
         return *this;
     }
 
@@ -135,6 +140,81 @@ class OStringStream
     }
 
   private:
+    template <typename T>
+    void appendNumber(const T& value, std::true_type)
+    {
+        if (std::is_signed<T>::value)
+            appendInteger(static_cast<int64_t>(value));
+        else
+            appendInteger(static_cast<uint64_t>(value));
+    }
+    void appendNumber(double value, std::false_type)
+    {
+        appendDouble(value);
+    }
+    void appendNumber(float value, std::false_type)
+    {
+        appendDouble(value);
+    }
+    template <typename T>
+    void appendNumber(const T& value, std::false_type)
+    {
+        buffer_.append(std::to_string(value));
+    }
+    void appendInteger(int64_t value)
+    {
+#if __cplusplus >= 201703L || (defined _MSC_VER && _MSC_VER > 1900)
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        buffer_.append(buf, result.ptr - buf);
+#else
+        if (value < 0)
+        {
+            buffer_.push_back('-');
+            // Negate in the unsigned type to handle the minimum value.
+            appendInteger(0 - static_cast<uint64_t>(value));
+        }
+        else
+        {
+            appendInteger(static_cast<uint64_t>(value));
+        }
+#endif
+    }
+    void appendInteger(uint64_t value)
+    {
+        char buf[24];
+#if __cplusplus >= 201703L || (defined _MSC_VER && _MSC_VER > 1900)
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        buffer_.append(buf, result.ptr - buf);
+#else
+        char* end = buf + sizeof(buf);
+        char* p = end;
+        do
+        {
+            *--p = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        buffer_.append(p, end - p);
+#endif
+    }
+    // The same format as std::ostream with the default precision.
+    void appendDouble(double value)
+    {
+        char buf[32];
+#ifdef __cpp_lib_to_chars
+        auto result = std::to_chars(buf,
+                                    buf + sizeof(buf),
+                                    value,
+                                    std::chars_format::general,
+                                    6);
+        buffer_.append(buf, result.ptr - buf);
+#else
+        auto length = snprintf(buf, sizeof(buf), "%g", value);
+        if (length > 0)
+            buffer_.append(buf, length);
+#endif
+    }
+
     std::string buffer_;
 };
 }  // namespace drogon
\ No newline at end of file
@@ -0,0 +1,329 @@
+/**
+ *
+ *  @file AccessLogRecord.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "AccessLogRecord.h"
+#include "HttpUtils.h"
+#include <trantor/utils/Date.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <regex>
+#include <stdio.h>
+#include <unordered_map>
+
+using namespace drogon;
+
+void drogon::collectAccessLogRecords(
+    const std::vector<std::shared_ptr<AccessLogRecordRing>> &rings,
+    std::vector<AccessLogRecord> &records)
+{
+    for (auto &ring : rings)
+    {
+        ring->popAll(records);
+    }
+    std::stable_sort(records.begin(),
+                     records.end(),
+                     [](const AccessLogRecord &a, const AccessLogRecord &b) {
+                         return a.date < b.date;
+                     });
+}
+
+std::vector<std::pair<bool, std::string>> drogon::splitAccessLogFormat(
+    std::string format)
+{
+    std::vector<std::pair<bool, std::string>> tokens;
+    std::string rawString;
+    while (!format.empty())
+    {
+        LOG_INFO << format;
+        auto pos = format.find('$');
+        if (pos != std::string::npos)
+        {
+            rawString += format.substr(0, pos);
+
+            format = format.substr(pos);
+            std::regex e{"^\\$[a-zA-Z0-9\\-_]+"};
+            std::smatch m;
+            if (std::regex_search(format, m, e))
+            {
+                if (!rawString.empty())
+                {
+                    tokens.emplace_back(false, std::move(rawString));
+                    rawString.clear();
+                }
+                tokens.emplace_back(true, m[0].str());
+                format = m.suffix().str();
+            }
+            else
+            {
+                rawString += '$';
+                format = format.substr(1);
+            }
+        }
+        else
+        {
+            rawString += format;
+            break;
+        }
+    }
+    if (!rawString.empty())
+    {
+        tokens.emplace_back(false, std::move(rawString));
+    }
+    return tokens;
+}
+
+AccessLogFormatter::AccessLogFormatter(const std::string &format,
+                                       bool inJson,
+                                       bool useLocalTime)
+    : inJson_(inJson), useLocalTime_(useLocalTime)
+{
+    static const std::unordered_map<std::string, Field> fieldMap{
+        {"$date", Field::kDate},
+        {"$request_date", Field::kRequestDate},
+        {"$request_path", Field::kPath},
+        {"$path", Field::kPath},
+        {"$request_query", Field::kQuery},
+        {"$query", Field::kQuery},
+        {"$request_url", Field::kUrl},
+        {"$url", Field::kUrl},
+        {"$remote_addr", Field::kRemoteAddr},
+        {"$local_addr", Field::kLocalAddr},
+        {"$request_len", Field::kRequestLength},
+        {"$body_bytes_received", Field::kRequestLength},
+        {"$response_len", Field::kResponseLength},
+        {"$body_bytes_sent", Field::kResponseLength},
+        {"$method", Field::kMethod},
+        {"$thread", Field::kThread},
+        {"$status", Field::kStatus},
+        {"$status_code", Field::kStatusCode},
+        {"$processing_time", Field::kProcessingTime},
+        {"$upstream_http_content-type", Field::kContentType},
+        {"$upstream_http_content_type", Field::kContentType}};
+    for (auto &token : splitAccessLogFormat(format))
+    {
+        if (!token.first)
+        {
+            fields_.emplace_back(Field::kRaw, std::move(token.second));
+            continue;
+        }
+        auto iter = fieldMap.find(token.second);
+        if (iter == fieldMap.end())
+        {
+            LOG_WARN << "The placeholder " << token.second
+                     << " is not supported by the batched access log";
+            fields_.emplace_back(Field::kUnsupported, std::move(token.second));
+            continue;
+        }
+        fields_.emplace_back(iter->second, std::move(token.second));
+    }
+}
+
+void AccessLogFormatter::format(std::string &output,
+                                const AccessLogRecord &record) const
+{
+    if (inJson_)
+        formatJson(output, record);
+    else
+        formatText(output, record);
+}
+
+static void appendInteger(std::string &output, uint64_t value)
+{
+    char buf[24];
+    auto length = snprintf(buf,
+                           sizeof(buf),
+                           "%llu",
+                           static_cast<unsigned long long>(value));
+    output.append(buf, length);
+}
+
+static void appendSeconds(std::string &output, int64_t microseconds)
+{
+    char buf[32];
+    auto length = snprintf(buf,
+                           sizeof(buf),
+                           "%.12g",
+                           static_cast<double>(microseconds) / 1000000.0);
+    output.append(buf, length);
+}
+
+static void appendContentType(std::string &output, ContentType contentType)
+{
+    auto typeStr = webContentTypeToString(contentType);
+    if (typeStr.empty())
+    {
+        output.append("content-type: ");
+        return;
+    }
+    auto length = typeStr.size();
+    if (length >= 2 && typeStr[length - 1] == '\n' &&
+        typeStr[length - 2] == '\r')
+        length -= 2;
+    output.append(typeStr.data(), length);
+}
+
+void AccessLogFormatter::formatText(std::string &output,
+                                    const AccessLogRecord &record) const
+{
+    for (auto &field : fields_)
+    {
+        if (field.first == Field::kRaw ||
+            field.first == Field::kUnsupported)
+            output.append(field.second);
+        else
+            formatField(output, field.first, record);
+    }
+    output.push_back('\n');
+}
+
+void AccessLogFormatter::formatField(std::string &output,
+                                     Field field,
+                                     const AccessLogRecord &record) const
+{
+    switch (field)
+    {
+        case Field::kDate:
+        case Field::kRequestDate:
+        {
+            trantor::Date date(field == Field::kDate
+                                   ? record.date
+                                   : record.requestDate);
+            output.append(useLocalTime_
+                              ? date.toFormattedStringLocal(true)
+                              : date.toFormattedString(true));
+            break;
+        }
+        case Field::kPath:
+            output.append(record.url, record.pathLength);
+            break;
+        case Field::kQuery:
+            output.append(record.url + record.pathLength, record.queryLength);
+            break;
+        case Field::kUrl:
+            output.append(record.url, record.pathLength);
+            if (record.queryLength > 0)
+            {
+                output.push_back('?');
+                output.append(record.url + record.pathLength,
+                              record.queryLength);
+            }
+            break;
+        case Field::kRemoteAddr:
+            output.append(record.remoteAddr.toIpPort());
+            break;
+        case Field::kLocalAddr:
+            output.append(record.localAddr.toIpPort());
+            break;
+        case Field::kRequestLength:
+            appendInteger(output, record.requestLength);
+            break;
+        case Field::kResponseLength:
+            appendInteger(output, record.responseLength);
+            break;
+        case Field::kMethod:
+            output.append(record.method);
+            break;
+        case Field::kThread:
+            appendInteger(output, record.thread);
+            break;
+        case Field::kStatus:
+        {
+            appendInteger(output, record.statusCode);
+            output.push_back(' ');
+            auto &str = statusCodeToString(record.statusCode);
+            output.append(str.data(), str.length());
+            break;
+        }
+        case Field::kStatusCode:
+            appendInteger(output, record.statusCode);
+            break;
+        case Field::kProcessingTime:
+            appendSeconds(output, record.date - record.requestDate);
+            break;
+        case Field::kContentType:
+            appendContentType(output, record.contentType);
+            break;
+        default:
+            break;
+    }
+}
+
+static void appendJsonString(std::string &output, const char *str, size_t len)
+{
+    output.push_back('"');
+    for (size_t i = 0; i < len; ++i)
+    {
+        auto c = static_cast<unsigned char>(str[i]);
+        if (c == '"' || c == '\\')
+        {
+            output.push_back('\\');
+            output.push_back(static_cast<char>(c));
+        }
+        else if (c < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            output.append(buf);
+        }
+        else
+        {
+            output.push_back(static_cast<char>(c));
+        }
+    }
+    output.push_back('"');
+}
+
+static void appendJsonString(std::string &output, const std::string &str)
+{
+    appendJsonString(output, str.data(), str.length());
+}
+
+void AccessLogFormatter::formatJson(std::string &output,
+                                    const AccessLogRecord &record) const
+{
+    output.push_back('{');
+    bool first = true;
+    std::string value;
+    for (auto &field : fields_)
+    {
+        if (field.first == Field::kRaw ||
+            field.first == Field::kUnsupported)
+            continue;
+        if (!first)
+            output.push_back(',');
+        first = false;
+        // The key is the placeholder without '$'.
+        appendJsonString(output,
+                         field.second.data() + 1,
+                         field.second.size() - 1);
+        output.push_back(':');
+        switch (field.first)
+        {
+            case Field::kRequestLength:
+            case Field::kResponseLength:
+            case Field::kThread:
+            case Field::kStatusCode:
+            case Field::kProcessingTime:
+                // Numbers are not quoted.
+                formatField(output, field.first, record);
+                break;
+            default:
+                value.clear();
+                formatField(value, field.first, record);
+                appendJsonString(output, value);
+                break;
+        }
+    }
+    output.append("}\n");
+}
@@ -0,0 +1,170 @@
+/**
+ *
+ *  @file AccessLogRecord.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpTypes.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/// The fields of a response logged in the batched mode of the AccessLogger
+/// plugin.
+struct AccessLogRecord
+{
+    int64_t date;
+    int64_t requestDate;
+    trantor::InetAddress remoteAddr;
+    trantor::InetAddress localAddr;
+    uint64_t requestLength;
+    uint64_t responseLength;
+    uint64_t thread;
+    int statusCode;
+    // A string literal returned by HttpRequest::methodString()
+    const char *method;
+    ContentType contentType;
+    uint16_t pathLength;
+    uint16_t queryLength;
+    // The path followed by the query, truncated if it's too long.
+    char url[240];
+};
+
+/**
+ * @brief A single-producer single-consumer ring of records. The thread that
+ * owns the ring writes records in place, the writer thread takes them out.
+ */
+class AccessLogRecordRing : public trantor::NonCopyable
+{
+  public:
+    explicit AccessLogRecordRing(size_t size)
+    {
+        size_t capacity = 1;
+        while (capacity < size)
+            capacity <<= 1;
+        records_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+    /// Return the slot of the next record, or nullptr if the ring is full.
+    AccessLogRecord *prepare()
+    {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_)
+            return nullptr;
+        return &records_[tail & mask_];
+    }
+    /// Publish the record returned by prepare().
+    void commit()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+    void popAll(std::vector<AccessLogRecord> &records)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        auto tail = tail_.load(std::memory_order_acquire);
+        for (; head != tail; ++head)
+            records.push_back(records_[head & mask_]);
+        head_.store(head, std::memory_order_release);
+    }
+    /// Called by the owner thread when it exits, no record is written after
+    /// this call.
+    void retire()
+    {
+        retired_.store(true, std::memory_order_release);
+    }
+    bool retired() const
+    {
+        return retired_.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::vector<AccessLogRecord> records_;
+    size_t mask_;
+    std::atomic<bool> retired_{false};
+    std::atomic<size_t> head_{0};
+    // Keep the indices written by different threads in different cache lines.
+    char padding_[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail_{0};
+};
+
+/**
+ * @brief Take all records out of the rings and sort them by their dates, so
+ * the records of different threads are interleaved in the order they were
+ * logged. The records of the same date keep the order of the rings.
+ */
+void collectAccessLogRecords(
+    const std::vector<std::shared_ptr<AccessLogRecordRing>> &rings,
+    std::vector<AccessLogRecord> &records);
+
+/// Split the format into raw strings and placeholders, the placeholders are
+/// marked with true.
+std::vector<std::pair<bool, std::string>> splitAccessLogFormat(
+    std::string format);
+
+/**
+ * @brief Format the records of the batched mode with the placeholders of the
+ * log_format option, either as text or as a JSON object in a line.
+ */
+class AccessLogFormatter
+{
+  public:
+    AccessLogFormatter(const std::string &format,
+                       bool inJson,
+                       bool useLocalTime);
+    /// Append the record and a line break to output.
+    void format(std::string &output, const AccessLogRecord &record) const;
+
+  private:
+    enum class Field
+    {
+        kRaw,
+        kDate,
+        kRequestDate,
+        kPath,
+        kQuery,
+        kUrl,
+        kRemoteAddr,
+        kLocalAddr,
+        kRequestLength,
+        kResponseLength,
+        kMethod,
+        kThread,
+        kStatus,
+        kStatusCode,
+        kProcessingTime,
+        kContentType,
+        kUnsupported
+    };
+    bool inJson_;
+    bool useLocalTime_;
+    // The fields of the format with the raw strings or the placeholders.
+    std::vector<std::pair<Field, std::string>> fields_;
+    void formatText(std::string &output, const AccessLogRecord &record) const;
+    void formatJson(std::string &output, const AccessLogRecord &record) const;
+    void formatField(std::string &output,
+                     Field field,
+                     const AccessLogRecord &record) const;
+};
+}  // namespace drogon
@@ -12,10 +12,13 @@
  *
  */
 
+#include "AccessLogRecord.h"
 #include "HttpUtils.h"
 #include <drogon/drogon.h>
+#include <drogon/Metrics.h>
 #include <drogon/plugins/AccessLogger.h>
-#include <regex>
+#include <algorithm>
+#include <string.h>
 #include <thread>
 #ifndef _WIN32
 #include <unistd.h>
@@ -30,6 +33,16 @@
 using namespace drogon;
 using namespace drogon::plugin;
 
+static metrics::Counter &droppedRecords()
+{
+    static auto &counter =
+        metrics::Registry::instance()
+            .counter("drogon_access_log_dropped_records_total",
+                     "Access log records dropped because the rings are full")
+            .get();
+    return counter;
+}
+
 void AccessLogger::initAndStart(const Json::Value &config)
 {
     useLocalTime_ = config.get("use_local_time", true).asBool();
@@ -71,7 +84,21 @@ void AccessLogger::initAndStart(const Json::Value &config)
             "$request_date $method $url [$body_bytes_received] ($remote_addr - "
             "$local_addr) $status $body_bytes_sent $processing_time";
     }
-    createLogFunctions(format);
+    batched_ = config.get("batched", false).asBool();
+    if (batched_)
+    {
+        auto inJson = config.get("batch_format", "text").asString() == "json";
+        batchRingSize_ = config.get("batch_ring_size", 4096).asUInt64();
+        if (batchRingSize_ == 0)
+            batchRingSize_ = 1;
+        batchInterval_ = config.get("batch_interval", 0.1).asDouble();
+        formatter_ =
+            std::make_shared<AccessLogFormatter>(format, inJson, useLocalTime_);
+    }
+    else
+    {
+        createLogFunctions(format);
+    }
     auto logPath = config.get("log_path", "").asString();
     if (!logPath.empty())
     {
@@ -89,6 +116,7 @@ void AccessLogger::initAndStart(const Json::Value &config)
         }
         asyncFileLogger_.setFileName(fileName, extension, logPath);
         asyncFileLogger_.startLogging();
+        useFileLogger_ = true;
         logIndex_ = config.get("log_index", 0).asInt();
         trantor::Logger::setOutputFunction(
             [&](const char *msg, const uint64_t len) {
@@ -102,6 +130,17 @@ void AccessLogger::initAndStart(const Json::Value &config)
             asyncFileLogger_.setFileSizeLimit(sizeLimit);
         }
     }
+    if (batched_)
+    {
+        droppedRecords();
+        writerThread_ = std::thread([this]() { writeRecords(); });
+        drogon::app().registerPreSendingAdvice(
+            [this](const drogon::HttpRequestPtr &req,
+                   const drogon::HttpResponsePtr &resp) {
+                pushRecord(req, resp);
+            });
+        return;
+    }
     drogon::app().registerPreSendingAdvice(
         [this](const drogon::HttpRequestPtr &req,
                const drogon::HttpResponsePtr &resp) {
@@ -111,6 +150,15 @@ void AccessLogger::initAndStart(const Json::Value &config)
 
 void AccessLogger::shutdown()
 {
+    if (writerThread_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            stopping_ = true;
+        }
+        stopCond_.notify_one();
+        writerThread_.join();
+    }
 }
 
 void AccessLogger::logging(trantor::LogStream &stream,
@@ -125,63 +173,27 @@ void AccessLogger::logging(trantor::LogStream &stream,
 
 void AccessLogger::createLogFunctions(std::string format)
 {
-    std::string rawString;
-    while (!format.empty())
+    auto tokens = splitAccessLogFormat(std::move(format));
+    if (tokens.empty() || tokens.back().first)
     {
-        LOG_INFO << format;
-        auto pos = format.find('$');
-        if (pos != std::string::npos)
-        {
-            rawString += format.substr(0, pos);
-
-            format = format.substr(pos);
-            std::regex e{"^\\$[a-zA-Z0-9\\-_]+"};
-            std::smatch m;
-            if (std::regex_search(format, m, e))
-            {
-                if (!rawString.empty())
-                {
-                    logFunctions_.emplace_back(
-                        [rawString](trantor::LogStream &stream,
-                                    const drogon::HttpRequestPtr &,
-                                    const drogon::HttpResponsePtr &) {
-                            stream << rawString;
-                        });
-                    rawString.clear();
-                }
-                auto placeholder = m[0];
-                logFunctions_.emplace_back(newLogFunction(placeholder));
-                format = m.suffix().str();
-            }
-            else
-            {
-                rawString += '$';
-                format = format.substr(1);
-            }
-        }
-        else
-        {
-            rawString += format;
-            break;
-        }
+        tokens.emplace_back(false, "");
     }
-    if (!rawString.empty())
+    tokens.back().second.push_back('\n');
+    for (auto &token : tokens)
     {
+        if (token.first)
+        {
+            logFunctions_.emplace_back(newLogFunction(token.second));
+            continue;
+        }
         logFunctions_.emplace_back(
             [rawString =
-                 std::move(rawString)](trantor::LogStream &stream,
-                                       const drogon::HttpRequestPtr &,
-                                       const drogon::HttpResponsePtr &) {
-                stream << rawString << "\n";
+                 std::move(token.second)](trantor::LogStream &stream,
+                                          const drogon::HttpRequestPtr &,
+                                          const drogon::HttpResponsePtr &) {
+                stream << rawString;
             });
     }
-    else
-    {
-        logFunctions_.emplace_back(
-            [](trantor::LogStream &stream,
-               const drogon::HttpRequestPtr &,
-               const drogon::HttpResponsePtr &) { stream << "\n"; });
-    }
 }
 
 AccessLogger::LogFunction AccessLogger::newLogFunction(
@@ -324,6 +336,11 @@ void AccessLogger::outputMethod(trantor::LogStream &stream,
 void AccessLogger::outputThreadNumber(trantor::LogStream &stream,
                                       const drogon::HttpRequestPtr &,
                                       const drogon::HttpResponsePtr &)
+{
+    stream << threadNumber();
+}
+
+uint64_t AccessLogger::threadNumber()
 {
 #ifdef __linux__
     static thread_local pid_t threadId_{0};
@@ -356,7 +373,7 @@ void AccessLogger::outputThreadNumber(trantor::LogStream &stream,
         pthread_threadid_np(NULL, &threadId_);
     }
 #endif
-    stream << threadId_;
+    return static_cast<uint64_t>(threadId_);
 }
 
 //$http_[header_name]
@@ -433,4 +450,109 @@ void AccessLogger::outputRespContentType(trantor::LogStream &stream,
             stream << typeStr;
         }
     }
-}
\ No newline at end of file
+}
+AccessLogRecordRing &AccessLogger::threadRing()
+{
+    // The plugin is a singleton, so a thread has at most one ring. When the
+    // thread exits, the ring is retired and the writer thread unregisters it
+    // after taking its last records out.
+    struct RingHolder
+    {
+        std::shared_ptr<AccessLogRecordRing> ring;
+        ~RingHolder()
+        {
+            if (ring)
+                ring->retire();
+        }
+    };
+    static thread_local RingHolder holder;
+    if (!holder.ring)
+    {
+        holder.ring = std::make_shared<AccessLogRecordRing>(batchRingSize_);
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.push_back(holder.ring);
+    }
+    return *holder.ring;
+}
+
+void AccessLogger::pushRecord(const drogon::HttpRequestPtr &req,
+                              const drogon::HttpResponsePtr &resp)
+{
+    auto &ring = threadRing();
+    auto record = ring.prepare();
+    if (!record)
+    {
+        droppedRecords().increment();
+        return;
+    }
+    record->date = trantor::Date::now().microSecondsSinceEpoch();
+    record->requestDate = req->creationDate().microSecondsSinceEpoch();
+    record->remoteAddr = req->peerAddr();
+    record->localAddr = req->localAddr();
+    record->requestLength = req->body().length();
+    record->responseLength = resp->body().length();
+    record->thread = threadNumber();
+    record->statusCode = resp->getStatusCode();
+    record->method = req->methodString();
+    record->contentType = resp->contentType();
+    auto &path = req->path();
+    auto &query = req->query();
+    auto pathLength = (std::min)(path.length(), sizeof(record->url));
+    auto queryLength =
+        (std::min)(query.length(), sizeof(record->url) - pathLength);
+    memcpy(record->url, path.data(), pathLength);
+    memcpy(record->url + pathLength, query.data(), queryLength);
+    record->pathLength = static_cast<uint16_t>(pathLength);
+    record->queryLength = static_cast<uint16_t>(queryLength);
+    ring.commit();
+}
+
+void AccessLogger::writeRecords()
+{
+    std::vector<std::shared_ptr<AccessLogRecordRing>> rings;
+    std::vector<AccessLogRecord> records;
+    std::string batch;
+    uint64_t reportedDrops = 0;
+    bool stopping = false;
+    while (!stopping)
+    {
+        {
+            std::unique_lock<std::mutex> lock(ringsMutex_);
+            stopping = stopCond_.wait_for(
+                lock,
+                std::chrono::duration<double>(batchInterval_),
+                [this]() { return stopping_; });
+            rings = rings_;
+            // The retired rings are drained below for the last time.
+            auto retired =
+                [](const std::shared_ptr<AccessLogRecordRing> &ring) {
+                    return ring->retired();
+                };
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), retired),
+                         rings_.end());
+        }
+        records.clear();
+        collectAccessLogRecords(rings, records);
+        batch.clear();
+        for (auto &record : records)
+        {
+            formatter_->format(batch, record);
+        }
+        // The whole batch is written at once, the log stream switches to a
+        // dynamic buffer when its fixed one is too small.
+        if (!batch.empty())
+        {
+            if (useFileLogger_)
+                asyncFileLogger_.output(batch.data(), batch.length());
+            else
+                LOG_RAW_TO(logIndex_) << batch;
+        }
+        auto drops = droppedRecords().value();
+        if (drops != reportedDrops)
+        {
+            LOG_WARN << drops - reportedDrops
+                     << " access log records are dropped";
+            reportedDrops = drops;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ *
+ *  @file BuiltinMetrics.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/Metrics.h>
+#include <drogon/HttpRequest.h>
+#include <trantor/utils/Date.h>
+#include <atomic>
+#include <utility>
+
+namespace drogon
+{
+namespace internal
+{
+/// The metrics collected by the framework.
+struct BuiltinMetrics
+{
+    metrics::Gauge *connections;
+    metrics::Counter *acceptedConnections;
+    metrics::Gauge *requestsInFlight;
+    metrics::Family<metrics::Histogram> *requestDuration;
+    metrics::Family<metrics::Counter> *requests;
+    metrics::Histogram *dbPoolWait;
+    metrics::Histogram *dbQueryDuration;
+    metrics::Histogram *redisPoolWait;
+    metrics::Histogram *redisCommandDuration;
+    metrics::Counter *tlsFullHandshakes;
+    metrics::Counter *tlsResumedHandshakes;
+
+    /// Record a handled request, the route is the matched path pattern.
+    void observeRequest(const HttpRequest &req,
+                        HttpStatusCode status,
+                        double seconds);
+};
+
+extern std::atomic<BuiltinMetrics *> builtinMetricsPtr;
+
+/// Return nullptr if the built-in metrics are not enabled.
+inline BuiltinMetrics *builtinMetrics()
+{
+    return builtinMetricsPtr.load(std::memory_order_acquire);
+}
+
+inline double secondsSince(const trantor::Date &start)
+{
+    auto microseconds = trantor::Date::now().microSecondsSinceEpoch() -
+                        start.microSecondsSinceEpoch();
+    return microseconds > 0 ? microseconds / 1000000.0 : 0.0;
+}
+
+/// Wrap the callbacks of an asynchronous call to record the time from now to
+/// the result or the exception.
+template <typename ResultCallback, typename ExceptionCallback>
+void recordCallDuration(metrics::Histogram &histogram,
+                        ResultCallback &resultCallback,
+                        ExceptionCallback &exceptionCallback)
+{
+    auto start = trantor::Date::now();
+    resultCallback = [callback = std::move(resultCallback), &histogram, start](
+                         const auto &result) {
+        histogram.observe(secondsSince(start));
+        if (callback)
+            callback(result);
+    };
+    exceptionCallback = [callback = std::move(exceptionCallback),
+                         &histogram,
+                         start](const auto &exception) {
+        histogram.observe(secondsSince(start));
+        if (callback)
+            callback(exception);
+    };
+}
+}  // namespace internal
+}  // namespace drogon
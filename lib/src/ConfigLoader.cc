@@ -426,6 +426,27 @@ static void loadApp(const Json::Value &app)
     drogon::app().enableServerHeader(sendServerHeader);
     auto sendDateHeader = app.get("enable_date_header", true).asBool();
     drogon::app().enableDateHeader(sendDateHeader);
+    auto &tracing = app["request_tracing"];
+    if (tracing.isObject())
+    {
+        drogon::app().enableRequestTracing(
+            tracing.get("sample_ratio", 0.0).asDouble(),
+            tracing.get("force_header", "x-drogon-trace").asString());
+        auto otlpUrl = tracing.get("otlp_url", "").asString();
+        auto otlpFilePath = tracing.get("otlp_file_path", "").asString();
+        if (!otlpUrl.empty())
+        {
+            drogon::app().setRequestTraceExporter(newOtlpHttpTraceExporter(
+                otlpUrl,
+                tracing.get("otlp_batch_size", 512).asUInt64(),
+                tracing.get("otlp_batch_interval", 5.0).asDouble()));
+        }
+        else if (!otlpFilePath.empty())
+        {
+            drogon::app().setRequestTraceExporter(
+                newOtlpFileTraceExporter(otlpFilePath));
+        }
+    }
     auto keepaliveReqs = app.get("keepalive_requests", 0).asUInt64();
     drogon::app().setKeepaliveRequestsNumber(keepaliveReqs);
     auto pipeliningReqs = app.get("pipelining_requests", 0).asUInt64();
@@ -469,6 +490,8 @@ static void loadApp(const Json::Value &app)
         exit(1);
     }
     drogon::app().enableReusePort(app.get("reuse_port", false).asBool());
+    drogon::app().enableHttp2(app.get("enable_http2", false).asBool());
+    drogon::app().enableIoUring(app.get("enable_io_uring", false).asBool());
     drogon::app().setHomePage(app.get("home_page", "index.html").asString());
     drogon::app().setImplicitPageEnable(
         app.get("use_implicit_page", true).asBool());
@@ -512,6 +535,25 @@ static void loadDbClients(const Json::Value &dbClients)
             characterSet = client.get("client_encoding", "").asString();
         }
         auto timeout = client.get("timeout", -1.0).asDouble();
+        auto maxPendingQueries =
+            client.get("max_pending_queries", 0).asUInt64();
+        std::vector<std::pair<std::string, unsigned short>> replicas;
+        for (auto const &replica : client["replicas"])
+        {
+            auto replicaHost = replica.get("host", "").asString();
+            if (replicaHost.empty())
+            {
+                std::cerr << "Please configure the host of replicas in the "
+                             "configuration file"
+                          << std::endl;
+                exit(1);
+            }
+            replicas.emplace_back(replicaHost,
+                                  (unsigned short)replica.get("port", port)
+                                      .asUInt());
+        }
+        auto maxReplicationLag =
+            client.get("max_replication_lag", 0.0).asDouble();
         drogon::app().createDbClient(type,
                                      host,
                                      (unsigned short)port,
@@ -523,7 +565,10 @@ static void loadDbClients(const Json::Value &dbClients)
                                      name,
                                      isFast,
                                      characterSet,
-                                     timeout);
+                                     timeout,
+                                     maxPendingQueries,
+                                     replicas,
+                                     maxReplicationLag);
     }
 }
 
@@ -610,6 +655,14 @@ static void loadSSL(const Json::Value &sslConf)
         }
     }
     drogon::app().setSSLConfigCommands(sslConfCmds);
+    if (sslConf.isMember("session_sharing"))
+    {
+        auto &sharing = sslConf["session_sharing"];
+        drogon::app().enableSSLSessionSharing(
+            sharing.get("cache_size", 20480).asUInt64(),
+            sharing.get("ticket_key_rotation", 3600).asUInt64(),
+            sharing.get("ticket_key_file", "").asString());
+    }
 }
 void ConfigLoader::load()
 {
@@ -53,7 +53,11 @@ class DbClientManager : public trantor::NonCopyable
                         const std::string &name,
                         const bool isFast,
                         const std::string &characterSet,
-                        double timeout);
+                        double timeout,
+                        size_t maxPendingQueries,
+                        const std::vector<
+                            std::pair<std::string, unsigned short>> &replicas,
+                        double maxReplicationLag);
     bool areAllDbClientsAvailable() const noexcept;
 
   private:
@@ -66,6 +70,9 @@ class DbClientManager : public trantor::NonCopyable
         bool isFast_;
         size_t connectionNumber_;
         double timeout_;
+        size_t maxPendingQueries_;
+        std::vector<std::string> replicaConnectionInfos_;
+        double maxReplicationLag_;
     };
     std::vector<DbInfo> dbInfos_;
     std::map<std::string, IOThreadStorage<orm::DbClientPtr>> dbFastClientsMap_;
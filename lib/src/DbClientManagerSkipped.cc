@@ -38,7 +38,12 @@ void DbClientManager::createDbClient(const std::string & /*dbType*/,
                                      const std::string & /*name*/,
                                      const bool /*isFast*/,
                                      const std::string & /*characterSet*/,
-                                     double /*timeout*/)
+                                     double /*timeout*/,
+                                     size_t /*maxPendingQueries*/,
+                                     const std::vector<
+                                         std::pair<std::string, unsigned short>>
+                                         & /*replicas*/,
+                                     double /*maxReplicationLag*/)
 {
     LOG_FATAL << "No database is supported by drogon, please install the "
                  "database development library first.";
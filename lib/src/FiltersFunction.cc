@@ -85,6 +85,7 @@ void doFilters(
         &callbackPtr,
     std::function<void()> &&missCallback)
 {
+    req->markTrace(RequestTrace::kFiltering);
     doFilterChains(filters, 0, req, callbackPtr, std::move(missCallback));
 }
 
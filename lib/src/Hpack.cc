@@ -0,0 +1,556 @@
+/**
+ *
+ *  @file Hpack.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Hpack.h"
+#include <string.h>
+#include <unordered_map>
+
+using namespace drogon;
+
+namespace
+{
+struct StaticEntry
+{
+    const char *name;
+    const char *value;
+};
+// RFC 7541 Appendix A, the index of the first entry is 1.
+const StaticEntry kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+constexpr size_t kStaticTableSize =
+    sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+// The lookup of the static table by the encoder.
+struct StaticIndex
+{
+    StaticIndex()
+    {
+        for (size_t i = kStaticTableSize; i > 0; --i)
+        {
+            auto &entry = kStaticTable[i - 1];
+            names[entry.name] = i;
+            if (entry.value[0] != '\0')
+                fields[std::string(entry.name) + '\0' + entry.value] = i;
+        }
+    }
+    std::unordered_map<std::string, size_t> names;
+    std::unordered_map<std::string, size_t> fields;
+};
+const StaticIndex &staticIndex()
+{
+    static const StaticIndex index;
+    return index;
+}
+
+// RFC 7541 Appendix B. The code is canonical, the codes are assigned in the
+// order of their lengths and then of the symbols, so the lengths are enough.
+const uint8_t kHuffmanCodeLengths[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6,  10, 10, 12, 13, 6,  8,  11, 10, 10, 8,  11, 8,  6,  6,  6,
+    5,  5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  8,  15, 6,  12, 10,
+    13, 6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+    7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  8,  13, 19, 13, 14, 6,
+    15, 5,  6,  5,  6,  5,  6,  6,  6,  5,  7,  7,  6,  6,  6,  5,
+    6,  7,  6,  5,  5,  6,  7,  7,  7,  7,  7,  15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30};
+constexpr int kMinCodeLength = 5;
+constexpr int kMaxCodeLength = 30;
+constexpr int kEos = 256;
+
+struct HuffmanCode
+{
+    HuffmanCode()
+    {
+        // Sort the symbols by their code lengths, then assign the codes.
+        size_t pos = 0;
+        for (int length = kMinCodeLength; length <= kMaxCodeLength; ++length)
+        {
+            firstIndex[length] = static_cast<uint16_t>(pos);
+            for (int symbol = 0; symbol <= kEos; ++symbol)
+            {
+                if (kHuffmanCodeLengths[symbol] == length)
+                    sortedSymbols[pos++] = static_cast<uint16_t>(symbol);
+            }
+            count[length] = static_cast<uint16_t>(pos - firstIndex[length]);
+        }
+        uint32_t code = 0;
+        for (int length = kMinCodeLength; length <= kMaxCodeLength; ++length)
+        {
+            firstCode[length] = code;
+            for (size_t i = 0; i < count[length]; ++i)
+                codes[sortedSymbols[firstIndex[length] + i]] = code++;
+            code <<= 1;
+        }
+    }
+    uint32_t codes[257];
+    uint16_t sortedSymbols[257];
+    uint32_t firstCode[kMaxCodeLength + 1]{};
+    uint16_t firstIndex[kMaxCodeLength + 1]{};
+    uint16_t count[kMaxCodeLength + 1]{};
+};
+const HuffmanCode &huffmanCode()
+{
+    static const HuffmanCode code;
+    return code;
+}
+
+// Decode an integer with a prefix of the given bits, return false if the
+// data is incomplete or the value is too large.
+bool decodeInteger(const unsigned char *&p,
+                   const unsigned char *end,
+                   int prefixBits,
+                   uint64_t &value)
+{
+    if (p == end)
+        return false;
+    const uint64_t maxPrefix = (1U << prefixBits) - 1;
+    value = *p++ & maxPrefix;
+    if (value < maxPrefix)
+        return true;
+    int shift = 0;
+    while (p != end)
+    {
+        auto byte = *p++;
+        value += static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+        shift += 7;
+        // No length or index of a sane peer needs more than 4 bytes.
+        if (shift > 28)
+            return false;
+    }
+    return false;
+}
+
+bool decodeString(const unsigned char *&p,
+                  const unsigned char *end,
+                  std::string &out)
+{
+    if (p == end)
+        return false;
+    bool huffman = (*p & 0x80) != 0;
+    uint64_t length;
+    if (!decodeInteger(p, end, 7, length))
+        return false;
+    if (length > static_cast<uint64_t>(end - p))
+        return false;
+    out.clear();
+    bool ok = true;
+    if (huffman)
+        ok = hpack::huffmanDecode(reinterpret_cast<const char *>(p),
+                                  length,
+                                  out);
+    else
+        out.assign(reinterpret_cast<const char *>(p), length);
+    p += length;
+    return ok;
+}
+}  // namespace
+
+void HpackTable::add(string_view name, string_view value)
+{
+    auto size = entrySize(name.length(), value.length());
+    if (size > maxSize_)
+    {
+        // An entry larger than the table empties it.
+        entries_.clear();
+        size_ = 0;
+        return;
+    }
+    evict(maxSize_ - size);
+    entries_.emplace_front(std::string(name.data(), name.length()),
+                           std::string(value.data(), value.length()));
+    size_ += size;
+}
+
+void HpackTable::setMaxSize(size_t maxSize)
+{
+    maxSize_ = maxSize;
+    evict(maxSize);
+}
+
+void HpackTable::evict(size_t maxSize)
+{
+    while (size_ > maxSize && !entries_.empty())
+    {
+        auto &entry = entries_.back();
+        size_ -= entrySize(entry.first.length(), entry.second.length());
+        entries_.pop_back();
+    }
+}
+
+HpackDecoder::HpackDecoder(size_t maxTableSize, size_t maxHeaderListSize)
+    : table_(maxTableSize),
+      maxTableSize_(maxTableSize),
+      maxHeaderListSize_(maxHeaderListSize)
+{
+}
+
+bool HpackDecoder::decode(const char *data,
+                          size_t length,
+                          HpackHeaders &headers)
+{
+    auto p = reinterpret_cast<const unsigned char *>(data);
+    auto end = p + length;
+    size_t listSize = 0;
+    bool atBeginning = true;
+    headerListTooLarge_ = false;
+    std::string name;
+    std::string value;
+    while (p != end)
+    {
+        auto byte = *p;
+        if (byte & 0x80)
+        {
+            // Indexed header field
+            uint64_t index;
+            if (!decodeInteger(p, end, 7, index) || index == 0)
+                return false;
+            if (index <= kStaticTableSize)
+            {
+                name = kStaticTable[index - 1].name;
+                value = kStaticTable[index - 1].value;
+            }
+            else if (index - kStaticTableSize <= table_.count())
+            {
+                auto &entry = table_.at(index - kStaticTableSize - 1);
+                name = entry.first;
+                value = entry.second;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if ((byte & 0xe0) == 0x20)
+        {
+            // Dynamic table size update, only at the beginning of a block.
+            uint64_t size;
+            if (!atBeginning || !decodeInteger(p, end, 5, size) ||
+                size > maxTableSize_)
+                return false;
+            table_.setMaxSize(size);
+            continue;
+        }
+        else
+        {
+            // Literal header field, with incremental indexing (01), without
+            // indexing (0000) or never indexed (0001).
+            bool indexing = (byte & 0xc0) == 0x40;
+            uint64_t index;
+            if (!decodeInteger(p, end, indexing ? 6 : 4, index))
+                return false;
+            if (index == 0)
+            {
+                if (!decodeString(p, end, name))
+                    return false;
+            }
+            else if (index <= kStaticTableSize)
+            {
+                name = kStaticTable[index - 1].name;
+            }
+            else if (index - kStaticTableSize <= table_.count())
+            {
+                name = table_.at(index - kStaticTableSize - 1).first;
+            }
+            else
+            {
+                return false;
+            }
+            if (!decodeString(p, end, value))
+                return false;
+            if (indexing)
+                table_.add(name, value);
+        }
+        atBeginning = false;
+        listSize += HpackTable::entrySize(name.length(), value.length());
+        if (listSize > maxHeaderListSize_)
+        {
+            headerListTooLarge_ = true;
+            headers.clear();
+        }
+        if (!headerListTooLarge_)
+            headers.emplace_back(std::move(name), std::move(value));
+    }
+    return true;
+}
+
+void HpackEncoder::setMaxTableSize(size_t maxSize)
+{
+    // The encoder uses 4096 bytes at most even if the peer allows more.
+    if (maxSize > 4096)
+        maxSize = 4096;
+    if (!hasPendingMaxSize_ || maxSize < smallestPendingMaxSize_)
+        smallestPendingMaxSize_ = maxSize;
+    pendingMaxSize_ = maxSize;
+    hasPendingMaxSize_ = true;
+}
+
+void HpackEncoder::encode(const HpackHeaderViews &headers, std::string &out)
+{
+    if (hasPendingMaxSize_)
+    {
+        // The smallest size is signalled first if the size was reduced and
+        // increased again (RFC 7541 4.2).
+        if (smallestPendingMaxSize_ < pendingMaxSize_)
+        {
+            hpack::encodeInteger(smallestPendingMaxSize_, 5, 0x20, out);
+            table_.setMaxSize(smallestPendingMaxSize_);
+        }
+        hpack::encodeInteger(pendingMaxSize_, 5, 0x20, out);
+        table_.setMaxSize(pendingMaxSize_);
+        hasPendingMaxSize_ = false;
+    }
+    for (auto &header : headers)
+        encodeHeader(header.first, header.second, out);
+}
+
+size_t HpackEncoder::find(string_view name,
+                          string_view value,
+                          size_t &nameIndex) const
+{
+    nameIndex = 0;
+    for (size_t i = 0; i < table_.count(); ++i)
+    {
+        auto &entry = table_.at(i);
+        if (entry.first.length() != name.length() ||
+            memcmp(entry.first.data(), name.data(), name.length()) != 0)
+            continue;
+        if (entry.second.length() == value.length() &&
+            memcmp(entry.second.data(), value.data(), value.length()) == 0)
+            return kStaticTableSize + i + 1;
+        if (nameIndex == 0)
+            nameIndex = kStaticTableSize + i + 1;
+    }
+    auto &index = staticIndex();
+    std::string key(name.data(), name.length());
+    auto nameIter = index.names.find(key);
+    if (nameIter == index.names.end())
+        return 0;
+    nameIndex = nameIter->second;
+    if (!value.empty())
+    {
+        key += '\0';
+        key.append(value.data(), value.length());
+        auto fieldIter = index.fields.find(key);
+        if (fieldIter != index.fields.end())
+            return fieldIter->second;
+    }
+    return 0;
+}
+
+void HpackEncoder::encodeHeader(string_view name,
+                                string_view value,
+                                std::string &out)
+{
+    size_t nameIndex;
+    auto index = find(name, value, nameIndex);
+    if (index != 0)
+    {
+        hpack::encodeInteger(index, 7, static_cast<char>(0x80), out);
+        return;
+    }
+    // The values that change on every message or are secret are not
+    // indexed.
+    bool sensitive = name == "authorization" || name == "set-cookie" ||
+                     name == "cookie" || name == "proxy-authorization";
+    bool indexing = !sensitive && name != "content-length" &&
+                    name != "date" && name != ":path" && name != "etag" &&
+                    HpackTable::entrySize(name.length(), value.length()) <=
+                        table_.maxSize() / 2;
+    if (indexing)
+        hpack::encodeInteger(nameIndex, 6, 0x40, out);
+    else
+        hpack::encodeInteger(nameIndex, 4, sensitive ? 0x10 : 0x00, out);
+    if (nameIndex == 0)
+        hpack::encodeString(name, out);
+    hpack::encodeString(value, out);
+    if (indexing)
+        table_.add(name, value);
+}
+
+void hpack::encodeInteger(uint64_t value,
+                          int prefixBits,
+                          char flags,
+                          std::string &out)
+{
+    const uint64_t maxPrefix = (1U << prefixBits) - 1;
+    if (value < maxPrefix)
+    {
+        out += static_cast<char>(flags | static_cast<char>(value));
+        return;
+    }
+    out += static_cast<char>(flags | static_cast<char>(maxPrefix));
+    value -= maxPrefix;
+    while (value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void hpack::encodeString(string_view str, std::string &out)
+{
+    auto huffmanLength = huffmanEncodedLength(str);
+    if (huffmanLength < str.length())
+    {
+        encodeInteger(huffmanLength, 7, static_cast<char>(0x80), out);
+        huffmanEncode(str, out);
+    }
+    else
+    {
+        encodeInteger(str.length(), 7, 0, out);
+        out.append(str.data(), str.length());
+    }
+}
+
+size_t hpack::huffmanEncodedLength(string_view str)
+{
+    size_t bits = 0;
+    for (auto c : str)
+        bits += kHuffmanCodeLengths[static_cast<unsigned char>(c)];
+    return (bits + 7) / 8;
+}
+
+void hpack::huffmanEncode(string_view str, std::string &out)
+{
+    auto &code = huffmanCode();
+    uint64_t bits = 0;
+    int bitsCount = 0;
+    for (auto c : str)
+    {
+        auto symbol = static_cast<unsigned char>(c);
+        auto length = kHuffmanCodeLengths[symbol];
+        bits = (bits << length) | code.codes[symbol];
+        bitsCount += length;
+        while (bitsCount >= 8)
+        {
+            bitsCount -= 8;
+            out += static_cast<char>(bits >> bitsCount);
+        }
+    }
+    if (bitsCount > 0)
+    {
+        // Padded with the most significant bits of EOS, i.e. ones.
+        out += static_cast<char>((bits << (8 - bitsCount)) |
+                                 (0xff >> bitsCount));
+    }
+}
+
+bool hpack::huffmanDecode(const char *data, size_t length, std::string &out)
+{
+    auto &code = huffmanCode();
+    uint32_t bits = 0;
+    int bitsCount = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        auto byte = static_cast<unsigned char>(data[i]);
+        for (int bit = 7; bit >= 0; --bit)
+        {
+            bits = (bits << 1) | ((byte >> bit) & 1);
+            ++bitsCount;
+            if (bitsCount < kMinCodeLength)
+                continue;
+            auto offset = bits - code.firstCode[bitsCount];
+            if (bits >= code.firstCode[bitsCount] &&
+                offset < code.count[bitsCount])
+            {
+                auto symbol =
+                    code.sortedSymbols[code.firstIndex[bitsCount] + offset];
+                if (symbol == kEos)
+                    return false;
+                out += static_cast<char>(symbol);
+                bits = 0;
+                bitsCount = 0;
+            }
+            else if (bitsCount == kMaxCodeLength)
+            {
+                return false;
+            }
+        }
+    }
+    // The padding is at most 7 bits of ones.
+    return bitsCount < 8 && bits == (1U << bitsCount) - 1;
+}
@@ -0,0 +1,159 @@
+/**
+ *
+ *  @file Hpack.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/string_view.h>
+#include <trantor/utils/NonCopyable.h>
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+using HpackHeaders = std::vector<std::pair<std::string, std::string>>;
+using HpackHeaderViews = std::vector<std::pair<string_view, string_view>>;
+
+/**
+ * @brief The dynamic table of HPACK (RFC 7541), the newest entry has the
+ * smallest index.
+ */
+class HpackTable
+{
+  public:
+    explicit HpackTable(size_t maxSize) : maxSize_(maxSize)
+    {
+    }
+    void add(string_view name, string_view value);
+    void setMaxSize(size_t maxSize);
+    size_t maxSize() const
+    {
+        return maxSize_;
+    }
+    size_t size() const
+    {
+        return size_;
+    }
+    size_t count() const
+    {
+        return entries_.size();
+    }
+    /// The index starts from 0 for the newest entry.
+    const std::pair<std::string, std::string> &at(size_t index) const
+    {
+        return entries_[index];
+    }
+
+    /// The size of an entry, the lengths of the strings plus 32.
+    static size_t entrySize(size_t nameLength, size_t valueLength)
+    {
+        return nameLength + valueLength + 32;
+    }
+
+  private:
+    void evict(size_t maxSize);
+    std::deque<std::pair<std::string, std::string>> entries_;
+    size_t size_{0};
+    size_t maxSize_;
+};
+
+/**
+ * @brief The decoder of the header blocks of a HTTP/2 connection.
+ */
+class HpackDecoder : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @param maxTableSize The SETTINGS_HEADER_TABLE_SIZE sent to the peer,
+     * the limit of the size of the dynamic table.
+     * @param maxHeaderListSize The limit of the decoded size of a header
+     * list.
+     */
+    HpackDecoder(size_t maxTableSize, size_t maxHeaderListSize);
+
+    /**
+     * @brief Decode a header block.
+     *
+     * @return false if the block is malformed, it's a connection error of
+     * COMPRESSION_ERROR type, because the dynamic table may be corrupted.
+     * @note When the header list is larger than the limit, the block is still
+     * decoded to keep the dynamic table in sync but the headers are dropped,
+     * headerListTooLarge() returns true then.
+     */
+    bool decode(const char *data, size_t length, HpackHeaders &headers);
+
+    bool headerListTooLarge() const
+    {
+        return headerListTooLarge_;
+    }
+
+  private:
+    HpackTable table_;
+    const size_t maxTableSize_;
+    const size_t maxHeaderListSize_;
+    bool headerListTooLarge_{false};
+};
+
+/**
+ * @brief The encoder of the header blocks of a HTTP/2 connection.
+ */
+class HpackEncoder : public trantor::NonCopyable
+{
+  public:
+    HpackEncoder() : table_(4096)
+    {
+    }
+
+    /**
+     * @brief Apply the SETTINGS_HEADER_TABLE_SIZE of the peer, the new size
+     * is signalled at the beginning of the next header block.
+     */
+    void setMaxTableSize(size_t maxSize);
+
+    /**
+     * @brief Append the header block of the headers to out. The names must be
+     * in lower case.
+     */
+    void encode(const HpackHeaderViews &headers, std::string &out);
+
+  private:
+    void encodeHeader(string_view name, string_view value, std::string &out);
+    // Return the index of the entry that matches the name and the value, or
+    // 0, and set nameIndex to the index of an entry with the name.
+    size_t find(string_view name, string_view value, size_t &nameIndex) const;
+
+    HpackTable table_;
+    size_t pendingMaxSize_{0};
+    size_t smallestPendingMaxSize_{0};
+    bool hasPendingMaxSize_{false};
+};
+
+namespace hpack
+{
+/// Append an integer with a prefix of the given bits, the first byte is or-ed
+/// with the flags.
+void encodeInteger(uint64_t value,
+                   int prefixBits,
+                   char flags,
+                   std::string &out);
+/// Append a string literal, huffman encoded if it's shorter.
+void encodeString(string_view str, std::string &out);
+/// Return false if the huffman code is invalid.
+bool huffmanDecode(const char *data, size_t length, std::string &out);
+void huffmanEncode(string_view str, std::string &out);
+size_t huffmanEncodedLength(string_view str);
+}  // namespace hpack
+}  // namespace drogon
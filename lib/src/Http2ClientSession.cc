@@ -0,0 +1,278 @@
+/**
+ *
+ *  @file Http2ClientSession.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http2ClientSession.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <string.h>
+
+using namespace drogon;
+
+namespace
+{
+// The headers of HTTP/1.x connections that are not allowed in HTTP/2
+// (RFC 7540 8.1.2.2), the host header is replaced by :authority.
+bool isConnectionSpecificHeader(string_view name)
+{
+    return name == "connection" || name == "keep-alive" ||
+           name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "upgrade" || name == "host";
+}
+}  // namespace
+
+Http2ClientSession::Http2ClientSession(
+    const trantor::TcpConnectionPtr &conn,
+    bool secure,
+    ResponseCallback &&responseCallback,
+    std::function<void()> &&streamClosedCallback)
+    : Http2Session(conn, false),
+      responseCallback_(std::move(responseCallback)),
+      streamClosedCallback_(std::move(streamClosedCallback)),
+      secure_(secure)
+{
+}
+
+void Http2ClientSession::sendRequest(RequestAndCallback &&reqAndCb)
+{
+    loop_->assertInLoopThread();
+    assert(canSendRequest());
+    // The request of HTTP/1.1 is rendered as usual and converted to a header
+    // list, so the parameters, the cookies and the uploaded files work as
+    // well.
+    trantor::MsgBuffer buffer;
+    static_cast<HttpRequestImpl *>(reqAndCb.first.get())
+        ->appendToBuffer(&buffer);
+    auto request =
+        std::make_shared<std::string>(buffer.peek(), buffer.readableBytes());
+    auto lineEnd = request->find("\r\n");
+    auto headerEnd = request->find("\r\n\r\n");
+    auto methodEnd = request->find(' ');
+    auto targetEnd = request->rfind(' ', lineEnd);
+    if (headerEnd == std::string::npos || methodEnd >= targetEnd)
+    {
+        LOG_ERROR << "Can't send the request with HTTP/2";
+        reqAndCb.second(ReqResult::BadResponse, nullptr);
+        return;
+    }
+    HpackHeaderViews headers;
+    headers.emplace_back(":method", string_view(request->data(), methodEnd));
+    headers.emplace_back(":scheme", secure_ ? "https" : "http");
+    headers.emplace_back(":authority", string_view());
+    headers.emplace_back(":path",
+                         string_view(request->data() + methodEnd + 1,
+                                     targetEnd - methodEnd - 1));
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd + 2)
+    {
+        lineEnd = request->find("\r\n", pos);
+        auto colon = request->find(':', pos);
+        if (colon != std::string::npos && colon < lineEnd)
+        {
+            std::transform(request->begin() + pos,
+                           request->begin() + colon,
+                           request->begin() + pos,
+                           ::tolower);
+            string_view name(request->data() + pos, colon - pos);
+            auto valueBegin = colon + 1;
+            while (valueBegin < lineEnd && (*request)[valueBegin] == ' ')
+                ++valueBegin;
+            string_view value(request->data() + valueBegin,
+                              lineEnd - valueBegin);
+            if (name == "host")
+                headers[2].second = value;
+            else if (!isConnectionSpecificHeader(name) &&
+                     (name != "te" || value == "trailers"))
+                headers.emplace_back(name, value);
+        }
+        pos = lineEnd + 2;
+    }
+    if (headers[2].second.empty())
+        headers.erase(headers.begin() + 2);
+
+    auto streamId = openStream();
+    responses_[streamId].reqAndCb = std::move(reqAndCb);
+    size_t offset = headerEnd + 4;
+    if (offset == request->length())
+    {
+        sendHeaders(streamId, headers, true);
+    }
+    else
+    {
+        sendHeaders(streamId, headers, false);
+        sendData(streamId,
+                 [request, offset](char *data, size_t size, bool &eof) mutable {
+                     auto length =
+                         std::min(size, request->length() - offset);
+                     memcpy(data, request->data() + offset, length);
+                     offset += length;
+                     eof = offset == request->length();
+                     return length;
+                 });
+    }
+    flush();
+}
+
+void Http2ClientSession::onHeaders(uint32_t streamId,
+                                   HpackHeaders &&headers,
+                                   bool endStream,
+                                   bool headerListTooLarge)
+{
+    auto iter = responses_.find(streamId);
+    if (iter == responses_.end())
+        return;
+    auto &pending = iter->second;
+    if (pending.response)
+    {
+        // Trailers, which are ignored like the ones of chunked responses.
+        if (endStream)
+            complete(iter);
+        else
+            fail(streamId, kProtocolError);
+        return;
+    }
+    if (headerListTooLarge)
+    {
+        fail(streamId, kCancel);
+        return;
+    }
+    int status = 0;
+    auto response = std::make_shared<HttpResponseImpl>();
+    response->setVersion(Version::kHttp2);
+    std::string line;
+    for (auto &header : headers)
+    {
+        auto &name = header.first;
+        if (name == ":status")
+        {
+            auto &value = header.second;
+            if (value.length() == 3 &&
+                std::all_of(value.begin(), value.end(), ::isdigit))
+                status = std::stoi(value);
+            continue;
+        }
+        if (name.empty() || name[0] == ':')
+            continue;
+        line = name;
+        line += ':';
+        line += header.second;
+        response->addHeader(line.data(),
+                            line.data() + name.length(),
+                            line.data() + line.length());
+    }
+    if (status < 100 || (status < 200 && endStream))
+    {
+        fail(streamId, kProtocolError);
+        return;
+    }
+    // The informational responses are skipped.
+    if (status < 200)
+        return;
+    response->setStatusCode(static_cast<HttpStatusCode>(status));
+    pending.response = std::move(response);
+    if (endStream)
+        complete(iter);
+}
+
+void Http2ClientSession::onData(uint32_t streamId,
+                                const char *data,
+                                size_t length,
+                                bool endStream)
+{
+    auto iter = responses_.find(streamId);
+    if (iter == responses_.end())
+        return;
+    if (!iter->second.response)
+    {
+        fail(streamId, kProtocolError);
+        return;
+    }
+    iter->second.body.append(data, length);
+    if (endStream)
+        complete(iter);
+}
+
+void Http2ClientSession::complete(PendingResponses::iterator iter)
+{
+    auto pending = std::move(iter->second);
+    responses_.erase(iter);
+    if (!pending.body.empty())
+        pending.response->setBody(std::move(pending.body));
+    responseCallback_(pending.response, std::move(pending.reqAndCb));
+}
+
+void Http2ClientSession::fail(uint32_t streamId, ErrorCode errorCode)
+{
+    auto iter = responses_.find(streamId);
+    if (iter != responses_.end())
+    {
+        auto callback = std::move(iter->second.reqAndCb.second);
+        responses_.erase(iter);
+        callback(ReqResult::BadResponse, nullptr);
+    }
+    resetStream(streamId, errorCode);
+}
+
+void Http2ClientSession::onStreamClosed(uint32_t streamId, uint32_t errorCode)
+{
+    auto iter = responses_.find(streamId);
+    if (iter != responses_.end())
+    {
+        auto reqAndCb = std::move(iter->second.reqAndCb);
+        responses_.erase(iter);
+        // A refused stream is not processed, so it's safe to retry
+        // (RFC 7540 8.1.4).
+        if (errorCode == kRefusedStream)
+            unprocessed_.push_back(std::move(reqAndCb));
+        else
+            reqAndCb.second(errorCode == kCancel ? ReqResult::NetworkFailure
+                                                 : ReqResult::BadResponse,
+                            nullptr);
+    }
+    if (streamClosedCallback_)
+        streamClosedCallback_();
+}
+
+void Http2ClientSession::onGoAway(uint32_t lastStreamId, uint32_t errorCode)
+{
+    LOG_DEBUG << "GOAWAY received, last stream " << lastStreamId
+              << ", error code " << errorCode;
+    // The streams after the last one are not processed by the server.
+    std::vector<uint32_t> streamIds;
+    for (auto iter = responses_.upper_bound(lastStreamId);
+         iter != responses_.end();)
+    {
+        streamIds.push_back(iter->first);
+        unprocessed_.push_back(std::move(iter->second.reqAndCb));
+        iter = responses_.erase(iter);
+    }
+    for (auto streamId : streamIds)
+        resetStream(streamId, kCancel);
+}
+
+void Http2ClientSession::abandonStreams()
+{
+    for (auto &item : responses_)
+        unprocessed_.push_back(std::move(item.second.reqAndCb));
+    responses_.clear();
+}
+
+std::vector<Http2ClientSession::RequestAndCallback>
+Http2ClientSession::takeUnprocessedRequests()
+{
+    auto requests = std::move(unprocessed_);
+    unprocessed_.clear();
+    return requests;
+}
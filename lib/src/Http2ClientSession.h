@@ -0,0 +1,102 @@
+/**
+ *
+ *  @file Http2ClientSession.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Http2Session.h"
+#include "impl_forwards.h"
+#include <drogon/HttpClient.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The client side of a HTTP/2 connection. Every request is sent on a
+ * new stream, at most as many as the server allows at the same time, and the
+ * response is built in a HttpResponseImpl object.
+ */
+class Http2ClientSession final : public Http2Session
+{
+  public:
+    using RequestAndCallback = std::pair<HttpRequestPtr, HttpReqCallback>;
+    /// Called with a complete response, the callback of the request is not
+    /// called by the session in this case.
+    using ResponseCallback =
+        std::function<void(const HttpResponseImplPtr &, RequestAndCallback &&)>;
+
+    Http2ClientSession(const trantor::TcpConnectionPtr &conn,
+                       bool secure,
+                       ResponseCallback &&responseCallback,
+                       std::function<void()> &&streamClosedCallback);
+
+    /// True if a new stream can be opened for a request.
+    bool canSendRequest() const
+    {
+        return !closed() && !goAwayReceived() &&
+               numberOfStreams() < peerMaxConcurrentStreams();
+    }
+
+    /// True if no more responses are expected on the connection.
+    bool finished() const
+    {
+        return (closed() || goAwayReceived()) && responses_.empty();
+    }
+
+    void sendRequest(RequestAndCallback &&reqAndCb);
+
+    /**
+     * @brief Return the requests that were not processed by the server, i.e.
+     * the ones refused or beyond the last stream of GOAWAY, which can be sent
+     * again on another connection.
+     */
+    std::vector<RequestAndCallback> takeUnprocessedRequests();
+
+    /// Give up all the requests on the streams without calling back, they
+    /// are returned by takeUnprocessedRequests().
+    void abandonStreams();
+
+  protected:
+    void onHeaders(uint32_t streamId,
+                   HpackHeaders &&headers,
+                   bool endStream,
+                   bool headerListTooLarge) override;
+    void onData(uint32_t streamId,
+                const char *data,
+                size_t length,
+                bool endStream) override;
+    void onStreamClosed(uint32_t streamId, uint32_t errorCode) override;
+    void onGoAway(uint32_t lastStreamId, uint32_t errorCode) override;
+
+  private:
+    struct PendingResponse
+    {
+        RequestAndCallback reqAndCb;
+        HttpResponseImplPtr response;
+        std::string body;
+    };
+    using PendingResponses = std::map<uint32_t, PendingResponse>;
+    void complete(PendingResponses::iterator iter);
+    void fail(uint32_t streamId, ErrorCode errorCode);
+
+    ResponseCallback responseCallback_;
+    std::function<void()> streamClosedCallback_;
+    PendingResponses responses_;
+    std::vector<RequestAndCallback> unprocessed_;
+    bool secure_;
+};
+
+}  // namespace drogon
@@ -0,0 +1,353 @@
+/**
+ *
+ *  @file Http2ServerSession.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http2ServerSession.h"
+#include "HttpAppFrameworkImpl.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+using namespace drogon;
+
+namespace
+{
+// The headers of HTTP/1.x connections that are not allowed in HTTP/2
+// (RFC 7540 8.1.2.2).
+bool isConnectionSpecificHeader(string_view name)
+{
+    return name == "connection" || name == "keep-alive" ||
+           name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "upgrade";
+}
+}  // namespace
+
+Http2ServerSession::Http2ServerSession(const trantor::TcpConnectionPtr &conn,
+                                       RequestCallback &&callback)
+    : Http2Session(conn, true),
+      requestCallback_(std::move(callback)),
+      peerAddr_(conn->peerAddr()),
+      localAddr_(conn->localAddr()),
+      secure_(conn->isSSLConnection())
+{
+}
+
+void Http2ServerSession::onHeaders(uint32_t streamId,
+                                   HpackHeaders &&headers,
+                                   bool endStream,
+                                   bool headerListTooLarge)
+{
+    // The pending request is removed before anything is sent on the stream,
+    // because the stream may be closed by that.
+    auto iter = requests_.find(streamId);
+    if (iter != requests_.end())
+    {
+        // Trailers, which are ignored like the ones of chunked HTTP/1.1
+        // requests.
+        if (!endStream)
+        {
+            requests_.erase(iter);
+            resetStream(streamId, kProtocolError);
+            return;
+        }
+        auto pending = std::move(iter->second);
+        requests_.erase(iter);
+        dispatch(streamId, pending);
+        return;
+    }
+    // The DATA frames of a stream without a pending request are ignored, so
+    // an error response can be sent right away.
+    if (headerListTooLarge)
+    {
+        sendError(streamId, k431RequestHeaderFieldsTooLarge);
+        return;
+    }
+    PendingRequest pending;
+    pending.request = makeRequest(streamId, headers, pending);
+    if (!pending.request)
+        return;
+    if (endStream)
+        dispatch(streamId, pending);
+    else
+        requests_.emplace(streamId, std::move(pending));
+}
+
+HttpRequestImplPtr Http2ServerSession::makeRequest(uint32_t streamId,
+                                                   HpackHeaders &headers,
+                                                   PendingRequest &pending)
+{
+    auto req = std::make_shared<HttpRequestImpl>(loop_);
+    req->setVersion(Version::kHttp2);
+    const std::string *method{nullptr};
+    const std::string *path{nullptr};
+    const std::string *scheme{nullptr};
+    const std::string *authority{nullptr};
+    bool regularHeaderFound = false;
+    bool malformed = false;
+    std::string line;
+    for (auto &header : headers)
+    {
+        auto &name = header.first;
+        if (name.empty() ||
+            std::any_of(name.begin(), name.end(), [](char c) {
+                return c >= 'A' && c <= 'Z';
+            }))
+        {
+            malformed = true;
+            break;
+        }
+        if (name[0] == ':')
+        {
+            // The pseudo-headers must precede the regular ones and appear
+            // once.
+            const std::string **field{nullptr};
+            if (name == ":method")
+                field = &method;
+            else if (name == ":path")
+                field = &path;
+            else if (name == ":scheme")
+                field = &scheme;
+            else if (name == ":authority")
+                field = &authority;
+            if (!field || *field || regularHeaderFound)
+            {
+                malformed = true;
+                break;
+            }
+            *field = &header.second;
+            continue;
+        }
+        regularHeaderFound = true;
+        if (isConnectionSpecificHeader(name) ||
+            (name == "te" && header.second != "trailers"))
+        {
+            malformed = true;
+            break;
+        }
+        line = name;
+        line += ':';
+        line += header.second;
+        req->addHeader(line.data(),
+                       line.data() + name.length(),
+                       line.data() + line.length());
+    }
+    if (malformed || !method || !scheme || !path || path->empty())
+    {
+        resetStream(streamId, kProtocolError);
+        return nullptr;
+    }
+    if (!req->setMethod(method->data(), method->data() + method->length()))
+    {
+        sendError(streamId, k405MethodNotAllowed);
+        return nullptr;
+    }
+    auto question = path->find('?');
+    if (question != std::string::npos)
+    {
+        req->setPath(path->data(), path->data() + question);
+        req->setQuery(path->data() + question + 1,
+                      path->data() + path->length());
+    }
+    else
+    {
+        req->setPath(path->data(), path->data() + path->length());
+    }
+    if (authority && req->getHeaderBy("host").empty())
+        req->addHeader("host", *authority);
+
+    auto &contentLength = req->getHeaderBy("content-length");
+    if (!contentLength.empty())
+    {
+        try
+        {
+            pending.contentLength = std::stoull(contentLength);
+        }
+        catch (...)
+        {
+            resetStream(streamId, kProtocolError);
+            return nullptr;
+        }
+        pending.hasContentLength = true;
+        if (pending.contentLength >
+            HttpAppFrameworkImpl::instance().getClientMaxBodySize())
+        {
+            sendError(streamId, k413RequestEntityTooLarge);
+            return nullptr;
+        }
+        req->reserveBodySize(pending.contentLength);
+    }
+    return req;
+}
+
+void Http2ServerSession::onData(uint32_t streamId,
+                                const char *data,
+                                size_t length,
+                                bool endStream)
+{
+    auto iter = requests_.find(streamId);
+    if (iter == requests_.end())
+        return;
+    auto &pending = iter->second;
+    pending.bodyLength += length;
+    if (pending.bodyLength >
+            HttpAppFrameworkImpl::instance().getClientMaxBodySize() ||
+        (pending.hasContentLength &&
+         pending.bodyLength > pending.contentLength))
+    {
+        bool hasContentLength = pending.hasContentLength;
+        requests_.erase(iter);
+        if (hasContentLength)
+            resetStream(streamId, kProtocolError);
+        else
+            sendError(streamId, k413RequestEntityTooLarge);
+        return;
+    }
+    if (length > 0)
+        pending.request->appendToBody(data, length);
+    if (endStream)
+    {
+        auto request = std::move(pending);
+        requests_.erase(iter);
+        dispatch(streamId, request);
+    }
+}
+
+void Http2ServerSession::dispatch(uint32_t streamId, PendingRequest &pending)
+{
+    // The length must match the content-length header (RFC 7540 8.1.2.6).
+    if (pending.hasContentLength && pending.bodyLength != pending.contentLength)
+    {
+        resetStream(streamId, kProtocolError);
+        return;
+    }
+    auto &req = pending.request;
+    req->setPeerAddr(peerAddr_);
+    req->setLocalAddr(localAddr_);
+    req->setCreationDate(trantor::Date::date());
+    req->setSecure(secure_);
+    HttpAppFrameworkImpl::instance().startTraceIfSampled(req);
+    requestCallback_(shared_from_this(), req, streamId);
+}
+
+void Http2ServerSession::sendError(uint32_t streamId, HttpStatusCode code)
+{
+    sendResponse(streamId,
+                 HttpAppFrameworkImpl::instance().getCustomErrorHandler()(code),
+                 false);
+}
+
+void Http2ServerSession::onStreamClosed(uint32_t streamId,
+                                        uint32_t /*errorCode*/)
+{
+    requests_.erase(streamId);
+}
+
+void Http2ServerSession::sendResponse(uint32_t streamId,
+                                      const HttpResponsePtr &response,
+                                      bool isHeadMethod)
+{
+    loop_->assertInLoopThread();
+    if (closed() || !hasStream(streamId))
+        return;
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    // The header of HTTP/1.1 is rendered as usual and converted to a header
+    // list, so the advices, the cookies and the cached responses work as
+    // well.
+    auto buffer = respImplPtr->renderHeaderForHeadMethod();
+    std::string header(buffer->peek(), buffer->readableBytes());
+    HpackHeaderViews headers;
+    auto lineEnd = header.find("\r\n");
+    auto space = header.find(' ');
+    if (lineEnd == std::string::npos || space == std::string::npos ||
+        space + 4 > lineEnd)
+    {
+        resetStream(streamId, kInternalError);
+        flush();
+        return;
+    }
+    string_view status(header.data() + space + 1, 3);
+    headers.emplace_back(":status", status);
+    size_t pos = lineEnd + 2;
+    while ((lineEnd = header.find("\r\n", pos)) != std::string::npos &&
+           lineEnd > pos)
+    {
+        auto colon = header.find(':', pos);
+        if (colon != std::string::npos && colon < lineEnd)
+        {
+            std::transform(header.begin() + pos,
+                           header.begin() + colon,
+                           header.begin() + pos,
+                           ::tolower);
+            string_view name(header.data() + pos, colon - pos);
+            auto valueBegin = colon + 1;
+            while (valueBegin < lineEnd && header[valueBegin] == ' ')
+                ++valueBegin;
+            if (!isConnectionSpecificHeader(name))
+                headers.emplace_back(name,
+                                     string_view(header.data() + valueBegin,
+                                                 lineEnd - valueBegin));
+        }
+        pos = lineEnd + 2;
+    }
+
+    auto statusCode = respImplPtr->statusCode();
+    bool noBody = isHeadMethod || statusCode == k204NoContent ||
+                  statusCode == k304NotModified || statusCode < k200OK;
+    auto &sendfileName = respImplPtr->sendfileName();
+    if (noBody || (sendfileName.empty() && respImplPtr->getBodyLength() == 0))
+    {
+        sendHeaders(streamId, headers, true);
+    }
+    else if (!sendfileName.empty())
+    {
+        auto file = std::make_shared<std::ifstream>(
+            utils::toNativePath(sendfileName), std::ifstream::binary);
+        if (!*file)
+        {
+            LOG_ERROR << "Can't open " << sendfileName;
+            resetStream(streamId, kInternalError);
+            flush();
+            return;
+        }
+        sendHeaders(streamId, headers, false);
+        sendData(streamId, [file](char *data, size_t size, bool &eof) {
+            file->read(data, static_cast<std::streamsize>(size));
+            auto length = static_cast<size_t>(file->gcount());
+            eof = length < size;
+            return length;
+        });
+    }
+    else
+    {
+        sendHeaders(streamId, headers, false);
+        // The response is kept until its body is sent.
+        size_t offset = 0;
+        sendData(streamId,
+                 [response, respImplPtr, offset](char *data,
+                                                 size_t size,
+                                                 bool &eof) mutable {
+                     auto length = std::min(size,
+                                            respImplPtr->getBodyLength() -
+                                                offset);
+                     memcpy(data, respImplPtr->getBodyData() + offset, length);
+                     offset += length;
+                     eof = offset == respImplPtr->getBodyLength();
+                     return length;
+                 });
+    }
+    flush();
+}
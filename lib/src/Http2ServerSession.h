@@ -0,0 +1,84 @@
+/**
+ *
+ *  @file Http2ServerSession.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Http2Session.h"
+#include "impl_forwards.h"
+#include <drogon/HttpTypes.h>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief The server side of a HTTP/2 connection. Every stream carries a
+ * request, which is built in a HttpRequestImpl object and handled like a
+ * HTTP/1.x request, the response is sent on the same stream.
+ */
+class Http2ServerSession final
+    : public Http2Session,
+      public std::enable_shared_from_this<Http2ServerSession>
+{
+  public:
+    using RequestCallback =
+        std::function<void(const std::shared_ptr<Http2ServerSession> &,
+                           const HttpRequestImplPtr &,
+                           uint32_t streamId)>;
+
+    Http2ServerSession(const trantor::TcpConnectionPtr &conn,
+                       RequestCallback &&callback);
+
+    /**
+     * @brief Send the response on the stream, it's discarded if the stream
+     * was reset by the client.
+     */
+    void sendResponse(uint32_t streamId,
+                      const HttpResponsePtr &response,
+                      bool isHeadMethod);
+
+  protected:
+    void onHeaders(uint32_t streamId,
+                   HpackHeaders &&headers,
+                   bool endStream,
+                   bool headerListTooLarge) override;
+    void onData(uint32_t streamId,
+                const char *data,
+                size_t length,
+                bool endStream) override;
+    void onStreamClosed(uint32_t streamId, uint32_t errorCode) override;
+
+  private:
+    struct PendingRequest
+    {
+        HttpRequestImplPtr request;
+        size_t contentLength{0};
+        size_t bodyLength{0};
+        bool hasContentLength{false};
+    };
+    HttpRequestImplPtr makeRequest(uint32_t streamId,
+                                   HpackHeaders &headers,
+                                   PendingRequest &pending);
+    void dispatch(uint32_t streamId, PendingRequest &pending);
+    void sendError(uint32_t streamId, HttpStatusCode code);
+
+    RequestCallback requestCallback_;
+    std::unordered_map<uint32_t, PendingRequest> requests_;
+    trantor::InetAddress peerAddr_;
+    trantor::InetAddress localAddr_;
+    bool secure_;
+};
+
+}  // namespace drogon
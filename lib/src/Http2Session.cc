@@ -0,0 +1,771 @@
+/**
+ *
+ *  @file Http2Session.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http2Session.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+enum FrameType : uint8_t
+{
+    kData = 0x0,
+    kHeaders = 0x1,
+    kPriority = 0x2,
+    kRstStream = 0x3,
+    kSettings = 0x4,
+    kPushPromise = 0x5,
+    kPing = 0x6,
+    kGoAway = 0x7,
+    kWindowUpdate = 0x8,
+    kContinuation = 0x9
+};
+enum FrameFlag : uint8_t
+{
+    kEndStream = 0x1,
+    kAck = 0x1,
+    kEndHeaders = 0x4,
+    kPadded = 0x8,
+    kPriorityFlag = 0x20
+};
+enum SettingId : uint16_t
+{
+    kHeaderTableSize = 0x1,
+    kEnablePush = 0x2,
+    kMaxConcurrentStreams = 0x3,
+    kInitialWindowSize = 0x4,
+    kMaxFrameSize = 0x5,
+    kMaxHeaderListSize = 0x6
+};
+
+constexpr size_t kFrameHeaderLength = 9;
+constexpr uint32_t kDefaultWindowSize = 65535;
+constexpr int64_t kMaxWindowSize = 0x7fffffff;
+// The settings of this side.
+constexpr uint32_t kLocalWindowSize = 1024 * 1024;
+constexpr uint32_t kLocalMaxFrameSize = 16384;
+constexpr uint32_t kLocalMaxConcurrentStreams = 100;
+constexpr uint32_t kLocalHeaderTableSize = 4096;
+constexpr uint32_t kLocalMaxHeaderListSize = 64 * 1024;
+// The limit of a compressed header block in several frames.
+constexpr size_t kMaxHeaderBlockSize = 256 * 1024;
+
+uint32_t readUint32(const char *p)
+{
+    auto u = reinterpret_cast<const unsigned char *>(p);
+    return (static_cast<uint32_t>(u[0]) << 24) |
+           (static_cast<uint32_t>(u[1]) << 16) |
+           (static_cast<uint32_t>(u[2]) << 8) | static_cast<uint32_t>(u[3]);
+}
+
+void appendUint32(std::string &out, uint32_t value)
+{
+    out += static_cast<char>(value >> 24);
+    out += static_cast<char>(value >> 16);
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value);
+}
+
+void appendSetting(std::string &out, uint16_t id, uint32_t value)
+{
+    out += static_cast<char>(id >> 8);
+    out += static_cast<char>(id);
+    appendUint32(out, value);
+}
+
+// Remove the padding of a DATA or HEADERS frame.
+bool removePadding(uint8_t flags, const char *&payload, size_t &length)
+{
+    if (!(flags & kPadded))
+        return true;
+    if (length < 1)
+        return false;
+    size_t padLength = static_cast<unsigned char>(payload[0]);
+    ++payload;
+    --length;
+    if (padLength > length)
+        return false;
+    length -= padLength;
+    return true;
+}
+}  // namespace
+
+const string_view Http2Session::kClientPreface{
+    "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n",
+    24};
+
+Http2Session::Http2Session(const trantor::TcpConnectionPtr &conn,
+                           bool isServer)
+    : loop_(conn->getLoop()),
+      conn_(conn),
+      isServer_(isServer),
+      decoder_(kLocalHeaderTableSize, kLocalMaxHeaderListSize),
+      nextStreamId_(isServer ? 2 : 1),
+      connectionRecvWindow_(kDefaultWindowSize)
+{
+}
+
+void Http2Session::start()
+{
+    if (!isServer_)
+        output_.append(kClientPreface.data(), kClientPreface.length());
+    std::string settings;
+    appendSetting(settings, kHeaderTableSize, kLocalHeaderTableSize);
+    if (isServer_)
+        appendSetting(settings,
+                      kMaxConcurrentStreams,
+                      kLocalMaxConcurrentStreams);
+    else
+        appendSetting(settings, kEnablePush, 0);
+    appendSetting(settings, kInitialWindowSize, kLocalWindowSize);
+    appendSetting(settings, kMaxFrameSize, kLocalMaxFrameSize);
+    appendSetting(settings, kMaxHeaderListSize, kLocalMaxHeaderListSize);
+    writeFrameHeader(settings.length(), kSettings, 0, 0);
+    output_ += settings;
+    // The window of the connection can only be enlarged by WINDOW_UPDATE.
+    sendWindowUpdate(0, kLocalWindowSize - kDefaultWindowSize);
+    connectionRecvWindow_ = kLocalWindowSize;
+    flush();
+}
+
+bool Http2Session::onMessage(trantor::MsgBuffer *buffer)
+{
+    if (closed_)
+    {
+        buffer->retrieveAll();
+        return false;
+    }
+    if (isServer_ && !prefaceReceived_)
+    {
+        if (buffer->readableBytes() < kClientPreface.length())
+            return true;
+        if (memcmp(buffer->peek(),
+                   kClientPreface.data(),
+                   kClientPreface.length()) != 0)
+        {
+            connectionError(kProtocolError, "Invalid connection preface");
+            buffer->retrieveAll();
+            return false;
+        }
+        buffer->retrieve(kClientPreface.length());
+        prefaceReceived_ = true;
+    }
+    while (buffer->readableBytes() >= kFrameHeaderLength)
+    {
+        auto p = reinterpret_cast<const unsigned char *>(buffer->peek());
+        size_t length = (static_cast<size_t>(p[0]) << 16) |
+                        (static_cast<size_t>(p[1]) << 8) | p[2];
+        uint8_t type = p[3];
+        uint8_t flags = p[4];
+        uint32_t streamId = readUint32(buffer->peek() + 5) & 0x7fffffff;
+        if (length > kLocalMaxFrameSize)
+        {
+            connectionError(kFrameSizeError, "Frame too large");
+            break;
+        }
+        if (buffer->readableBytes() < kFrameHeaderLength + length)
+            break;
+        if (!processFrame(type,
+                          flags,
+                          streamId,
+                          buffer->peek() + kFrameHeaderLength,
+                          length))
+            break;
+        buffer->retrieve(kFrameHeaderLength + length);
+    }
+    if (closed_)
+    {
+        buffer->retrieveAll();
+        return false;
+    }
+    flush();
+    return true;
+}
+
+void Http2Session::onClose()
+{
+    closed_ = true;
+    output_.clear();
+    auto streams = std::move(streams_);
+    streams_.clear();
+    for (auto &stream : streams)
+        onStreamClosed(stream.first, kCancel);
+}
+
+bool Http2Session::processFrame(uint8_t type,
+                                uint8_t flags,
+                                uint32_t streamId,
+                                const char *payload,
+                                size_t length)
+{
+    // The first frame of the peer must be SETTINGS.
+    if (!settingsReceived_ && type != kSettings)
+    {
+        connectionError(kProtocolError, "SETTINGS expected");
+        return false;
+    }
+    // A header block must not be interleaved with other frames.
+    if (headerStreamId_ != 0 &&
+        (type != kContinuation || streamId != headerStreamId_))
+    {
+        connectionError(kProtocolError, "CONTINUATION expected");
+        return false;
+    }
+    switch (type)
+    {
+        case kData:
+            return processData(flags, streamId, payload, length);
+        case kHeaders:
+            return processHeaders(flags, streamId, payload, length);
+        case kContinuation:
+            if (headerStreamId_ == 0)
+            {
+                connectionError(kProtocolError, "Unexpected CONTINUATION");
+                return false;
+            }
+            if (headerBlock_.length() + length > kMaxHeaderBlockSize)
+            {
+                connectionError(kEnhanceYourCalm, "Header block too large");
+                return false;
+            }
+            headerBlock_.append(payload, length);
+            if (flags & kEndHeaders)
+                return processHeaderBlock();
+            return true;
+        case kPriority:
+            if (streamId == 0)
+            {
+                connectionError(kProtocolError, "PRIORITY on stream 0");
+                return false;
+            }
+            if (length != 5)
+            {
+                resetStream(streamId, kFrameSizeError);
+            }
+            // The priorities are ignored.
+            return true;
+        case kRstStream:
+            if (streamId == 0 || length != 4)
+            {
+                connectionError(streamId == 0 ? kProtocolError
+                                              : kFrameSizeError,
+                                "Invalid RST_STREAM");
+                return false;
+            }
+            if (streamId > lastPeerStreamId_ && streamId >= nextStreamId_)
+            {
+                connectionError(kProtocolError, "RST_STREAM on idle stream");
+                return false;
+            }
+            closeStream(streamId, readUint32(payload));
+            return true;
+        case kSettings:
+            return processSettings(flags, streamId, payload, length);
+        case kPushPromise:
+            // Server push is disabled by the SETTINGS of the client, and a
+            // client never sends it.
+            connectionError(kProtocolError, "Unexpected PUSH_PROMISE");
+            return false;
+        case kPing:
+            if (streamId != 0 || length != 8)
+            {
+                connectionError(streamId != 0 ? kProtocolError
+                                              : kFrameSizeError,
+                                "Invalid PING");
+                return false;
+            }
+            if (!(flags & kAck))
+            {
+                writeFrameHeader(8, kPing, kAck, 0);
+                output_.append(payload, 8);
+            }
+            return true;
+        case kGoAway:
+            if (streamId != 0 || length < 8)
+            {
+                connectionError(kProtocolError, "Invalid GOAWAY");
+                return false;
+            }
+            goAwayReceived_ = true;
+            onGoAway(readUint32(payload) & 0x7fffffff, readUint32(payload + 4));
+            return !closed_;
+        case kWindowUpdate:
+            return processWindowUpdate(streamId, payload, length);
+        default:
+            // Unknown frames are ignored.
+            return true;
+    }
+}
+
+bool Http2Session::processHeaders(uint8_t flags,
+                                  uint32_t streamId,
+                                  const char *payload,
+                                  size_t length)
+{
+    if (streamId == 0 || !removePadding(flags, payload, length))
+    {
+        connectionError(kProtocolError, "Invalid HEADERS");
+        return false;
+    }
+    if (flags & kPriorityFlag)
+    {
+        if (length < 5)
+        {
+            connectionError(kFrameSizeError, "Invalid HEADERS");
+            return false;
+        }
+        payload += 5;
+        length -= 5;
+    }
+    headerStreamId_ = streamId;
+    headerEndStream_ = (flags & kEndStream) != 0;
+    headerBlock_.assign(payload, length);
+    if (flags & kEndHeaders)
+        return processHeaderBlock();
+    return true;
+}
+
+bool Http2Session::processHeaderBlock()
+{
+    auto streamId = headerStreamId_;
+    bool endStream = headerEndStream_;
+    headerStreamId_ = 0;
+    HpackHeaders headers;
+    // The block is always decoded to keep the dynamic table in sync.
+    if (!decoder_.decode(headerBlock_.data(), headerBlock_.length(), headers))
+    {
+        connectionError(kCompressionError, "Invalid header block");
+        return false;
+    }
+    headerBlock_.clear();
+    auto iter = streams_.find(streamId);
+    if (iter == streams_.end())
+    {
+        // Only the peer can open a new stream with a HEADERS frame.
+        bool peerStream = isServer_ ? (streamId & 1) == 1 : false;
+        if (!peerStream || streamId <= lastPeerStreamId_)
+        {
+            if (peerStream || streamId < nextStreamId_)
+            {
+                // The stream was closed, e.g. reset by this side.
+                resetStream(streamId, kStreamClosed);
+                return true;
+            }
+            connectionError(kProtocolError, "Invalid stream id");
+            return false;
+        }
+        lastPeerStreamId_ = streamId;
+        if (goAwayReceived_ || streams_.size() >= kLocalMaxConcurrentStreams)
+        {
+            resetStream(streamId, kRefusedStream);
+            return true;
+        }
+        createStream(streamId);
+    }
+    else if (iter->second.remoteClosed)
+    {
+        resetStream(streamId, kStreamClosed);
+        return true;
+    }
+    if (endStream)
+        streams_[streamId].remoteClosed = true;
+    onHeaders(streamId,
+              std::move(headers),
+              endStream,
+              decoder_.headerListTooLarge());
+    if (endStream)
+        closeRemote(streamId);
+    return !closed_;
+}
+
+bool Http2Session::processData(uint8_t flags,
+                               uint32_t streamId,
+                               const char *payload,
+                               size_t length)
+{
+    if (streamId == 0)
+    {
+        connectionError(kProtocolError, "DATA on stream 0");
+        return false;
+    }
+    // The whole frame, with the padding, counts for the flow control.
+    auto frameLength = length;
+    if (static_cast<int64_t>(frameLength) > connectionRecvWindow_)
+    {
+        connectionError(kFlowControlError, "Connection window exceeded");
+        return false;
+    }
+    connectionRecvWindow_ -= frameLength;
+    connectionUnacknowledged_ += frameLength;
+    if (connectionUnacknowledged_ >= kLocalWindowSize / 2)
+    {
+        sendWindowUpdate(0, static_cast<uint32_t>(connectionUnacknowledged_));
+        connectionRecvWindow_ += connectionUnacknowledged_;
+        connectionUnacknowledged_ = 0;
+    }
+    if (!removePadding(flags, payload, length))
+    {
+        connectionError(kProtocolError, "Invalid padding");
+        return false;
+    }
+    auto iter = streams_.find(streamId);
+    if (iter == streams_.end() || iter->second.remoteClosed)
+    {
+        if (iter == streams_.end() && streamId > lastPeerStreamId_ &&
+            streamId >= nextStreamId_)
+        {
+            connectionError(kProtocolError, "DATA on idle stream");
+            return false;
+        }
+        resetStream(streamId, kStreamClosed);
+        return true;
+    }
+    auto &stream = iter->second;
+    stream.unacknowledged += frameLength;
+    if (stream.unacknowledged > kLocalWindowSize)
+    {
+        resetStream(streamId, kFlowControlError);
+        return true;
+    }
+    bool endStream = (flags & kEndStream) != 0;
+    if (endStream)
+        stream.remoteClosed = true;
+    onData(streamId, payload, length, endStream);
+    if (endStream)
+    {
+        closeRemote(streamId);
+        return !closed_;
+    }
+    iter = streams_.find(streamId);
+    if (iter != streams_.end() &&
+        iter->second.unacknowledged >= kLocalWindowSize / 2)
+    {
+        sendWindowUpdate(streamId,
+                         static_cast<uint32_t>(iter->second.unacknowledged));
+        iter->second.unacknowledged = 0;
+    }
+    return !closed_;
+}
+
+bool Http2Session::processSettings(uint8_t flags,
+                                   uint32_t streamId,
+                                   const char *payload,
+                                   size_t length)
+{
+    if (streamId != 0)
+    {
+        connectionError(kProtocolError, "SETTINGS on a stream");
+        return false;
+    }
+    if (flags & kAck)
+    {
+        if (length != 0)
+        {
+            connectionError(kFrameSizeError, "Invalid SETTINGS ack");
+            return false;
+        }
+        return true;
+    }
+    if (length % 6 != 0)
+    {
+        connectionError(kFrameSizeError, "Invalid SETTINGS");
+        return false;
+    }
+    settingsReceived_ = true;
+    for (size_t i = 0; i < length; i += 6)
+    {
+        auto p = reinterpret_cast<const unsigned char *>(payload + i);
+        uint16_t id = static_cast<uint16_t>((p[0] << 8) | p[1]);
+        auto value = readUint32(payload + i + 2);
+        switch (id)
+        {
+            case kHeaderTableSize:
+                encoder_.setMaxTableSize(value);
+                break;
+            case kEnablePush:
+                if (value > 1)
+                {
+                    connectionError(kProtocolError, "Invalid ENABLE_PUSH");
+                    return false;
+                }
+                break;
+            case kMaxConcurrentStreams:
+                peerMaxConcurrentStreams_ = value;
+                break;
+            case kInitialWindowSize:
+            {
+                if (value > kMaxWindowSize)
+                {
+                    connectionError(kFlowControlError,
+                                    "Invalid INITIAL_WINDOW_SIZE");
+                    return false;
+                }
+                // The change applies to the windows of all open streams.
+                int64_t delta = static_cast<int64_t>(value) -
+                                static_cast<int64_t>(peerInitialWindowSize_);
+                for (auto &stream : streams_)
+                {
+                    stream.second.sendWindow += delta;
+                    if (stream.second.sendWindow > kMaxWindowSize)
+                    {
+                        connectionError(kFlowControlError,
+                                        "Window overflow");
+                        return false;
+                    }
+                }
+                peerInitialWindowSize_ = value;
+                break;
+            }
+            case kMaxFrameSize:
+                if (value < 16384 || value > 16777215)
+                {
+                    connectionError(kProtocolError, "Invalid MAX_FRAME_SIZE");
+                    return false;
+                }
+                peerMaxFrameSize_ = value;
+                break;
+            default:
+                // MAX_HEADER_LIST_SIZE is advisory, unknown ones are ignored.
+                break;
+        }
+    }
+    writeFrameHeader(0, kSettings, kAck, 0);
+    sendPendingData();
+    return true;
+}
+
+bool Http2Session::processWindowUpdate(uint32_t streamId,
+                                       const char *payload,
+                                       size_t length)
+{
+    if (length != 4)
+    {
+        connectionError(kFrameSizeError, "Invalid WINDOW_UPDATE");
+        return false;
+    }
+    auto increment = readUint32(payload) & 0x7fffffff;
+    if (streamId == 0)
+    {
+        if (increment == 0 ||
+            connectionSendWindow_ + increment > kMaxWindowSize)
+        {
+            connectionError(increment == 0 ? kProtocolError
+                                           : kFlowControlError,
+                            "Invalid WINDOW_UPDATE");
+            return false;
+        }
+        connectionSendWindow_ += increment;
+    }
+    else
+    {
+        auto iter = streams_.find(streamId);
+        if (iter == streams_.end())
+            return true;
+        if (increment == 0)
+        {
+            resetStream(streamId, kProtocolError);
+            return true;
+        }
+        if (iter->second.sendWindow + increment > kMaxWindowSize)
+        {
+            resetStream(streamId, kFlowControlError);
+            return true;
+        }
+        iter->second.sendWindow += increment;
+    }
+    sendPendingData();
+    return true;
+}
+
+Http2Session::Stream *Http2Session::createStream(uint32_t streamId)
+{
+    auto &stream = streams_[streamId];
+    stream.sendWindow = peerInitialWindowSize_;
+    return &stream;
+}
+
+uint32_t Http2Session::openStream()
+{
+    auto streamId = nextStreamId_;
+    nextStreamId_ += 2;
+    createStream(streamId);
+    return streamId;
+}
+
+void Http2Session::closeStream(uint32_t streamId, uint32_t errorCode)
+{
+    if (streams_.erase(streamId) > 0)
+        onStreamClosed(streamId, errorCode);
+}
+
+void Http2Session::closeLocal(uint32_t streamId)
+{
+    auto iter = streams_.find(streamId);
+    if (iter == streams_.end())
+        return;
+    iter->second.localClosed = true;
+    iter->second.source = nullptr;
+    if (iter->second.remoteClosed)
+        closeStream(streamId, kNoError);
+}
+
+void Http2Session::closeRemote(uint32_t streamId)
+{
+    auto iter = streams_.find(streamId);
+    if (iter == streams_.end())
+        return;
+    iter->second.remoteClosed = true;
+    if (iter->second.localClosed)
+        closeStream(streamId, kNoError);
+}
+
+void Http2Session::writeFrameHeader(size_t length,
+                                    uint8_t type,
+                                    uint8_t flags,
+                                    uint32_t streamId)
+{
+    output_ += static_cast<char>(length >> 16);
+    output_ += static_cast<char>(length >> 8);
+    output_ += static_cast<char>(length);
+    output_ += static_cast<char>(type);
+    output_ += static_cast<char>(flags);
+    appendUint32(output_, streamId);
+}
+
+void Http2Session::sendWindowUpdate(uint32_t streamId, uint32_t increment)
+{
+    writeFrameHeader(4, kWindowUpdate, 0, streamId);
+    appendUint32(output_, increment);
+}
+
+void Http2Session::sendHeaders(uint32_t streamId,
+                               const HpackHeaderViews &headers,
+                               bool endStream)
+{
+    if (closed_ || !hasStream(streamId))
+        return;
+    std::string block;
+    encoder_.encode(headers, block);
+    // The block is split into a HEADERS frame and CONTINUATION frames.
+    size_t offset = 0;
+    uint8_t type = kHeaders;
+    do
+    {
+        auto length = std::min<size_t>(block.length() - offset,
+                                       peerMaxFrameSize_);
+        uint8_t flags = 0;
+        if (type == kHeaders && endStream)
+            flags |= kEndStream;
+        if (offset + length == block.length())
+            flags |= kEndHeaders;
+        writeFrameHeader(length, type, flags, streamId);
+        output_.append(block, offset, length);
+        offset += length;
+        type = kContinuation;
+    } while (offset < block.length());
+    if (endStream)
+        closeLocal(streamId);
+}
+
+void Http2Session::sendData(uint32_t streamId, Http2DataSource &&source)
+{
+    auto iter = streams_.find(streamId);
+    if (closed_ || iter == streams_.end())
+        return;
+    iter->second.source = std::move(source);
+    sendPendingData();
+}
+
+void Http2Session::sendPendingData()
+{
+    std::vector<uint32_t> endedStreams;
+    for (auto &item : streams_)
+    {
+        auto &stream = item.second;
+        while (stream.source && stream.sendWindow > 0 &&
+               connectionSendWindow_ > 0)
+        {
+            auto size = std::min<int64_t>(
+                std::min<int64_t>(stream.sendWindow, connectionSendWindow_),
+                peerMaxFrameSize_);
+            auto headerPos = output_.length();
+            writeFrameHeader(0, kData, 0, item.first);
+            auto dataPos = output_.length();
+            output_.resize(dataPos + static_cast<size_t>(size));
+            bool eof = false;
+            auto length = stream.source(&output_[dataPos],
+                                        static_cast<size_t>(size),
+                                        eof);
+            output_.resize(dataPos + length);
+            output_[headerPos] = static_cast<char>(length >> 16);
+            output_[headerPos + 1] = static_cast<char>(length >> 8);
+            output_[headerPos + 2] = static_cast<char>(length);
+            stream.sendWindow -= length;
+            connectionSendWindow_ -= length;
+            if (eof)
+            {
+                output_[headerPos + 4] = static_cast<char>(kEndStream);
+                stream.source = nullptr;
+                endedStreams.push_back(item.first);
+            }
+        }
+    }
+    for (auto streamId : endedStreams)
+        closeLocal(streamId);
+}
+
+void Http2Session::resetStream(uint32_t streamId, ErrorCode errorCode)
+{
+    if (closed_)
+        return;
+    writeFrameHeader(4, kRstStream, 0, streamId);
+    appendUint32(output_, errorCode);
+    closeStream(streamId, errorCode);
+}
+
+void Http2Session::connectionError(ErrorCode errorCode, const char *reason)
+{
+    if (closed_)
+        return;
+    LOG_DEBUG << "HTTP/2 connection error " << errorCode << ": " << reason;
+    writeFrameHeader(8 + strlen(reason), kGoAway, 0, 0);
+    appendUint32(output_, lastPeerStreamId_);
+    appendUint32(output_, errorCode);
+    output_.append(reason);
+    flush();
+    closed_ = true;
+    if (auto conn = conn_.lock())
+        conn->shutdown();
+    auto streams = std::move(streams_);
+    streams_.clear();
+    for (auto &stream : streams)
+        onStreamClosed(stream.first, errorCode);
+}
+
+void Http2Session::flush()
+{
+    if (output_.empty())
+        return;
+    auto conn = conn_.lock();
+    if (conn && conn->connected())
+    {
+        bytesSent_ += output_.length();
+        conn->send(std::move(output_));
+    }
+    output_.clear();
+}
@@ -0,0 +1,242 @@
+/**
+ *
+ *  @file Http2Session.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Hpack.h"
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief Fill the buffer with at most size bytes of the body of a stream and
+ * return the number of bytes, set eof to true after the last byte.
+ */
+using Http2DataSource =
+    std::function<size_t(char *buffer, size_t size, bool &eof)>;
+
+/**
+ * @brief The framing layer of a HTTP/2 connection (RFC 7540) shared by the
+ * server and the client. It handles the connection preface, SETTINGS, PING,
+ * GOAWAY, the flow control and the header compression, the subclasses handle
+ * the requests and the responses on the streams.
+ *
+ * All methods must be called in the event loop of the connection. The frames
+ * are collected in a buffer and sent by flush(), which is called at the end of
+ * onMessage().
+ */
+class Http2Session : public trantor::NonCopyable
+{
+  public:
+    enum ErrorCode : uint32_t
+    {
+        kNoError = 0x0,
+        kProtocolError = 0x1,
+        kInternalError = 0x2,
+        kFlowControlError = 0x3,
+        kSettingsTimeout = 0x4,
+        kStreamClosed = 0x5,
+        kFrameSizeError = 0x6,
+        kRefusedStream = 0x7,
+        kCancel = 0x8,
+        kCompressionError = 0x9,
+        kConnectError = 0xa,
+        kEnhanceYourCalm = 0xb,
+        kInadequateSecurity = 0xc,
+        kHttp11Required = 0xd
+    };
+
+    /// The connection preface sent by a client.
+    static const string_view kClientPreface;
+
+    Http2Session(const trantor::TcpConnectionPtr &conn, bool isServer);
+    virtual ~Http2Session() = default;
+
+    /**
+     * @brief Send the connection preface of this side, i.e. the SETTINGS
+     * frame, preceded by the magic string on the client.
+     */
+    void start();
+
+    /**
+     * @brief Process the received bytes.
+     *
+     * @return false if the connection is closed because of an error.
+     */
+    bool onMessage(trantor::MsgBuffer *buffer);
+
+    /// Called when the TCP connection is closed.
+    void onClose();
+
+    bool closed() const
+    {
+        return closed_;
+    }
+
+    /// True after the first SETTINGS frame of the peer.
+    bool settingsReceived() const
+    {
+        return settingsReceived_;
+    }
+
+    size_t bytesSent() const
+    {
+        return bytesSent_;
+    }
+
+    trantor::EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+  protected:
+    /**
+     * @brief Called when a header block is received on a stream. A stream
+     * that is not known yet is opened by the peer.
+     *
+     * @param headerListTooLarge The header list exceeds the limit, the
+     * headers are dropped.
+     */
+    virtual void onHeaders(uint32_t streamId,
+                           HpackHeaders &&headers,
+                           bool endStream,
+                           bool headerListTooLarge) = 0;
+    virtual void onData(uint32_t streamId,
+                        const char *data,
+                        size_t length,
+                        bool endStream) = 0;
+    /// Called when a stream is closed, normally or by RST_STREAM.
+    virtual void onStreamClosed(uint32_t streamId, uint32_t errorCode) = 0;
+    /// Called when the peer sends GOAWAY.
+    virtual void onGoAway(uint32_t /*lastStreamId*/, uint32_t /*errorCode*/)
+    {
+    }
+
+    /// Open a stream initiated by this side, return its id.
+    uint32_t openStream();
+    bool hasStream(uint32_t streamId) const
+    {
+        return streams_.find(streamId) != streams_.end();
+    }
+    size_t numberOfStreams() const
+    {
+        return streams_.size();
+    }
+    /// The SETTINGS_MAX_CONCURRENT_STREAMS of the peer.
+    uint32_t peerMaxConcurrentStreams() const
+    {
+        return peerMaxConcurrentStreams_;
+    }
+    bool goAwayReceived() const
+    {
+        return goAwayReceived_;
+    }
+
+    /**
+     * @brief Send a header block on the stream. The names must be in lower
+     * case.
+     */
+    void sendHeaders(uint32_t streamId,
+                     const HpackHeaderViews &headers,
+                     bool endStream);
+    /**
+     * @brief Send the body of the stream, the data is pulled from the source
+     * as the flow control windows allow. The stream is ended after the last
+     * byte.
+     */
+    void sendData(uint32_t streamId, Http2DataSource &&source);
+    void resetStream(uint32_t streamId, ErrorCode errorCode);
+    /// Send GOAWAY and close the connection.
+    void connectionError(ErrorCode errorCode, const char *reason);
+    /// Send the frames in the buffer.
+    void flush();
+
+    trantor::EventLoop *loop_;
+    std::weak_ptr<trantor::TcpConnection> conn_;
+    const bool isServer_;
+
+  private:
+    struct Stream
+    {
+        int64_t sendWindow;
+        // The bytes received since the last WINDOW_UPDATE of the stream.
+        size_t unacknowledged{0};
+        bool localClosed{false};
+        bool remoteClosed{false};
+        Http2DataSource source;
+    };
+
+    bool processFrame(uint8_t type,
+                      uint8_t flags,
+                      uint32_t streamId,
+                      const char *payload,
+                      size_t length);
+    bool processHeaders(uint8_t flags,
+                        uint32_t streamId,
+                        const char *payload,
+                        size_t length);
+    bool processHeaderBlock();
+    bool processData(uint8_t flags,
+                     uint32_t streamId,
+                     const char *payload,
+                     size_t length);
+    bool processSettings(uint8_t flags,
+                         uint32_t streamId,
+                         const char *payload,
+                         size_t length);
+    bool processWindowUpdate(uint32_t streamId,
+                             const char *payload,
+                             size_t length);
+    Stream *createStream(uint32_t streamId);
+    void closeStream(uint32_t streamId, uint32_t errorCode);
+    void closeLocal(uint32_t streamId);
+    void closeRemote(uint32_t streamId);
+    void writeFrameHeader(size_t length,
+                          uint8_t type,
+                          uint8_t flags,
+                          uint32_t streamId);
+    void sendWindowUpdate(uint32_t streamId, uint32_t increment);
+    void sendPendingData();
+
+    HpackEncoder encoder_;
+    HpackDecoder decoder_;
+    std::map<uint32_t, Stream> streams_;
+    std::string output_;
+    // The header block being received in HEADERS and CONTINUATION frames.
+    std::string headerBlock_;
+    uint32_t headerStreamId_{0};
+    bool headerEndStream_{false};
+
+    uint32_t lastPeerStreamId_{0};
+    uint32_t nextStreamId_;
+    int64_t connectionSendWindow_{65535};
+    int64_t connectionRecvWindow_;
+    size_t connectionUnacknowledged_{0};
+    uint32_t peerInitialWindowSize_{65535};
+    uint32_t peerMaxFrameSize_{16384};
+    uint32_t peerMaxConcurrentStreams_{100};
+    size_t bytesSent_{0};
+    bool prefaceReceived_{false};
+    bool settingsReceived_{false};
+    bool goAwayReceived_{false};
+    bool closed_{false};
+};
+
+}  // namespace drogon
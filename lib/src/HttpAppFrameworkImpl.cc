@@ -31,11 +31,15 @@
 #include "DbClientManager.h"
 #include "RedisClientManager.h"
 #include <drogon/config.h>
+#ifdef OpenSSL_FOUND
+#include "SSLSessionManager.h"
+#endif
 #include <algorithm>
 #include <drogon/version.h>
 #include <drogon/CacheMap.h>
 #include <drogon/DrClassMap.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/JsonTraits.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/Session.h>
@@ -47,6 +51,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <unordered_map>
 #include <utility>
 #include <tuple>
@@ -434,6 +439,25 @@ HttpAppFramework &HttpAppFrameworkImpl::setSSLFiles(const std::string &certPath,
     sslKeyPath_ = keyPath;
     return *this;
 }
+HttpAppFramework &HttpAppFrameworkImpl::enableSSLSessionSharing(
+    size_t cacheSize,
+    size_t ticketKeyRotation,
+    const std::string &ticketKeyFile)
+{
+    assert(!running_);
+#ifdef OpenSSL_FOUND
+    SSLSessionManager::instance().enable(cacheSize,
+                                         ticketKeyRotation,
+                                         ticketKeyFile);
+#else
+    (void)cacheSize;
+    (void)ticketKeyRotation;
+    (void)ticketKeyFile;
+    LOG_ERROR << "Can't share SSL sessions without OpenSSL found in your "
+                 "system";
+#endif
+    return *this;
+}
 
 void HttpAppFrameworkImpl::run()
 {
@@ -688,6 +712,25 @@ void HttpAppFrameworkImpl::findSessionForRequest(const HttpRequestImplPtr &req)
             sessionManagerPtr_->getSession(sessionId, needSetJsessionid));
     }
 }
+void HttpAppFrameworkImpl::sampleTrace(const HttpRequestImplPtr &req) const
+{
+    if (traceForceHeader_.empty() || req->getHeader(traceForceHeader_).empty())
+    {
+        if (traceSampleRatio_ <= 0)
+            return;
+        if (traceSampleRatio_ < 1)
+        {
+            static thread_local std::mt19937 engine{std::random_device{}()};
+            std::uniform_real_distribution<double> distribution(0, 1);
+            if (distribution(engine) >= traceSampleRatio_)
+                return;
+        }
+    }
+    auto &trace = req->startTrace();
+    auto &traceparent = req->getHeader("traceparent");
+    if (!traceparent.empty())
+        trace.setTraceParent(traceparent);
+}
 void HttpAppFrameworkImpl::onNewWebsockRequest(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback,
@@ -810,6 +853,7 @@ void HttpAppFrameworkImpl::onAsyncRequest(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kPreRouting);
     LOG_TRACE << "new request:" << req->peerAddr().toIpPort() << "->"
               << req->localAddr().toIpPort();
     LOG_TRACE << "Headers " << req->methodString() << " " << req->path();
@@ -965,7 +1009,10 @@ HttpAppFramework &HttpAppFrameworkImpl::createDbClient(
     const std::string &name,
     const bool isFast,
     const std::string &characterSet,
-    double timeout)
+    double timeout,
+    size_t maxPendingQueries,
+    const std::vector<std::pair<std::string, unsigned short>> &replicas,
+    double maxReplicationLag)
 {
     assert(!running_);
     dbClientManagerPtr_->createDbClient(dbType,
@@ -979,7 +1026,10 @@ HttpAppFramework &HttpAppFrameworkImpl::createDbClient(
                                         name,
                                         isFast,
                                         characterSet,
-                                        timeout);
+                                        timeout,
+                                        maxPendingQueries,
+                                        replicas,
+                                        maxReplicationLag);
     return *this;
 }
 
@@ -1036,6 +1086,30 @@ const HttpResponsePtr &HttpAppFrameworkImpl::getCustom404Page()
     }
 }
 
+static const std::shared_ptr<JsonCodec> &defaultJsonCodec()
+{
+    static std::shared_ptr<JsonCodec> codec =
+        std::make_shared<DefaultJsonCodec>(
+            app().isUnicodeEscapingUsedInJson(),
+            app().getFloatPrecisionInJson().first,
+            app().getFloatPrecisionInJson().second);
+    return codec;
+}
+
+const DefaultJsonCodec &drogon::internal::getDefaultJsonCodec()
+{
+    return static_cast<const DefaultJsonCodec &>(*defaultJsonCodec());
+}
+
+const std::shared_ptr<JsonCodec> &HttpAppFrameworkImpl::getJsonCodec() const
+{
+    if (jsonCodec_)
+    {
+        return jsonCodec_;
+    }
+    return defaultJsonCodec();
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setStaticFileHeaders(
     const std::vector<std::pair<std::string, std::string>> &headers)
 {
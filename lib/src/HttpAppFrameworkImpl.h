@@ -71,6 +71,10 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         override;
     HttpAppFramework &setSSLFiles(const std::string &certPath,
                                   const std::string &keyPath) override;
+    HttpAppFramework &enableSSLSessionSharing(
+        size_t cacheSize,
+        size_t ticketKeyRotation,
+        const std::string &ticketKeyFile) override;
     void run() override;
     HttpAppFramework &registerWebSocketController(
         const std::string &pathName,
@@ -415,6 +419,13 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     {
         return floatPrecisionInJson_;
     }
+    HttpAppFramework &setJsonCodec(
+        const std::shared_ptr<JsonCodec> &codec) override
+    {
+        jsonCodec_ = codec;
+        return *this;
+    }
+    const std::shared_ptr<JsonCodec> &getJsonCodec() const override;
     trantor::EventLoop *getLoop() const override;
 
     trantor::EventLoop *getIOLoop(size_t id) const override;
@@ -439,6 +450,33 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         enableDateHeader_ = flag;
         return *this;
     }
+    HttpAppFramework &enableRequestTracing(
+        double sampleRatio,
+        const std::string &forceHeader) override
+    {
+        assert(!running_);
+        tracingEnabled_ = true;
+        traceSampleRatio_ = sampleRatio;
+        traceForceHeader_ = forceHeader;
+        return *this;
+    }
+    HttpAppFramework &setRequestTraceExporter(
+        const RequestTraceExporter &exporter) override
+    {
+        assert(!running_);
+        traceExporter_ = exporter;
+        return *this;
+    }
+    /// Start the trace of the request if it is sampled.
+    void startTraceIfSampled(const HttpRequestImplPtr &req) const
+    {
+        if (tracingEnabled_)
+            sampleTrace(req);
+    }
+    const RequestTraceExporter &requestTraceExporter() const
+    {
+        return traceExporter_;
+    }
     bool sendServerHeader() const
     {
         return enableServerHeader_;
@@ -465,7 +503,12 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
                                      const std::string &name,
                                      bool isFast,
                                      const std::string &characterSet,
-                                     double timeout) override;
+                                     double timeout,
+                                     size_t maxPendingQueries,
+                                     const std::vector<
+                                         std::pair<std::string, unsigned short>>
+                                         &replicas,
+                                     double maxReplicationLag) override;
     HttpAppFramework &createRedisClient(const std::string &ip,
                                         unsigned short port,
                                         const std::string &name,
@@ -524,6 +567,24 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     {
         return reusePort_;
     }
+    HttpAppFramework &enableHttp2(bool enable) override
+    {
+        http2Enabled_ = enable;
+        return *this;
+    }
+    bool isHttp2Enabled() const override
+    {
+        return http2Enabled_;
+    }
+    HttpAppFramework &enableIoUring(bool enable) override
+    {
+        ioUringEnabled_ = enable;
+        return *this;
+    }
+    bool isIoUringEnabled() const override
+    {
+        return ioUringEnabled_;
+    }
 
     void setExceptionHandler(ExceptionHandler handler) override
     {
@@ -557,6 +618,7 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     void onConnection(const trantor::TcpConnectionPtr &conn);
 
     void findSessionForRequest(const HttpRequestImplPtr &req);
+    void sampleTrace(const HttpRequestImplPtr &req) const;
 
     // We use a uuid string as session id;
     // set sessionTimeout_=0 to make location session valid forever based on
@@ -609,6 +671,7 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     bool useSendfile_{true};
     bool useGzip_{true};
     bool useBrotli_{false};
+    std::shared_ptr<JsonCodec> jsonCodec_;
     bool usingUnicodeEscaping_{true};
     std::pair<unsigned int, std::string> floatPrecisionInJson_{0,
                                                                "significant"};
@@ -626,7 +689,13 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     static InitBeforeMainFunction initFirst_;
     bool enableServerHeader_{true};
     bool enableDateHeader_{true};
+    bool tracingEnabled_{false};
+    double traceSampleRatio_{0};
+    std::string traceForceHeader_;
+    RequestTraceExporter traceExporter_;
     bool reusePort_{false};
+    bool http2Enabled_{false};
+    bool ioUringEnabled_{false};
     std::vector<std::function<void()>> beginningAdvices_;
     std::vector<std::function<bool(const trantor::InetAddress &,
                                    const trantor::InetAddress &)>>
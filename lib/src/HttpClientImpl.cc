@@ -18,8 +18,13 @@
 #include "HttpResponseParser.h"
 #include "HttpAppFrameworkImpl.h"
 #include <drogon/config.h>
+#ifdef OpenSSL_FOUND
+#include "SSLSessionManager.h"
+#endif
 #include <algorithm>
+#include <iterator>
 #include <stdlib.h>
+#include <string.h>
 
 using namespace trantor;
 using namespace drogon;
@@ -28,6 +33,26 @@ namespace trantor
 {
 const static size_t kDefaultDNSTimeout{600};
 }
+static void decodeResponse(const HttpResponseImplPtr &resp)
+{
+    auto &type = resp->getHeaderBy("content-type");
+    auto &coding = resp->getHeaderBy("content-encoding");
+    if (coding == "gzip")
+    {
+        resp->gunzip();
+    }
+#ifdef USE_BROTLI
+    else if (coding == "br")
+    {
+        resp->brDecompress();
+    }
+#endif
+    if (type.find("application/json") != std::string::npos)
+    {
+        resp->parseJson();
+    }
+}
+
 void HttpClientImpl::createTcpClient()
 {
     LOG_TRACE << "New TcpClient," << serverAddr_.toIpPort();
@@ -39,6 +64,16 @@ void HttpClientImpl::createTcpClient()
     {
         LOG_TRACE << "useOldTLS=" << useOldTLS_;
         LOG_TRACE << "domain=" << domain_;
+        // The TLS sessions are shared by the clients connecting to the same
+        // origin with the same settings, so a new connection resumes the
+        // session of a previous one.
+        auto origin = (domain_.empty() ? serverAddr_.toIp() : domain_) + ':' +
+                      std::to_string(serverAddr_.toPort());
+        if (!validateCert_)
+            origin += " no-validation";
+        if (useOldTLS_)
+            origin += " old-tls";
+        SSLSessionManager::Scope scope(std::move(origin), http2Enabled_);
         tcpClientPtr_->enableSSL(useOldTLS_, validateCert_, domain_);
     }
 #endif
@@ -52,6 +87,12 @@ void HttpClientImpl::createTcpClient()
                 return;
             if (connPtr->connected())
             {
+                thisPtr->finishWarmUp(ReqResult::Ok);
+                if (thisPtr->http2Enabled_ && thisPtr->negotiateHttp2(connPtr))
+                {
+                    thisPtr->startHttp2(connPtr);
+                    return;
+                }
                 connPtr->setContext(
                     std::make_shared<HttpResponseParser>(connPtr));
                 // send request;
@@ -70,6 +111,11 @@ void HttpClientImpl::createTcpClient()
             else
             {
                 LOG_TRACE << "connection disconnect";
+                if (thisPtr->http2Session_)
+                {
+                    thisPtr->onHttp2Close();
+                    return;
+                }
                 auto responseParser = connPtr->getContext<HttpResponseParser>();
                 if (responseParser && responseParser->parseResponseOnClose() &&
                     responseParser->gotAll())
@@ -364,81 +410,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                               const HttpResponsePtr &response) {
                  callback(result, response);
              }});
-        if (!dns_)
-        {
-            bool hasIpv6Address = false;
-            if (serverAddr_.isIpV6())
-            {
-                auto ipaddr = serverAddr_.ip6NetEndian();
-                for (int i = 0; i < 4; ++i)
-                {
-                    if (ipaddr[i] != 0)
-                    {
-                        hasIpv6Address = true;
-                        break;
-                    }
-                }
-            }
-
-            if (serverAddr_.ipNetEndian() == 0 && !hasIpv6Address &&
-                !domain_.empty() && serverAddr_.portNetEndian() != 0)
-            {
-                dns_ = true;
-                if (!resolverPtr_)
-                {
-                    resolverPtr_ =
-                        trantor::Resolver::newResolver(loop_,
-                                                       kDefaultDNSTimeout);
-                }
-                resolverPtr_->resolve(
-                    domain_,
-                    [thisPtr = shared_from_this(),
-                     hasIpv6Address](const trantor::InetAddress &addr) {
-                        thisPtr->loop_->runInLoop([thisPtr,
-                                                   addr,
-                                                   hasIpv6Address]() {
-                            auto port = thisPtr->serverAddr_.portNetEndian();
-                            thisPtr->serverAddr_ = addr;
-                            thisPtr->serverAddr_.setPortNetEndian(port);
-                            LOG_TRACE << "dns:domain=" << thisPtr->domain_
-                                      << ";ip=" << thisPtr->serverAddr_.toIp();
-                            thisPtr->dns_ = false;
-                            if ((thisPtr->serverAddr_.ipNetEndian() != 0 ||
-                                 hasIpv6Address) &&
-                                thisPtr->serverAddr_.portNetEndian() != 0)
-                            {
-                                thisPtr->createTcpClient();
-                            }
-                            else
-                            {
-                                while (!(thisPtr->requestsBuffer_).empty())
-                                {
-                                    auto &reqAndCb =
-                                        (thisPtr->requestsBuffer_).front();
-                                    reqAndCb.second(ReqResult::BadServerAddress,
-                                                    nullptr);
-                                    (thisPtr->requestsBuffer_).pop_front();
-                                }
-                                return;
-                            }
-                        });
-                    });
-                return;
-            }
-
-            if ((serverAddr_.ipNetEndian() != 0 || hasIpv6Address) &&
-                serverAddr_.portNetEndian() != 0)
-            {
-                createTcpClient();
-            }
-            else
-            {
-                requestsBuffer_.pop_front();
-                callback(ReqResult::BadServerAddress, nullptr);
-                assert(requestsBuffer_.empty());
-                return;
-            }
-        }
+        connectInLoop();
     }
     else
     {
@@ -447,8 +419,18 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
         auto thisPtr = shared_from_this();
         if (connPtr && connPtr->connected())
         {
-            if (pipeliningCallbacks_.size() <= pipeliningDepth_ &&
-                requestsBuffer_.empty())
+            if (http2Session_)
+            {
+                requestsBuffer_.push_back(
+                    {req,
+                     [thisPtr, callback = std::move(callback)](
+                         ReqResult result, const HttpResponsePtr &response) {
+                         callback(result, response);
+                     }});
+                sendRequestsHttp2();
+            }
+            else if (pipeliningCallbacks_.size() <= pipeliningDepth_ &&
+                     requestsBuffer_.empty())
             {
                 sendReq(connPtr, req);
                 pipeliningCallbacks_.push(
@@ -480,6 +462,111 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
     }
 }
 
+void HttpClientImpl::connectInLoop()
+{
+    if (dns_)
+        return;
+    bool hasIpv6Address = false;
+    if (serverAddr_.isIpV6())
+    {
+        auto ipaddr = serverAddr_.ip6NetEndian();
+        for (int i = 0; i < 4; ++i)
+        {
+            if (ipaddr[i] != 0)
+            {
+                hasIpv6Address = true;
+                break;
+            }
+        }
+    }
+
+    if (serverAddr_.ipNetEndian() == 0 && !hasIpv6Address && !domain_.empty() &&
+        serverAddr_.portNetEndian() != 0)
+    {
+        dns_ = true;
+        if (!resolverPtr_)
+        {
+            resolverPtr_ =
+                trantor::Resolver::newResolver(loop_, kDefaultDNSTimeout);
+        }
+        resolverPtr_->resolve(
+            domain_,
+            [thisPtr = shared_from_this(),
+             hasIpv6Address](const trantor::InetAddress &addr) {
+                thisPtr->loop_->runInLoop([thisPtr, addr, hasIpv6Address]() {
+                    auto port = thisPtr->serverAddr_.portNetEndian();
+                    thisPtr->serverAddr_ = addr;
+                    thisPtr->serverAddr_.setPortNetEndian(port);
+                    LOG_TRACE << "dns:domain=" << thisPtr->domain_
+                              << ";ip=" << thisPtr->serverAddr_.toIp();
+                    thisPtr->dns_ = false;
+                    if ((thisPtr->serverAddr_.ipNetEndian() != 0 ||
+                         hasIpv6Address) &&
+                        thisPtr->serverAddr_.portNetEndian() != 0)
+                    {
+                        thisPtr->createTcpClient();
+                    }
+                    else
+                    {
+                        thisPtr->onError(ReqResult::BadServerAddress);
+                    }
+                });
+            });
+        return;
+    }
+
+    if ((serverAddr_.ipNetEndian() != 0 || hasIpv6Address) &&
+        serverAddr_.portNetEndian() != 0)
+    {
+        createTcpClient();
+    }
+    else
+    {
+        onError(ReqResult::BadServerAddress);
+    }
+}
+
+void HttpClientImpl::warmUp(std::function<void(ReqResult)> callback)
+{
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr, callback = std::move(callback)]() mutable {
+        thisPtr->warmUpInLoop(std::move(callback));
+    });
+}
+
+void HttpClientImpl::warmUpInLoop(std::function<void(ReqResult)> &&callback)
+{
+    loop_->assertInLoopThread();
+    if (tcpClientPtr_)
+    {
+        auto connPtr = tcpClientPtr_->connection();
+        if (connPtr && connPtr->connected())
+        {
+            if (callback)
+                callback(ReqResult::Ok);
+            return;
+        }
+    }
+    if (callback)
+    {
+        warmUpCallbacks_.emplace_back(
+            [thisPtr = shared_from_this(),
+             callback = std::move(callback)](ReqResult result) {
+                callback(result);
+            });
+    }
+    if (!tcpClientPtr_)
+        connectInLoop();
+}
+
+void HttpClientImpl::finishWarmUp(ReqResult result)
+{
+    auto callbacks = std::move(warmUpCallbacks_);
+    warmUpCallbacks_.clear();
+    for (auto &callback : callbacks)
+        callback(result);
+}
+
 void HttpClientImpl::sendReq(const trantor::TcpConnectionPtr &connPtr,
                              const HttpRequestPtr &req)
 {
@@ -499,22 +586,7 @@ void HttpClientImpl::handleResponse(
     const trantor::TcpConnectionPtr &connPtr)
 {
     assert(!pipeliningCallbacks_.empty());
-    auto &type = resp->getHeaderBy("content-type");
-    auto &coding = resp->getHeaderBy("content-encoding");
-    if (coding == "gzip")
-    {
-        resp->gunzip();
-    }
-#ifdef USE_BROTLI
-    else if (coding == "br")
-    {
-        resp->brDecompress();
-    }
-#endif
-    if (type.find("application/json") != std::string::npos)
-    {
-        resp->parseJson();
-    }
+    decodeResponse(resp);
     auto cb = std::move(reqAndCb);
     pipeliningCallbacks_.pop();
     handleCookies(resp);
@@ -554,6 +626,11 @@ void HttpClientImpl::handleResponse(
 void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
                                    trantor::MsgBuffer *msg)
 {
+    if (http2Session_)
+    {
+        onHttp2Message(msg);
+        return;
+    }
     auto responseParser = connPtr->getContext<HttpResponseParser>();
 
     // LOG_TRACE << "###:" << msg->readableBytes();
@@ -592,6 +669,165 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
     }
 }
 
+bool HttpClientImpl::negotiateHttp2(const trantor::TcpConnectionPtr &connPtr)
+{
+#ifdef OpenSSL_FOUND
+    // Over TLS, the server tells whether it speaks HTTP/2 by ALPN.
+    if (connPtr->isSSLConnection())
+        return SSLSessionManager::negotiatedProtocol(connPtr->localAddr()) ==
+               "h2";
+#endif
+    if (http2Skipped_)
+    {
+        http2Skipped_ = false;
+        return false;
+    }
+    return !http2Refused_;
+}
+
+void HttpClientImpl::startHttp2(const trantor::TcpConnectionPtr &connPtr)
+{
+    LOG_TRACE << "Connection established, start HTTP/2";
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    http2Session_ = std::make_shared<Http2ClientSession>(
+        connPtr,
+        useSSL_,
+        [weakPtr](const HttpResponseImplPtr &resp,
+                  std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb) {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->handleHttp2Response(resp, std::move(reqAndCb));
+        },
+        [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->sendRequestsHttp2();
+        });
+    http2Session_->start();
+    sendRequestsHttp2();
+}
+
+void HttpClientImpl::sendRequestsHttp2()
+{
+    // The requests wait in the buffer until the server allows more streams.
+    auto session = http2Session_;
+    while (session && session->canSendRequest() && !requestsBuffer_.empty())
+    {
+        auto reqAndCb = std::move(requestsBuffer_.front());
+        requestsBuffer_.pop_front();
+        session->sendRequest(std::move(reqAndCb));
+    }
+}
+
+void HttpClientImpl::handleHttp2Response(
+    const HttpResponseImplPtr &resp,
+    std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb)
+{
+    decodeResponse(resp);
+    handleCookies(resp);
+    reqAndCb.second(ReqResult::Ok, resp);
+}
+
+void HttpClientImpl::onHttp2Message(trantor::MsgBuffer *msg)
+{
+    auto session = http2Session_;
+    bytesReceived_ += msg->readableBytes();
+    // A server of HTTP/1.x answers the connection preface with an error
+    // response instead of SETTINGS.
+    if (!session->settingsReceived() && msg->readableBytes() >= 5 &&
+        strncmp(msg->peek(), "HTTP/", 5) == 0)
+    {
+        msg->retrieveAll();
+        fallBackToHttp11(releaseHttp2Session(), true);
+        return;
+    }
+    session->onMessage(msg);
+    requeueRequests(session->takeUnprocessedRequests());
+    if (session->finished())
+    {
+        // After GOAWAY or an error of the connection, the requests left are
+        // sent on a new connection.
+        releaseHttp2Session();
+        tcpClientPtr_.reset();
+        if (!requestsBuffer_.empty())
+        {
+            createTcpClient();
+        }
+        return;
+    }
+    sendRequestsHttp2();
+}
+
+void HttpClientImpl::onHttp2Close()
+{
+    auto session = releaseHttp2Session();
+    if (!session->settingsReceived())
+    {
+        // The server closed the connection without a frame of HTTP/2, so the
+        // requests were not processed.
+        if (useSSL_)
+        {
+            // HTTP/2 was selected by ALPN, the connection was lost.
+            session->abandonStreams();
+            session->onClose();
+            requeueRequests(session->takeUnprocessedRequests());
+            onError(ReqResult::NetworkFailure);
+            return;
+        }
+        // The server may not speak HTTP/2 or the connection was lost, so
+        // only the next connection uses HTTP/1.1.
+        fallBackToHttp11(session, false);
+        return;
+    }
+    // The streams in progress fail.
+    session->onClose();
+    auto unprocessed = session->takeUnprocessedRequests();
+    if (unprocessed.empty())
+    {
+        onError(ReqResult::NetworkFailure);
+        return;
+    }
+    requeueRequests(std::move(unprocessed));
+    tcpClientPtr_.reset();
+    createTcpClient();
+}
+
+void HttpClientImpl::fallBackToHttp11(
+    const std::shared_ptr<Http2ClientSession> &session,
+    bool refused)
+{
+    LOG_DEBUG << "HTTP/2 is not supported by the server, use HTTP/1.1";
+    if (refused)
+        http2Refused_ = true;
+    else
+        http2Skipped_ = true;
+    session->abandonStreams();
+    session->onClose();
+    requeueRequests(session->takeUnprocessedRequests());
+    tcpClientPtr_.reset();
+    if (!requestsBuffer_.empty())
+    {
+        createTcpClient();
+    }
+}
+
+std::shared_ptr<Http2ClientSession> HttpClientImpl::releaseHttp2Session()
+{
+    auto session = std::move(http2Session_);
+    http2Session_.reset();
+    bytesSent_ += session->bytesSent();
+    return session;
+}
+
+void HttpClientImpl::requeueRequests(
+    std::vector<std::pair<HttpRequestPtr, HttpReqCallback>> &&requests)
+{
+    // They are sent again before the requests in the buffer.
+    requestsBuffer_.insert(requestsBuffer_.begin(),
+                           std::make_move_iterator(requests.begin()),
+                           std::make_move_iterator(requests.end()));
+}
+
 HttpClientPtr HttpClient::newHttpClient(const std::string &ip,
                                         uint16_t port,
                                         bool useSSL,
@@ -622,6 +858,12 @@ HttpClientPtr HttpClient::newHttpClient(const std::string &hostString,
 
 void HttpClientImpl::onError(ReqResult result)
 {
+    if (http2Session_)
+    {
+        auto session = releaseHttp2Session();
+        session->onClose();
+        requeueRequests(session->takeUnprocessedRequests());
+    }
     while (!pipeliningCallbacks_.empty())
     {
         auto cb = std::move(pipeliningCallbacks_.front());
@@ -635,6 +877,7 @@ void HttpClientImpl::onError(ReqResult result)
         cb(result, nullptr);
     }
     tcpClientPtr_.reset();
+    finishWarmUp(result);
 }
 
 void HttpClientImpl::handleCookies(const HttpResponseImplPtr &resp)
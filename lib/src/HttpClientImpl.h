@@ -15,6 +15,7 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include "Http2ClientSession.h"
 #include <drogon/HttpClient.h>
 #include <drogon/Cookie.h>
 #include <trantor/net/EventLoop.h>
@@ -54,6 +55,11 @@ class HttpClientImpl final : public HttpClient,
     {
         pipeliningDepth_ = depth;
     }
+    void enableHttp2(bool flag = true) override
+    {
+        http2Enabled_ = flag;
+    }
+    void warmUp(std::function<void(ReqResult)> callback = nullptr) override;
     ~HttpClientImpl();
 
     void enableCookies(bool flag = true) override
@@ -73,7 +79,7 @@ class HttpClientImpl final : public HttpClient,
 
     size_t bytesSent() const override
     {
-        return bytesSent_;
+        return bytesSent_ + (http2Session_ ? http2Session_->bytesSent() : 0);
     }
     size_t bytesReceived() const override
     {
@@ -102,6 +108,22 @@ class HttpClientImpl final : public HttpClient,
                         std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb,
                         const trantor::TcpConnectionPtr &connPtr);
     void createTcpClient();
+    void connectInLoop();
+    void warmUpInLoop(std::function<void(ReqResult)> &&callback);
+    void finishWarmUp(ReqResult result);
+    bool negotiateHttp2(const trantor::TcpConnectionPtr &connPtr);
+    void startHttp2(const trantor::TcpConnectionPtr &connPtr);
+    void sendRequestsHttp2();
+    void handleHttp2Response(
+        const HttpResponseImplPtr &resp,
+        std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb);
+    void onHttp2Message(trantor::MsgBuffer *msg);
+    void onHttp2Close();
+    void fallBackToHttp11(const std::shared_ptr<Http2ClientSession> &session,
+                          bool refused);
+    std::shared_ptr<Http2ClientSession> releaseHttp2Session();
+    void requeueRequests(
+        std::vector<std::pair<HttpRequestPtr, HttpReqCallback>> &&requests);
     std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> pipeliningCallbacks_;
     std::list<std::pair<HttpRequestPtr, HttpReqCallback>> requestsBuffer_;
     void onRecvMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
@@ -116,6 +138,14 @@ class HttpClientImpl final : public HttpClient,
     std::shared_ptr<trantor::Resolver> resolverPtr_;
     bool useOldTLS_{false};
     std::string userAgent_{"DrogonClient"};
+    bool http2Enabled_{false};
+    // The server doesn't speak HTTP/2 with prior knowledge.
+    bool http2Refused_{false};
+    // The next connection uses HTTP/1.1, since the last one was closed
+    // before the server spoke HTTP/2.
+    bool http2Skipped_{false};
+    std::shared_ptr<Http2ClientSession> http2Session_;
+    std::vector<std::function<void(ReqResult)>> warmUpCallbacks_;
 };
 using HttpClientImplPtr = std::shared_ptr<HttpClientImpl>;
 }  // namespace drogon
@@ -21,7 +21,6 @@
 #include "FiltersFunction.h"
 #include <algorithm>
 #include <cctype>
-#include <deque>
 
 using namespace drogon;
 
@@ -618,6 +617,7 @@ void HttpControllersRouter::doControllerHandler(
     const std::smatch &matchResult,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kHandling);
     auto &responsePtr = *(ctrlBinderPtr->responseCache_);
     if (responsePtr)
     {
@@ -637,7 +637,8 @@ void HttpControllersRouter::doControllerHandler(
         }
     }
 
-    std::deque<std::string> params(ctrlBinderPtr->parameterPlaces_.size());
+    // The arguments refer to the path and the query parameters of the request
+    std::vector<string_view> params(ctrlBinderPtr->parameterPlaces_.size());
 
     for (size_t j = 1; j < matchResult.size(); ++j)
     {
@@ -650,7 +651,9 @@ void HttpControllersRouter::doControllerHandler(
         }
         if (place > params.size())
             params.resize(place);
-        params[place - 1] = matchResult[j].str();
+        if (matchResult[j].length() > 0)
+            params[place - 1] = string_view(&*matchResult[j].first,
+                                            matchResult[j].length());
         LOG_TRACE << "place=" << place << " para:" << params[place - 1];
     }
 
@@ -669,7 +672,7 @@ void HttpControllersRouter::doControllerHandler(
             }
             else
             {
-                params[place - 1] = std::string{};
+                params[place - 1] = string_view{};
             }
         }
     }
@@ -705,6 +708,7 @@ void HttpControllersRouter::doPreHandlingAdvices(
     std::smatch &&matchResult,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kPreHandling);
     if (req->method() == Options)
     {
         auto resp = HttpResponse::newHttpResponse();
@@ -797,6 +801,7 @@ void HttpControllersRouter::invokeCallback(
     const HttpRequestImplPtr &req,
     const HttpResponsePtr &resp)
 {
+    req->markTrace(RequestTrace::kHandled);
     for (auto &advice : postHandlingAdvices_)
     {
         advice(req, resp);
@@ -33,16 +33,10 @@ void HttpRequestImpl::parseJson() const
         getHeaderBy("content-type").find("application/json") !=
             std::string::npos)
     {
-        static std::once_flag once;
-        static Json::CharReaderBuilder builder;
-        std::call_once(once, []() { builder["collectComments"] = false; });
         jsonPtr_ = std::make_shared<Json::Value>();
-        JSONCPP_STRING errs;
-        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-        if (!reader->parse(input.data(),
-                           input.data() + input.size(),
-                           jsonPtr_.get(),
-                           &errs))
+        std::string errs;
+        if (!HttpAppFrameworkImpl::instance().getJsonCodec()->parse(
+                input.data(), input.data() + input.size(), *jsonPtr_, errs))
         {
             LOG_ERROR << errs;
             jsonPtr_.reset();
@@ -247,7 +241,9 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
     }
 
     output->append(" ");
-    if (version_ == Version::kHttp11)
+    // A request received over HTTP/2 is sent as an HTTP/1.1 one, e.g. when
+    // it's forwarded.
+    if (version_ == Version::kHttp11 || version_ == Version::kHttp2)
     {
         output->append("HTTP/1.1");
     }
@@ -338,6 +334,18 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
             output->append(contentTypeString_);
         }
     }
+    else if (version_ == Version::kHttp2 && !content_.empty() &&
+             getHeaderBy("content-length").empty())
+    {
+        // The length of an HTTP/2 body is given by its frames.
+        char buf[64];
+        auto len = snprintf(buf,
+                            sizeof(buf),
+                            contentLengthFormatString<decltype(
+                                content_.length())>(),
+                            content_.length());
+        output->append(buf, len);
+    }
     for (auto it = headers_.begin(); it != headers_.end(); ++it)
     {
         output->append(it->first);
@@ -486,27 +494,13 @@ HttpRequestPtr HttpRequest::newHttpFormPostRequest()
 
 HttpRequestPtr HttpRequest::newHttpJsonRequest(const Json::Value &data)
 {
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-        if (!app().isUnicodeEscapingUsedInJson())
-        {
-            builder["emitUTF8"] = true;
-        }
-        auto &precision = app().getFloatPrecisionInJson();
-        if (precision.first != 0)
-        {
-            builder["precision"] = precision.first;
-            builder["precisionType"] = precision.second;
-        }
-    });
     auto req = std::make_shared<HttpRequestImpl>(nullptr);
     req->setMethod(drogon::Get);
     req->setVersion(drogon::Version::kHttp11);
     req->contentType_ = CT_APPLICATION_JSON;
-    req->setContent(writeString(builder, data));
+    std::string content;
+    HttpAppFrameworkImpl::instance().getJsonCodec()->serialize(data, content);
+    req->setContent(std::move(content));
     req->flagForParsingContentType_ = true;
     return req;
 }
@@ -540,6 +534,7 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(creationDate_, that.creationDate_);
     swap(content_, that.content_);
     swap(expectPtr_, that.expectPtr_);
+    swap(trace_, that.trace_);
     swap(contentType_, that.contentType_);
     swap(contentTypeString_, that.contentTypeString_);
     swap(keepAlive_, that.keepAlive_);
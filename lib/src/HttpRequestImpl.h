@@ -18,6 +18,7 @@
 #include "CacheFile.h"
 #include <drogon/utils/Utilities.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/RequestTrace.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/InetAddress.h>
@@ -66,6 +67,7 @@ class HttpRequestImpl : public HttpRequest
         contentTypeString_.clear();
         keepAlive_ = true;
         jsonParsingErrorPtr_.reset();
+        trace_.reset();
     }
     trantor::EventLoop *getLoop()
     {
@@ -226,6 +228,22 @@ class HttpRequestImpl : public HttpRequest
         creationDate_ = date;
     }
 
+    /// The trace of the request, or nullptr if the request is not traced.
+    RequestTrace *trace() const
+    {
+        return trace_.get();
+    }
+    RequestTrace &startTrace()
+    {
+        trace_ = std::make_unique<RequestTrace>();
+        return *trace_;
+    }
+    void markTrace(RequestTrace::Stage stage)
+    {
+        if (trace_)
+            trace_->mark(stage);
+    }
+
     void setPeerAddr(const trantor::InetAddress &peer)
     {
         peer_ = peer;
@@ -305,6 +323,10 @@ class HttpRequestImpl : public HttpRequest
     {
         content_ = content;
     }
+    void setContent(std::string &&content)
+    {
+        content_ = std::move(content);
+    }
 
     virtual void setBody(const std::string &body) override
     {
@@ -509,6 +531,7 @@ class HttpRequestImpl : public HttpRequest
     std::unique_ptr<CacheFile> cacheFilePtr_;
     mutable std::unique_ptr<std::string> jsonParsingErrorPtr_;
     std::unique_ptr<std::string> expectPtr_;
+    std::unique_ptr<RequestTrace> trace_;
     bool keepAlive_{true};
     bool isOnSecureConnection_{false};
     bool passThrough_{false};
@@ -24,6 +24,7 @@
 
 namespace drogon
 {
+class Http2ServerSession;
 class HttpRequestParser : public trantor::NonCopyable,
                           public std::enable_shared_from_this<HttpRequestParser>
 {
@@ -74,6 +75,21 @@ class HttpRequestParser : public trantor::NonCopyable,
     {
         websockConnPtr_ = conn;
     }
+    const std::shared_ptr<Http2ServerSession> &http2Session() const
+    {
+        return http2SessionPtr_;
+    }
+    void setHttp2Session(const std::shared_ptr<Http2ServerSession> &session)
+    {
+        http2SessionPtr_ = session;
+    }
+    // True before any byte of the first request is parsed, the connection
+    // preface of HTTP/2 is only expected there.
+    bool atConnectionStart() const
+    {
+        return requestsCounter_ == 0 &&
+               status_ == HttpRequestParseStatus::kExpectMethod;
+    }
     // to support request pipelining(rfc2616-8.1.2.2)
     void pushRequestToPipelining(const HttpRequestPtr &req);
     HttpRequestPtr getFirstRequest() const;
@@ -137,6 +153,7 @@ class HttpRequestParser : public trantor::NonCopyable,
     HttpRequestImplPtr request_;
     bool firstRequest_{true};
     WebSocketConnectionImplPtr websockConnPtr_;
+    std::shared_ptr<Http2ServerSession> http2SessionPtr_;
     std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>
         requestPipelining_;
     size_t requestsCounter_{0};
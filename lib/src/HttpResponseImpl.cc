@@ -17,6 +17,7 @@
 #include "HttpUtils.h"
 #include <drogon/HttpViewData.h>
 #include <drogon/IOThreadStorage.h>
+#include <drogon/ViewCache.h>
 #include "filesystem.h"
 #include <fstream>
 #include <memory>
@@ -94,24 +95,10 @@ void HttpResponseImpl::generateBodyFromJson() const
         return;
     }
     flagForSerializingJson_ = true;
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-        if (!app().isUnicodeEscapingUsedInJson())
-        {
-            builder["emitUTF8"] = true;
-        }
-        auto &precision = app().getFloatPrecisionInJson();
-        if (precision.first != 0)
-        {
-            builder["precision"] = precision.first;
-            builder["precisionType"] = precision.second;
-        }
-    });
-    bodyPtr_ = std::make_shared<HttpMessageStringBody>(
-        writeString(builder, *jsonPtr_));
+    std::string body;
+    HttpAppFrameworkImpl::instance().getJsonCodec()->serialize(*jsonPtr_,
+                                                               body);
+    bodyPtr_ = std::make_shared<HttpMessageStringBody>(std::move(body));
 }
 
 HttpResponsePtr HttpResponse::newNotFoundResponse()
@@ -192,6 +179,22 @@ HttpResponsePtr HttpResponse::newHttpViewResponse(const std::string &viewName,
     return genHttpResponse(viewName, data);
 }
 
+HttpResponsePtr HttpResponse::newHttpViewResponse(
+    const std::string &viewName,
+    const HttpViewData &data,
+    const std::vector<std::string> &keys,
+    double timeout)
+{
+    std::string text;
+    if (ViewCache::renderView(viewName, data, keys, timeout, text))
+    {
+        auto res = HttpResponse::newHttpResponse();
+        res->setBody(std::move(text));
+        return res;
+    }
+    return drogon::HttpResponse::newNotFoundResponse();
+}
+
 HttpResponsePtr HttpResponse::newFileResponse(
     const unsigned char *pBuffer,
     size_t bufferLength,
@@ -692,18 +695,15 @@ void HttpResponseImpl::clear()
 
 void HttpResponseImpl::parseJson() const
 {
-    static std::once_flag once;
-    static Json::CharReaderBuilder builder;
-    std::call_once(once, []() { builder["collectComments"] = false; });
-    JSONCPP_STRING errs;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errs;
     if (bodyPtr_)
     {
         jsonPtr_ = std::make_shared<Json::Value>();
-        if (!reader->parse(bodyPtr_->data(),
-                           bodyPtr_->data() + bodyPtr_->length(),
-                           jsonPtr_.get(),
-                           &errs))
+        if (!HttpAppFrameworkImpl::instance().getJsonCodec()->parse(
+                bodyPtr_->data(),
+                bodyPtr_->data() + bodyPtr_->length(),
+                *jsonPtr_,
+                errs))
         {
             LOG_ERROR << errs;
             LOG_ERROR << "body: " << bodyPtr_->getString();
@@ -13,11 +13,16 @@
  */
 
 #include "HttpServer.h"
+#include "Http2ServerSession.h"
 #include "HttpRequestImpl.h"
 #include "HttpRequestParser.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpResponseImpl.h"
 #include "WebSocketConnectionImpl.h"
+#include "BuiltinMetrics.h"
+#ifdef USE_IO_URING
+#include "UringTcpServer.h"
+#endif
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
@@ -157,21 +162,39 @@ HttpServer::HttpServer(
         &syncAdvices,
     const std::vector<
         std::function<void(const HttpRequestPtr &, const HttpResponsePtr &)>>
-        &preSendingAdvices)
-#ifdef __linux__
-    : server_(loop, listenAddr, name.c_str()),
-#else
-    : server_(loop, listenAddr, name.c_str(), true, app().reusePort()),
-#endif
+        &preSendingAdvices,
+    bool useIoUring)
+    : loop_(loop),
       httpAsyncCallback_(defaultHttpAsyncCallback),
       newWebsocketCallback_(defaultWebSockAsyncCallback),
       connectionCallback_(defaultConnectionCallback),
       syncAdvices_(syncAdvices),
       preSendingAdvices_(preSendingAdvices)
 {
-    server_.setConnectionCallback(
+#ifdef USE_IO_URING
+    if (useIoUring)
+    {
+        uringServer_ = std::make_unique<UringTcpServer>(loop, listenAddr, name);
+        uringServer_->setConnectionCallback(
+            [this](const auto &conn) { this->onConnection(conn); });
+        uringServer_->setRecvMessageCallback(
+            [this](const auto &conn, auto buff) {
+                this->onMessage(conn, buff);
+            });
+        return;
+    }
+#else
+    (void)useIoUring;
+#endif
+#ifdef __linux__
+    server_ = std::make_unique<TcpServer>(loop, listenAddr, name.c_str());
+#else
+    server_ = std::make_unique<TcpServer>(
+        loop, listenAddr, name.c_str(), true, app().reusePort());
+#endif
+    server_->setConnectionCallback(
         [this](const auto &conn) { this->onConnection(conn); });
-    server_.setRecvMessageCallback(
+    server_->setRecvMessageCallback(
         [this](const auto &conn, auto buff) { this->onMessage(conn, buff); });
 }
 
@@ -179,15 +202,104 @@ HttpServer::~HttpServer()
 {
 }
 
+void HttpServer::setIoLoopThreadPool(
+    const std::shared_ptr<trantor::EventLoopThreadPool> &pool)
+{
+#ifdef USE_IO_URING
+    if (uringServer_)
+    {
+        // The connections of an io_uring listener stay in its own loop.
+        LOG_ERROR << "The io_uring listeners don't use IO loop pools";
+        return;
+    }
+#endif
+    server_->setIoLoopThreadPool(pool);
+}
+
+void HttpServer::setIoLoopNum(int numThreads)
+{
+#ifdef USE_IO_URING
+    if (uringServer_)
+    {
+        LOG_ERROR << "The io_uring listeners don't use IO loop pools";
+        return;
+    }
+#endif
+    server_->setIoLoopNum(numThreads);
+}
+
+void HttpServer::enableSSL(
+    const std::string &certPath,
+    const std::string &keyPath,
+    bool useOldTLS,
+    const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
+{
+#ifdef USE_IO_URING
+    if (uringServer_)
+    {
+        LOG_ERROR << "TLS is not supported by the io_uring listeners";
+        return;
+    }
+#endif
+    server_->enableSSL(certPath, keyPath, useOldTLS, sslConfCmds);
+}
+
+void HttpServer::kickoffIdleConnections(size_t timeout)
+{
+#ifdef USE_IO_URING
+    if (uringServer_)
+    {
+        uringServer_->kickoffIdleConnections(timeout);
+        return;
+    }
+#endif
+    server_->kickoffIdleConnections(timeout);
+}
+
+std::vector<trantor::EventLoop *> HttpServer::getIoLoops()
+{
+#ifdef USE_IO_URING
+    if (uringServer_)
+        return {loop_};
+#endif
+    return server_->getIoLoops();
+}
+
+const trantor::InetAddress &HttpServer::address() const
+{
+#ifdef USE_IO_URING
+    if (uringServer_)
+        return uringServer_->address();
+#endif
+    return server_->address();
+}
+
 void HttpServer::start()
 {
-    LOG_TRACE << "HttpServer[" << server_.name() << "] starts listenning on "
-              << server_.ipPort();
-    server_.start();
+#ifdef USE_IO_URING
+    if (uringServer_)
+    {
+        LOG_TRACE << "HttpServer[" << uringServer_->name()
+                  << "] starts listenning on " << uringServer_->ipPort()
+                  << " with io_uring";
+        uringServer_->start();
+        return;
+    }
+#endif
+    LOG_TRACE << "HttpServer[" << server_->name() << "] starts listenning on "
+              << server_->ipPort();
+    server_->start();
 }
 void HttpServer::stop()
 {
-    server_.stop();
+#ifdef USE_IO_URING
+    if (uringServer_)
+    {
+        uringServer_->stop();
+        return;
+    }
+#endif
+    server_->stop();
 }
 void HttpServer::onConnection(const TcpConnectionPtr &conn)
 {
@@ -196,11 +308,18 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
         auto parser = std::make_shared<HttpRequestParser>(conn);
         parser->reset();
         conn->setContext(parser);
+        if (auto metrics = internal::builtinMetrics())
+        {
+            metrics->connections->increment();
+            metrics->acceptedConnections->increment();
+        }
         connectionCallback_(conn);
     }
     else if (conn->disconnected())
     {
         LOG_TRACE << "conn disconnected!";
+        if (auto metrics = internal::builtinMetrics())
+            metrics->connections->decrement();
         connectionCallback_(conn);
         auto requestParser = conn->getContext<HttpRequestParser>();
         if (requestParser)
@@ -209,6 +328,10 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
             {
                 requestParser->webSocketConn()->onClose();
             }
+            else if (requestParser->http2Session())
+            {
+                requestParser->http2Session()->onClose();
+            }
             conn->clearContext();
         }
     }
@@ -229,6 +352,33 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
         // Websocket payload
         requestParser->webSocketConn()->onNewMessage(conn, buf);
     }
+    else if (requestParser->http2Session())
+    {
+        requestParser->http2Session()->onMessage(buf);
+    }
+    else if (HttpAppFrameworkImpl::instance().isHttp2Enabled() &&
+             requestParser->atConnectionStart() &&
+             buf->readableBytes() > 0 &&
+             memcmp(buf->peek(),
+                    Http2Session::kClientPreface.data(),
+                    std::min(buf->readableBytes(),
+                             Http2Session::kClientPreface.length())) == 0)
+    {
+        // The client of HTTP/2 with prior knowledge (RFC 7540 3.4) starts
+        // with the connection preface, which is not a valid HTTP/1.x request.
+        if (buf->readableBytes() < Http2Session::kClientPreface.length())
+            return;
+        auto session = std::make_shared<Http2ServerSession>(
+            conn,
+            [this](const std::shared_ptr<Http2ServerSession> &session,
+                   const HttpRequestImplPtr &req,
+                   uint32_t streamId) {
+                onHttp2Request(session, req, streamId);
+            });
+        requestParser->setHttp2Session(session);
+        session->start();
+        session->onMessage(buf);
+    }
     else
     {
         auto &requests = requestParser->getRequestBuffer();
@@ -254,6 +404,8 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
                     trantor::Date::date());
                 requestParser->requestImpl()->setSecure(
                     conn->isSSLConnection());
+                HttpAppFrameworkImpl::instance().startTraceIfSampled(
+                    requestParser->requestImpl());
                 if (requestParser->firstReq() &&
                     isWebSocket(requestParser->requestImpl()))
                 {
@@ -411,6 +563,8 @@ void HttpServer::onRequests(
                                                              &syncFlag,
                                                              close_,
                                                              isHeadMethod);
+        if (auto metrics = internal::builtinMetrics())
+            metrics->requestsInFlight->increment();
         httpAsyncCallback_(
             req,
             [paramPack = std::move(paramPack),
@@ -423,11 +577,21 @@ void HttpServer::onRequests(
                 auto &loopFlagPtr = paramPack->loopFlag;
                 auto &requestParser = paramPack->requestParser;
 
+                if (auto metrics = internal::builtinMetrics())
+                {
+                    metrics->requestsInFlight->decrement();
+                    if (response)
+                        metrics->observeRequest(*req,
+                                                response->statusCode(),
+                                                internal::secondsSince(
+                                                    req->creationDate()));
+                }
                 if (!response)
                     return;
                 if (!conn->connected())
                     return;
 
+                req->markTrace(RequestTrace::kResponding);
                 response->setVersion(req->getVersion());
                 response->setCloseConnection(close_);
                 for (auto &advice : preSendingAdvices_)
@@ -436,6 +600,14 @@ void HttpServer::onRequests(
                 }
                 auto newResp =
                     getCompressedResponse(req, response, isHeadMethod);
+                if (auto trace = req->trace())
+                {
+                    trace->mark(RequestTrace::kSent);
+                    auto &exporter =
+                        HttpAppFrameworkImpl::instance().requestTraceExporter();
+                    if (exporter)
+                        exporter(req, newResp, *trace);
+                }
                 if (conn->getLoop()->isInLoopThread())
                 {
                     /*
@@ -547,6 +719,77 @@ void HttpServer::onRequests(
     }
 }
 
+void HttpServer::onHttp2Request(
+    const std::shared_ptr<Http2ServerSession> &session,
+    const HttpRequestImplPtr &req,
+    uint32_t streamId)
+{
+    // The streams of a HTTP/2 connection are independent, so there is no
+    // pipelining here, the responses are sent on their streams in any order.
+    bool isHeadMethod = (req->method() == Head);
+    if (isHeadMethod)
+    {
+        req->setMethod(Get);
+    }
+    for (auto &advice : syncAdvices_)
+    {
+        auto resp = advice(req);
+        if (resp)
+        {
+            session->sendResponse(streamId,
+                                  getCompressedResponse(req,
+                                                        resp,
+                                                        isHeadMethod),
+                                  isHeadMethod);
+            return;
+        }
+    }
+    if (auto metrics = internal::builtinMetrics())
+        metrics->requestsInFlight->increment();
+    std::weak_ptr<Http2ServerSession> weakSession = session;
+    httpAsyncCallback_(
+        req,
+        [weakSession, req, streamId, isHeadMethod, this](
+            const HttpResponsePtr &response) {
+            if (auto metrics = internal::builtinMetrics())
+            {
+                metrics->requestsInFlight->decrement();
+                if (response)
+                    metrics->observeRequest(*req,
+                                            response->statusCode(),
+                                            internal::secondsSince(
+                                                req->creationDate()));
+            }
+            if (!response)
+                return;
+            auto session = weakSession.lock();
+            if (!session)
+                return;
+            req->markTrace(RequestTrace::kResponding);
+            for (auto &advice : preSendingAdvices_)
+            {
+                advice(req, response);
+            }
+            auto newResp = getCompressedResponse(req, response, isHeadMethod);
+            if (auto trace = req->trace())
+            {
+                trace->mark(RequestTrace::kSent);
+                auto &exporter =
+                    HttpAppFrameworkImpl::instance().requestTraceExporter();
+                if (exporter)
+                    exporter(req, newResp, *trace);
+            }
+            // The state of the session is only read in the loop of its
+            // connection.
+            session->getLoop()->runInLoop(
+                [session, streamId, newResp, isHeadMethod]() {
+                    if (session->closed())
+                        return;
+                    session->sendResponse(streamId, newResp, isHeadMethod);
+                });
+        });
+}
+
 void HttpServer::sendResponse(const TcpConnectionPtr &conn,
                               const HttpResponsePtr &response,
                               bool isHeadMethod)
@@ -19,11 +19,16 @@
 #include <trantor/net/callbacks.h>
 #include <trantor/utils/NonCopyable.h>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace drogon
 {
+class Http2ServerSession;
+#ifdef USE_IO_URING
+class UringTcpServer;
+#endif
 class HttpServer : trantor::NonCopyable
 {
   public:
@@ -35,13 +40,14 @@ class HttpServer : trantor::NonCopyable
                    &syncAdvices,
                const std::vector<std::function<void(const HttpRequestPtr &,
                                                     const HttpResponsePtr &)>>
-                   &preSendingAdvices);
+                   &preSendingAdvices,
+               bool useIoUring = false);
 
     ~HttpServer();
 
     trantor::EventLoop *getLoop() const
     {
-        return server_.getLoop();
+        return loop_;
     }
 
     void setHttpAsyncCallback(const HttpAsyncCallback &cb)
@@ -58,26 +64,14 @@ class HttpServer : trantor::NonCopyable
         connectionCallback_ = cb;
     }
     void setIoLoopThreadPool(
-        const std::shared_ptr<trantor::EventLoopThreadPool> &pool)
-    {
-        server_.setIoLoopThreadPool(pool);
-    }
-    void setIoLoopNum(int numThreads)
-    {
-        server_.setIoLoopNum(numThreads);
-    }
-    void kickoffIdleConnections(size_t timeout)
-    {
-        server_.kickoffIdleConnections(timeout);
-    }
+        const std::shared_ptr<trantor::EventLoopThreadPool> &pool);
+    void setIoLoopNum(int numThreads);
+    void kickoffIdleConnections(size_t timeout);
     trantor::EventLoop *getLoop()
     {
-        return server_.getLoop();
-    }
-    std::vector<trantor::EventLoop *> getIoLoops()
-    {
-        return server_.getIoLoops();
+        return loop_;
     }
+    std::vector<trantor::EventLoop *> getIoLoops();
     void start();
     void stop();
 
@@ -85,15 +79,9 @@ class HttpServer : trantor::NonCopyable
         const std::string &certPath,
         const std::string &keyPath,
         bool useOldTLS,
-        const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
-    {
-        server_.enableSSL(certPath, keyPath, useOldTLS, sslConfCmds);
-    }
+        const std::vector<std::pair<std::string, std::string>> &sslConfCmds);
 
-    const trantor::InetAddress &address() const
-    {
-        return server_.address();
-    }
+    const trantor::InetAddress &address() const;
 
   private:
     void onConnection(const trantor::TcpConnectionPtr &conn);
@@ -101,6 +89,9 @@ class HttpServer : trantor::NonCopyable
     void onRequests(const trantor::TcpConnectionPtr &,
                     const std::vector<HttpRequestImplPtr> &,
                     const std::shared_ptr<HttpRequestParser> &);
+    void onHttp2Request(const std::shared_ptr<Http2ServerSession> &session,
+                        const HttpRequestImplPtr &req,
+                        uint32_t streamId);
     void sendResponse(const trantor::TcpConnectionPtr &,
                       const HttpResponsePtr &,
                       bool isHeadMethod);
@@ -108,7 +99,13 @@ class HttpServer : trantor::NonCopyable
         const trantor::TcpConnectionPtr &conn,
         const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
         trantor::MsgBuffer &buffer);
-    trantor::TcpServer server_;
+    trantor::EventLoop *loop_;
+    // Only one of the servers is created, the io_uring one is used for the
+    // plain TCP listeners when io_uring is enabled.
+    std::unique_ptr<trantor::TcpServer> server_;
+#ifdef USE_IO_URING
+    std::unique_ptr<UringTcpServer> uringServer_;
+#endif
     HttpAsyncCallback httpAsyncCallback_;
     WebSocketNewAsyncCallback newWebsocketCallback_;
     trantor::ConnectionCallback connectionCallback_;
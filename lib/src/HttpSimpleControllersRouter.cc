@@ -91,6 +91,7 @@ void HttpSimpleControllersRouter::route(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kRouting);
     std::string pathLower(req->path().length(), 0);
     std::transform(req->path().begin(),
                    req->path().end(),
@@ -203,6 +204,7 @@ void HttpSimpleControllersRouter::doControllerHandler(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kHandling);
     auto &controller = ctrlBinderPtr->controller_;
     if (controller)
     {
@@ -323,6 +325,7 @@ void HttpSimpleControllersRouter::doPreHandlingAdvices(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kPreHandling);
     if (req->method() == Options)
     {
         auto resp = HttpResponse::newHttpResponse();
@@ -408,6 +411,7 @@ void HttpSimpleControllersRouter::invokeCallback(
     const HttpRequestImplPtr &req,
     const HttpResponsePtr &resp)
 {
+    req->markTrace(RequestTrace::kHandled);
     for (auto &advice : postHandlingAdvices_)
     {
         advice(req, resp);
@@ -0,0 +1,373 @@
+/**
+ *
+ *  @file IoUring.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "IoUring.h"
+#include <trantor/net/Channel.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+using namespace drogon;
+
+namespace
+{
+int ioUringSetup(unsigned int entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd,
+                 unsigned int toSubmit,
+                 unsigned int minComplete,
+                 unsigned int flags)
+{
+    return static_cast<int>(syscall(
+        __NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned int opcode, void *arg, unsigned int num)
+{
+    return static_cast<int>(
+        syscall(__NR_io_uring_register, fd, opcode, arg, num));
+}
+
+// The receive requests are multishot since Linux 6.0, the other features
+// are older.
+bool kernelSupportsMultishotRecv()
+{
+    struct utsname name;
+    int major = 0;
+    int minor = 0;
+    if (uname(&name) != 0 ||
+        sscanf(name.release, "%d.%d", &major, &minor) != 2)
+        return false;
+    return major >= 6;
+}
+
+bool probeOps(int ringFd)
+{
+    constexpr unsigned int kOps = 256;
+    std::vector<char> memory(sizeof(io_uring_probe) +
+                             kOps * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe *>(memory.data());
+    if (ioUringRegister(ringFd, IORING_REGISTER_PROBE, probe, kOps) != 0)
+        return false;
+    for (unsigned int op : {IORING_OP_ACCEPT,
+                            IORING_OP_RECV,
+                            IORING_OP_SEND,
+                            IORING_OP_SENDMSG,
+                            IORING_OP_SPLICE,
+                            IORING_OP_SHUTDOWN,
+                            IORING_OP_ASYNC_CANCEL,
+                            IORING_OP_CLOSE})
+    {
+        if (op > probe->last_op ||
+            !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            return false;
+    }
+    return true;
+}
+
+bool probeBufferRing(int ringFd)
+{
+    auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto ring = mmap(nullptr,
+                     pageSize,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0);
+    if (ring == MAP_FAILED)
+        return false;
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = 1;
+    reg.bgid = IoUring::kBufferGroup;
+    bool ok = ioUringRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+    if (ok)
+        ioUringRegister(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(ring, pageSize);
+    return ok;
+}
+}  // namespace
+
+bool IoUring::supported()
+{
+    static const bool result = []() {
+        if (!kernelSupportsMultishotRecv())
+        {
+            LOG_WARN << "io_uring needs Linux 6.0 or later, "
+                        "epoll is used instead";
+            return false;
+        }
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = ioUringSetup(4, &params);
+        if (fd < 0)
+        {
+            LOG_SYSERR << "io_uring is not available, epoll is used instead";
+            return false;
+        }
+        bool ok = (params.features & IORING_FEAT_SINGLE_MMAP) &&
+                  (params.features & IORING_FEAT_NODROP) && probeOps(fd) &&
+                  probeBufferRing(fd);
+        close(fd);
+        if (!ok)
+            LOG_WARN << "The io_uring of the kernel lacks some features, "
+                        "epoll is used instead";
+        return ok;
+    }();
+    return result;
+}
+
+IoUring::IoUring(trantor::EventLoop *loop,
+                 unsigned int entries,
+                 unsigned int bufferCount,
+                 size_t bufferSize)
+    : loop_(loop), bufferCount_(bufferCount), bufferSize_(bufferSize)
+{
+    loop_->assertInLoopThread();
+    // Multishot requests post several completions per submission, so the
+    // completion queue is larger. Only the loop thread submits.
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER;
+    params.cq_entries = entries * 4;
+    ringFd_ = ioUringSetup(entries, &params);
+    if (ringFd_ < 0 && errno == EINVAL)
+    {
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        ringFd_ = ioUringSetup(entries, &params);
+    }
+    if (ringFd_ < 0)
+    {
+        LOG_SYSERR << "io_uring_setup";
+        LOG_FATAL << "Failed to create the io_uring instance";
+        abort();
+    }
+
+    ringSize_ =
+        std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+                 params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ringPtr_ = mmap(nullptr,
+                    ringSize_,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    ringFd_,
+                    IORING_OFF_SQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mmap(nullptr,
+                     sqesSize_,
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE,
+                     ringFd_,
+                     IORING_OFF_SQES);
+    if (ringPtr_ == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        LOG_SYSERR << "mmap";
+        LOG_FATAL << "Failed to map the io_uring queues";
+        abort();
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+    auto base = static_cast<char *>(ringPtr_);
+    sqHead_ = reinterpret_cast<unsigned int *>(base + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned int *>(base + params.sq_off.tail);
+    sqFlags_ = reinterpret_cast<unsigned int *>(base + params.sq_off.flags);
+    sqMask_ = *reinterpret_cast<unsigned int *>(base + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    // The submission entries are always used in order.
+    auto array = reinterpret_cast<unsigned int *>(base + params.sq_off.array);
+    for (unsigned int i = 0; i < sqEntries_; ++i)
+        array[i] = i;
+    sqeTail_ = *sqTail_;
+    cqHead_ = reinterpret_cast<unsigned int *>(base + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned int *>(base + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned int *>(base + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+
+    eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ < 0 ||
+        ioUringRegister(ringFd_, IORING_REGISTER_EVENTFD, &eventFd_, 1) != 0)
+    {
+        LOG_SYSERR << "io_uring eventfd";
+        LOG_FATAL << "Failed to register the eventfd of io_uring";
+        abort();
+    }
+    eventChannel_ = std::make_unique<trantor::Channel>(loop_, eventFd_);
+    eventChannel_->setReadCallback([this]() { handleCompletions(); });
+    eventChannel_->enableReading();
+
+    auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    bufferRingSize_ = (bufferCount_ * sizeof(io_uring_buf) + pageSize - 1) /
+                      pageSize * pageSize;
+    auto bufferRing = mmap(nullptr,
+                           bufferRingSize_,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1,
+                           0);
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+    reg.ring_entries = bufferCount_;
+    reg.bgid = kBufferGroup;
+    if (bufferRing == MAP_FAILED ||
+        ioUringRegister(ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        LOG_SYSERR << "io_uring buffer ring";
+        LOG_FATAL << "Failed to register the buffers of io_uring";
+        abort();
+    }
+    bufferRing_ = static_cast<io_uring_buf *>(bufferRing);
+    buffers_.resize(bufferCount_ * bufferSize_);
+    for (unsigned int i = 0; i < bufferCount_; ++i)
+        recycleBuffer(static_cast<uint16_t>(i));
+}
+
+IoUring::~IoUring()
+{
+    // The channel can only be removed in the loop thread, the loop is gone
+    // otherwise.
+    if (loop_->isInLoopThread())
+    {
+        eventChannel_->disableAll();
+        eventChannel_->remove();
+    }
+    // Closing the ring cancels the requests still in flight.
+    close(ringFd_);
+    close(eventFd_);
+    munmap(bufferRing_, bufferRingSize_);
+    munmap(sqes_, sqesSize_);
+    munmap(ringPtr_, ringSize_);
+}
+
+io_uring_sqe *IoUring::getSqe()
+{
+    if (sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_)
+    {
+        submit();
+        if (sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) ==
+            sqEntries_)
+        {
+            LOG_FATAL << "The submission queue of io_uring is full";
+            abort();
+        }
+    }
+    auto sqe = &sqes_[sqeTail_ & sqMask_];
+    ++sqeTail_;
+    ++toSubmit_;
+    memset(sqe, 0, sizeof(*sqe));
+    if (!submitQueued_)
+    {
+        // All the entries prepared in this iteration of the loop are
+        // submitted at its end.
+        submitQueued_ = true;
+        std::weak_ptr<IoUring> weakPtr = shared_from_this();
+        loop_->queueInLoop([weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->submitQueued_ = false;
+            thisPtr->submit();
+        });
+    }
+    return sqe;
+}
+
+void IoUring::submit()
+{
+    unsigned int flags = 0;
+    // The completions that didn't fit in the queue are flushed by the
+    // kernel when asked to.
+    if (__atomic_load_n(sqFlags_, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW)
+        flags |= IORING_ENTER_GETEVENTS;
+    if (toSubmit_ == 0 && flags == 0)
+        return;
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    int ret;
+    do
+    {
+        ret = ioUringEnter(ringFd_, toSubmit_, 0, flags);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0)
+    {
+        // The entries stay in the queue and are submitted by the next call.
+        if (errno != EAGAIN && errno != EBUSY)
+            LOG_SYSERR << "io_uring_enter";
+        return;
+    }
+    toSubmit_ -= std::min(toSubmit_, static_cast<unsigned int>(ret));
+}
+
+void IoUring::recycleBuffer(uint16_t id)
+{
+    auto &buf = bufferRing_[bufferTail_ & (bufferCount_ - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffers_.data() + id * bufferSize_);
+    buf.len = static_cast<uint32_t>(bufferSize_);
+    buf.bid = id;
+    ++bufferTail_;
+    __atomic_store_n(&bufferRing_[0].resv, bufferTail_, __ATOMIC_RELEASE);
+}
+
+void IoUring::handleCompletions()
+{
+    uint64_t count;
+    if (::read(eventFd_, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        LOG_SYSERR << "read eventfd";
+    reapCompletions();
+    // The requests made by the callbacks are submitted without waiting for
+    // the end of the iteration.
+    submit();
+}
+
+void IoUring::reapCompletions()
+{
+    for (;;)
+    {
+        auto head = *cqHead_;
+        auto tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        if (head == tail)
+        {
+            if (!(__atomic_load_n(sqFlags_, __ATOMIC_RELAXED) &
+                  IORING_SQ_CQ_OVERFLOW))
+                return;
+            if (ioUringEnter(ringFd_, 0, 0, IORING_ENTER_GETEVENTS) < 0 &&
+                errno != EINTR)
+            {
+                LOG_SYSERR << "io_uring_enter";
+                return;
+            }
+            continue;
+        }
+        for (; head != tail; ++head)
+        {
+            // The entry is copied so the kernel can reuse it while the
+            // callback runs.
+            auto cqe = cqes_[head & cqMask_];
+            __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+            if (completionCallback_)
+                completionCallback_(cqe.user_data, cqe.res, cqe.flags);
+        }
+    }
+}
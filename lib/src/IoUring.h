@@ -0,0 +1,138 @@
+/**
+ *
+ *  @file IoUring.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <linux/io_uring.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace trantor
+{
+class Channel;
+}
+
+namespace drogon
+{
+/**
+ * @brief An io_uring instance driven by an event loop. The completions are
+ * signaled by an eventfd watched by the loop, and the submission entries
+ * prepared in an iteration of the loop are submitted together with a single
+ * system call at the end of it.
+ *
+ * The ring also owns a ring of provided buffers, which the receive requests
+ * select from when data arrives instead of having a buffer per connection.
+ *
+ * All the methods must be called in the loop thread.
+ */
+class IoUring : public trantor::NonCopyable,
+                public std::enable_shared_from_this<IoUring>
+{
+  public:
+    using CompletionCallback =
+        std::function<void(uint64_t userData, int32_t result, uint32_t flags)>;
+
+    /// The group ID of the provided buffers.
+    static constexpr uint16_t kBufferGroup = 0;
+
+    /**
+     * @brief Return true if the kernel supports all the features used by
+     * the io_uring listeners (multishot accept and receive, provided buffer
+     * rings and splice). The result is checked once and logged if it's
+     * false.
+     */
+    static bool supported();
+
+    /**
+     * @brief Create the ring and register its eventfd and buffers in the
+     * loop, it must be called in the loop thread.
+     *
+     * @param entries The size of the submission queue.
+     * @param bufferCount The number of provided buffers, a power of 2.
+     * @param bufferSize The size of each provided buffer.
+     */
+    IoUring(trantor::EventLoop *loop,
+            unsigned int entries,
+            unsigned int bufferCount,
+            size_t bufferSize);
+    ~IoUring();
+
+    void setCompletionCallback(CompletionCallback cb)
+    {
+        completionCallback_ = std::move(cb);
+    }
+
+    /**
+     * @brief Get a cleared submission entry, it's submitted at the end of
+     * the current iteration of the loop.
+     */
+    io_uring_sqe *getSqe();
+
+    /// Submit the prepared entries now.
+    void submit();
+
+    const char *buffer(uint16_t id) const
+    {
+        return buffers_.data() + id * bufferSize_;
+    }
+    /// Give a provided buffer back to the kernel after its data is consumed.
+    void recycleBuffer(uint16_t id);
+
+    trantor::EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+  private:
+    void handleCompletions();
+    void reapCompletions();
+
+    trantor::EventLoop *loop_;
+    int ringFd_{-1};
+    int eventFd_{-1};
+    std::unique_ptr<trantor::Channel> eventChannel_;
+    CompletionCallback completionCallback_;
+
+    void *ringPtr_{nullptr};
+    size_t ringSize_{0};
+    io_uring_sqe *sqes_{nullptr};
+    size_t sqesSize_{0};
+    unsigned int *sqHead_{nullptr};
+    unsigned int *sqTail_{nullptr};
+    unsigned int *sqFlags_{nullptr};
+    unsigned int sqMask_{0};
+    unsigned int sqEntries_{0};
+    unsigned int *cqHead_{nullptr};
+    unsigned int *cqTail_{nullptr};
+    unsigned int cqMask_{0};
+    io_uring_cqe *cqes_{nullptr};
+    // The tail of the prepared entries and the number not submitted yet.
+    unsigned int sqeTail_{0};
+    unsigned int toSubmit_{0};
+    bool submitQueued_{false};
+
+    // The provided buffer ring is used as an array of entries, the tail of
+    // the ring overlays the reserved field of the first one.
+    io_uring_buf *bufferRing_{nullptr};
+    size_t bufferRingSize_{0};
+    unsigned int bufferCount_{0};
+    size_t bufferSize_{0};
+    uint16_t bufferTail_{0};
+    std::vector<char> buffers_;
+};
+
+}  // namespace drogon
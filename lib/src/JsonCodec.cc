@@ -0,0 +1,318 @@
+/**
+ *
+ *  @file JsonCodec.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/JsonCodec.h>
+#include <cmath>
+#include <memory>
+#include <stdio.h>
+
+using namespace drogon;
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static void appendHex(std::string &output, unsigned int codepoint)
+{
+    char buf[6] = {'\\',
+                   'u',
+                   hexDigits[(codepoint >> 12) & 0xf],
+                   hexDigits[(codepoint >> 8) & 0xf],
+                   hexDigits[(codepoint >> 4) & 0xf],
+                   hexDigits[codepoint & 0xf]};
+    output.append(buf, sizeof(buf));
+}
+
+// The same decoding as jsoncpp, invalid sequences are replaced by U+FFFD.
+static unsigned int utf8ToCodepoint(const char *&s, const char *e)
+{
+    const unsigned int replacementCharacter = 0xFFFD;
+    auto firstByte = static_cast<unsigned int>(static_cast<unsigned char>(*s));
+    if (firstByte < 0x80)
+        return firstByte;
+    auto byte = [s](int i) {
+        return static_cast<unsigned int>(static_cast<unsigned char>(s[i])) &
+               0x3F;
+    };
+    if (firstByte < 0xE0)
+    {
+        if (e - s < 2)
+            return replacementCharacter;
+        auto calculated = ((firstByte & 0x1F) << 6) | byte(1);
+        s += 1;
+        return calculated < 0x80 ? replacementCharacter : calculated;
+    }
+    if (firstByte < 0xF0)
+    {
+        if (e - s < 3)
+            return replacementCharacter;
+        auto calculated =
+            ((firstByte & 0x0F) << 12) | (byte(1) << 6) | byte(2);
+        s += 2;
+        if (calculated >= 0xD800 && calculated <= 0xDFFF)
+            return replacementCharacter;
+        return calculated < 0x800 ? replacementCharacter : calculated;
+    }
+    if (firstByte < 0xF8)
+    {
+        if (e - s < 4)
+            return replacementCharacter;
+        auto calculated = ((firstByte & 0x07) << 18) | (byte(1) << 12) |
+                          (byte(2) << 6) | byte(3);
+        s += 3;
+        return calculated < 0x10000 ? replacementCharacter : calculated;
+    }
+    return replacementCharacter;
+}
+
+void DefaultJsonCodec::writeUInt(uint64_t value, std::string &output)
+{
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    do
+    {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    output.append(p, end - p);
+}
+
+void DefaultJsonCodec::writeInt(int64_t value, std::string &output)
+{
+    if (value < 0)
+    {
+        output.push_back('-');
+        // Negate in the unsigned type to handle the minimum value.
+        writeUInt(0 - static_cast<uint64_t>(value), output);
+    }
+    else
+    {
+        writeUInt(static_cast<uint64_t>(value), output);
+    }
+}
+
+DefaultJsonCodec::DefaultJsonCodec(bool escapeUnicode,
+                                   unsigned int precision,
+                                   const std::string &precisionType)
+    : escapeUnicode_(escapeUnicode),
+      precision_(precision == 0 ? 17 : precision),
+      decimalPlaces_(precision != 0 && precisionType == "decimal")
+{
+}
+
+void DefaultJsonCodec::serialize(const Json::Value &value,
+                                 std::string &output)
+{
+    writeValue(value, output);
+}
+
+bool DefaultJsonCodec::parse(const char *begin,
+                             const char *end,
+                             Json::Value &value,
+                             std::string &errs)
+{
+    // A Json::CharReader resets its state for each document, so it can be
+    // reused by all requests in the same thread.
+    static thread_local std::unique_ptr<Json::CharReader> reader;
+    if (!reader)
+    {
+        Json::CharReaderBuilder builder;
+        builder["collectComments"] = false;
+        reader.reset(builder.newCharReader());
+    }
+    JSONCPP_STRING error;
+    if (!reader->parse(begin, end, &value, &error))
+    {
+        errs = std::move(error);
+        return false;
+    }
+    return true;
+}
+
+void DefaultJsonCodec::writeValue(const Json::Value &value,
+                                  std::string &output) const
+{
+    switch (value.type())
+    {
+        case Json::nullValue:
+            output.append("null", 4);
+            break;
+        case Json::intValue:
+            writeInt(value.asLargestInt(), output);
+            break;
+        case Json::uintValue:
+            writeUInt(value.asLargestUInt(), output);
+            break;
+        case Json::realValue:
+            writeDouble(value.asDouble(), output);
+            break;
+        case Json::stringValue:
+        {
+            const char *begin = nullptr;
+            const char *end = nullptr;
+            if (value.getString(&begin, &end))
+                writeString(begin, end, output);
+            else
+                output.append("\"\"", 2);
+            break;
+        }
+        case Json::booleanValue:
+            if (value.asBool())
+                output.append("true", 4);
+            else
+                output.append("false", 5);
+            break;
+        case Json::arrayValue:
+        {
+            output.push_back('[');
+            auto size = value.size();
+            for (Json::ArrayIndex i = 0; i < size; ++i)
+            {
+                if (i > 0)
+                    output.push_back(',');
+                writeValue(value[i], output);
+            }
+            output.push_back(']');
+            break;
+        }
+        case Json::objectValue:
+        {
+            output.push_back('{');
+            bool first = true;
+            for (auto iter = value.begin(); iter != value.end(); ++iter)
+            {
+                if (!first)
+                    output.push_back(',');
+                first = false;
+                const char *nameEnd = nullptr;
+                const char *name = iter.memberName(&nameEnd);
+                writeString(name, nameEnd, output);
+                output.push_back(':');
+                writeValue(*iter, output);
+            }
+            output.push_back('}');
+            break;
+        }
+    }
+}
+
+void DefaultJsonCodec::writeString(const char *begin,
+                                   const char *end,
+                                   std::string &output) const
+{
+    output.push_back('"');
+    const char *unescaped = begin;
+    for (const char *c = begin; c != end; ++c)
+    {
+        auto ch = static_cast<unsigned char>(*c);
+        if (ch >= 0x20 && ch != '"' && ch != '\\' &&
+            (ch < 0x80 || !escapeUnicode_))
+            continue;
+        output.append(unescaped, c - unescaped);
+        switch (ch)
+        {
+            case '"':
+                output.append("\\\"", 2);
+                break;
+            case '\\':
+                output.append("\\\\", 2);
+                break;
+            case '\b':
+                output.append("\\b", 2);
+                break;
+            case '\f':
+                output.append("\\f", 2);
+                break;
+            case '\n':
+                output.append("\\n", 2);
+                break;
+            case '\r':
+                output.append("\\r", 2);
+                break;
+            case '\t':
+                output.append("\\t", 2);
+                break;
+            default:
+                if (ch < 0x20)
+                {
+                    appendHex(output, ch);
+                }
+                else
+                {
+                    auto codepoint = utf8ToCodepoint(c, end);
+                    if (codepoint < 0x10000)
+                    {
+                        appendHex(output, codepoint);
+                    }
+                    else
+                    {
+                        // Encode 20 bits as a surrogate pair.
+                        codepoint -= 0x10000;
+                        appendHex(output, 0xd800 + ((codepoint >> 10) & 0x3ff));
+                        appendHex(output, 0xdc00 + (codepoint & 0x3ff));
+                    }
+                }
+                break;
+        }
+        unescaped = c + 1;
+    }
+    output.append(unescaped, end - unescaped);
+    output.push_back('"');
+}
+
+void DefaultJsonCodec::writeDouble(double value, std::string &output) const
+{
+    if (!std::isfinite(value))
+    {
+        if (std::isnan(value))
+            output.append("null", 4);
+        else if (value < 0)
+            output.append("-1e+9999", 8);
+        else
+            output.append("1e+9999", 7);
+        return;
+    }
+    char buf[512];
+    auto len = snprintf(buf,
+                        sizeof(buf),
+                        decimalPlaces_ ? "%.*f" : "%.*g",
+                        static_cast<int>(precision_),
+                        value);
+    if (len < 0 || static_cast<size_t>(len) + 2 >= sizeof(buf))
+    {
+        // Too many decimal places, fall back to the scientific notation.
+        len = snprintf(buf, sizeof(buf), "%.17g", value);
+    }
+    bool hasPoint = false;
+    for (int i = 0; i < len; ++i)
+    {
+        // Some locales use ',' as the decimal separator.
+        if (buf[i] == ',')
+            buf[i] = '.';
+        if (buf[i] == '.' || buf[i] == 'e')
+            hasPoint = true;
+    }
+    if (!hasPoint)
+    {
+        // Keep the number a real one when it is parsed back.
+        buf[len++] = '.';
+        buf[len++] = '0';
+    }
+    else if (decimalPlaces_)
+    {
+        // Remove the trailing zeros but keep one after the decimal point.
+        while (len > 2 && buf[len - 1] == '0' && buf[len - 2] != '.')
+            --len;
+    }
+    output.append(buf, len);
+}
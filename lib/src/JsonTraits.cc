@@ -0,0 +1,494 @@
+/**
+ *
+ *  @file JsonTraits.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/JsonTraits.h>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace drogon;
+
+static const size_t maxNestingDepth = 1000;
+
+static void appendUtf8(std::string &str, unsigned int codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        str.push_back(static_cast<char>(codepoint));
+    }
+    else if (codepoint < 0x800)
+    {
+        str.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        str.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+    else if (codepoint < 0x10000)
+    {
+        str.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        str.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        str.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+    else
+    {
+        str.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        str.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        str.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        str.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+char JsonReader::peek()
+{
+    while (pos_ < end_ &&
+           (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r'))
+        ++pos_;
+    return pos_ < end_ ? *pos_ : 0;
+}
+
+bool JsonReader::consume(char c)
+{
+    if (peek() == c && pos_ < end_)
+    {
+        ++pos_;
+        return true;
+    }
+    return false;
+}
+
+void JsonReader::expect(char c)
+{
+    if (!consume(c))
+    {
+        char message[] = "Missing ' '";
+        message[9] = c;
+        fail(message);
+    }
+}
+
+bool JsonReader::readNull()
+{
+    if (peek() == 'n' && end_ - pos_ >= 4 && memcmp(pos_, "null", 4) == 0)
+    {
+        pos_ += 4;
+        return true;
+    }
+    return false;
+}
+
+bool JsonReader::readBool()
+{
+    auto c = peek();
+    if (c == 't' && end_ - pos_ >= 4 && memcmp(pos_, "true", 4) == 0)
+    {
+        pos_ += 4;
+        return true;
+    }
+    if (c == 'f' && end_ - pos_ >= 5 && memcmp(pos_, "false", 5) == 0)
+    {
+        pos_ += 5;
+        return false;
+    }
+    fail("Expected a boolean");
+}
+
+void JsonReader::readString(std::string &str)
+{
+    expect('"');
+    str.clear();
+    auto readHex = [this]() {
+        if (end_ - pos_ < 4)
+            fail("Bad unicode escape sequence");
+        unsigned int codepoint = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            auto c = *pos_++;
+            codepoint <<= 4;
+            if (isDigit(c))
+                codepoint += c - '0';
+            else if (c >= 'a' && c <= 'f')
+                codepoint += c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                codepoint += c - 'A' + 10;
+            else
+                fail("Bad unicode escape sequence");
+        }
+        return codepoint;
+    };
+    while (true)
+    {
+        auto start = pos_;
+        while (pos_ < end_ && *pos_ != '"' && *pos_ != '\\')
+            ++pos_;
+        str.append(start, pos_ - start);
+        if (pos_ == end_)
+            fail("Missing '\"'");
+        if (*pos_++ == '"')
+            return;
+        if (pos_ == end_)
+            fail("Bad escape sequence");
+        switch (*pos_++)
+        {
+            case '"':
+                str.push_back('"');
+                break;
+            case '\\':
+                str.push_back('\\');
+                break;
+            case '/':
+                str.push_back('/');
+                break;
+            case 'b':
+                str.push_back('\b');
+                break;
+            case 'f':
+                str.push_back('\f');
+                break;
+            case 'n':
+                str.push_back('\n');
+                break;
+            case 'r':
+                str.push_back('\r');
+                break;
+            case 't':
+                str.push_back('\t');
+                break;
+            case 'u':
+            {
+                auto codepoint = readHex();
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+                {
+                    // The second half of a surrogate pair must follow.
+                    if (end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u')
+                        fail("Bad unicode surrogate pair");
+                    pos_ += 2;
+                    auto low = readHex();
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        fail("Bad unicode surrogate pair");
+                    codepoint =
+                        0x10000 + ((codepoint & 0x3FF) << 10) + (low & 0x3FF);
+                }
+                else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+                {
+                    fail("Bad unicode surrogate pair");
+                }
+                appendUtf8(str, codepoint);
+                break;
+            }
+            default:
+                fail("Bad escape sequence");
+        }
+    }
+}
+
+// Scan a number and return whether it is an integer.
+static bool scanNumber(const char *&pos, const char *end)
+{
+    bool isInteger = true;
+    if (pos < end && *pos == '-')
+        ++pos;
+    auto digits = pos;
+    while (pos < end && isDigit(*pos))
+        ++pos;
+    if (pos == digits)
+        throw std::invalid_argument("Expected a number");
+    if (pos < end && *pos == '.')
+    {
+        isInteger = false;
+        ++pos;
+        digits = pos;
+        while (pos < end && isDigit(*pos))
+            ++pos;
+        if (pos == digits)
+            throw std::invalid_argument("Bad number");
+    }
+    if (pos < end && (*pos == 'e' || *pos == 'E'))
+    {
+        isInteger = false;
+        ++pos;
+        if (pos < end && (*pos == '+' || *pos == '-'))
+            ++pos;
+        digits = pos;
+        while (pos < end && isDigit(*pos))
+            ++pos;
+        if (pos == digits)
+            throw std::invalid_argument("Bad number");
+    }
+    return isInteger;
+}
+
+int64_t JsonReader::readInt()
+{
+    peek();
+    auto start = pos_;
+    bool isInteger = false;
+    try
+    {
+        isInteger = scanNumber(pos_, end_);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        fail(e.what());
+    }
+    if (!isInteger)
+        fail("Expected an integer");
+    bool negative = *start == '-';
+    uint64_t limit = negative ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+    uint64_t value = 0;
+    for (auto p = negative ? start + 1 : start; p < pos_; ++p)
+    {
+        auto digit = static_cast<uint64_t>(*p - '0');
+        if (value > (limit - digit) / 10)
+            fail("Integer out of range");
+        value = value * 10 + digit;
+    }
+    return negative ? static_cast<int64_t>(0 - value)
+                    : static_cast<int64_t>(value);
+}
+
+uint64_t JsonReader::readUInt()
+{
+    if (peek() == '-')
+        fail("Expected an unsigned integer");
+    auto start = pos_;
+    bool isInteger = false;
+    try
+    {
+        isInteger = scanNumber(pos_, end_);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        fail(e.what());
+    }
+    if (!isInteger)
+        fail("Expected an integer");
+    uint64_t value = 0;
+    for (auto p = start; p < pos_; ++p)
+    {
+        auto digit = static_cast<uint64_t>(*p - '0');
+        if (value > (UINT64_MAX - digit) / 10)
+            fail("Integer out of range");
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+double JsonReader::readDouble()
+{
+    peek();
+    auto start = pos_;
+    try
+    {
+        scanNumber(pos_, end_);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        fail(e.what());
+    }
+    // strtod() needs a null-terminated string.
+    char buf[64];
+    auto length = static_cast<size_t>(pos_ - start);
+    if (length < sizeof(buf))
+    {
+        memcpy(buf, start, length);
+        buf[length] = '\0';
+        return strtod(buf, nullptr);
+    }
+    std::string str(start, length);
+    return strtod(str.c_str(), nullptr);
+}
+
+void JsonReader::readValue(Json::Value &value)
+{
+    switch (peek())
+    {
+        case '{':
+        {
+            ++pos_;
+            enter();
+            value = Json::Value(Json::objectValue);
+            if (!consume('}'))
+            {
+                std::string name;
+                do
+                {
+                    readString(name);
+                    expect(':');
+                    readValue(value[name]);
+                } while (consume(','));
+                expect('}');
+            }
+            leave();
+            break;
+        }
+        case '[':
+        {
+            ++pos_;
+            enter();
+            value = Json::Value(Json::arrayValue);
+            if (!consume(']'))
+            {
+                do
+                {
+                    readValue(value.append(Json::Value()));
+                } while (consume(','));
+                expect(']');
+            }
+            leave();
+            break;
+        }
+        case '"':
+        {
+            std::string str;
+            readString(str);
+            value = Json::Value(std::move(str));
+            break;
+        }
+        case 't':
+        case 'f':
+            value = readBool();
+            break;
+        case 'n':
+            if (!readNull())
+                fail("Expected null");
+            value = Json::Value();
+            break;
+        default:
+        {
+            // Integers are kept as integers as far as they fit as jsoncpp
+            // does.
+            auto start = pos_;
+            bool isInteger = false;
+            try
+            {
+                isInteger = scanNumber(pos_, end_);
+            }
+            catch (const std::invalid_argument &e)
+            {
+                fail(e.what());
+            }
+            auto end = pos_;
+            pos_ = start;
+            if (isInteger)
+            {
+                try
+                {
+                    if (*start == '-')
+                        value = Json::Value(Json::Int64(readInt()));
+                    else
+                    {
+                        auto v = readUInt();
+                        if (v <= uint64_t(INT64_MAX))
+                            value = Json::Value(Json::Int64(v));
+                        else
+                            value = Json::Value(Json::UInt64(v));
+                    }
+                    break;
+                }
+                catch (const std::runtime_error &)
+                {
+                    pos_ = start;
+                }
+            }
+            value = readDouble();
+            pos_ = end;
+            break;
+        }
+    }
+}
+
+void JsonReader::skipValue()
+{
+    switch (peek())
+    {
+        case '{':
+        {
+            ++pos_;
+            enter();
+            if (!consume('}'))
+            {
+                std::string name;
+                do
+                {
+                    readString(name);
+                    expect(':');
+                    skipValue();
+                } while (consume(','));
+                expect('}');
+            }
+            leave();
+            break;
+        }
+        case '[':
+        {
+            ++pos_;
+            enter();
+            if (!consume(']'))
+            {
+                do
+                {
+                    skipValue();
+                } while (consume(','));
+                expect(']');
+            }
+            leave();
+            break;
+        }
+        case '"':
+        {
+            std::string str;
+            readString(str);
+            break;
+        }
+        case 't':
+        case 'f':
+            readBool();
+            break;
+        case 'n':
+            if (!readNull())
+                fail("Expected null");
+            break;
+        default:
+            try
+            {
+                scanNumber(pos_, end_);
+            }
+            catch (const std::invalid_argument &e)
+            {
+                fail(e.what());
+            }
+            break;
+    }
+}
+
+void JsonReader::finish()
+{
+    if (peek() != 0 || pos_ != end_)
+        fail("Unexpected characters after the value");
+}
+
+void JsonReader::enter()
+{
+    if (++depth_ > maxNestingDepth)
+        fail("Too deep nesting");
+}
+
+void JsonReader::fail(const char *message) const
+{
+    throw std::runtime_error(std::string(message) + " at offset " +
+                             std::to_string(pos_ - begin_));
+}
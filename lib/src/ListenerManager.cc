@@ -17,6 +17,12 @@
 #include "HttpAppFrameworkImpl.h"
 #include <drogon/config.h>
 #include <trantor/utils/Logger.h>
+#ifdef OpenSSL_FOUND
+#include "SSLSessionManager.h"
+#endif
+#ifdef USE_IO_URING
+#include "IoUring.h"
+#endif
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -93,6 +99,15 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
         &preSendingAdvices)
 {
 #ifdef __linux__
+    bool useIoUring = false;
+    if (HttpAppFrameworkImpl::instance().isIoUringEnabled())
+    {
+#ifdef USE_IO_URING
+        useIoUring = IoUring::supported();
+#else
+        LOG_WARN << "Drogon is built without io_uring, epoll is used instead";
+#endif
+    }
     for (size_t i = 0; i < threadNum; ++i)
     {
         LOG_TRACE << "thread num=" << threadNum;
@@ -121,21 +136,23 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
                                  "drogonPortTest",
                                  true,
                                  false);
-                serverPtr =
-                    std::make_shared<HttpServer>(loopThreadPtr->getLoop(),
-                                                 std::move(listenAddress),
-                                                 "drogon",
-                                                 syncAdvices,
-                                                 preSendingAdvices);
+                serverPtr = std::make_shared<HttpServer>(
+                    loopThreadPtr->getLoop(),
+                    std::move(listenAddress),
+                    "drogon",
+                    syncAdvices,
+                    preSendingAdvices,
+                    useIoUring && !listener.useSSL_);
             }
             else
             {
-                serverPtr =
-                    std::make_shared<HttpServer>(loopThreadPtr->getLoop(),
-                                                 std::move(listenAddress),
-                                                 "drogon",
-                                                 syncAdvices,
-                                                 preSendingAdvices);
+                serverPtr = std::make_shared<HttpServer>(
+                    loopThreadPtr->getLoop(),
+                    std::move(listenAddress),
+                    "drogon",
+                    syncAdvices,
+                    preSendingAdvices,
+                    useIoUring && !listener.useSSL_);
             }
 
             if (listener.useSSL_)
@@ -158,6 +175,11 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
                 std::copy(listener.sslConfCmds_.begin(),
                           listener.sslConfCmds_.end(),
                           std::back_inserter(cmds));
+                // The contexts created in the scope share the TLS sessions
+                // if it's enabled, and select HTTP/2 by ALPN if it's
+                // enabled.
+                SSLSessionManager::Scope scope(
+                    HttpAppFrameworkImpl::instance().isHttp2Enabled());
                 serverPtr->enableSSL(cert, key, listener.useOldTLS_, cmds);
 #endif
             }
@@ -170,6 +192,8 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
         }
     }
 #else
+    if (HttpAppFrameworkImpl::instance().isIoUringEnabled())
+        LOG_WARN << "io_uring is only supported on Linux";
 
     ioLoopThreadPoolPtr_ = std::make_shared<EventLoopThreadPool>(threadNum);
     if (!listeners_.empty())
@@ -208,6 +232,8 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
                 std::copy(listener.sslConfCmds_.begin(),
                           listener.sslConfCmds_.end(),
                           std::back_inserter(cmds));
+                SSLSessionManager::Scope scope(
+                    HttpAppFrameworkImpl::instance().isHttp2Enabled());
                 serverPtr->enableSSL(cert, key, listener.useOldTLS_, cmds);
 #endif
             }
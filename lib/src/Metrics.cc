@@ -0,0 +1,405 @@
+/**
+ *
+ *  @file Metrics.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BuiltinMetrics.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+
+using namespace drogon;
+using namespace drogon::metrics;
+
+std::atomic<drogon::internal::BuiltinMetrics *>
+    drogon::internal::builtinMetricsPtr{nullptr};
+
+size_t metrics::internal::shardIndex()
+{
+    static std::atomic<size_t> nextIndex{0};
+    static thread_local size_t index =
+        nextIndex.fetch_add(1, std::memory_order_relaxed) % kShardsNumber;
+    return index;
+}
+
+static void appendNumber(std::string &output, double value)
+{
+    if (std::isnan(value))
+    {
+        output.append("NaN");
+        return;
+    }
+    if (std::isinf(value))
+    {
+        output.append(value > 0 ? "+Inf" : "-Inf");
+        return;
+    }
+    // Use the shortest representation that reads back to the same value.
+    char buf[32];
+    int length = 0;
+    for (int precision = 6; precision <= 17; ++precision)
+    {
+        length = snprintf(buf, sizeof(buf), "%.*g", precision, value);
+        if (strtod(buf, nullptr) == value)
+            break;
+    }
+    output.append(buf, length);
+}
+
+static void appendNumber(std::string &output, uint64_t value)
+{
+    output.append(std::to_string(value));
+}
+
+// Append a sample line: name{labels} value
+template <typename T>
+static void appendSample(std::string &output,
+                         const std::string &name,
+                         const char *suffix,
+                         const std::string &labels,
+                         T value)
+{
+    output.append(name);
+    output.append(suffix);
+    if (!labels.empty())
+    {
+        output.push_back('{');
+        output.append(labels);
+        output.push_back('}');
+    }
+    output.push_back(' ');
+    appendNumber(output, value);
+    output.push_back('\n');
+}
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+    for (auto &shard : shards_)
+        total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Counter::render(std::string &output,
+                     const std::string &name,
+                     const std::string &labels) const
+{
+    appendSample(output, name, "", labels, value());
+}
+
+void Gauge::set(double value)
+{
+    shards_[0].value.store(value, std::memory_order_relaxed);
+    for (size_t i = 1; i < internal::kShardsNumber; ++i)
+        shards_[i].value.store(0, std::memory_order_relaxed);
+}
+
+double Gauge::value() const
+{
+    double total = 0;
+    for (auto &shard : shards_)
+        total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Gauge::render(std::string &output,
+                   const std::string &name,
+                   const std::string &labels) const
+{
+    appendSample(output, name, "", labels, value());
+}
+
+Histogram::Histogram(const std::vector<double> &bounds)
+    : bounds_(bounds), stride_(bounds.size() + 1)
+{
+    std::sort(bounds_.begin(), bounds_.end());
+    // Keep the counters of different shards in different cache lines.
+    stride_ = (stride_ + 7) / 8 * 8;
+    counts_.reset(
+        new std::atomic<uint64_t>[stride_ * internal::kShardsNumber]());
+}
+
+void Histogram::observe(double value)
+{
+    auto shard = internal::shardIndex();
+    // A bucket counts the values less than or equal to its bound.
+    auto bucket = static_cast<size_t>(
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+        bounds_.begin());
+    counts_[shard * stride_ + bucket].fetch_add(1, std::memory_order_relaxed);
+    internal::atomicAdd(sums_[shard].value, value);
+}
+
+std::vector<uint64_t> Histogram::cumulativeCounts() const
+{
+    std::vector<uint64_t> counts(bounds_.size() + 1, 0);
+    for (size_t shard = 0; shard < internal::kShardsNumber; ++shard)
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            counts[i] +=
+                counts_[shard * stride_ + i].load(std::memory_order_relaxed);
+        }
+    }
+    for (size_t i = 1; i < counts.size(); ++i)
+        counts[i] += counts[i - 1];
+    return counts;
+}
+
+double Histogram::sum() const
+{
+    double total = 0;
+    for (auto &shard : sums_)
+        total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Histogram::render(std::string &output,
+                       const std::string &name,
+                       const std::string &labels) const
+{
+    auto counts = cumulativeCounts();
+    std::string bucketLabels = labels;
+    if (!bucketLabels.empty())
+        bucketLabels.push_back(',');
+    auto prefixLength = bucketLabels.length();
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        bucketLabels.resize(prefixLength);
+        bucketLabels.append("le=\"");
+        if (i < bounds_.size())
+            appendNumber(bucketLabels, bounds_[i]);
+        else
+            bucketLabels.append("+Inf");
+        bucketLabels.push_back('"');
+        appendSample(output, name, "_bucket", bucketLabels, counts[i]);
+    }
+    appendSample(output, name, "_sum", labels, sum());
+    appendSample(output, name, "_count", labels, counts.back());
+}
+
+void FamilyBase::render(std::string &output) const
+{
+    output.append("# HELP ");
+    output.append(name_);
+    output.push_back(' ');
+    for (auto c : help_)
+    {
+        if (c == '\\')
+            output.append("\\\\");
+        else if (c == '\n')
+            output.append("\\n");
+        else
+            output.push_back(c);
+    }
+    output.append("\n# TYPE ");
+    output.append(name_);
+    output.push_back(' ');
+    output.append(type_);
+    output.push_back('\n');
+    renderMetrics(output);
+}
+
+std::string FamilyBase::formatLabels(
+    const std::vector<std::string> &values) const
+{
+    std::string labels;
+    for (size_t i = 0; i < labelNames_.size(); ++i)
+    {
+        if (i > 0)
+            labels.push_back(',');
+        labels.append(labelNames_[i]);
+        labels.append("=\"");
+        for (auto c : values[i])
+        {
+            if (c == '\\')
+                labels.append("\\\\");
+            else if (c == '"')
+                labels.append("\\\"");
+            else if (c == '\n')
+                labels.append("\\n");
+            else
+                labels.push_back(c);
+        }
+        labels.push_back('"');
+    }
+    return labels;
+}
+
+Registry &Registry::instance()
+{
+    static Registry registry;
+    return registry;
+}
+
+template <typename MetricType>
+Family<MetricType> &Registry::getFamily(
+    const std::string &name,
+    const std::string &help,
+    const char *type,
+    const std::vector<std::string> &labelNames,
+    std::function<std::unique_ptr<MetricType>()> &&factory)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &family : families_)
+    {
+        if (family->name() == name)
+        {
+            if (family->type() != type)
+                throw std::invalid_argument("The metric " + name +
+                                            " is not a " + type);
+            return static_cast<Family<MetricType> &>(*family);
+        }
+    }
+    auto family = std::make_unique<Family<MetricType>>(
+        name, help, type, labelNames, std::move(factory));
+    auto &ref = *family;
+    families_.push_back(std::move(family));
+    return ref;
+}
+
+Family<Counter> &Registry::counter(const std::string &name,
+                                   const std::string &help,
+                                   const std::vector<std::string> &labelNames)
+{
+    return getFamily<Counter>(name, help, "counter", labelNames, []() {
+        return std::make_unique<Counter>();
+    });
+}
+
+Family<Gauge> &Registry::gauge(const std::string &name,
+                               const std::string &help,
+                               const std::vector<std::string> &labelNames)
+{
+    return getFamily<Gauge>(name, help, "gauge", labelNames, []() {
+        return std::make_unique<Gauge>();
+    });
+}
+
+Family<Histogram> &Registry::histogram(
+    const std::string &name,
+    const std::string &help,
+    const std::vector<std::string> &labelNames,
+    const std::vector<double> &bounds)
+{
+    return getFamily<Histogram>(name,
+                                help,
+                                "histogram",
+                                labelNames,
+                                [bounds]() {
+                                    return std::make_unique<Histogram>(bounds);
+                                });
+}
+
+const std::vector<double> &Registry::defaultBounds()
+{
+    static const std::vector<double>
+        bounds{0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+    return bounds;
+}
+
+void Registry::render(std::string &output) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &family : families_)
+    {
+        family->render(output);
+    }
+}
+
+void Registry::enableBuiltinMetrics()
+{
+    std::call_once(builtinFlag_, [this]() {
+        static drogon::internal::BuiltinMetrics builtin;
+        builtin.connections =
+            &gauge("drogon_http_connections", "Open HTTP connections").get();
+        builtin.acceptedConnections =
+            &counter("drogon_http_connections_total",
+                     "Accepted HTTP connections")
+                 .get();
+        builtin.requestsInFlight = &gauge("drogon_http_requests_in_flight",
+                                          "HTTP requests being handled")
+                                        .get();
+        builtin.requestDuration =
+            &histogram("drogon_http_request_duration_seconds",
+                       "Time from receiving HTTP requests to their responses",
+                       {"method", "route"});
+        builtin.requests = &counter("drogon_http_requests_total",
+                                    "Handled HTTP requests",
+                                    {"method", "route", "status"});
+        builtin.dbPoolWait =
+            &histogram("drogon_db_pool_wait_seconds",
+                       "Time SQL queries wait for idle connections")
+                 .get();
+        builtin.dbQueryDuration =
+            &histogram("drogon_db_query_duration_seconds",
+                       "Time from sending SQL queries on connections to their "
+                       "results")
+                 .get();
+        builtin.redisPoolWait =
+            &histogram("drogon_redis_pool_wait_seconds",
+                       "Time buffered redis commands wait for connections")
+                 .get();
+        builtin.redisCommandDuration =
+            &histogram("drogon_redis_command_duration_seconds",
+                       "Time from submitting redis commands to their results")
+                 .get();
+        auto &handshakes = counter("drogon_tls_handshakes_total",
+                                   "Completed TLS handshakes of the listeners",
+                                   {"resumed"});
+        builtin.tlsFullHandshakes = &handshakes.get({"false"});
+        builtin.tlsResumedHandshakes = &handshakes.get({"true"});
+        drogon::internal::builtinMetricsPtr.store(&builtin,
+                                                  std::memory_order_release);
+    });
+}
+
+void drogon::internal::BuiltinMetrics::observeRequest(const HttpRequest &req,
+                                                      HttpStatusCode status,
+                                                      double seconds)
+{
+    // Looking up the metrics in the families takes a lock, so the metrics
+    // found are cached in each thread.
+    static thread_local std::unordered_map<std::string, metrics::Histogram *>
+        durations;
+    static thread_local std::unordered_map<std::string, metrics::Counter *>
+        counters;
+    static thread_local std::string key;
+    auto method = req.methodString();
+    auto route = req.matchedPathPattern();
+    key.assign(method);
+    key.push_back(' ');
+    key.append(route.data(), route.length());
+    auto durationIter = durations.find(key);
+    if (durationIter == durations.end())
+    {
+        auto &histogram = requestDuration->get(
+            {method, std::string(route.data(), route.length())});
+        durationIter = durations.emplace(key, &histogram).first;
+    }
+    durationIter->second->observe(seconds);
+
+    key.push_back(' ');
+    key.append(std::to_string(static_cast<int>(status)));
+    auto counterIter = counters.find(key);
+    if (counterIter == counters.end())
+    {
+        auto &counter =
+            requests->get({method,
+                           std::string(route.data(), route.length()),
+                           std::to_string(static_cast<int>(status))});
+        counterIter = counters.emplace(key, &counter).first;
+    }
+    counterIter->second->increment();
+}
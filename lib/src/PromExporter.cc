@@ -0,0 +1,40 @@
+/**
+ *
+ *  PromExporter.cc
+ *
+ */
+#include <drogon/drogon.h>
+#include <drogon/Metrics.h>
+#include <drogon/plugins/PromExporter.h>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+void PromExporter::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    if (config.get("builtin_metrics", true).asBool())
+    {
+        metrics::Registry::instance().enableBuiltinMetrics();
+    }
+    app().registerHandler(
+        path_,
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            std::string body;
+            metrics::Registry::instance().render(body);
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setBody(std::move(body));
+            resp->setContentTypeCodeAndCustomString(
+                CT_TEXT_PLAIN,
+                "content-type: text/plain; version=0.0.4; "
+                "charset=utf-8\r\n");
+            callback(resp);
+        },
+        {Get});
+}
+
+void PromExporter::shutdown()
+{
+    /// Shutdown the plugin
+}
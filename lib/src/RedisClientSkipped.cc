@@ -28,5 +28,15 @@ std::shared_ptr<RedisClient> RedisClient::newRedisClient(
                  "hiredis library first.";
     abort();
 }
+
+std::shared_ptr<RedisClient> RedisClient::newRedisClusterClient(
+    const std::vector<trantor::InetAddress>& /*seeds*/,
+    size_t /*connectionsPerNode*/,
+    const std::string& /*password*/)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
 }  // namespace nosql
 }  // namespace drogon
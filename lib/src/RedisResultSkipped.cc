@@ -54,6 +54,36 @@ std::vector<RedisResult> RedisResult::asArray() const noexcept(false)
                  "hiredis library first.";
     abort();
 }
+string_view RedisResult::asStringView() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+size_t RedisResult::arraySize() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+RedisResult RedisResult::operator[](size_t /*index*/) const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+RedisResult::ConstIterator RedisResult::begin() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+RedisResult::ConstIterator RedisResult::end() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
 long long RedisResult::asInteger() const noexcept(false)
 {
     LOG_FATAL << "Redis is not supported by drogon, please install the "
@@ -0,0 +1,370 @@
+/**
+ *
+ *  @file RequestTrace.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/RequestTrace.h>
+#include <drogon/HttpClient.h>
+#include <json/json.h>
+#include <trantor/utils/AsyncFileLogger.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+
+using namespace drogon;
+
+static std::string randomHex(size_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+    static thread_local std::mt19937_64 engine{std::random_device{}()};
+    std::string id;
+    id.reserve(length);
+    while (id.length() < length)
+    {
+        auto value = engine();
+        for (int i = 0; i < 16 && id.length() < length; ++i)
+        {
+            id.push_back(hex[value & 0xf]);
+            value >>= 4;
+        }
+    }
+    return id;
+}
+
+static bool isValidId(const std::string &str, size_t pos, size_t length)
+{
+    bool allZero = true;
+    for (size_t i = pos; i < pos + length; ++i)
+    {
+        auto c = str[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+            return false;
+        if (c != '0')
+            allZero = false;
+    }
+    return !allZero;
+}
+
+RequestTrace::RequestTrace()
+    : start_(std::chrono::steady_clock::now()),
+      startDate_(trantor::Date::now()),
+      traceId_(randomHex(32)),
+      spanId_(randomHex(16))
+{
+    timestamps_[kParsed] = 1;
+}
+
+void RequestTrace::setTraceParent(const std::string &traceparent)
+{
+    // version-traceid-parentid-flags, e.g.
+    // 00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01
+    if (traceparent.length() < 55 || traceparent[2] != '-' ||
+        traceparent[35] != '-' || traceparent[52] != '-')
+        return;
+    if (!isValidId(traceparent, 3, 32) || !isValidId(traceparent, 36, 16))
+        return;
+    traceId_ = traceparent.substr(3, 32);
+    parentSpanId_ = traceparent.substr(36, 16);
+}
+
+const char *RequestTrace::stageName(Stage stage)
+{
+    switch (stage)
+    {
+        case kParsed:
+            return "parsed";
+        case kPreRouting:
+            return "pre-routing";
+        case kRouting:
+            return "routing";
+        case kFiltering:
+            return "filtering";
+        case kPreHandling:
+            return "pre-handling";
+        case kHandling:
+            return "handling";
+        case kHandled:
+            return "handled";
+        case kResponding:
+            return "responding";
+        case kSent:
+            return "sent";
+        default:
+            return "unknown";
+    }
+}
+
+static Json::Value stringAttribute(const char *key, const std::string &value)
+{
+    Json::Value attribute;
+    attribute["key"] = key;
+    attribute["value"]["stringValue"] = value;
+    return attribute;
+}
+
+static Json::Value intAttribute(const char *key, int64_t value)
+{
+    // OTLP/JSON encodes 64-bit integers as strings.
+    Json::Value attribute;
+    attribute["key"] = key;
+    attribute["value"]["intValue"] = std::to_string(value);
+    return attribute;
+}
+
+void RequestTrace::appendOtlpSpans(Json::Value &spans,
+                                   const HttpRequest &req,
+                                   const HttpResponse &resp) const
+{
+    auto startNanoseconds = startDate_.microSecondsSinceEpoch() * 1000;
+    auto lastStage = kParsed;
+    for (int i = kParsed; i < kStagesNumber; ++i)
+    {
+        if (reached(static_cast<Stage>(i)))
+            lastStage = static_cast<Stage>(i);
+    }
+    auto endNanoseconds = startNanoseconds + elapsed(lastStage);
+
+    auto route = req.matchedPathPattern();
+    Json::Value root;
+    root["traceId"] = traceId_;
+    root["spanId"] = spanId_;
+    if (!parentSpanId_.empty())
+        root["parentSpanId"] = parentSpanId_;
+    root["name"] = std::string(req.methodString()) + " " +
+                   (route.empty() ? req.path()
+                                  : std::string(route.data(), route.length()));
+    root["kind"] = 2;  // SPAN_KIND_SERVER
+    root["startTimeUnixNano"] = std::to_string(startNanoseconds);
+    root["endTimeUnixNano"] = std::to_string(endNanoseconds);
+    auto &attributes = root["attributes"];
+    attributes.append(stringAttribute("http.method", req.methodString()));
+    attributes.append(stringAttribute("http.target", req.path()));
+    if (!route.empty())
+        attributes.append(stringAttribute(
+            "http.route", std::string(route.data(), route.length())));
+    attributes.append(
+        intAttribute("http.status_code", static_cast<int>(resp.statusCode())));
+    if (resp.statusCode() >= 500)
+        root["status"]["code"] = 2;  // STATUS_CODE_ERROR
+
+    spans.append(root);
+    for (int i = kParsed; i < kStagesNumber; ++i)
+    {
+        auto stage = static_cast<Stage>(i);
+        if (!reached(stage) || stage == lastStage)
+            continue;
+        // A stage lasts until the next recorded stage.
+        auto next = i + 1;
+        while (!reached(static_cast<Stage>(next)))
+            ++next;
+        Json::Value span;
+        span["traceId"] = traceId_;
+        span["spanId"] = randomHex(16);
+        span["parentSpanId"] = spanId_;
+        span["name"] = stageName(stage);
+        span["kind"] = 1;  // SPAN_KIND_INTERNAL
+        span["startTimeUnixNano"] =
+            std::to_string(startNanoseconds + elapsed(stage));
+        span["endTimeUnixNano"] = std::to_string(
+            startNanoseconds + elapsed(static_cast<Stage>(next)));
+        spans.append(span);
+    }
+}
+
+// Wrap the spans in an ExportTraceServiceRequest object.
+static std::string otlpRequestJson(Json::Value &&spans)
+{
+    Json::Value scopeSpans;
+    scopeSpans["scope"]["name"] = "drogon";
+    scopeSpans["spans"] = std::move(spans);
+    Json::Value resourceSpans;
+    resourceSpans["resource"]["attributes"].append(
+        stringAttribute("service.name", "drogon"));
+    resourceSpans["scopeSpans"].append(scopeSpans);
+    Json::Value request;
+    request["resourceSpans"].append(resourceSpans);
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, request);
+}
+
+std::string RequestTrace::toOtlpJson(const HttpRequest &req,
+                                     const HttpResponse &resp) const
+{
+    Json::Value spans(Json::arrayValue);
+    appendOtlpSpans(spans, req, resp);
+    return otlpRequestJson(std::move(spans));
+}
+
+RequestTraceExporter drogon::newOtlpFileTraceExporter(
+    const std::string &path,
+    const std::string &baseName,
+    uint64_t sizeLimit)
+{
+    auto logger = std::make_shared<trantor::AsyncFileLogger>();
+    logger->setFileName(baseName, ".json", path);
+    logger->setFileSizeLimit(sizeLimit);
+    logger->startLogging();
+    return [logger](const HttpRequestPtr &req,
+                    const HttpResponsePtr &resp,
+                    const RequestTrace &trace) {
+        auto line = trace.toOtlpJson(*req, *resp);
+        line.push_back('\n');
+        logger->output(line.data(), line.length());
+    };
+}
+
+namespace
+{
+/**
+ * @brief Buffer the spans of the traces and post them to a collector in
+ * batches.
+ */
+class OtlpSpanBatcher : public std::enable_shared_from_this<OtlpSpanBatcher>
+{
+  public:
+    OtlpSpanBatcher(HttpClientPtr client,
+                    std::string path,
+                    size_t maxBatchSize,
+                    size_t maxQueueSize)
+        : client_(std::move(client)),
+          path_(std::move(path)),
+          maxBatchSize_(maxBatchSize == 0 ? 1 : maxBatchSize),
+          maxQueueSize_((std::max)(maxQueueSize, maxBatchSize_))
+    {
+    }
+    void start(double interval)
+    {
+        if (interval <= 0)
+            return;
+        std::weak_ptr<OtlpSpanBatcher> weakPtr = shared_from_this();
+        client_->getLoop()->runEvery(interval, [weakPtr]() {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->flush();
+        });
+    }
+    void add(const HttpRequest &req,
+             const HttpResponse &resp,
+             const RequestTrace &trace)
+    {
+        Json::Value spans(Json::arrayValue);
+        trace.appendOtlpSpans(spans, req, resp);
+        Json::Value batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (spans_.size() + spans.size() +
+                    postingSpans_.load(std::memory_order_relaxed) >
+                maxQueueSize_)
+            {
+                ++droppedTraces_;
+                return;
+            }
+            for (auto &span : spans)
+                spans_.append(std::move(span));
+            if (spans_.size() < maxBatchSize_)
+                return;
+            batch.swap(spans_);
+            spans_ = Json::Value(Json::arrayValue);
+        }
+        post(std::move(batch));
+    }
+    void flush()
+    {
+        Json::Value batch;
+        size_t dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            dropped = droppedTraces_;
+            droppedTraces_ = 0;
+            if (spans_.size() > 0)
+            {
+                batch.swap(spans_);
+                spans_ = Json::Value(Json::arrayValue);
+            }
+        }
+        if (dropped > 0)
+            LOG_WARN << dropped
+                     << " traces are dropped because the export queue is full";
+        if (batch.size() > 0)
+            post(std::move(batch));
+    }
+
+  private:
+    void post(Json::Value &&batch)
+    {
+        auto spansNumber = batch.size();
+        postingSpans_.fetch_add(spansNumber, std::memory_order_relaxed);
+        auto exportReq = HttpRequest::newHttpRequest();
+        exportReq->setMethod(Post);
+        exportReq->setPath(path_);
+        exportReq->setContentTypeCode(CT_APPLICATION_JSON);
+        exportReq->setBody(otlpRequestJson(std::move(batch)));
+        auto thisPtr = shared_from_this();
+        client_->sendRequest(
+            exportReq,
+            [thisPtr, spansNumber](ReqResult result,
+                                   const HttpResponsePtr &resp) {
+                thisPtr->postingSpans_.fetch_sub(spansNumber,
+                                                 std::memory_order_relaxed);
+                if (result != ReqResult::Ok)
+                {
+                    LOG_ERROR << "Failed to export traces: "
+                              << static_cast<int>(result);
+                }
+                else if (resp->statusCode() >= 300)
+                {
+                    LOG_ERROR << "Failed to export traces, status: "
+                              << resp->statusCode();
+                }
+            },
+            kExportTimeout);
+    }
+
+    static constexpr double kExportTimeout{30.0};
+    HttpClientPtr client_;
+    std::string path_;
+    size_t maxBatchSize_;
+    size_t maxQueueSize_;
+    std::mutex mutex_;
+    Json::Value spans_{Json::arrayValue};
+    size_t droppedTraces_{0};
+    std::atomic<size_t> postingSpans_{0};
+};
+}  // namespace
+
+RequestTraceExporter drogon::newOtlpHttpTraceExporter(const std::string &url,
+                                                      size_t maxBatchSize,
+                                                      double batchInterval,
+                                                      size_t maxQueueSize)
+{
+    // Split "http://host:port/path" into the host and the path.
+    auto hostStart = url.find("://");
+    hostStart = hostStart == std::string::npos ? 0 : hostStart + 3;
+    auto pathStart = url.find('/', hostStart);
+    std::string host = url.substr(0, pathStart);
+    std::string path =
+        pathStart == std::string::npos ? "/v1/traces" : url.substr(pathStart);
+    auto batcher =
+        std::make_shared<OtlpSpanBatcher>(HttpClient::newHttpClient(host),
+                                          std::move(path),
+                                          maxBatchSize,
+                                          maxQueueSize);
+    batcher->start(batchInterval);
+    return [batcher](const HttpRequestPtr &req,
+                     const HttpResponsePtr &resp,
+                     const RequestTrace &trace) {
+        batcher->add(*req, *resp, trace);
+    };
+}
@@ -0,0 +1,692 @@
+/**
+ *
+ *  @file SSLSessionManager.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SSLSessionManager.h"
+#include "BuiltinMetrics.h"
+#include <trantor/utils/Logger.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+#include <algorithm>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#include <winsock2.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// The current key and the two previous ones, so a ticket can be resumed at
+// least one rotation interval after it's issued.
+constexpr size_t kMaxTicketKeys = 3;
+// The key file is checked at least every minute to pick up the keys rotated
+// by other processes.
+constexpr std::chrono::seconds kMaxKeyCheckInterval{60};
+// The sessions larger than this (e.g. with long certificate chains) are not
+// cached.
+constexpr int kMaxSessionSize = 16 * 1024;
+// The sessions kept for each origin on the client side.
+constexpr size_t kMaxClientSessions = 4;
+constexpr size_t kMaxClientOrigins = 1024;
+
+// The contexts created in the current thread in the lifetime of a scope.
+thread_local std::vector<SSL_CTX *> *capturedContexts{nullptr};
+
+void captureContext(void *parent,
+                    void * /*ptr*/,
+                    CRYPTO_EX_DATA * /*ad*/,
+                    int /*idx*/,
+                    long /*argl*/,
+                    void * /*argp*/)
+{
+    if (capturedContexts)
+        capturedContexts->push_back(static_cast<SSL_CTX *>(parent));
+}
+
+void freeOrigin(void * /*parent*/,
+                void *ptr,
+                CRYPTO_EX_DATA * /*ad*/,
+                int /*idx*/,
+                long /*argl*/,
+                void * /*argp*/)
+{
+    delete static_cast<std::string *>(ptr);
+}
+
+// Trantor doesn't expose the contexts of the servers and the clients, so
+// they are captured when they are created by OpenSSL. The origin of a client
+// context is kept in it.
+int contextIndex()
+{
+    static int index = SSL_CTX_get_ex_new_index(
+        0, nullptr, captureContext, nullptr, freeOrigin);
+    return index;
+}
+
+void resumeClientSession(void *parent,
+                         void * /*ptr*/,
+                         CRYPTO_EX_DATA * /*ad*/,
+                         int /*idx*/,
+                         long /*argl*/,
+                         void * /*argp*/)
+{
+    auto ssl = static_cast<SSL *>(parent);
+    auto origin = static_cast<std::string *>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+    std::string data;
+    if (!origin ||
+        !SSLSessionManager::instance().findClientSession(*origin, data))
+        return;
+    auto ptr = reinterpret_cast<const unsigned char *>(data.data());
+    auto session =
+        d2i_SSL_SESSION(nullptr, &ptr, static_cast<long>(data.length()));
+    if (!session)
+        return;
+    // The expired sessions are not offered to the server.
+    if (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) >
+        time(nullptr))
+        SSL_set_session(ssl, session);
+    SSL_SESSION_free(session);
+}
+
+// The sessions are set to the client connections when they are created.
+int connectionIndex()
+{
+    static int index = SSL_get_ex_new_index(
+        0, nullptr, resumeClientSession, nullptr, nullptr);
+    return index;
+}
+
+bool generateKey(SSLSessionManager::TicketKey &key)
+{
+    if (RAND_bytes(reinterpret_cast<unsigned char *>(&key), sizeof(key)) <= 0)
+    {
+        LOG_ERROR << "Failed to generate the TLS session ticket key";
+        return false;
+    }
+    return true;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+bool initMac(EVP_MAC_CTX *macCtx, const SSLSessionManager::TicketKey &key)
+{
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(
+            OSSL_MAC_PARAM_KEY,
+            const_cast<unsigned char *>(key.hmacKey),
+            sizeof(key.hmacKey)),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()};
+    return EVP_MAC_CTX_set_params(macCtx, params) == 1;
+}
+using MacContext = EVP_MAC_CTX;
+#else
+bool initMac(HMAC_CTX *macCtx, const SSLSessionManager::TicketKey &key)
+{
+    return HMAC_Init_ex(macCtx,
+                        key.hmacKey,
+                        sizeof(key.hmacKey),
+                        EVP_sha256(),
+                        nullptr) == 1;
+}
+using MacContext = HMAC_CTX;
+#endif
+
+int ticketKeyCallback(SSL * /*ssl*/,
+                      unsigned char *name,
+                      unsigned char *iv,
+                      EVP_CIPHER_CTX *cipherCtx,
+                      MacContext *macCtx,
+                      int encrypt)
+{
+    auto &manager = SSLSessionManager::instance();
+    SSLSessionManager::TicketKey key;
+    if (encrypt)
+    {
+        // No ticket is issued without a key.
+        if (!manager.encryptionKey(key))
+            return 0;
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0)
+            return -1;
+        memcpy(name, key.name, sizeof(key.name));
+        if (EVP_EncryptInit_ex(
+                cipherCtx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1 ||
+            !initMac(macCtx, key))
+            return -1;
+        return 1;
+    }
+    // The client does a full handshake if the key is not found.
+    auto result = manager.decryptionKey(name, key);
+    if (result == 0)
+        return 0;
+    if (!initMac(macCtx, key) ||
+        EVP_DecryptInit_ex(
+            cipherCtx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1)
+        return -1;
+    return result;
+}
+
+std::string sessionId(const SSL_SESSION *session)
+{
+    unsigned int length = 0;
+    auto id = SSL_SESSION_get_id(session, &length);
+    return std::string(reinterpret_cast<const char *>(id), length);
+}
+
+int newSessionCallback(SSL *ssl, SSL_SESSION *session)
+{
+    // The sessions of TLS 1.3 are resumed by the stateless tickets unless
+    // the tickets are disabled.
+    if (!SSL_is_server(ssl) || (SSL_version(ssl) == TLS1_3_VERSION &&
+                                !(SSL_get_options(ssl) & SSL_OP_NO_TICKET)))
+        return 0;
+    auto id = sessionId(session);
+    auto length = i2d_SSL_SESSION(session, nullptr);
+    if (id.empty() || length <= 0 || length > kMaxSessionSize)
+        return 0;
+    std::string data(length, '\0');
+    auto ptr = reinterpret_cast<unsigned char *>(&data[0]);
+    if (i2d_SSL_SESSION(session, &ptr) != length)
+        return 0;
+    SSLSessionManager::instance().storeSession(std::move(id), std::move(data));
+    // The session is not referenced by the cache.
+    return 0;
+}
+
+SSL_SESSION *getSessionCallback(SSL * /*ssl*/,
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+                                const unsigned char *id,
+#else
+                                unsigned char *id,
+#endif
+                                int length,
+                                int *copy)
+{
+    *copy = 0;
+    std::string data;
+    if (!SSLSessionManager::instance().findSession(
+            std::string(reinterpret_cast<const char *>(id), length), data))
+        return nullptr;
+    auto ptr = reinterpret_cast<const unsigned char *>(data.data());
+    return d2i_SSL_SESSION(nullptr, &ptr, static_cast<long>(data.length()));
+}
+
+void removeSessionCallback(SSL_CTX * /*ctx*/, SSL_SESSION *session)
+{
+    SSLSessionManager::instance().removeSession(sessionId(session));
+}
+
+int newClientSessionCallback(SSL *ssl, SSL_SESSION *session)
+{
+    auto origin = static_cast<std::string *>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+    if (!origin || !SSL_SESSION_is_resumable(session))
+        return 0;
+    auto length = i2d_SSL_SESSION(session, nullptr);
+    if (length <= 0 || length > kMaxSessionSize)
+        return 0;
+    std::string data(length, '\0');
+    auto ptr = reinterpret_cast<unsigned char *>(&data[0]);
+    if (i2d_SSL_SESSION(session, &ptr) != length)
+        return 0;
+    // The session is serialized rather than referenced, since it's made not
+    // resumable when its connection is closed without a proper shutdown.
+    SSLSessionManager::instance().storeClientSession(*origin, std::move(data));
+    return 0;
+}
+
+void infoCallback(const SSL *ssl, int where, int /*ret*/)
+{
+    if (!(where & SSL_CB_HANDSHAKE_DONE))
+        return;
+    if (auto metrics = internal::builtinMetrics())
+    {
+        if (SSL_session_reused(const_cast<SSL *>(ssl)))
+            metrics->tlsResumedHandshakes->increment();
+        else
+            metrics->tlsFullHandshakes->increment();
+    }
+}
+// The protocols of ALPN in the wire format, HTTP/2 is preferred.
+const unsigned char alpnProtocols[] = "\x02h2\x08http/1.1";
+
+// The clients that offer neither of the protocols connect without ALPN.
+int selectAlpnProtocol(SSL * /*ssl*/,
+                       const unsigned char **out,
+                       unsigned char *outLength,
+                       const unsigned char *in,
+                       unsigned int inLength,
+                       void * /*arg*/)
+{
+    unsigned char *selected{nullptr};
+    if (SSL_select_next_proto(&selected,
+                              outLength,
+                              alpnProtocols,
+                              sizeof(alpnProtocols) - 1,
+                              in,
+                              inLength) != OPENSSL_NPN_NEGOTIATED)
+        return SSL_TLSEXT_ERR_NOACK;
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+// The protocol selected in the last handshake of a client connection in this
+// thread, with the local address of the connection. Trantor calls the
+// connection callback right after the handshake, in the same thread.
+struct Negotiation
+{
+    std::string localAddr;
+    std::string protocol;
+};
+thread_local Negotiation lastNegotiation;
+
+void clientInfoCallback(const SSL *ssl, int where, int /*ret*/)
+{
+    if (!(where & SSL_CB_HANDSHAKE_DONE))
+        return;
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    socklen_t addrLength = sizeof(addr);
+    if (getsockname(SSL_get_fd(ssl),
+                    reinterpret_cast<struct sockaddr *>(&addr),
+                    &addrLength) != 0)
+        return;
+    if (addr.sin6_family == AF_INET6)
+        lastNegotiation.localAddr = trantor::InetAddress(addr).toIpPort();
+    else
+        lastNegotiation.localAddr =
+            trantor::InetAddress(
+                *reinterpret_cast<struct sockaddr_in *>(&addr))
+                .toIpPort();
+    const unsigned char *protocol{nullptr};
+    unsigned int length = 0;
+    SSL_get0_alpn_selected(ssl, &protocol, &length);
+    lastNegotiation.protocol.assign(reinterpret_cast<const char *>(protocol),
+                                    length);
+}
+}  // namespace
+
+SSLSessionManager &SSLSessionManager::instance()
+{
+    static SSLSessionManager manager;
+    return manager;
+}
+
+void SSLSessionManager::enable(size_t cacheSize,
+                               size_t ticketKeyRotation,
+                               const std::string &ticketKeyFile)
+{
+    enabled_ = true;
+    cacheSize_ = cacheSize;
+    ticketKeyRotation_ = std::chrono::seconds(ticketKeyRotation);
+    ticketKeyFile_ = ticketKeyFile;
+#ifdef _WIN32
+    if (!ticketKeyFile_.empty())
+    {
+        LOG_ERROR << "The TLS session ticket key file is not supported on "
+                     "Windows, the keys are generated in the process";
+        ticketKeyFile_.clear();
+    }
+#endif
+}
+
+SSLSessionManager::Scope::Scope(bool http2) : http2_(http2)
+{
+    if ((!instance().enabled() && !http2_) || capturedContexts)
+        return;
+    if (contextIndex() < 0)
+    {
+        LOG_ERROR << "Failed to hook the creation of SSL contexts";
+        return;
+    }
+    capturedContexts = new std::vector<SSL_CTX *>;
+    active_ = true;
+}
+
+SSLSessionManager::Scope::Scope(std::string origin, bool http2)
+    : http2_(http2), origin_(std::move(origin))
+{
+    if (capturedContexts)
+        return;
+    if (contextIndex() < 0 || connectionIndex() < 0)
+    {
+        LOG_ERROR << "Failed to hook the creation of SSL contexts";
+        return;
+    }
+    capturedContexts = new std::vector<SSL_CTX *>;
+    active_ = true;
+}
+
+SSLSessionManager::Scope::~Scope()
+{
+    if (!active_)
+        return;
+    for (auto ctx : *capturedContexts)
+    {
+        if (origin_.empty())
+        {
+            if (instance().enabled())
+                instance().configure(ctx);
+            if (http2_)
+                SSL_CTX_set_alpn_select_cb(ctx, selectAlpnProtocol, nullptr);
+        }
+        else
+            instance().configureClient(ctx, origin_, http2_);
+    }
+    delete capturedContexts;
+    capturedContexts = nullptr;
+}
+
+void SSLSessionManager::configure(SSL_CTX *ctx)
+{
+    // The sessions are resumed only by the listeners with the same
+    // certificate.
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    auto cert = SSL_CTX_get0_certificate(ctx);
+    if (!cert || !X509_digest(cert, EVP_sha256(), digest, &digestLength))
+    {
+        LOG_ERROR << "Can't share the TLS sessions without a certificate";
+        return;
+    }
+    SSL_CTX_set_session_id_context(
+        ctx,
+        digest,
+        (std::min)(digestLength,
+                   static_cast<unsigned int>(SSL_MAX_SID_CTX_LENGTH)));
+    if (cacheSize_ > 0)
+    {
+        // The internal cache of each context is replaced by the shared one.
+        SSL_CTX_set_session_cache_mode(ctx,
+                                       SSL_SESS_CACHE_SERVER |
+                                           SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(ctx, newSessionCallback);
+        SSL_CTX_sess_set_get_cb(ctx, getSessionCallback);
+        SSL_CTX_sess_set_remove_cb(ctx, removeSessionCallback);
+    }
+    else
+    {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticketKeyCallback);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticketKeyCallback);
+#endif
+    SSL_CTX_set_info_callback(ctx, infoCallback);
+}
+
+void SSLSessionManager::configureClient(SSL_CTX *ctx,
+                                        const std::string &origin,
+                                        bool http2)
+{
+    SSL_CTX_set_ex_data(ctx, contextIndex(), new std::string(origin));
+    // The sessions are kept in the shared cache only.
+    SSL_CTX_set_session_cache_mode(ctx,
+                                   SSL_SESS_CACHE_CLIENT |
+                                       SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, newClientSessionCallback);
+    if (http2)
+    {
+        SSL_CTX_set_alpn_protos(ctx,
+                                alpnProtocols,
+                                sizeof(alpnProtocols) - 1);
+        SSL_CTX_set_info_callback(ctx, clientInfoCallback);
+    }
+}
+
+std::string SSLSessionManager::negotiatedProtocol(
+    const trantor::InetAddress &localAddr)
+{
+    if (lastNegotiation.localAddr != localAddr.toIpPort())
+        return std::string();
+    lastNegotiation.localAddr.clear();
+    return std::move(lastNegotiation.protocol);
+}
+
+bool SSLSessionManager::encryptionKey(TicketKey &key)
+{
+    std::lock_guard<std::mutex> lock(keysMutex_);
+    updateKeys();
+    if (keys_.empty())
+        return false;
+    key = keys_.front();
+    return true;
+}
+
+int SSLSessionManager::decryptionKey(const unsigned char *name, TicketKey &key)
+{
+    std::lock_guard<std::mutex> lock(keysMutex_);
+    updateKeys();
+    for (size_t i = 0; i < keys_.size(); ++i)
+    {
+        if (memcmp(keys_[i].name, name, sizeof(key.name)) == 0)
+        {
+            key = keys_[i];
+            return i == 0 ? 1 : 2;
+        }
+    }
+    return 0;
+}
+
+void SSLSessionManager::updateKeys()
+{
+    auto steadyNow = std::chrono::steady_clock::now();
+    if (!keys_.empty() && steadyNow < nextCheck_)
+        return;
+    if (ticketKeyRotation_.count() == 0 && ticketKeyFile_.empty())
+        nextCheck_ = std::chrono::steady_clock::time_point::max();
+    else if (ticketKeyRotation_.count() == 0)
+        nextCheck_ = steadyNow + kMaxKeyCheckInterval;
+    else
+        nextCheck_ =
+            steadyNow + (std::min)(ticketKeyRotation_, kMaxKeyCheckInterval);
+    auto now = std::chrono::system_clock::now();
+    if (!ticketKeyFile_.empty() && updateKeysFromFile(now))
+        return;
+    if (keys_.empty() || (ticketKeyRotation_.count() > 0 &&
+                          now - lastRotation_ >= ticketKeyRotation_))
+        rotateKeys(now);
+}
+
+void SSLSessionManager::rotateKeys(std::chrono::system_clock::time_point now)
+{
+    TicketKey key;
+    if (!generateKey(key))
+        return;
+    keys_.push_front(key);
+    if (keys_.size() > kMaxTicketKeys)
+        keys_.resize(kMaxTicketKeys);
+    lastRotation_ = now;
+}
+
+bool SSLSessionManager::updateKeysFromFile(
+    std::chrono::system_clock::time_point now)
+{
+#ifndef _WIN32
+    // The file is locked while it's read and rotated, so the processes
+    // sharing it agree on the keys. The one finding the current key expired
+    // rotates it.
+    auto fd = open(ticketKeyFile_.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "Can't open the TLS session ticket key file "
+                   << ticketKeyFile_;
+        return false;
+    }
+    flock(fd, LOCK_EX);
+    struct stat st;
+    std::string data;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        data.resize(static_cast<size_t>(st.st_size));
+        auto n = pread(fd, &data[0], data.length(), 0);
+        data.resize(n > 0 ? static_cast<size_t>(n) : 0);
+    }
+    if (data.length() % sizeof(TicketKey) != 0)
+    {
+        LOG_WARN << "The size of the TLS session ticket key file "
+                 << ticketKeyFile_ << " is not a multiple of "
+                 << sizeof(TicketKey);
+    }
+    std::deque<TicketKey> keys;
+    for (size_t offset = 0;
+         offset + sizeof(TicketKey) <= data.length() &&
+         keys.size() < kMaxTicketKeys;
+         offset += sizeof(TicketKey))
+    {
+        keys.emplace_back();
+        memcpy(&keys.back(), data.data() + offset, sizeof(TicketKey));
+    }
+    auto modified = std::chrono::system_clock::from_time_t(st.st_mtime);
+    bool ok = true;
+    if (keys.empty() || (ticketKeyRotation_.count() > 0 &&
+                         now - modified >= ticketKeyRotation_))
+    {
+        TicketKey key;
+        ok = generateKey(key);
+        if (ok)
+        {
+            keys.push_front(key);
+            if (keys.size() > kMaxTicketKeys)
+                keys.resize(kMaxTicketKeys);
+            data.clear();
+            for (auto &k : keys)
+                data.append(reinterpret_cast<const char *>(&k), sizeof(k));
+            ok = ftruncate(fd, 0) == 0 &&
+                 pwrite(fd, data.data(), data.length(), 0) ==
+                     static_cast<ssize_t>(data.length());
+            if (!ok)
+            {
+                LOG_SYSERR << "Can't write the TLS session ticket key file "
+                           << ticketKeyFile_;
+            }
+        }
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    if (!ok)
+        return false;
+    keys_ = std::move(keys);
+    lastRotation_ = now;
+    return true;
+#else
+    (void)now;
+    return false;
+#endif
+}
+
+void SSLSessionManager::storeSession(std::string &&id, std::string &&session)
+{
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    auto iter = sessionIndex_.find(id);
+    if (iter != sessionIndex_.end())
+    {
+        iter->second->second = std::move(session);
+        sessions_.splice(sessions_.begin(), sessions_, iter->second);
+        return;
+    }
+    sessions_.emplace_front(id, std::move(session));
+    sessionIndex_.emplace(std::move(id), sessions_.begin());
+    if (sessions_.size() > cacheSize_)
+    {
+        sessionIndex_.erase(sessions_.back().first);
+        sessions_.pop_back();
+    }
+}
+
+bool SSLSessionManager::findSession(const std::string &id,
+                                    std::string &session)
+{
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    auto iter = sessionIndex_.find(id);
+    if (iter == sessionIndex_.end())
+        return false;
+    sessions_.splice(sessions_.begin(), sessions_, iter->second);
+    session = iter->second->second;
+    return true;
+}
+
+void SSLSessionManager::removeSession(const std::string &id)
+{
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    auto iter = sessionIndex_.find(id);
+    if (iter == sessionIndex_.end())
+        return;
+    sessions_.erase(iter->second);
+    sessionIndex_.erase(iter);
+}
+
+void SSLSessionManager::storeClientSession(const std::string &origin,
+                                           std::string &&session)
+{
+    std::lock_guard<std::mutex> lock(clientSessionsMutex_);
+    auto iter = clientSessionIndex_.find(origin);
+    if (iter == clientSessionIndex_.end())
+    {
+        clientSessions_.emplace_front(origin, std::deque<std::string>());
+        iter = clientSessionIndex_.emplace(origin, clientSessions_.begin())
+                   .first;
+        if (clientSessions_.size() > kMaxClientOrigins)
+        {
+            clientSessionIndex_.erase(clientSessions_.back().first);
+            clientSessions_.pop_back();
+        }
+    }
+    else
+    {
+        clientSessions_.splice(clientSessions_.begin(),
+                               clientSessions_,
+                               iter->second);
+    }
+    auto &sessions = iter->second->second;
+    sessions.push_back(std::move(session));
+    if (sessions.size() > kMaxClientSessions)
+        sessions.pop_front();
+}
+
+bool SSLSessionManager::findClientSession(const std::string &origin,
+                                          std::string &session)
+{
+    std::lock_guard<std::mutex> lock(clientSessionsMutex_);
+    auto iter = clientSessionIndex_.find(origin);
+    if (iter == clientSessionIndex_.end())
+        return false;
+    auto &sessions = iter->second->second;
+    if (sessions.size() == 1)
+    {
+        session = sessions.back();
+        return true;
+    }
+    session = std::move(sessions.back());
+    sessions.pop_back();
+    return true;
+}
@@ -0,0 +1,165 @@
+/**
+ *
+ *  @file SSLSessionManager.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct ssl_ctx_st;
+
+namespace drogon
+{
+/**
+ * @brief The TLS sessions shared by all the listeners of the process. The
+ * session tickets are encrypted with the keys rotated by this class (and
+ * shared with other processes through a key file if there is one), and the
+ * sessions resumed by IDs are kept in a LRU cache, so a client reconnecting to
+ * any IO thread or any process can skip the full handshake.
+ *
+ * On the client side, the sessions established by the HTTP clients are kept
+ * per origin, so a new connection to the same origin resumes the session of
+ * a previous one, even if it's made by another client object.
+ */
+class SSLSessionManager : public trantor::NonCopyable
+{
+  public:
+    static SSLSessionManager &instance();
+
+    /**
+     * @brief Enable the sharing of TLS sessions, it must be called before the
+     * listeners are created.
+     *
+     * @param cacheSize The number of sessions cached, 0 disables the cache.
+     * @param ticketKeyRotation The interval in seconds between two rotations
+     * of the ticket key, 0 means the key is never rotated.
+     * @param ticketKeyFile The file containing the ticket keys, which is read
+     * and rotated by all the processes using it. If it's empty, the keys are
+     * generated in the process.
+     */
+    void enable(size_t cacheSize,
+                size_t ticketKeyRotation,
+                const std::string &ticketKeyFile);
+    bool enabled() const
+    {
+        return enabled_;
+    }
+
+    /**
+     * @brief The SSL contexts created in the lifetime of a scope object in
+     * the same thread are configured to use the shared sessions when the
+     * scope is destroyed.
+     */
+    class Scope : public trantor::NonCopyable
+    {
+      public:
+        /// For the contexts of the listeners, the sessions are shared if the
+        /// manager is enabled, and HTTP/2 is selected by ALPN if http2 is
+        /// true.
+        explicit Scope(bool http2 = false);
+        /// For the contexts of the clients connecting to the origin, the
+        /// clients with different security settings must not share an
+        /// origin. HTTP/2 is offered by ALPN if http2 is true.
+        explicit Scope(std::string origin, bool http2 = false);
+        ~Scope();
+
+      private:
+        bool active_{false};
+        bool http2_{false};
+        std::string origin_;
+    };
+
+    /**
+     * @brief Get the protocol selected by ALPN for a client connection
+     * created in a scope with HTTP/2, it must be called in the connection
+     * callback.
+     *
+     * @return An empty string if no protocol was selected.
+     */
+    static std::string negotiatedProtocol(
+        const trantor::InetAddress &localAddr);
+
+    /// The ticket key in the format used by nginx and others, 80 bytes in
+    /// the key file.
+    struct TicketKey
+    {
+        unsigned char name[16];
+        unsigned char hmacKey[32];
+        unsigned char aesKey[32];
+    };
+
+    /// Get the key to encrypt new tickets, return false if there is none.
+    bool encryptionKey(TicketKey &key);
+
+    /**
+     * @brief Find the key to decrypt a ticket by the name in it.
+     *
+     * @return 0 if the key is not found, 1 if it's the current key, 2 if it's
+     * an old key, in which case the ticket should be renewed.
+     */
+    int decryptionKey(const unsigned char *name, TicketKey &key);
+
+    void storeSession(std::string &&id, std::string &&session);
+    bool findSession(const std::string &id, std::string &session);
+    void removeSession(const std::string &id);
+
+    void storeClientSession(const std::string &origin, std::string &&session);
+    /// The latest session of the origin is returned, it's removed from the
+    /// cache unless it's the only one, since a TLS 1.3 ticket should be used
+    /// only once.
+    bool findClientSession(const std::string &origin, std::string &session);
+
+  private:
+    SSLSessionManager() = default;
+    void configure(ssl_ctx_st *ctx);
+    void configureClient(ssl_ctx_st *ctx,
+                         const std::string &origin,
+                         bool http2);
+    void updateKeys();
+    void rotateKeys(std::chrono::system_clock::time_point now);
+    bool updateKeysFromFile(std::chrono::system_clock::time_point now);
+
+    bool enabled_{false};
+    size_t cacheSize_{0};
+    std::chrono::seconds ticketKeyRotation_{0};
+    std::string ticketKeyFile_;
+
+    std::mutex keysMutex_;
+    // The current key is at the front.
+    std::deque<TicketKey> keys_;
+    std::chrono::system_clock::time_point lastRotation_;
+    std::chrono::steady_clock::time_point nextCheck_;
+
+    std::mutex sessionsMutex_;
+    using SessionList = std::list<std::pair<std::string, std::string>>;
+    // The most recently used session is at the front.
+    SessionList sessions_;
+    std::unordered_map<std::string, SessionList::iterator> sessionIndex_;
+
+    std::mutex clientSessionsMutex_;
+    using ClientSessionList =
+        std::list<std::pair<std::string, std::deque<std::string>>>;
+    // The most recently used origin is at the front.
+    ClientSessionList clientSessions_;
+    std::unordered_map<std::string, ClientSessionList::iterator>
+        clientSessionIndex_;
+};
+
+}  // namespace drogon
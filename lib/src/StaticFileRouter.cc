@@ -67,6 +67,7 @@ void StaticFileRouter::route(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    req->markTrace(RequestTrace::kHandling);
     const std::string &path = req->path();
     if (path.find("..") != std::string::npos)
     {
@@ -0,0 +1,539 @@
+/**
+ *
+ *  @file UringTcpConnection.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "UringTcpConnection.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace drogon;
+
+namespace
+{
+/// Closes a file sent by sendFile() when all of it is sent.
+struct FileHolder
+{
+    explicit FileHolder(int fd) : fd_(fd)
+    {
+    }
+    ~FileHolder()
+    {
+        close(fd_);
+    }
+    int fd_;
+};
+
+// The size of the parts of a file spliced at once, the default capacity of
+// a pipe.
+constexpr size_t kSpliceSize = 64 * 1024;
+}  // namespace
+
+UringTcpConnection::UringTcpConnection(std::shared_ptr<IoUring> ring,
+                                       int fd,
+                                       const trantor::InetAddress &localAddr,
+                                       const trantor::InetAddress &peerAddr)
+    : ring_(std::move(ring)),
+      loop_(ring_->getLoop()),
+      fd_(fd),
+      localAddr_(localAddr),
+      peerAddr_(peerAddr),
+      lastActivity_(trantor::Date::now())
+{
+    memset(&message_, 0, sizeof(message_));
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+}
+
+UringTcpConnection::~UringTcpConnection()
+{
+    // The connection is released after all its requests are completed, so
+    // the descriptors are not used by the ring anymore.
+    close(fd_);
+    if (pipeFds_[0] >= 0)
+    {
+        close(pipeFds_[0]);
+        close(pipeFds_[1]);
+    }
+}
+
+void UringTcpConnection::send(const char *msg, size_t len)
+{
+    sendString(std::make_shared<std::string>(msg, len));
+}
+
+void UringTcpConnection::send(const void *msg, size_t len)
+{
+    send(static_cast<const char *>(msg), len);
+}
+
+void UringTcpConnection::send(const std::string &msg)
+{
+    sendString(std::make_shared<std::string>(msg));
+}
+
+void UringTcpConnection::send(std::string &&msg)
+{
+    sendString(std::make_shared<std::string>(std::move(msg)));
+}
+
+void UringTcpConnection::send(const trantor::MsgBuffer &buffer)
+{
+    sendString(std::make_shared<std::string>(buffer.peek(),
+                                             buffer.readableBytes()));
+}
+
+void UringTcpConnection::send(trantor::MsgBuffer &&buffer)
+{
+    sendBuffer(std::make_shared<trantor::MsgBuffer>(std::move(buffer)));
+}
+
+void UringTcpConnection::send(const std::shared_ptr<std::string> &msgPtr)
+{
+    sendString(msgPtr);
+}
+
+void UringTcpConnection::send(const std::shared_ptr<trantor::MsgBuffer> &msgPtr)
+{
+    sendBuffer(msgPtr);
+}
+
+void UringTcpConnection::sendFile(const char *fileName,
+                                  size_t offset,
+                                  size_t length)
+{
+    int fd = open(fileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_SYSERR << fileName << " open error";
+        return;
+    }
+    if (length == 0)
+    {
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) < 0)
+        {
+            LOG_SYSERR << fileName << " stat error";
+            close(fd);
+            return;
+        }
+        if (static_cast<size_t>(fileStat.st_size) <= offset)
+        {
+            close(fd);
+            return;
+        }
+        length = fileStat.st_size - offset;
+    }
+    WriteNode node;
+    node.holder_ = std::make_shared<FileHolder>(fd);
+    node.length_ = length;
+    node.fileFd_ = fd;
+    node.fileOffset_ = static_cast<off_t>(offset);
+    sendNode(std::move(node));
+}
+
+void UringTcpConnection::sendFile(const wchar_t *fileName,
+                                  size_t offset,
+                                  size_t length)
+{
+    sendFile(utils::fromWidePath(fileName).c_str(), offset, length);
+}
+
+void UringTcpConnection::setTcpNoDelay(bool on)
+{
+    int optval = on ? 1 : 0;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+}
+
+void UringTcpConnection::shutdown()
+{
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr]() {
+        if (thisPtr->status_ != Status::Connected)
+            return;
+        // The write side is shut down when all the data is sent.
+        thisPtr->status_ = Status::Disconnecting;
+        thisPtr->startWrite();
+    });
+}
+
+void UringTcpConnection::forceClose()
+{
+    auto thisPtr = shared_from_this();
+    loop_->queueInLoop([thisPtr]() { thisPtr->handleClose(); });
+}
+
+void UringTcpConnection::startClientEncryption(
+    std::function<void()>,
+    bool,
+    bool,
+    std::string,
+    const std::vector<std::pair<std::string, std::string>> &)
+{
+    LOG_ERROR << "TLS is not supported by the io_uring connections";
+}
+
+void UringTcpConnection::startServerEncryption(
+    const std::shared_ptr<trantor::SSLContext> &,
+    std::function<void()>)
+{
+    LOG_ERROR << "TLS is not supported by the io_uring connections";
+}
+
+void UringTcpConnection::connectEstablished()
+{
+    if (connectionCallback_)
+        connectionCallback_(shared_from_this());
+    if (status_ != Status::Disconnected)
+        startRecv();
+}
+
+void UringTcpConnection::handleCompletion(Operation op,
+                                          int32_t result,
+                                          uint32_t flags)
+{
+    auto thisPtr = shared_from_this();
+    switch (op)
+    {
+        case kRecv:
+            handleRecv(result, flags);
+            break;
+        case kSend:
+            handleSend(result);
+            break;
+        case kSpliceIn:
+        case kSpliceOut:
+            handleSplice(op, result);
+            break;
+        default:
+            break;
+    }
+    // A multishot receive request goes on until a completion without more.
+    if (op != kRecv || !(flags & IORING_CQE_F_MORE))
+    {
+        --pendingRequests_;
+        releaseIfDone();
+    }
+}
+
+void UringTcpConnection::sendString(std::shared_ptr<std::string> msgPtr)
+{
+    WriteNode node;
+    node.data_ = msgPtr->data();
+    node.length_ = msgPtr->length();
+    node.holder_ = std::move(msgPtr);
+    sendNode(std::move(node));
+}
+
+void UringTcpConnection::sendBuffer(std::shared_ptr<trantor::MsgBuffer> msgPtr)
+{
+    WriteNode node;
+    node.data_ = msgPtr->peek();
+    node.length_ = msgPtr->readableBytes();
+    node.holder_ = std::move(msgPtr);
+    sendNode(std::move(node));
+}
+
+void UringTcpConnection::sendNode(WriteNode &&node)
+{
+    if (node.length_ == 0)
+        return;
+    if (loop_->isInLoopThread())
+    {
+        bool queued;
+        {
+            std::lock_guard<std::mutex> guard(sendNumMutex_);
+            queued = sendNum_ > 0;
+        }
+        if (!queued)
+        {
+            sendNodeInLoop(std::move(node));
+            return;
+        }
+    }
+    auto thisPtr = shared_from_this();
+    auto nodePtr = std::make_shared<WriteNode>(std::move(node));
+    std::lock_guard<std::mutex> guard(sendNumMutex_);
+    ++sendNum_;
+    loop_->queueInLoop([thisPtr, nodePtr]() {
+        thisPtr->sendNodeInLoop(std::move(*nodePtr));
+        std::lock_guard<std::mutex> guard1(thisPtr->sendNumMutex_);
+        --thisPtr->sendNum_;
+    });
+}
+
+void UringTcpConnection::sendNodeInLoop(WriteNode &&node)
+{
+    if (status_ != Status::Connected)
+    {
+        LOG_WARN << "Connection is not connected, give up sending";
+        return;
+    }
+    auto oldLength = bytesToSend_;
+    bytesToSend_ += node.length_;
+    writeQueue_.push_back(std::move(node));
+    if (highWaterMarkCallback_ && oldLength < highWaterMarkLen_ &&
+        bytesToSend_ >= highWaterMarkLen_)
+    {
+        auto thisPtr = shared_from_this();
+        auto length = bytesToSend_;
+        loop_->queueInLoop([thisPtr, length]() {
+            thisPtr->highWaterMarkCallback_(thisPtr, length);
+        });
+    }
+    startWrite();
+}
+
+void UringTcpConnection::startRecv()
+{
+    // The data is received into a buffer selected from the ring when it
+    // arrives, until the request is stopped by an error or by running out
+    // of buffers.
+    auto sqe = ring_->getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd_;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IoUring::kBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = userData(kRecv);
+    receiving_ = true;
+    ++pendingRequests_;
+}
+
+void UringTcpConnection::startWrite()
+{
+    if (writing_ || status_ == Status::Disconnected)
+        return;
+    if (writeQueue_.empty())
+    {
+        if (status_ == Status::Disconnecting)
+            startShutdown();
+        return;
+    }
+    auto &front = writeQueue_.front();
+    io_uring_sqe *sqe;
+    if (front.fileFd_ >= 0)
+    {
+        if (pipeFds_[0] < 0 && pipe2(pipeFds_, O_CLOEXEC) < 0)
+        {
+            LOG_SYSERR << "pipe2";
+            pipeFds_[0] = pipeFds_[1] = -1;
+            handleClose();
+            return;
+        }
+        // The file is moved to the socket through the pipe without being
+        // copied to the user space.
+        sqe = ring_->getSqe();
+        sqe->opcode = IORING_OP_SPLICE;
+        if (bytesInPipe_ > 0)
+        {
+            sqe->splice_fd_in = pipeFds_[0];
+            sqe->splice_off_in = static_cast<uint64_t>(-1);
+            sqe->fd = fd_;
+            sqe->len = static_cast<uint32_t>(bytesInPipe_);
+            sqe->user_data = userData(kSpliceOut);
+        }
+        else
+        {
+            sqe->splice_fd_in = front.fileFd_;
+            sqe->splice_off_in = static_cast<uint64_t>(front.fileOffset_);
+            sqe->fd = pipeFds_[1];
+            sqe->len =
+                static_cast<uint32_t>(std::min(front.length_, kSpliceSize));
+            sqe->user_data = userData(kSpliceIn);
+        }
+        sqe->off = static_cast<uint64_t>(-1);
+    }
+    else
+    {
+        // The data of consecutive sends is sent by a single request.
+        size_t count = 0;
+        for (auto &node : writeQueue_)
+        {
+            if (node.fileFd_ >= 0 || count == kMaxIovecs)
+                break;
+            iovecs_[count].iov_base = const_cast<char *>(node.data_);
+            iovecs_[count].iov_len = node.length_;
+            ++count;
+        }
+        sqe = ring_->getSqe();
+        sqe->fd = fd_;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        if (count == 1)
+        {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->addr = reinterpret_cast<uint64_t>(front.data_);
+            sqe->len = static_cast<uint32_t>(front.length_);
+        }
+        else
+        {
+            message_.msg_iov = iovecs_;
+            message_.msg_iovlen = count;
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&message_);
+            sqe->len = 1;
+        }
+        sqe->user_data = userData(kSend);
+    }
+    writing_ = true;
+    ++pendingRequests_;
+}
+
+void UringTcpConnection::startShutdown()
+{
+    if (shutdownSent_)
+        return;
+    shutdownSent_ = true;
+    auto sqe = ring_->getSqe();
+    sqe->opcode = IORING_OP_SHUTDOWN;
+    sqe->fd = fd_;
+    sqe->len = SHUT_WR;
+    sqe->user_data = userData(kShutdown);
+    ++pendingRequests_;
+}
+
+void UringTcpConnection::handleRecv(int32_t result, uint32_t flags)
+{
+    if (!(flags & IORING_CQE_F_MORE))
+        receiving_ = false;
+    if (result > 0)
+    {
+        auto id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        readBuffer_.append(ring_->buffer(id), result);
+        ring_->recycleBuffer(id);
+        bytesReceived_ += result;
+        lastActivity_ = trantor::Date::now();
+        if (status_ != Status::Disconnected && recvMsgCallback_)
+            recvMsgCallback_(shared_from_this(), &readBuffer_);
+        if (!receiving_ && status_ != Status::Disconnected)
+            startRecv();
+        return;
+    }
+    if (result == -ENOBUFS)
+    {
+        // All the buffers were in use, the data is still in the socket.
+        if (!receiving_ && status_ != Status::Disconnected)
+            startRecv();
+        return;
+    }
+    if (result < 0 && result != -ECANCELED && result != -ECONNRESET)
+        LOG_ERROR << "recv error: " << strerror(-result);
+    // The peer has closed the connection.
+    handleClose();
+}
+
+void UringTcpConnection::handleSend(int32_t result)
+{
+    writing_ = false;
+    if (status_ == Status::Disconnected)
+        return;
+    if (result < 0)
+    {
+        if (result != -EPIPE && result != -ECONNRESET)
+            LOG_ERROR << "send error: " << strerror(-result);
+        handleClose();
+        return;
+    }
+    auto sent = static_cast<size_t>(result);
+    bytesSent_ += sent;
+    bytesToSend_ -= sent;
+    lastActivity_ = trantor::Date::now();
+    while (sent > 0)
+    {
+        auto &node = writeQueue_.front();
+        if (node.length_ <= sent)
+        {
+            sent -= node.length_;
+            writeQueue_.pop_front();
+        }
+        else
+        {
+            node.data_ += sent;
+            node.length_ -= sent;
+            sent = 0;
+        }
+    }
+    startWrite();
+}
+
+void UringTcpConnection::handleSplice(Operation op, int32_t result)
+{
+    writing_ = false;
+    if (status_ == Status::Disconnected)
+        return;
+    if (result <= 0)
+    {
+        if (result == 0)
+            LOG_ERROR << "The file is shorter than the length to send";
+        else if (result != -EPIPE && result != -ECONNRESET)
+            LOG_ERROR << "splice error: " << strerror(-result);
+        handleClose();
+        return;
+    }
+    auto &front = writeQueue_.front();
+    auto moved = static_cast<size_t>(result);
+    if (op == kSpliceIn)
+    {
+        bytesInPipe_ = moved;
+        front.fileOffset_ += result;
+        front.length_ -= moved;
+    }
+    else
+    {
+        bytesInPipe_ -= moved;
+        bytesSent_ += moved;
+        bytesToSend_ -= moved;
+        lastActivity_ = trantor::Date::now();
+        if (bytesInPipe_ == 0 && front.length_ == 0)
+            writeQueue_.pop_front();
+    }
+    startWrite();
+}
+
+void UringTcpConnection::handleClose()
+{
+    if (status_ == Status::Disconnected)
+        return;
+    status_ = Status::Disconnected;
+    if (pendingRequests_ > 0)
+    {
+        // The requests on the socket complete with -ECANCELED.
+        auto sqe = ring_->getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd_;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = kIgnored;
+    }
+    writeQueue_.clear();
+    bytesToSend_ = 0;
+    auto thisPtr = shared_from_this();
+    if (connectionCallback_)
+        connectionCallback_(thisPtr);
+    releaseIfDone();
+}
+
+void UringTcpConnection::releaseIfDone()
+{
+    if (status_ != Status::Disconnected || pendingRequests_ > 0 ||
+        !closeCallback_)
+        return;
+    auto callback = std::move(closeCallback_);
+    closeCallback_ = nullptr;
+    callback(shared_from_this());
+}
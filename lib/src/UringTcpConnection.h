@@ -0,0 +1,247 @@
+/**
+ *
+ *  @file UringTcpConnection.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "IoUring.h"
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace drogon
+{
+/**
+ * @brief A connection accepted by a UringTcpServer. The data is received by
+ * a multishot receive request from the provided buffers of the ring, and
+ * sent by send requests, the files are spliced to the socket through a pipe.
+ * It behaves like the connections of trantor for the users of the
+ * TcpConnection interface, including the thread safety of send().
+ *
+ * TLS is not supported.
+ */
+class UringTcpConnection
+    : public trantor::TcpConnection,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<UringTcpConnection>
+{
+  public:
+    /// The requests are told apart by the low bits of their user data, the
+    /// rest is the address of the connection.
+    enum Operation : uint64_t
+    {
+        kIgnored = 0,
+        kAccept,
+        kRecv,
+        kSend,
+        kSpliceIn,
+        kSpliceOut,
+        kShutdown
+    };
+    static constexpr uint64_t kOperationMask = 7;
+
+    using CloseCallback =
+        std::function<void(const std::shared_ptr<UringTcpConnection> &)>;
+
+    UringTcpConnection(std::shared_ptr<IoUring> ring,
+                       int fd,
+                       const trantor::InetAddress &localAddr,
+                       const trantor::InetAddress &peerAddr);
+    ~UringTcpConnection() override;
+
+    void send(const char *msg, size_t len) override;
+    void send(const void *msg, size_t len) override;
+    void send(const std::string &msg) override;
+    void send(std::string &&msg) override;
+    void send(const trantor::MsgBuffer &buffer) override;
+    void send(trantor::MsgBuffer &&buffer) override;
+    void send(const std::shared_ptr<std::string> &msgPtr) override;
+    void send(const std::shared_ptr<trantor::MsgBuffer> &msgPtr) override;
+    void sendFile(const char *fileName,
+                  size_t offset = 0,
+                  size_t length = 0) override;
+    void sendFile(const wchar_t *fileName,
+                  size_t offset = 0,
+                  size_t length = 0) override;
+
+    const trantor::InetAddress &localAddr() const override
+    {
+        return localAddr_;
+    }
+    const trantor::InetAddress &peerAddr() const override
+    {
+        return peerAddr_;
+    }
+    bool connected() const override
+    {
+        return status_ == Status::Connected;
+    }
+    bool disconnected() const override
+    {
+        return status_ == Status::Disconnected;
+    }
+    trantor::MsgBuffer *getRecvBuffer() override
+    {
+        return &readBuffer_;
+    }
+    void setHighWaterMarkCallback(const trantor::HighWaterMarkCallback &cb,
+                                  size_t markLen) override
+    {
+        highWaterMarkCallback_ = cb;
+        highWaterMarkLen_ = markLen;
+    }
+    void setTcpNoDelay(bool on) override;
+    void shutdown() override;
+    void forceClose() override;
+    trantor::EventLoop *getLoop() override
+    {
+        return loop_;
+    }
+    void keepAlive() override
+    {
+        keepAlive_ = true;
+    }
+    bool isKeepAlive() override
+    {
+        return keepAlive_;
+    }
+    size_t bytesSent() const override
+    {
+        return bytesSent_;
+    }
+    size_t bytesReceived() const override
+    {
+        return bytesReceived_;
+    }
+    bool isSSLConnection() const override
+    {
+        return false;
+    }
+    void startClientEncryption(
+        std::function<void()> callback,
+        bool useOldTLS,
+        bool validateCert,
+        std::string hostname,
+        const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
+        override;
+    void startServerEncryption(const std::shared_ptr<trantor::SSLContext> &ctx,
+                               std::function<void()> callback) override;
+
+    void setRecvMsgCallback(const trantor::RecvMessageCallback &cb)
+    {
+        recvMsgCallback_ = cb;
+    }
+    void setConnectionCallback(const trantor::ConnectionCallback &cb)
+    {
+        connectionCallback_ = cb;
+    }
+    /// Called when the connection is closed and none of its requests is in
+    /// flight, so it can be released.
+    void setCloseCallback(const CloseCallback &cb)
+    {
+        closeCallback_ = cb;
+    }
+
+    /// The time data was last received or sent, for kicking off idle
+    /// connections.
+    const trantor::Date &lastActivity() const
+    {
+        return lastActivity_;
+    }
+
+    void connectEstablished();
+    void handleCompletion(Operation op, int32_t result, uint32_t flags);
+
+  private:
+    enum class Status
+    {
+        Connected,
+        Disconnecting,
+        Disconnected
+    };
+
+    /// The data waiting to be sent, either memory kept alive by holder_ or a
+    /// part of a file.
+    struct WriteNode
+    {
+        std::shared_ptr<void> holder_;
+        const char *data_{nullptr};
+        size_t length_{0};
+        int fileFd_{-1};
+        off_t fileOffset_{0};
+    };
+
+    uint64_t userData(Operation op) const
+    {
+        return reinterpret_cast<uint64_t>(this) | op;
+    }
+    void sendString(std::shared_ptr<std::string> msgPtr);
+    void sendBuffer(std::shared_ptr<trantor::MsgBuffer> msgPtr);
+    void sendNode(WriteNode &&node);
+    void sendNodeInLoop(WriteNode &&node);
+    void startRecv();
+    void startWrite();
+    void startShutdown();
+    void handleRecv(int32_t result, uint32_t flags);
+    void handleSend(int32_t result);
+    void handleSplice(Operation op, int32_t result);
+    void handleClose();
+    void releaseIfDone();
+
+    std::shared_ptr<IoUring> ring_;
+    trantor::EventLoop *loop_;
+    int fd_;
+    trantor::InetAddress localAddr_;
+    trantor::InetAddress peerAddr_;
+    Status status_{Status::Connected};
+    trantor::MsgBuffer readBuffer_;
+    trantor::Date lastActivity_;
+    bool keepAlive_{false};
+    size_t bytesSent_{0};
+    size_t bytesReceived_{0};
+
+    // The number of requests in flight, the connection is released when it's
+    // closed and this drops to 0.
+    size_t pendingRequests_{0};
+    bool receiving_{false};
+    bool writing_{false};
+    bool shutdownSent_{false};
+    std::deque<WriteNode> writeQueue_;
+    size_t bytesToSend_{0};
+    static constexpr size_t kMaxIovecs = 16;
+    struct iovec iovecs_[kMaxIovecs];
+    struct msghdr message_;
+    // The pipe for splicing files and the bytes of the file in it.
+    int pipeFds_[2]{-1, -1};
+    size_t bytesInPipe_{0};
+
+    // The sends from other threads, or after them, are queued in the loop
+    // to keep the order.
+    std::mutex sendNumMutex_;
+    size_t sendNum_{0};
+
+    trantor::RecvMessageCallback recvMsgCallback_;
+    trantor::ConnectionCallback connectionCallback_;
+    trantor::HighWaterMarkCallback highWaterMarkCallback_;
+    size_t highWaterMarkLen_{0};
+    CloseCallback closeCallback_;
+};
+
+}  // namespace drogon
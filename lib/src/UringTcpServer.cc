@@ -0,0 +1,254 @@
+/**
+ *
+ *  @file UringTcpServer.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "UringTcpServer.h"
+#include <trantor/utils/Logger.h>
+#include <errno.h>
+#include <future>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+// A ring per IO loop, with 2MB of buffers for receiving.
+constexpr unsigned int kRingEntries = 1024;
+constexpr unsigned int kBufferCount = 512;
+constexpr size_t kBufferSize = 4096;
+
+trantor::InetAddress toInetAddress(const struct sockaddr_in6 &addr)
+{
+    if (addr.sin6_family == AF_INET6)
+        return trantor::InetAddress(addr);
+    return trantor::InetAddress(
+        *reinterpret_cast<const struct sockaddr_in *>(&addr));
+}
+
+/// Pass the completion of a request to its connection, return false if it's
+/// not the request of a connection.
+bool dispatchToConnection(uint64_t userData, int32_t result, uint32_t flags)
+{
+    auto op = static_cast<UringTcpConnection::Operation>(
+        userData & UringTcpConnection::kOperationMask);
+    if (op == UringTcpConnection::kIgnored ||
+        op == UringTcpConnection::kAccept)
+        return false;
+    auto conn = reinterpret_cast<UringTcpConnection *>(
+        userData & ~UringTcpConnection::kOperationMask);
+    conn->handleCompletion(op, result, flags);
+    return true;
+}
+}  // namespace
+
+UringTcpServer::UringTcpServer(trantor::EventLoop *loop,
+                               const trantor::InetAddress &address,
+                               std::string name)
+    : loop_(loop), address_(address), name_(std::move(name))
+{
+    listenFd_ =
+        ::socket(address.family(), SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (listenFd_ < 0)
+    {
+        LOG_SYSERR << "socket";
+        exit(1);
+    }
+    int on = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    socklen_t length = address.isIpV6() ? sizeof(struct sockaddr_in6)
+                                        : sizeof(struct sockaddr_in);
+    if (::bind(listenFd_, address.getSockAddr(), length) < 0)
+    {
+        LOG_SYSERR << ", Bind address failed at " << address.toIpPort();
+        exit(1);
+    }
+    // The port is chosen by the system if it's 0.
+    struct sockaddr_in6 localAddr;
+    memset(&localAddr, 0, sizeof(localAddr));
+    length = sizeof(localAddr);
+    if (getsockname(listenFd_,
+                    reinterpret_cast<struct sockaddr *>(&localAddr),
+                    &length) == 0)
+        address_ = toInetAddress(localAddr);
+}
+
+UringTcpServer::~UringTcpServer()
+{
+    // The connections still held by others keep the ring, whose completions
+    // only go to them from now on.
+    for (auto &conn : connections_)
+        conn->setCloseCallback(nullptr);
+    if (ring_)
+        ring_->setCompletionCallback(
+            [](uint64_t userData, int32_t result, uint32_t flags) {
+                dispatchToConnection(userData, result, flags);
+            });
+    if (listenFd_ >= 0)
+        close(listenFd_);
+}
+
+void UringTcpServer::start()
+{
+    // The connections made before the accept request is submitted wait in
+    // the backlog.
+    if (::listen(listenFd_, SOMAXCONN) < 0)
+    {
+        LOG_SYSERR << "listen";
+        exit(1);
+    }
+    loop_->runInLoop([this]() {
+        ring_ = std::make_shared<IoUring>(loop_,
+                                          kRingEntries,
+                                          kBufferCount,
+                                          kBufferSize);
+        ring_->setCompletionCallback(
+            [this](uint64_t userData, int32_t result, uint32_t flags) {
+                handleCompletion(userData, result, flags);
+            });
+        startAccept();
+        if (idleTimeout_ > 0)
+            idleTimerId_ =
+                loop_->runEvery(1.0, [this]() { removeIdleConnections(); });
+    });
+}
+
+void UringTcpServer::stop()
+{
+    auto stopInLoop = [this]() {
+        stopped_ = true;
+        if (idleTimerId_ != trantor::InvalidTimerId)
+            loop_->invalidateTimer(idleTimerId_);
+        if (ring_ && accepting_)
+        {
+            auto sqe = ring_->getSqe();
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = UringTcpConnection::kAccept;
+            sqe->user_data = UringTcpConnection::kIgnored;
+        }
+        if (listenFd_ >= 0)
+        {
+            close(listenFd_);
+            listenFd_ = -1;
+        }
+        std::vector<std::shared_ptr<UringTcpConnection>> connections(
+            connections_.begin(), connections_.end());
+        for (auto &conn : connections)
+            conn->forceClose();
+    };
+    if (loop_->isInLoopThread() || !loop_->isRunning())
+    {
+        stopInLoop();
+        return;
+    }
+    std::promise<void> pro;
+    auto f = pro.get_future();
+    loop_->queueInLoop([&stopInLoop, &pro]() {
+        stopInLoop();
+        pro.set_value();
+    });
+    f.get();
+}
+
+void UringTcpServer::startAccept()
+{
+    auto sqe = ring_->getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = UringTcpConnection::kAccept;
+    accepting_ = true;
+}
+
+void UringTcpServer::handleCompletion(uint64_t userData,
+                                      int32_t result,
+                                      uint32_t flags)
+{
+    if (dispatchToConnection(userData, result, flags))
+        return;
+    if ((userData & UringTcpConnection::kOperationMask) ==
+        UringTcpConnection::kAccept)
+        handleAccept(result, flags);
+}
+
+void UringTcpServer::handleAccept(int32_t result, uint32_t flags)
+{
+    if (!(flags & IORING_CQE_F_MORE))
+        accepting_ = false;
+    if (result >= 0)
+    {
+        int fd = result;
+        if (stopped_)
+        {
+            close(fd);
+            return;
+        }
+        struct sockaddr_in6 localAddr, peerAddr;
+        memset(&localAddr, 0, sizeof(localAddr));
+        memset(&peerAddr, 0, sizeof(peerAddr));
+        socklen_t length = sizeof(localAddr);
+        getsockname(fd,
+                    reinterpret_cast<struct sockaddr *>(&localAddr),
+                    &length);
+        length = sizeof(peerAddr);
+        getpeername(fd,
+                    reinterpret_cast<struct sockaddr *>(&peerAddr),
+                    &length);
+        auto conn = std::make_shared<UringTcpConnection>(
+            ring_, fd, toInetAddress(localAddr), toInetAddress(peerAddr));
+        conn->setRecvMsgCallback(recvMessageCallback_);
+        conn->setConnectionCallback(connectionCallback_);
+        conn->setCloseCallback(
+            [this](const std::shared_ptr<UringTcpConnection> &connPtr) {
+                connections_.erase(connPtr);
+            });
+        connections_.insert(conn);
+        conn->connectEstablished();
+    }
+    else if (result != -ECANCELED)
+    {
+        LOG_ERROR << "accept error: " << strerror(-result);
+    }
+    if (accepting_ || stopped_)
+        return;
+    if (result == -EMFILE || result == -ENFILE)
+    {
+        // Wait for some connections to be closed.
+        loop_->runAfter(0.1, [this]() {
+            if (!accepting_ && !stopped_)
+                startAccept();
+        });
+        return;
+    }
+    startAccept();
+}
+
+void UringTcpServer::removeIdleConnections()
+{
+    auto now = trantor::Date::now();
+    std::vector<std::shared_ptr<UringTcpConnection>> idleConnections;
+    for (auto &conn : connections_)
+    {
+        if (!conn->isKeepAlive() &&
+            conn->lastActivity().after(static_cast<double>(idleTimeout_)) <
+                now)
+            idleConnections.push_back(conn);
+    }
+    for (auto &conn : idleConnections)
+        conn->forceClose();
+}
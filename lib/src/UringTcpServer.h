@@ -0,0 +1,101 @@
+/**
+ *
+ *  @file UringTcpServer.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "IoUring.h"
+#include "UringTcpConnection.h"
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/net/callbacks.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief A TCP server doing the socket I/O of its connections with an
+ * io_uring instance in its loop, used instead of trantor::TcpServer by the
+ * listeners when io_uring is enabled. The connections are accepted by a
+ * multishot accept request on a socket bound with SO_REUSEPORT, like the
+ * listeners of trantor on Linux, so each IO loop has its own server.
+ *
+ * TLS is not supported, the HTTPS listeners keep using trantor.
+ */
+class UringTcpServer : public trantor::NonCopyable
+{
+  public:
+    /// Bind the address, the server starts accepting in start().
+    UringTcpServer(trantor::EventLoop *loop,
+                   const trantor::InetAddress &address,
+                   std::string name);
+    ~UringTcpServer();
+
+    void start();
+    void stop();
+
+    void setRecvMessageCallback(const trantor::RecvMessageCallback &cb)
+    {
+        recvMessageCallback_ = cb;
+    }
+    void setConnectionCallback(const trantor::ConnectionCallback &cb)
+    {
+        connectionCallback_ = cb;
+    }
+    /// The connections without any I/O in timeout seconds are closed.
+    void kickoffIdleConnections(size_t timeout)
+    {
+        idleTimeout_ = timeout;
+    }
+
+    const std::string &name() const
+    {
+        return name_;
+    }
+    std::string ipPort() const
+    {
+        return address_.toIpPort();
+    }
+    const trantor::InetAddress &address() const
+    {
+        return address_;
+    }
+    trantor::EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+  private:
+    void startAccept();
+    void handleCompletion(uint64_t userData, int32_t result, uint32_t flags);
+    void handleAccept(int32_t result, uint32_t flags);
+    void removeIdleConnections();
+
+    trantor::EventLoop *loop_;
+    trantor::InetAddress address_;
+    std::string name_;
+    int listenFd_{-1};
+    std::shared_ptr<IoUring> ring_;
+    std::set<std::shared_ptr<UringTcpConnection>> connections_;
+    trantor::RecvMessageCallback recvMessageCallback_;
+    trantor::ConnectionCallback connectionCallback_;
+    size_t idleTimeout_{0};
+    trantor::TimerId idleTimerId_{trantor::InvalidTimerId};
+    bool accepting_{false};
+    bool stopped_{false};
+};
+
+}  // namespace drogon
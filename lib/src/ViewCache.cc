@@ -0,0 +1,323 @@
+/**
+ *
+ *  @file ViewCache.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/ViewCache.h>
+#include <drogon/DrTemplateBase.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace drogon;
+
+// The memory used by an entry besides the key and the text.
+static const size_t entryOverhead = 128;
+
+static std::atomic<size_t> capacity{64 * 1024 * 1024};
+static std::atomic<size_t> usedBytes{0};
+
+// Invalidations and clearings increase the epoch. Every thread compares the
+// epoch with the one it has seen before looking up its cache, and removes the
+// texts that were invalidated after they were rendered.
+static std::atomic<uint64_t> currentEpoch{0};
+static std::mutex invalidationMutex;
+static uint64_t clearedEpoch{0};
+static std::unordered_map<std::string, uint64_t> invalidatedEpochs;
+
+namespace
+{
+class ThreadCache
+{
+  public:
+    ~ThreadCache()
+    {
+        usedBytes -= size_;
+    }
+    uint64_t epoch() const
+    {
+        return epoch_;
+    }
+    void sync();
+    bool get(const std::string &key, std::string &text);
+    void put(std::string &&key,
+             const std::string &text,
+             double timeout,
+             uint64_t epoch);
+
+  private:
+    struct Entry;
+    using EntryMap = std::unordered_map<std::string, Entry>;
+    struct Entry
+    {
+        std::string text;
+        std::chrono::steady_clock::time_point expiry;
+        bool expires;
+        uint64_t epoch;
+        size_t cost;
+        // The position in the LRU list.
+        std::list<EntryMap::value_type *>::iterator lruIter;
+    };
+    EntryMap::iterator erase(EntryMap::iterator iter)
+    {
+        size_ -= iter->second.cost;
+        usedBytes -= iter->second.cost;
+        lru_.erase(iter->second.lruIter);
+        return entries_.erase(iter);
+    }
+
+    EntryMap entries_;
+    // The most recently used entry is at the front.
+    std::list<EntryMap::value_type *> lru_;
+    size_t size_{0};
+    uint64_t epoch_{0};
+};
+
+void ThreadCache::sync()
+{
+    if (currentEpoch.load(std::memory_order_acquire) == epoch_)
+        return;
+    std::lock_guard<std::mutex> lock(invalidationMutex);
+    for (auto iter = entries_.begin(); iter != entries_.end();)
+    {
+        auto &entry = iter->second;
+        if (entry.epoch < clearedEpoch)
+        {
+            iter = erase(iter);
+            continue;
+        }
+        // The key begins with the name of the text.
+        auto nameIter = invalidatedEpochs.find(iter->first.c_str());
+        if (nameIter != invalidatedEpochs.end() &&
+            entry.epoch < nameIter->second)
+        {
+            iter = erase(iter);
+            continue;
+        }
+        ++iter;
+    }
+    epoch_ = currentEpoch.load(std::memory_order_relaxed);
+}
+
+bool ThreadCache::get(const std::string &key, std::string &text)
+{
+    auto iter = entries_.find(key);
+    if (iter == entries_.end())
+        return false;
+    auto &entry = iter->second;
+    if (entry.expires && entry.expiry <= std::chrono::steady_clock::now())
+    {
+        erase(iter);
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, entry.lruIter);
+    text = entry.text;
+    return true;
+}
+
+void ThreadCache::put(std::string &&key,
+                      const std::string &text,
+                      double timeout,
+                      uint64_t epoch)
+{
+    auto cost = key.length() + text.length() + entryOverhead;
+    auto limit = capacity.load(std::memory_order_relaxed);
+    if (cost > limit)
+        return;
+    auto iter = entries_.find(key);
+    if (iter != entries_.end())
+        erase(iter);
+    while (!lru_.empty() &&
+           usedBytes.load(std::memory_order_relaxed) + cost > limit)
+    {
+        erase(entries_.find(lru_.back()->first));
+    }
+    if (usedBytes.fetch_add(cost) + cost > limit)
+    {
+        // Other threads use the rest of the capacity.
+        usedBytes -= cost;
+        return;
+    }
+    Entry entry;
+    entry.text = text;
+    entry.expires = timeout > 0;
+    if (entry.expires)
+    {
+        entry.expiry =
+            std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(timeout));
+    }
+    entry.epoch = epoch;
+    entry.cost = cost;
+    auto &value = *entries_.emplace(std::move(key), std::move(entry)).first;
+    lru_.push_front(&value);
+    value.second.lruIter = lru_.begin();
+    size_ += cost;
+}
+
+ThreadCache &threadCache()
+{
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+template <typename T>
+bool appendItem(const any &item, char tag, std::string &key)
+{
+    if (item.type() != typeid(T))
+        return false;
+    key.push_back(tag);
+    key.append(std::to_string(*any_cast<T>(&item)));
+    return true;
+}
+
+// std::to_string() rounds floating-point values to six decimals, so their
+// bytes are used instead.
+template <typename T>
+bool appendFloatItem(const any &item, char tag, std::string &key)
+{
+    if (item.type() != typeid(T))
+        return false;
+    key.push_back(tag);
+    key.append(reinterpret_cast<const char *>(any_cast<T>(&item)), sizeof(T));
+    return true;
+}
+
+// The key is the name followed by the selected items. Values are prefixed by
+// their lengths so that different items never make the same key.
+bool makeKey(const std::string &name,
+             const HttpViewData &data,
+             const std::vector<std::string> &keys,
+             std::string &key)
+{
+    key.reserve(name.length() + 1 + keys.size() * 16);
+    key.append(name);
+    key.push_back('\0');
+    for (auto &itemKey : keys)
+    {
+        key.append(itemKey);
+        key.push_back('\0');
+        auto item = data.find(itemKey);
+        if (!item)
+        {
+            key.push_back('n');
+            continue;
+        }
+        if (item->type() == typeid(std::string) ||
+            item->type() == typeid(const char *))
+        {
+            auto value = data.getStringView(itemKey);
+            key.push_back('s');
+            key.append(std::to_string(value.length()));
+            key.push_back(':');
+            key.append(value.data(), value.length());
+            continue;
+        }
+        if (!appendItem<int>(*item, 'i', key) &&
+            !appendItem<long>(*item, 'i', key) &&
+            !appendItem<long long>(*item, 'i', key) &&
+            !appendItem<unsigned int>(*item, 'u', key) &&
+            !appendItem<unsigned long>(*item, 'u', key) &&
+            !appendItem<unsigned long long>(*item, 'u', key) &&
+            !appendItem<bool>(*item, 'b', key) &&
+            !appendFloatItem<double>(*item, 'd', key) &&
+            !appendFloatItem<float>(*item, 'f', key))
+        {
+            return false;
+        }
+        key.push_back('\0');
+    }
+    return true;
+}
+
+template <typename Renderer>
+bool renderText(const std::string &name,
+                const HttpViewData &data,
+                const std::vector<std::string> &keys,
+                double timeout,
+                Renderer &&renderer,
+                std::string &text)
+{
+    std::string key;
+    if (capacity.load(std::memory_order_relaxed) == 0 ||
+        !makeKey(name, data, keys, key))
+    {
+        return renderer(text);
+    }
+    auto &cache = threadCache();
+    cache.sync();
+    if (cache.get(key, text))
+        return true;
+    auto epoch = cache.epoch();
+    if (!renderer(text))
+        return false;
+    cache.put(std::move(key), text, timeout, epoch);
+    return true;
+}
+}  // namespace
+
+void ViewCache::setCapacity(size_t bytes)
+{
+    capacity.store(bytes, std::memory_order_relaxed);
+    if (bytes == 0)
+        clear();
+}
+
+bool ViewCache::renderView(const std::string &viewName,
+                           const HttpViewData &data,
+                           const std::vector<std::string> &keys,
+                           double timeout,
+                           std::string &text)
+{
+    return renderText(
+        viewName, data, keys, timeout, [&](std::string &output) {
+            auto templ = DrTemplateBase::newTemplate(viewName);
+            if (!templ)
+                return false;
+            output = templ->genText(data);
+            return true;
+        },
+        text);
+}
+
+std::string ViewCache::renderFragment(
+    const std::string &name,
+    const HttpViewData &data,
+    const std::vector<std::string> &keys,
+    double timeout,
+    const std::function<std::string()> &renderer)
+{
+    std::string text;
+    renderText(
+        name, data, keys, timeout, [&](std::string &output) {
+            output = renderer();
+            return true;
+        },
+        text);
+    return text;
+}
+
+void ViewCache::invalidate(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(invalidationMutex);
+    invalidatedEpochs[name] = ++currentEpoch;
+}
+
+void ViewCache::clear()
+{
+    std::lock_guard<std::mutex> lock(invalidationMutex);
+    clearedEpoch = ++currentEpoch;
+    invalidatedEpochs.clear();
+}
@@ -0,0 +1,173 @@
+#include <drogon/HttpClient.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/drogon_test.h>
+#include <trantor/net/TcpServer.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+// A server of HTTP/1.1 only, which answers the connection preface of HTTP/2
+// with an error.
+static std::unique_ptr<trantor::TcpServer> http11Server;
+
+DROGON_TEST(Http2MultiplexingTest)
+{
+    auto client = HttpClient::newHttpClient("http://127.0.0.1:8848");
+    client->enableHttp2();
+
+    // The quick responses are not blocked by the slow one on the same
+    // connection.
+    auto order = std::make_shared<std::atomic<int>>(0);
+    auto slow = HttpRequest::newHttpRequest();
+    slow->setPath("/h2/echo");
+    slow->setParameter("delay", "1");
+    client->sendRequest(
+        slow, [TEST_CTX, order](ReqResult r, const HttpResponsePtr &resp) {
+            REQUIRE(r == ReqResult::Ok);
+            CHECK(resp->version() == Version::kHttp2);
+            CHECK(resp->body() == "GET /h2/echo?delay=1 HTTP/2 ");
+            CHECK(order->fetch_add(1) == 10);
+        });
+    for (int i = 0; i < 10; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/h2/echo");
+        req->setMethod(Post);
+        req->setBody("body " + std::to_string(i));
+        client->sendRequest(
+            req,
+            [TEST_CTX, order, i](ReqResult r, const HttpResponsePtr &resp) {
+                REQUIRE(r == ReqResult::Ok);
+                CHECK(resp->version() == Version::kHttp2);
+                CHECK(resp->body() ==
+                      "POST /h2/echo? HTTP/2 body " + std::to_string(i));
+                CHECK(order->fetch_add(1) < 10);
+            });
+    }
+}
+
+DROGON_TEST(Http2ForwardTest)
+{
+    // The request received over HTTP/2 is forwarded over HTTP/1.1.
+    auto client = HttpClient::newHttpClient("http://127.0.0.1:8848");
+    client->enableHttp2();
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/h2/forward");
+    req->setMethod(Post);
+    req->setParameter("a", "1");
+    req->setContentTypeCode(CT_TEXT_PLAIN);
+    req->setBody("forwarded body");
+    client->sendRequest(req,
+                        [TEST_CTX](ReqResult r, const HttpResponsePtr &resp) {
+                            REQUIRE(r == ReqResult::Ok);
+                            CHECK(resp->version() == Version::kHttp2);
+                            CHECK(resp->body() ==
+                                  "POST /h2/echo?a=1 HTTP/1.1 forwarded body");
+                        });
+}
+
+DROGON_TEST(Http2AlpnTest)
+{
+    if (!app().supportSSL())
+        return;
+
+    // HTTP/2 is selected by ALPN.
+    auto client = HttpClient::newHttpClient("https://127.0.0.1:8849",
+                                            app().getLoop(),
+                                            false,
+                                            false);
+    client->enableHttp2();
+    for (int i = 0; i < 3; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/h2/echo");
+        client->sendRequest(
+            req, [TEST_CTX](ReqResult r, const HttpResponsePtr &resp) {
+                REQUIRE(r == ReqResult::Ok);
+                CHECK(resp->version() == Version::kHttp2);
+                CHECK(resp->body() == "GET /h2/echo? HTTP/2 ");
+            });
+    }
+}
+
+DROGON_TEST(Http2FallbackTest)
+{
+    http11Server = std::make_unique<trantor::TcpServer>(
+        app().getLoop(), trantor::InetAddress(8850), "http11Server");
+    auto prefaces = std::make_shared<std::atomic<int>>(0);
+    http11Server->setRecvMessageCallback(
+        [prefaces](const trantor::TcpConnectionPtr &conn,
+                   trantor::MsgBuffer *buffer) {
+            if (buffer->readableBytes() >= 4 &&
+                std::string(buffer->peek(), 4) == "PRI ")
+            {
+                ++*prefaces;
+                buffer->retrieveAll();
+                conn->send(
+                    "HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\n"
+                    "connection: close\r\n\r\n");
+                conn->shutdown();
+                return;
+            }
+            // The requests have no body.
+            std::string data(buffer->peek(), buffer->readableBytes());
+            size_t pos;
+            while ((pos = data.find("\r\n\r\n")) != std::string::npos)
+            {
+                auto request = data.substr(0, pos);
+                data.erase(0, pos + 4);
+                buffer->retrieve(pos + 4);
+                if (request.find("\r\nconnection: close") !=
+                    std::string::npos)
+                {
+                    conn->send(
+                        "HTTP/1.1 200 OK\r\ncontent-length: 8\r\n"
+                        "connection: close\r\n\r\nHTTP/1.1");
+                    conn->shutdown();
+                    return;
+                }
+                conn->send(
+                    "HTTP/1.1 200 OK\r\ncontent-length: 8\r\n\r\nHTTP/1.1");
+            }
+        });
+    http11Server->start();
+
+    // The requests are sent again over HTTP/1.1 after the preface is
+    // refused.
+    auto client = HttpClient::newHttpClient("http://127.0.0.1:8850");
+    client->enableHttp2();
+    auto count = std::make_shared<std::atomic<int>>(0);
+    for (int i = 0; i < 3; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/fallback");
+        if (i == 2)
+            req->addHeader("connection", "close");
+        client->sendRequest(
+            req,
+            [TEST_CTX, client, prefaces, count](ReqResult r,
+                                                const HttpResponsePtr &resp) {
+                REQUIRE(r == ReqResult::Ok);
+                CHECK(resp->version() == Version::kHttp11);
+                CHECK(resp->body() == "HTTP/1.1");
+                if (++*count < 3)
+                    return;
+                CHECK(*prefaces == 1);
+                // The next connection doesn't try HTTP/2 again.
+                app().getLoop()->queueInLoop([TEST_CTX, client, prefaces]() {
+                    auto req = HttpRequest::newHttpRequest();
+                    req->setPath("/fallback");
+                    client->sendRequest(
+                        req,
+                        [TEST_CTX, prefaces](ReqResult r,
+                                             const HttpResponsePtr &resp) {
+                            REQUIRE(r == ReqResult::Ok);
+                            CHECK(resp->version() == Version::kHttp11);
+                            CHECK(*prefaces == 1);
+                        });
+                });
+            });
+    }
+}
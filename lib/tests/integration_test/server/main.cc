@@ -211,6 +211,41 @@ int main()
            std::function<void(const HttpResponsePtr &)> &&callback) {
             throw std::runtime_error("this should fail");
         });
+    // Echo the request line and the body, the response is delayed by the
+    // "delay" parameter (in seconds) to test the multiplexing of HTTP/2.
+    app().registerHandler(
+        "/h2/echo",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newHttpResponse();
+            std::string version = req->version() == Version::kHttp2
+                                      ? "HTTP/2"
+                                      : req->version() == Version::kHttp11
+                                            ? "HTTP/1.1"
+                                            : "HTTP/1.0";
+            resp->setBody(std::string(req->methodString()) + " " +
+                          req->path() + "?" + req->query() + " " + version +
+                          " " + std::string(req->body()));
+            auto delay = req->getParameter("delay");
+            if (delay.empty())
+            {
+                callback(resp);
+                return;
+            }
+            app().getLoop()->runAfter(std::stod(delay),
+                                      [callback = std::move(callback),
+                                       resp]() { callback(resp); });
+        },
+        {Get, Post});
+    // Forward the request to /h2/echo over HTTP/1.1.
+    app().registerHandler(
+        "/h2/forward",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            req->setPath("/h2/echo");
+            app().forward(req, std::move(callback), "http://127.0.0.1:8848");
+        },
+        {Get, Post});
 
     app().setDocumentRoot("./");
     app().enableSession(60);
@@ -220,6 +255,8 @@ int main()
     std::string opaque("drogonOpaque");
     // Load configuration
     app().loadConfigFile("config.example.json");
+    // The clients of HTTP/2 are served on all the listeners.
+    app().enableHttp2();
     app().setImplicitPageEnable(true);
     app().setImplicitPage("page.html");
     auto &json = app().getCustomConfig();
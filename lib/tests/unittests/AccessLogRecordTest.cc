@@ -0,0 +1,213 @@
+#include "../../lib/src/AccessLogRecord.h"
+#include <drogon/drogon_test.h>
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+static AccessLogRecord makeRecord(int64_t date,
+                                  const std::string &path,
+                                  const std::string &query = "")
+{
+    AccessLogRecord record{};
+    record.date = date;
+    record.requestDate = date - 1500;
+    record.remoteAddr = trantor::InetAddress(8080, true);
+    record.localAddr = trantor::InetAddress(80, true);
+    record.requestLength = 12;
+    record.responseLength = 345;
+    record.thread = 7;
+    record.statusCode = 200;
+    record.method = "GET";
+    record.contentType = CT_APPLICATION_JSON;
+    memcpy(record.url, path.data(), path.length());
+    memcpy(record.url + path.length(), query.data(), query.length());
+    record.pathLength = static_cast<uint16_t>(path.length());
+    record.queryLength = static_cast<uint16_t>(query.length());
+    return record;
+}
+
+static bool push(AccessLogRecordRing &ring, int64_t date)
+{
+    auto record = ring.prepare();
+    if (!record)
+        return false;
+    *record = makeRecord(date, "/");
+    ring.commit();
+    return true;
+}
+
+static std::vector<int64_t> dates(const std::vector<AccessLogRecord> &records)
+{
+    std::vector<int64_t> result;
+    for (auto &record : records)
+        result.push_back(record.date);
+    return result;
+}
+
+DROGON_TEST(AccessLogRecordTest)
+{
+    SUBSECTION(RingWrapAndOverflow)
+    {
+        // The size is rounded up to a power of two.
+        AccessLogRecordRing ring(3);
+        CHECK(ring.capacity() == 4U);
+        std::vector<AccessLogRecord> records;
+        ring.popAll(records);
+        CHECK(records.empty());
+
+        // The records that don't fit are dropped and counted by the caller.
+        size_t dropped = 0;
+        for (int64_t date = 1; date <= 6; ++date)
+        {
+            if (!push(ring, date))
+                ++dropped;
+        }
+        CHECK(dropped == 2U);
+        ring.popAll(records);
+        CHECK(dates(records) == std::vector<int64_t>({1, 2, 3, 4}));
+
+        // The indices wrap around the ring once the records are taken out.
+        for (int64_t round = 0; round < 3; ++round)
+        {
+            auto base = round * 10;
+            records.clear();
+            dropped = 0;
+            for (int64_t i = 0; i < 5; ++i)
+            {
+                if (!push(ring, base + i))
+                    ++dropped;
+            }
+            CHECK(dropped == 1U);
+            ring.popAll(records);
+            CHECK(dates(records) ==
+                  std::vector<int64_t>({base, base + 1, base + 2, base + 3}));
+        }
+
+        CHECK(!ring.retired());
+        ring.retire();
+        CHECK(ring.retired());
+    }
+
+    SUBSECTION(ConcurrentProducer)
+    {
+        AccessLogRecordRing ring(64);
+        const int64_t total = 100000;
+        size_t dropped = 0;
+        std::atomic<bool> done{false};
+        std::thread producer([&]() {
+            for (int64_t date = 0; date < total; ++date)
+            {
+                if (!push(ring, date))
+                    ++dropped;
+            }
+            done = true;
+        });
+        std::vector<AccessLogRecord> records;
+        while (!done)
+            ring.popAll(records);
+        producer.join();
+        ring.popAll(records);
+        // Every record is either taken out in order or counted as dropped.
+        CHECK(records.size() + dropped == static_cast<size_t>(total));
+        bool ordered = true;
+        for (size_t i = 1; i < records.size(); ++i)
+        {
+            if (records[i].date <= records[i - 1].date)
+                ordered = false;
+        }
+        CHECK(ordered);
+    }
+
+    SUBSECTION(FlushOrdering)
+    {
+        auto first = std::make_shared<AccessLogRecordRing>(8);
+        auto second = std::make_shared<AccessLogRecordRing>(8);
+        *first->prepare() = makeRecord(1, "/first/1");
+        first->commit();
+        *first->prepare() = makeRecord(4, "/first/4a");
+        first->commit();
+        *first->prepare() = makeRecord(4, "/first/4b");
+        first->commit();
+        *second->prepare() = makeRecord(2, "/second/2");
+        second->commit();
+        *second->prepare() = makeRecord(4, "/second/4");
+        second->commit();
+        *second->prepare() = makeRecord(3, "/second/3");
+        second->commit();
+
+        std::vector<AccessLogRecord> records;
+        collectAccessLogRecords({first, second}, records);
+        REQUIRE(records.size() == 6U);
+        CHECK(dates(records) == std::vector<int64_t>({1, 2, 3, 4, 4, 4}));
+        // The records of the same date keep the order of the rings.
+        std::vector<std::string> paths;
+        for (auto &record : records)
+            paths.emplace_back(record.url, record.pathLength);
+        CHECK(paths[3] == "/first/4a");
+        CHECK(paths[4] == "/first/4b");
+        CHECK(paths[5] == "/second/4");
+
+        // The rings are empty after being drained.
+        records.clear();
+        collectAccessLogRecords({first, second}, records);
+        CHECK(records.empty());
+    }
+
+    SUBSECTION(TextFormat)
+    {
+        AccessLogFormatter formatter(
+            "$method $url [$body_bytes_received] ($remote_addr - "
+            "$local_addr) $status $body_bytes_sent $processing_time "
+            "$upstream_http_content_type $http_host",
+            false,
+            false);
+        std::string output;
+        formatter.format(output, makeRecord(1000000, "/path", "a=1&b=2"));
+        CHECK(output ==
+              "GET /path?a=1&b=2 [12] (127.0.0.1:8080 - 127.0.0.1:80) 200 OK "
+              "345 0.0015 content-type: application/json; charset=utf-8 "
+              "$http_host\n");
+
+        // The records are appended, the URL has no '?' without a query.
+        AccessLogFormatter paths("$path|$query|$url $thread $status_code",
+                                 false,
+                                 false);
+        output.clear();
+        paths.format(output, makeRecord(1000000, "/a", "x=1"));
+        paths.format(output, makeRecord(1000000, "/b"));
+        CHECK(output == "/a|x=1|/a?x=1 7 200\n/b||/b 7 200\n");
+
+        AccessLogFormatter date("$request_date", false, false);
+        output.clear();
+        date.format(output, makeRecord(1500, "/"));
+        CHECK(output == "19700101 00:00:00.000000\n");
+    }
+
+    SUBSECTION(JsonFormat)
+    {
+        AccessLogFormatter formatter(
+            "$method $url [$body_bytes_received] $status_code $status "
+            "$processing_time $http_host",
+            true,
+            false);
+        std::string output;
+        formatter.format(output, makeRecord(1000000, "/api", "q=1"));
+        // The raw strings and the unsupported placeholders are skipped, the
+        // numbers are not quoted.
+        CHECK(output ==
+              "{\"method\":\"GET\",\"url\":\"/api?q=1\","
+              "\"body_bytes_received\":12,\"status_code\":200,"
+              "\"status\":\"200 OK\",\"processing_time\":0.0015}\n");
+
+        // Quotes, backslashes and control characters are escaped.
+        AccessLogFormatter path("$path", true, false);
+        output.clear();
+        path.format(output, makeRecord(1000000, "/a\"b\\c\n\x01"));
+        CHECK(output == "{\"path\":\"/a\\\"b\\\\c\\u000a\\u0001\"}\n");
+    }
+}
@@ -0,0 +1,62 @@
+#include "../../orm_lib/src/DbClientRouter.h"
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon::orm;
+
+static bool readOnly(const std::string &sql,
+                     ClientType type = ClientType::PostgreSQL)
+{
+    return DbClientRouter::isReadOnlySql(sql.data(), sql.length(), type);
+}
+
+DROGON_TEST(DbClientRouterTest)
+{
+    SUBSECTION(Select)
+    {
+        CHECK(readOnly("select * from users where id = $1"));
+        CHECK(readOnly(" (select count(*) from t) union (select 1)"));
+        CHECK(readOnly("select lower(name), coalesce(a, 0) from t "
+                       "where x in (1, 2) and exists (select 1)"));
+        CHECK(readOnly("select 1;"));
+        CHECK(readOnly("update t set a = 1") == false);
+        CHECK(readOnly("select 1; delete from t") == false);
+        CHECK(readOnly("with x as (delete from t returning *) "
+                       "select * from x") == false);
+    }
+
+    SUBSECTION(Locks)
+    {
+        CHECK(readOnly("select * from t for update") == false);
+        CHECK(readOnly("select * from t FOR  NO KEY UPDATE") == false);
+        CHECK(readOnly("select * from t lock in share mode",
+                       ClientType::Mysql) == false);
+        CHECK(readOnly("select a into b from t") == false);
+    }
+
+    SUBSECTION(Functions)
+    {
+        CHECK(readOnly("select nextval('s')") == false);
+        CHECK(readOnly("select pg_advisory_lock (1)") == false);
+        CHECK(readOnly("select my_writer(1)") == false);
+        CHECK(readOnly("select public.lower(a) from t") == false);
+    }
+
+    SUBSECTION(LiteralsAndComments)
+    {
+        CHECK(readOnly("select into_count, 'into' from t"));
+        CHECK(readOnly("select \"into\" from t"));
+        CHECK(readOnly("select * from t -- into\n where a = 1"));
+        CHECK(readOnly("select * from t /* a /* for update */ into */"));
+        CHECK(readOnly("select $$ into $$, $tag$ for update $tag$ from t"));
+        CHECK(readOnly("select E'it\\'s into', 'it''s into' from t"));
+        CHECK(readOnly("select 'it\\'s into' from t", ClientType::Mysql));
+        CHECK(readOnly("select `into` from t # into", ClientType::Mysql));
+    }
+
+    SUBSECTION(Hints)
+    {
+        CHECK(readOnly("select my_reader(1) /* drogon:read-only */"));
+        CHECK(readOnly("/*drogon:primary*/ select 1") == false);
+    }
+}
@@ -0,0 +1,119 @@
+#include "../../drogon_ctl/HdrHistogram.h"
+#include <drogon/drogon_test.h>
+#include <math.h>
+#include <stdint.h>
+
+using namespace drogon_ctl;
+
+// The upper bound of the bucket of a value, which is reported as the 50th
+// percentile when a larger value is recorded after it.
+static int64_t bucketUpperBound(int64_t value)
+{
+    HdrHistogram histogram;
+    histogram.record(value);
+    histogram.record(3600LL * 1000 * 1000);
+    return histogram.valueAtPercentile(50);
+}
+
+DROGON_TEST(HdrHistogramTest)
+{
+    SUBSECTION(Empty)
+    {
+        HdrHistogram histogram;
+        CHECK(histogram.count() == 0U);
+        CHECK(histogram.min() == 0);
+        CHECK(histogram.max() == 0);
+        CHECK(histogram.mean() == 0);
+        CHECK(histogram.valueAtPercentile(99) == 0);
+    }
+
+    SUBSECTION(BucketIndexing)
+    {
+        // The values below 2048 have their own buckets.
+        CHECK(bucketUpperBound(0) == 0);
+        CHECK(bucketUpperBound(1) == 1);
+        CHECK(bucketUpperBound(1023) == 1023);
+        CHECK(bucketUpperBound(1024) == 1024);
+        CHECK(bucketUpperBound(2047) == 2047);
+        // Then the width of the buckets doubles with the range of values.
+        CHECK(bucketUpperBound(2048) == 2049);
+        CHECK(bucketUpperBound(2049) == 2049);
+        CHECK(bucketUpperBound(4095) == 4095);
+        CHECK(bucketUpperBound(4096) == 4099);
+        CHECK(bucketUpperBound(1000000) == 1000447);
+        // Every value is in a bucket narrower than 1/1024 of it.
+        bool bounded = true;
+        const int64_t highest = 3600LL * 1000 * 1000;
+        for (int64_t value = 1; value < highest; value = value * 3 + 1)
+        {
+            auto bound = bucketUpperBound(value);
+            if (bound < value || (bound - value) * 1024 > value)
+                bounded = false;
+        }
+        CHECK(bounded);
+    }
+
+    SUBSECTION(Clamping)
+    {
+        HdrHistogram histogram(1000000);
+        histogram.record(-5);
+        histogram.record(5000000);
+        CHECK(histogram.count() == 2U);
+        CHECK(histogram.min() == 0);
+        CHECK(histogram.max() == 1000000);
+        CHECK(histogram.valueAtPercentile(0) == 0);
+        CHECK(histogram.valueAtPercentile(100) == 1000000);
+    }
+
+    SUBSECTION(PercentileAccuracy)
+    {
+        HdrHistogram histogram;
+        const int64_t total = 1000000;
+        for (int64_t value = 1; value <= total; ++value)
+            histogram.record(value);
+        CHECK(histogram.count() == static_cast<uint64_t>(total));
+        CHECK(histogram.min() == 1);
+        CHECK(histogram.max() == total);
+        // 3 significant digits: the reported values are at most 0.1% above
+        // the exact ones.
+        for (double percentile : {1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99})
+        {
+            auto exact = static_cast<int64_t>(ceil(percentile / 100 * total));
+            auto value = histogram.valueAtPercentile(percentile);
+            CHECK(value >= exact);
+            CHECK(value - exact <= exact / 1000);
+        }
+        CHECK(histogram.valueAtPercentile(100) == total);
+        CHECK(fabs(histogram.mean() - (total + 1) / 2.0) < total / 1000.0);
+        // The standard deviation of a uniform distribution.
+        CHECK(fabs(histogram.stddev() - total / sqrt(12.0)) < total / 1000.0);
+    }
+
+    SUBSECTION(Merging)
+    {
+        HdrHistogram all;
+        HdrHistogram even;
+        HdrHistogram odd;
+        for (int64_t value = 7; value < 5000000; value = value * 5 / 4 + 3)
+        {
+            all.record(value);
+            if (value % 2 == 0)
+                even.record(value);
+            else
+                odd.record(value);
+        }
+        HdrHistogram merged;
+        merged.add(even);
+        merged.add(odd);
+        CHECK(merged.count() == all.count());
+        CHECK(merged.count() == even.count() + odd.count());
+        CHECK(merged.min() == all.min());
+        CHECK(merged.max() == all.max());
+        CHECK(merged.mean() == all.mean());
+        for (double percentile : {10.0, 50.0, 75.0, 99.0, 100.0})
+        {
+            CHECK(merged.valueAtPercentile(percentile) ==
+                  all.valueAtPercentile(percentile));
+        }
+    }
+}
@@ -0,0 +1,147 @@
+#include "../../lib/src/Hpack.h"
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+static std::string fromHex(const std::string &hex)
+{
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.length(); i += 2)
+        out += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    return out;
+}
+
+DROGON_TEST(HpackTest)
+{
+    SUBSECTION(Integer)
+    {
+        // RFC 7541 C.1
+        std::string out;
+        hpack::encodeInteger(10, 5, 0, out);
+        CHECK(out == fromHex("0a"));
+        out.clear();
+        hpack::encodeInteger(1337, 5, 0, out);
+        CHECK(out == fromHex("1f9a0a"));
+        out.clear();
+        hpack::encodeInteger(42, 8, 0, out);
+        CHECK(out == fromHex("2a"));
+    }
+
+    SUBSECTION(Huffman)
+    {
+        std::string out;
+        hpack::huffmanEncode("www.example.com", out);
+        CHECK(out == fromHex("f1e3c2e5f23a6ba0ab90f4ff"));
+        CHECK(hpack::huffmanEncodedLength("www.example.com") == out.length());
+        std::string decoded;
+        CHECK(hpack::huffmanDecode(out.data(), out.length(), decoded));
+        CHECK(decoded == "www.example.com");
+
+        std::string all;
+        for (int c = 0; c < 256; ++c)
+            all += static_cast<char>(c);
+        out.clear();
+        hpack::huffmanEncode(all, out);
+        decoded.clear();
+        CHECK(hpack::huffmanDecode(out.data(), out.length(), decoded));
+        CHECK(decoded == all);
+
+        // The padding must be the ones of EOS, no longer than 7 bits.
+        decoded.clear();
+        CHECK(!hpack::huffmanDecode("\x00", 1, decoded));
+        auto eos = fromHex("ffffffff");
+        decoded.clear();
+        CHECK(!hpack::huffmanDecode(eos.data(), eos.length(), decoded));
+    }
+
+    SUBSECTION(Decoder)
+    {
+        // RFC 7541 C.4, the requests share the dynamic table.
+        HpackDecoder decoder(4096, 64 * 1024);
+        HpackHeaders headers;
+        auto block = fromHex("828684418cf1e3c2e5f23a6ba0ab90f4ff");
+        CHECK(decoder.decode(block.data(), block.length(), headers));
+        HpackHeaders expected{{":method", "GET"},
+                              {":scheme", "http"},
+                              {":path", "/"},
+                              {":authority", "www.example.com"}};
+        CHECK(headers == expected);
+        headers.clear();
+        block = fromHex("828684be5886a8eb10649cbf");
+        CHECK(decoder.decode(block.data(), block.length(), headers));
+        CHECK(headers.size() == 5UL);
+        CHECK(headers[3].second == "www.example.com");
+        CHECK(headers[4] ==
+              std::make_pair(std::string("cache-control"),
+                             std::string("no-cache")));
+        headers.clear();
+        block =
+            fromHex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf");
+        CHECK(decoder.decode(block.data(), block.length(), headers));
+        CHECK(headers.size() == 5UL);
+        CHECK(headers[2].second == "/index.html");
+        CHECK(headers[4] ==
+              std::make_pair(std::string("custom-key"),
+                             std::string("custom-value")));
+
+        // An index out of the tables
+        HpackDecoder other(4096, 64 * 1024);
+        block = fromHex("c0");
+        CHECK(!other.decode(block.data(), block.length(), headers));
+        // A size update larger than the limit
+        HpackDecoder small(100, 64 * 1024);
+        block = fromHex("3fe11f");
+        CHECK(!small.decode(block.data(), block.length(), headers));
+    }
+
+    SUBSECTION(HeaderListTooLarge)
+    {
+        HpackEncoder encoder;
+        HpackDecoder decoder(4096, 100);
+        std::string value(100, 'a');
+        std::string block;
+        encoder.encode({{"x-large", value}}, block);
+        HpackHeaders headers;
+        CHECK(decoder.decode(block.data(), block.length(), headers));
+        CHECK(decoder.headerListTooLarge());
+        CHECK(headers.empty());
+    }
+
+    SUBSECTION(RoundTrip)
+    {
+        HpackEncoder encoder;
+        HpackDecoder decoder(4096, 64 * 1024);
+        HpackHeaderViews views{{":status", "200"},
+                               {"content-type", "text/html; charset=utf-8"},
+                               {"server", "drogon"},
+                               {"set-cookie", "JSESSIONID=1234"},
+                               {"x-custom", "value"}};
+        std::string first;
+        encoder.encode(views, first);
+        std::string second;
+        encoder.encode(views, second);
+        // The repeated headers are indexed, except the sensitive ones.
+        CHECK(second.length() < first.length());
+        for (auto *block : {&first, &second})
+        {
+            HpackHeaders headers;
+            CHECK(decoder.decode(block->data(), block->length(), headers));
+            CHECK(headers.size() == views.size());
+            for (size_t i = 0; i < headers.size(); ++i)
+            {
+                CHECK(headers[i].first == views[i].first);
+                CHECK(headers[i].second == views[i].second);
+            }
+        }
+
+        // A smaller table of the peer is signalled in the next block.
+        encoder.setMaxTableSize(0);
+        std::string third;
+        encoder.encode(views, third);
+        CHECK(static_cast<unsigned char>(third[0]) == 0x20);
+        HpackHeaders headers;
+        CHECK(decoder.decode(third.data(), third.length(), headers));
+        CHECK(headers.size() == views.size());
+    }
+}
@@ -0,0 +1,942 @@
+#include "../../lib/src/Http2ServerSession.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/HttpResponseImpl.h"
+#include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpConnection.h>
+#include <algorithm>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include <string.h>
+
+using namespace drogon;
+
+namespace
+{
+enum FrameType : uint8_t
+{
+    kData = 0x0,
+    kHeaders = 0x1,
+    kRstStream = 0x3,
+    kSettings = 0x4,
+    kPing = 0x6,
+    kGoAway = 0x7,
+    kWindowUpdate = 0x8,
+    kContinuation = 0x9
+};
+enum FrameFlag : uint8_t
+{
+    kEndStream = 0x1,
+    kAck = 0x1,
+    kEndHeaders = 0x4
+};
+
+struct Frame
+{
+    uint8_t type;
+    uint8_t flags;
+    uint32_t streamId;
+    std::string payload;
+};
+
+void appendUint32(std::string &out, uint32_t value)
+{
+    out += static_cast<char>(value >> 24);
+    out += static_cast<char>(value >> 16);
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value);
+}
+
+uint32_t readUint32(const std::string &data, size_t pos)
+{
+    auto p = reinterpret_cast<const unsigned char *>(data.data() + pos);
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+std::string makeFrame(uint8_t type,
+                      uint8_t flags,
+                      uint32_t streamId,
+                      const std::string &payload = "")
+{
+    std::string frame;
+    frame += static_cast<char>(payload.length() >> 16);
+    frame += static_cast<char>(payload.length() >> 8);
+    frame += static_cast<char>(payload.length());
+    frame += static_cast<char>(type);
+    frame += static_cast<char>(flags);
+    appendUint32(frame, streamId);
+    frame += payload;
+    return frame;
+}
+
+std::string makeSettings(
+    const std::vector<std::pair<uint16_t, uint32_t>> &settings = {})
+{
+    std::string payload;
+    for (auto &setting : settings)
+    {
+        payload += static_cast<char>(setting.first >> 8);
+        payload += static_cast<char>(setting.first);
+        appendUint32(payload, setting.second);
+    }
+    return makeFrame(kSettings, 0, 0, payload);
+}
+
+std::string makeUint32Frame(uint8_t type, uint32_t streamId, uint32_t value)
+{
+    std::string payload;
+    appendUint32(payload, value);
+    return makeFrame(type, 0, streamId, payload);
+}
+
+/// A connection that keeps what the session sends.
+class MockConnection : public trantor::TcpConnection
+{
+  public:
+    explicit MockConnection(trantor::EventLoop *loop) : loop_(loop)
+    {
+    }
+    std::vector<Frame> takeFrames()
+    {
+        std::vector<Frame> frames;
+        size_t pos = 0;
+        while (pos + 9 <= output_.length())
+        {
+            auto p = reinterpret_cast<const unsigned char *>(output_.data());
+            size_t length = (static_cast<size_t>(p[pos]) << 16) |
+                            (static_cast<size_t>(p[pos + 1]) << 8) |
+                            p[pos + 2];
+            Frame frame;
+            frame.type = p[pos + 3];
+            frame.flags = p[pos + 4];
+            frame.streamId = readUint32(output_, pos + 5) & 0x7fffffff;
+            frame.payload = output_.substr(pos + 9, length);
+            frames.push_back(std::move(frame));
+            pos += 9 + length;
+        }
+        output_.clear();
+        return frames;
+    }
+    bool isShutdown() const
+    {
+        return shutdown_;
+    }
+
+    void send(const char *msg, size_t len) override
+    {
+        output_.append(msg, len);
+    }
+    void send(const void *msg, size_t len) override
+    {
+        output_.append(static_cast<const char *>(msg), len);
+    }
+    void send(const std::string &msg) override
+    {
+        output_ += msg;
+    }
+    void send(std::string &&msg) override
+    {
+        output_ += msg;
+    }
+    void send(const trantor::MsgBuffer &buffer) override
+    {
+        output_.append(buffer.peek(), buffer.readableBytes());
+    }
+    void send(trantor::MsgBuffer &&buffer) override
+    {
+        output_.append(buffer.peek(), buffer.readableBytes());
+    }
+    void send(const std::shared_ptr<std::string> &msgPtr) override
+    {
+        output_ += *msgPtr;
+    }
+    void send(const std::shared_ptr<trantor::MsgBuffer> &msgPtr) override
+    {
+        output_.append(msgPtr->peek(), msgPtr->readableBytes());
+    }
+    void sendFile(const char *, size_t, size_t) override
+    {
+    }
+    void sendFile(const wchar_t *, size_t, size_t) override
+    {
+    }
+    const trantor::InetAddress &localAddr() const override
+    {
+        return addr_;
+    }
+    const trantor::InetAddress &peerAddr() const override
+    {
+        return addr_;
+    }
+    bool connected() const override
+    {
+        return !shutdown_;
+    }
+    bool disconnected() const override
+    {
+        return shutdown_;
+    }
+    trantor::MsgBuffer *getRecvBuffer() override
+    {
+        return nullptr;
+    }
+    void setHighWaterMarkCallback(const trantor::HighWaterMarkCallback &,
+                                  size_t) override
+    {
+    }
+    void setTcpNoDelay(bool) override
+    {
+    }
+    void shutdown() override
+    {
+        shutdown_ = true;
+    }
+    void forceClose() override
+    {
+        shutdown_ = true;
+    }
+    trantor::EventLoop *getLoop() override
+    {
+        return loop_;
+    }
+    void keepAlive() override
+    {
+    }
+    bool isKeepAlive() override
+    {
+        return true;
+    }
+    size_t bytesSent() const override
+    {
+        return 0;
+    }
+    size_t bytesReceived() const override
+    {
+        return 0;
+    }
+    bool isSSLConnection() const override
+    {
+        return false;
+    }
+    void startClientEncryption(
+        std::function<void()>,
+        bool,
+        bool,
+        std::string,
+        const std::vector<std::pair<std::string, std::string>> &) override
+    {
+    }
+    void startServerEncryption(const std::shared_ptr<trantor::SSLContext> &,
+                               std::function<void()>) override
+    {
+    }
+
+  private:
+    trantor::EventLoop *loop_;
+    trantor::InetAddress addr_;
+    std::string output_;
+    bool shutdown_{false};
+};
+
+/// The server side of the framing layer, the streams are answered by the
+/// test.
+class TestSession : public Http2Session
+{
+  public:
+    explicit TestSession(const trantor::TcpConnectionPtr &conn)
+        : Http2Session(conn, true)
+    {
+    }
+    using Http2Session::flush;
+    using Http2Session::numberOfStreams;
+    using Http2Session::sendData;
+    using Http2Session::sendHeaders;
+
+    void sendBody(uint32_t streamId, size_t size)
+    {
+        auto sent = std::make_shared<size_t>(0);
+        sendData(streamId, [sent, size](char *data, size_t length, bool &eof) {
+            length = std::min(length, size - *sent);
+            memset(data, 'x', length);
+            *sent += length;
+            eof = *sent == size;
+            return length;
+        });
+        flush();
+    }
+
+    std::map<uint32_t, HpackHeaders> headers_;
+    std::map<uint32_t, std::string> bodies_;
+    std::map<uint32_t, uint32_t> closedStreams_;
+    uint32_t goAwayError_{0xffffffff};
+
+  protected:
+    void onHeaders(uint32_t streamId,
+                   HpackHeaders &&headers,
+                   bool,
+                   bool) override
+    {
+        headers_[streamId] = std::move(headers);
+    }
+    void onData(uint32_t streamId,
+                const char *data,
+                size_t length,
+                bool) override
+    {
+        bodies_[streamId].append(data, length);
+    }
+    void onStreamClosed(uint32_t streamId, uint32_t errorCode) override
+    {
+        closedStreams_[streamId] = errorCode;
+    }
+    void onGoAway(uint32_t, uint32_t errorCode) override
+    {
+        goAwayError_ = errorCode;
+    }
+};
+
+/// The client side of a connection, it encodes the frames and feeds the
+/// session with them.
+struct TestClient
+{
+    template <typename Session>
+    bool send(Session &session, const std::string &data)
+    {
+        buffer_.append(data);
+        return session.onMessage(&buffer_);
+    }
+    std::string headers(uint32_t streamId,
+                        const HpackHeaderViews &headerList,
+                        uint8_t flags = kEndHeaders | kEndStream)
+    {
+        std::string block;
+        encoder_.encode(headerList, block);
+        return makeFrame(kHeaders, flags, streamId, block);
+    }
+    std::string request(uint32_t streamId, bool endStream = true)
+    {
+        return headers(streamId,
+                       {{":method", "GET"},
+                        {":scheme", "http"},
+                        {":path", "/"},
+                        {":authority", "localhost"}},
+                       endStream ? kEndHeaders | kEndStream : kEndHeaders);
+    }
+    /// The connection preface and the SETTINGS of the client.
+    std::string preface(
+        const std::vector<std::pair<uint16_t, uint32_t>> &settings = {})
+    {
+        return std::string(Http2Session::kClientPreface.data(),
+                           Http2Session::kClientPreface.length()) +
+               makeSettings(settings);
+    }
+
+    HpackEncoder encoder_;
+    trantor::MsgBuffer buffer_;
+};
+
+const Frame *findFrame(const std::vector<Frame> &frames,
+                       uint8_t type,
+                       uint32_t streamId)
+{
+    for (auto &frame : frames)
+    {
+        if (frame.type == type && frame.streamId == streamId)
+            return &frame;
+    }
+    return nullptr;
+}
+
+size_t dataLength(const std::vector<Frame> &frames, uint32_t streamId)
+{
+    size_t length = 0;
+    for (auto &frame : frames)
+    {
+        if (frame.type == kData && frame.streamId == streamId)
+            length += frame.payload.length();
+    }
+    return length;
+}
+
+uint32_t goAwayError(const std::vector<Frame> &frames)
+{
+    auto frame = findFrame(frames, kGoAway, 0);
+    return frame && frame->payload.length() >= 8
+               ? readUint32(frame->payload, 4)
+               : 0xffffffff;
+}
+
+uint32_t rstStreamError(const std::vector<Frame> &frames, uint32_t streamId)
+{
+    auto frame = findFrame(frames, kRstStream, streamId);
+    return frame && frame->payload.length() == 4
+               ? readUint32(frame->payload, 0)
+               : 0xffffffff;
+}
+
+/// A session that has received the SETTINGS of the client.
+struct TestConnection
+{
+    explicit TestConnection(
+        const std::vector<std::pair<uint16_t, uint32_t>> &settings = {})
+        : conn(std::make_shared<MockConnection>(nullptr)), session(conn)
+    {
+        session.start();
+        client.send(session, client.preface(settings));
+        conn->takeFrames();
+    }
+
+    std::shared_ptr<MockConnection> conn;
+    TestSession session;
+    TestClient client;
+};
+
+/// A server session on a connection of an event loop, the session is driven
+/// in the loop like on a real connection.
+struct TestServerConnection
+{
+    TestServerConnection()
+    {
+        loopThread.run();
+        conn = std::make_shared<MockConnection>(loopThread.getLoop());
+        runInLoop([this]() {
+            session = std::make_shared<Http2ServerSession>(
+                conn,
+                [this](const std::shared_ptr<Http2ServerSession> &,
+                       const HttpRequestImplPtr &req,
+                       uint32_t streamId) {
+                    requests.emplace_back(req, streamId);
+                });
+            session->start();
+            client.send(*session, client.preface());
+        });
+        conn->takeFrames();
+    }
+    ~TestServerConnection()
+    {
+        runInLoop([this]() {
+            session->onClose();
+            session.reset();
+        });
+    }
+    bool send(const std::string &data)
+    {
+        bool ok = false;
+        runInLoop([this, &data, &ok]() { ok = client.send(*session, data); });
+        return ok;
+    }
+    void runInLoop(std::function<void()> &&func)
+    {
+        std::promise<void> done;
+        loopThread.getLoop()->runInLoop([&func, &done]() {
+            func();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    trantor::EventLoopThread loopThread;
+    std::shared_ptr<MockConnection> conn;
+    std::shared_ptr<Http2ServerSession> session;
+    TestClient client;
+    std::vector<std::pair<HttpRequestImplPtr, uint32_t>> requests;
+};
+}  // namespace
+
+DROGON_TEST(Http2SessionSettingsTest)
+{
+    auto conn = std::make_shared<MockConnection>(nullptr);
+    TestSession session(conn);
+    TestClient client;
+
+    // The SETTINGS of the server and the enlarged connection window
+    session.start();
+    auto frames = conn->takeFrames();
+    REQUIRE(frames.size() == 2UL);
+    CHECK(frames[0].type == kSettings);
+    CHECK(frames[0].flags == 0);
+    REQUIRE(frames[0].payload.length() % 6 == 0UL);
+    uint32_t maxStreams = 0;
+    for (size_t i = 0; i < frames[0].payload.length(); i += 6)
+    {
+        if (frames[0].payload[i] == 0 && frames[0].payload[i + 1] == 0x3)
+            maxStreams = readUint32(frames[0].payload, i + 2);
+    }
+    CHECK(maxStreams == 100U);
+    CHECK(frames[1].type == kWindowUpdate);
+    CHECK(frames[1].streamId == 0U);
+    CHECK(readUint32(frames[1].payload, 0) == 1024UL * 1024 - 65535);
+
+    // The preface and the SETTINGS may arrive in pieces
+    auto preface = client.preface({{0x4, 1000}});
+    CHECK(client.send(session, preface.substr(0, 10)));
+    CHECK(client.send(session, preface.substr(10, 20)));
+    CHECK(!session.settingsReceived());
+    CHECK(client.send(session, preface.substr(30)));
+    CHECK(session.settingsReceived());
+    frames = conn->takeFrames();
+    REQUIRE(frames.size() == 1UL);
+    CHECK(frames[0].type == kSettings);
+    CHECK(frames[0].flags == kAck);
+    CHECK(frames[0].payload.empty());
+
+    // A PING is echoed
+    CHECK(client.send(session, makeFrame(kPing, 0, 0, "12345678")));
+    frames = conn->takeFrames();
+    REQUIRE(frames.size() == 1UL);
+    CHECK(frames[0].type == kPing);
+    CHECK(frames[0].flags == kAck);
+    CHECK(frames[0].payload == "12345678");
+
+    // The ACK of the SETTINGS of the server is not answered
+    CHECK(client.send(session, makeFrame(kSettings, kAck, 0)));
+    CHECK(conn->takeFrames().empty());
+    CHECK(!session.closed());
+}
+
+DROGON_TEST(Http2SessionPrefaceErrorTest)
+{
+    // The first frame must be SETTINGS
+    {
+        auto conn = std::make_shared<MockConnection>(nullptr);
+        TestSession session(conn);
+        TestClient client;
+        session.start();
+        conn->takeFrames();
+        CHECK(client.send(session,
+                          std::string(Http2Session::kClientPreface.data(),
+                                      Http2Session::kClientPreface.length()) +
+                              client.request(1)) == false);
+        CHECK(goAwayError(conn->takeFrames()) == Http2Session::kProtocolError);
+        CHECK(session.closed());
+        CHECK(conn->isShutdown());
+        CHECK(session.headers_.empty());
+    }
+    // A HTTP/1.1 request is not a preface
+    {
+        auto conn = std::make_shared<MockConnection>(nullptr);
+        TestSession session(conn);
+        TestClient client;
+        session.start();
+        conn->takeFrames();
+        CHECK(client.send(session,
+                          "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n") ==
+              false);
+        CHECK(goAwayError(conn->takeFrames()) == Http2Session::kProtocolError);
+        CHECK(session.closed());
+    }
+    // Invalid settings
+    {
+        TestConnection test({{0x5, 100}});
+        CHECK(test.session.closed());
+        TestConnection test2;
+        CHECK(test2.client.send(test2.session,
+                                makeFrame(kSettings, 0, 0, "12345")) ==
+              false);
+        CHECK(goAwayError(test2.conn->takeFrames()) ==
+              Http2Session::kFrameSizeError);
+    }
+}
+
+DROGON_TEST(Http2SessionSendWindowTest)
+{
+    // The stream window of the client is 10 bytes
+    TestConnection test({{0x4, 10}});
+    auto &session = test.session;
+    auto &client = test.client;
+    auto &conn = test.conn;
+    CHECK(client.send(session, client.request(1)));
+    REQUIRE(session.headers_.count(1) == 1UL);
+    session.sendHeaders(1, {{":status", "200"}}, false);
+    session.sendBody(1, 100);
+    auto frames = conn->takeFrames();
+    CHECK(findFrame(frames, kHeaders, 1) != nullptr);
+    CHECK(dataLength(frames, 1) == 10UL);
+
+    CHECK(client.send(session, makeUint32Frame(kWindowUpdate, 1, 50)));
+    CHECK(dataLength(conn->takeFrames(), 1) == 50UL);
+    CHECK(session.closedStreams_.empty());
+
+    CHECK(client.send(session, makeUint32Frame(kWindowUpdate, 1, 100)));
+    frames = conn->takeFrames();
+    REQUIRE(frames.size() == 1UL);
+    CHECK(frames[0].payload.length() == 40UL);
+    CHECK(frames[0].flags == kEndStream);
+    REQUIRE(session.closedStreams_.count(1) == 1UL);
+    CHECK(session.closedStreams_[1] == Http2Session::kNoError);
+
+    // The new initial window applies to the streams, the connection window
+    // of 65535 bytes is shared by all of them
+    CHECK(client.send(session, makeSettings({{0x4, 1 << 20}})));
+    CHECK(client.send(session, client.request(3)));
+    conn->takeFrames();
+    session.sendHeaders(3, {{":status", "200"}}, false);
+    session.sendBody(3, 100000);
+    frames = conn->takeFrames();
+    CHECK(dataLength(frames, 3) == 65535UL - 100);
+    for (auto &frame : frames)
+        CHECK(frame.payload.length() <= 16384UL);
+    CHECK(session.closedStreams_.count(3) == 0UL);
+    CHECK(client.send(session, makeUint32Frame(kWindowUpdate, 0, 1 << 20)));
+    CHECK(dataLength(conn->takeFrames(), 3) == 100000UL - 65535 + 100);
+    CHECK(session.closedStreams_.count(3) == 1UL);
+
+    // The window must not overflow
+    CHECK(client.send(session,
+                      makeUint32Frame(kWindowUpdate, 0, 0x7fffffff)) ==
+          false);
+    CHECK(goAwayError(conn->takeFrames()) == Http2Session::kFlowControlError);
+}
+
+DROGON_TEST(Http2SessionReceiveWindowTest)
+{
+    TestConnection test;
+    auto &session = test.session;
+    auto &client = test.client;
+    auto &conn = test.conn;
+    CHECK(client.send(session, client.request(1, false)));
+
+    // The windows are renewed when half of them is consumed
+    std::string data(16384, 'd');
+    for (int i = 0; i < 31; ++i)
+        CHECK(client.send(session, makeFrame(kData, 0, 1, data)));
+    CHECK(conn->takeFrames().empty());
+    CHECK(client.send(session, makeFrame(kData, 0, 1, data)));
+    auto frames = conn->takeFrames();
+    auto connectionUpdate = findFrame(frames, kWindowUpdate, 0);
+    auto streamUpdate = findFrame(frames, kWindowUpdate, 1);
+    REQUIRE(connectionUpdate != nullptr);
+    REQUIRE(streamUpdate != nullptr);
+    CHECK(readUint32(connectionUpdate->payload, 0) == 32UL * 16384);
+    CHECK(readUint32(streamUpdate->payload, 0) == 32UL * 16384);
+
+    // So a body larger than the windows is received
+    for (int i = 0; i < 200; ++i)
+        CHECK(client.send(session, makeFrame(kData, 0, 1, data)));
+    CHECK(client.send(session, makeFrame(kData, kEndStream, 1, "end")));
+    CHECK(session.bodies_[1].length() == 232UL * 16384 + 3);
+    CHECK(!session.closed());
+
+    // DATA on a stream that was never opened is a connection error
+    CHECK(client.send(session, makeFrame(kData, 0, 3, "data")) == false);
+    CHECK(goAwayError(conn->takeFrames()) == Http2Session::kProtocolError);
+}
+
+DROGON_TEST(Http2SessionContinuationTest)
+{
+    TestConnection test;
+    auto &session = test.session;
+    auto &client = test.client;
+    auto &conn = test.conn;
+
+    // A header block in a HEADERS frame and two CONTINUATION frames
+    std::string block;
+    client.encoder_.encode({{":method", "GET"},
+                            {":scheme", "http"},
+                            {":path", "/continued"},
+                            {"x-long", std::string(100, 'a')}},
+                           block);
+    REQUIRE(block.length() > 20UL);
+    CHECK(client.send(session,
+                      makeFrame(kHeaders, kEndStream, 1, block.substr(0, 10))));
+    CHECK(session.headers_.empty());
+    CHECK(client.send(session,
+                      makeFrame(kContinuation, 0, 1, block.substr(10, 10))));
+    CHECK(session.headers_.empty());
+    CHECK(client.send(session,
+                      makeFrame(kContinuation,
+                                kEndHeaders,
+                                1,
+                                block.substr(20))));
+    REQUIRE(session.headers_.count(1) == 1UL);
+    auto &headers = session.headers_[1];
+    REQUIRE(headers.size() == 4UL);
+    CHECK(headers[2].second == "/continued");
+    CHECK(headers[3].second == std::string(100, 'a'));
+
+    // A header block larger than a frame is sent in CONTINUATION frames
+    std::string value;
+    for (int i = 0; i < 40000; ++i)
+        value += static_cast<char>('!' + (i * 7919) % 90);
+    session.sendHeaders(1, {{":status", "200"}, {"x-big", value}}, true);
+    session.flush();
+    auto frames = conn->takeFrames();
+    REQUIRE(frames.size() >= 2UL);
+    CHECK(frames[0].type == kHeaders);
+    CHECK(frames[0].flags == kEndStream);
+    std::string received = frames[0].payload;
+    for (size_t i = 1; i < frames.size(); ++i)
+    {
+        CHECK(frames[i].type == kContinuation);
+        CHECK(frames[i].streamId == 1U);
+        CHECK(frames[i].flags == (i + 1 == frames.size() ? kEndHeaders : 0));
+        CHECK(frames[i].payload.length() <= 16384UL);
+        received += frames[i].payload;
+    }
+    HpackDecoder decoder(4096, 64 * 1024);
+    HpackHeaders responseHeaders;
+    CHECK(decoder.decode(received.data(), received.length(), responseHeaders));
+    REQUIRE(responseHeaders.size() == 2UL);
+    CHECK(responseHeaders[1].second == value);
+
+    // No other frame can be interleaved with a header block
+    block.clear();
+    client.encoder_.encode({{":method", "GET"},
+                            {":scheme", "http"},
+                            {":path", "/"}},
+                           block);
+    CHECK(client.send(session, makeFrame(kHeaders, kEndStream, 3, block)));
+    CHECK(client.send(session, makeFrame(kPing, 0, 0, "12345678")) == false);
+    CHECK(goAwayError(conn->takeFrames()) == Http2Session::kProtocolError);
+    CHECK(session.headers_.count(3) == 0UL);
+
+    // CONTINUATION without HEADERS
+    TestConnection test2;
+    CHECK(test2.client.send(test2.session,
+                            makeFrame(kContinuation, kEndHeaders, 1)) ==
+          false);
+    CHECK(goAwayError(test2.conn->takeFrames()) ==
+          Http2Session::kProtocolError);
+}
+
+DROGON_TEST(Http2SessionStreamLimitTest)
+{
+    TestConnection test;
+    auto &session = test.session;
+    auto &client = test.client;
+    auto &conn = test.conn;
+
+    std::string requests;
+    for (uint32_t id = 1; id <= 201; id += 2)
+        requests += client.request(id);
+    CHECK(client.send(session, requests));
+    CHECK(session.numberOfStreams() == 100UL);
+    CHECK(session.headers_.size() == 100UL);
+    CHECK(session.headers_.count(201) == 0UL);
+    auto frames = conn->takeFrames();
+    REQUIRE(frames.size() == 1UL);
+    CHECK(rstStreamError(frames, 201) == Http2Session::kRefusedStream);
+
+    // A new stream is accepted after another one is closed
+    session.sendHeaders(1, {{":status", "204"}}, true);
+    session.flush();
+    conn->takeFrames();
+    CHECK(session.numberOfStreams() == 99UL);
+    CHECK(client.send(session, client.request(203)));
+    CHECK(session.numberOfStreams() == 100UL);
+    CHECK(session.headers_.count(203) == 1UL);
+    CHECK(conn->takeFrames().empty());
+}
+
+DROGON_TEST(Http2SessionRstStreamTest)
+{
+    TestConnection test;
+    auto &session = test.session;
+    auto &client = test.client;
+    auto &conn = test.conn;
+
+    CHECK(client.send(session, client.request(1, false)));
+    CHECK(client.send(session,
+                      makeUint32Frame(kRstStream, 1, Http2Session::kCancel)));
+    REQUIRE(session.closedStreams_.count(1) == 1UL);
+    CHECK(session.closedStreams_[1] == Http2Session::kCancel);
+    CHECK(session.numberOfStreams() == 0UL);
+
+    // Nothing is sent on a reset stream
+    session.sendHeaders(1, {{":status", "200"}}, false);
+    session.sendBody(1, 10);
+    CHECK(conn->takeFrames().empty());
+
+    // DATA on a closed stream is refused
+    CHECK(client.send(session, makeFrame(kData, kEndStream, 1, "late")));
+    CHECK(rstStreamError(conn->takeFrames(), 1) ==
+          Http2Session::kStreamClosed);
+    CHECK(session.bodies_.count(1) == 0UL);
+
+    // RST_STREAM on a stream that was never opened is a connection error
+    CHECK(client.send(session,
+                      makeUint32Frame(kRstStream, 9, Http2Session::kCancel)) ==
+          false);
+    CHECK(goAwayError(conn->takeFrames()) == Http2Session::kProtocolError);
+    CHECK(conn->isShutdown());
+}
+
+DROGON_TEST(Http2SessionGoAwayTest)
+{
+    TestConnection test;
+    auto &session = test.session;
+    auto &client = test.client;
+    auto &conn = test.conn;
+    CHECK(client.send(session, client.request(1, false)));
+
+    // After the GOAWAY of the client, the open streams are completed and the
+    // new ones are refused
+    std::string payload;
+    appendUint32(payload, 0);
+    appendUint32(payload, Http2Session::kNoError);
+    CHECK(client.send(session, makeFrame(kGoAway, 0, 0, payload)));
+    CHECK(session.goAwayError_ == Http2Session::kNoError);
+    CHECK(client.send(session, client.request(3)));
+    CHECK(rstStreamError(conn->takeFrames(), 3) ==
+          Http2Session::kRefusedStream);
+    CHECK(session.headers_.count(3) == 0UL);
+    CHECK(client.send(session, makeFrame(kData, kEndStream, 1, "body")));
+    CHECK(session.bodies_[1] == "body");
+
+    // A connection error is reported by GOAWAY with the last stream of the
+    // client, the open streams are closed
+    CHECK(client.send(session,
+                      makeFrame(kData, 0, 1, std::string(20000, 'x'))) ==
+          false);
+    auto frames = conn->takeFrames();
+    auto goAway = findFrame(frames, kGoAway, 0);
+    REQUIRE(goAway != nullptr);
+    CHECK(readUint32(goAway->payload, 0) == 3UL);
+    CHECK(readUint32(goAway->payload, 4) == Http2Session::kFrameSizeError);
+    REQUIRE(session.closedStreams_.count(1) == 1UL);
+    CHECK(session.closedStreams_[1] == Http2Session::kFrameSizeError);
+    CHECK(session.closed());
+    CHECK(conn->isShutdown());
+    CHECK(client.send(session, client.request(5)) == false);
+    CHECK(conn->takeFrames().empty());
+}
+
+DROGON_TEST(Http2ServerSessionRequestTest)
+{
+    TestServerConnection test;
+    CHECK(test.send(test.client.headers(1,
+                                        {{":method", "POST"},
+                                         {":scheme", "http"},
+                                         {":path", "/api/echo?a=1"},
+                                         {":authority", "example.com"},
+                                         {"x-test", "test"}},
+                                        kEndHeaders)));
+    CHECK(test.requests.empty());
+    CHECK(test.send(makeFrame(kData, 0, 1, "hello, ") +
+                    makeFrame(kData, kEndStream, 1, "world")));
+    REQUIRE(test.requests.size() == 1UL);
+    auto req = test.requests[0].first;
+    CHECK(test.requests[0].second == 1U);
+    CHECK(req->method() == Post);
+    CHECK(req->version() == Version::kHttp2);
+    CHECK(req->path() == "/api/echo");
+    CHECK(req->query() == "a=1");
+    CHECK(req->getHeader("host") == "example.com");
+    CHECK(req->getHeader("x-test") == "test");
+    CHECK(req->body() == "hello, world");
+
+    // The request is forwarded as a HTTP/1.1 request with the length of its
+    // body
+    req->setPassThrough(true);
+    trantor::MsgBuffer buffer;
+    req->appendToBuffer(&buffer);
+    std::string forwarded(buffer.peek(), buffer.readableBytes());
+    CHECK(forwarded.find("POST /api/echo?a=1 HTTP/1.1\r\n") == 0UL);
+    CHECK(forwarded.find("\r\ncontent-length: 12\r\n") != std::string::npos);
+    CHECK(forwarded.find("\r\nhost: example.com\r\n") != std::string::npos);
+    CHECK(forwarded.find("\r\n\r\nhello, world") ==
+          forwarded.length() - 16);
+
+    // The response is sent on the stream of the request
+    test.runInLoop([&test]() {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setBody("response body");
+        resp->addHeader("x-response", "1");
+        test.session->sendResponse(1, resp, false);
+    });
+    auto frames = test.conn->takeFrames();
+    REQUIRE(frames.size() == 2UL);
+    CHECK(frames[0].type == kHeaders);
+    CHECK(frames[0].flags == kEndHeaders);
+    HpackDecoder decoder(4096, 64 * 1024);
+    HpackHeaders headers;
+    CHECK(decoder.decode(frames[0].payload.data(),
+                         frames[0].payload.length(),
+                         headers));
+    REQUIRE(!headers.empty());
+    CHECK(headers[0].first == ":status");
+    CHECK(headers[0].second == "200");
+    std::string responseHeader;
+    for (auto &header : headers)
+    {
+        CHECK(header.first != "connection");
+        if (header.first == "x-response")
+            responseHeader = header.second;
+    }
+    CHECK(responseHeader == "1");
+    CHECK(frames[1].type == kData);
+    CHECK(frames[1].flags == kEndStream);
+    CHECK(frames[1].payload == "response body");
+}
+
+DROGON_TEST(Http2ServerSessionMalformedRequestTest)
+{
+    TestServerConnection test;
+    auto &client = test.client;
+    // A name in upper case
+    CHECK(test.send(client.headers(1,
+                                   {{":method", "GET"},
+                                    {":scheme", "http"},
+                                    {":path", "/"},
+                                    {"X-Upper", "1"}})));
+    // A connection-specific header
+    CHECK(test.send(client.headers(3,
+                                   {{":method", "GET"},
+                                    {":scheme", "http"},
+                                    {":path", "/"},
+                                    {"connection", "keep-alive"}})));
+    // No :path
+    CHECK(test.send(
+        client.headers(5, {{":method", "GET"}, {":scheme", "http"}})));
+    // A body longer than the content-length
+    CHECK(test.send(client.headers(7,
+                                   {{":method", "POST"},
+                                    {":scheme", "http"},
+                                    {":path", "/"},
+                                    {"content-length", "2"}},
+                                   kEndHeaders) +
+                    makeFrame(kData, kEndStream, 7, "abc")));
+    // A body shorter than the content-length
+    CHECK(test.send(client.headers(9,
+                                   {{":method", "POST"},
+                                    {":scheme", "http"},
+                                    {":path", "/"},
+                                    {"content-length", "4"}},
+                                   kEndHeaders) +
+                    makeFrame(kData, kEndStream, 9, "abc")));
+    CHECK(test.requests.empty());
+    auto frames = test.conn->takeFrames();
+    for (uint32_t id = 1; id <= 9; id += 2)
+        CHECK(rstStreamError(frames, id) == Http2Session::kProtocolError);
+    CHECK(!test.session->closed());
+}
+
+DROGON_TEST(Http2ServerSessionStreamLimitTest)
+{
+    TestServerConnection test;
+    std::string data;
+    for (uint32_t id = 1; id <= 201; id += 2)
+        data += test.client.request(id);
+    CHECK(test.send(data));
+    CHECK(test.requests.size() == 100UL);
+    CHECK(rstStreamError(test.conn->takeFrames(), 201) ==
+          Http2Session::kRefusedStream);
+
+    // The response to a stream reset by the client is dropped, a new stream
+    // is accepted after two are closed
+    CHECK(test.send(makeUint32Frame(kRstStream, 1, Http2Session::kCancel)));
+    test.runInLoop([&test]() {
+        test.session->sendResponse(1, HttpResponse::newHttpResponse(), false);
+        test.session->sendResponse(3, HttpResponse::newHttpResponse(), false);
+    });
+    auto frames = test.conn->takeFrames();
+    CHECK(findFrame(frames, kHeaders, 1) == nullptr);
+    CHECK(findFrame(frames, kHeaders, 3) != nullptr);
+    CHECK(test.send(test.client.request(203)));
+    CHECK(test.requests.size() == 101UL);
+    CHECK(test.requests.back().second == 203U);
+}
@@ -0,0 +1,95 @@
+#include <drogon/HttpBinder.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/drogon_test.h>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+enum class Color
+{
+    Red,
+    Green,
+    Blue
+};
+
+DROGON_TEST(HttpBinderTest)
+{
+    int i = 0;
+    unsigned short us = 0;
+    double d = 0.0;
+    bool b = false;
+    std::string str;
+    string_view view;
+    Color color = Color::Red;
+    char c = 0;
+    auto handler = [&](const HttpRequestPtr &,
+                       std::function<void(const HttpResponsePtr &)> &&,
+                       int iArg,
+                       unsigned short usArg,
+                       double dArg,
+                       bool bArg,
+                       std::string strArg,
+                       string_view viewArg,
+                       Color colorArg,
+                       char cArg) {
+        i = iArg;
+        us = usArg;
+        d = dArg;
+        b = bArg;
+        str = std::move(strArg);
+        view = viewArg;
+        color = colorArg;
+        c = cArg;
+    };
+    internal::HttpBinder<decltype(handler)> binder(std::move(handler));
+    auto req = HttpRequest::newHttpRequest();
+    std::string path = "/api/-42/8080/2.5/true/name/view/2/x";
+    std::vector<string_view> args{string_view(path.data() + 5, 3),
+                                  string_view(path.data() + 9, 4),
+                                  string_view(path.data() + 14, 3),
+                                  string_view(path.data() + 18, 4),
+                                  string_view(path.data() + 23, 4),
+                                  string_view(path.data() + 28, 4),
+                                  string_view(path.data() + 33, 1),
+                                  string_view(path.data() + 35, 1)};
+    binder.handleHttpRequest(args, req, [](const HttpResponsePtr &) {});
+    CHECK(i == -42);
+    CHECK(us == 8080);
+    CHECK(d == 2.5);
+    CHECK(b == true);
+    CHECK(str == "name");
+    CHECK(view.data() == path.data() + 28);
+    CHECK(view == "view");
+    CHECK(color == Color::Blue);
+    CHECK(c == 'x');
+
+    SUBSECTION(Leniency)
+    {
+        // Like std::stoi(), leading spaces and trailing characters are allowed
+        args[0] = " +7px";
+        binder.handleHttpRequest(args, req, [](const HttpResponsePtr &) {});
+        CHECK(i == 7);
+    }
+
+    SUBSECTION(InvalidNumber)
+    {
+        bool called = false;
+        auto checkInvalid = [&](size_t index, string_view value) {
+            auto invalidArgs = args;
+            invalidArgs[index] = value;
+            i = 1;
+            called = false;
+            binder.handleHttpRequest(invalidArgs,
+                                     req,
+                                     [&called](const HttpResponsePtr &) {
+                                         called = true;
+                                     });
+            CHECK(i == 1);
+            CHECK(called == true);
+        };
+        checkInvalid(0, "abc");
+        checkInvalid(1, "65536");
+        checkInvalid(2, "x1.5");
+    }
+}
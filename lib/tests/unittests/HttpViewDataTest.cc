@@ -27,6 +27,15 @@ DROGON_TEST(HttpViewData)
     // Bad key returns a default constructed value
     CHECK_NOTHROW(data.get<int>("this_does_not_exist"));
 
+    SUBSECTION(StringView)
+    {
+        data.insert("7", "seven");
+        CHECK(data.getStringView("5") == "5!!!!!!!");
+        CHECK(data.getStringView("7") == "seven");
+        CHECK(data.getStringView("1").empty());
+        CHECK(data.getStringView("this_does_not_exist").empty());
+    }
+
     SUBSECTION(Translate)
     {
         CHECK(HttpViewData::needTranslation("") == false);
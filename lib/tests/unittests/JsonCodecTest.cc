@@ -0,0 +1,104 @@
+#include <drogon/JsonCodec.h>
+#include <drogon/drogon_test.h>
+#include <json/json.h>
+#include <limits>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+static std::string writeByJsoncpp(const Json::Value &value,
+                                  bool escapeUnicode,
+                                  unsigned int precision = 0,
+                                  const std::string &precisionType = "")
+{
+    Json::StreamWriterBuilder builder;
+    builder["commentStyle"] = "None";
+    builder["indentation"] = "";
+    if (!escapeUnicode)
+        builder["emitUTF8"] = true;
+    if (precision != 0)
+    {
+        builder["precision"] = precision;
+        builder["precisionType"] = precisionType;
+    }
+    return Json::writeString(builder, value);
+}
+
+DROGON_TEST(JsonCodecTest)
+{
+    Json::Value value;
+    value["int"] = -42;
+    value["min"] = std::numeric_limits<Json::Int64>::min();
+    value["uint"] = std::numeric_limits<Json::UInt64>::max();
+    value["real"] = 0.1;
+    value["integral real"] = 3.0;
+    value["big real"] = 1e300;
+    value["bool"] = true;
+    value["null"] = Json::nullValue;
+    value["string"] = "quote\" backslash\\ tab\t \x01 slash/";
+    value["unicode"] = "\xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80";
+    value["invalid utf8"] = "\xe4\xb8";
+    value["array"].append(1);
+    value["array"].append("two");
+    value["array"].append(Json::Value(Json::objectValue));
+    value["empty array"] = Json::Value(Json::arrayValue);
+    value["nested"]["key"]["key"] = "value";
+    value["es\xc3\xa7" "aped key\n"] = 1;
+
+    SUBSECTION(SameAsJsoncpp)
+    {
+        for (auto escapeUnicode : {true, false})
+        {
+            DefaultJsonCodec codec(escapeUnicode);
+            std::string output;
+            codec.serialize(value, output);
+            CHECK(output == writeByJsoncpp(value, escapeUnicode));
+        }
+    }
+
+    SUBSECTION(Precision)
+    {
+        Json::Value reals;
+        reals.append(3.14159);
+        reals.append(2.0);
+        reals.append(1e-7);
+        reals.append(-123456.789);
+        DefaultJsonCodec significant(true, 4, "significant");
+        std::string output;
+        significant.serialize(reals, output);
+        CHECK(output == writeByJsoncpp(reals, true, 4, "significant"));
+        DefaultJsonCodec decimal(true, 3, "decimal");
+        output.clear();
+        decimal.serialize(reals, output);
+        CHECK(output == writeByJsoncpp(reals, true, 3, "decimal"));
+    }
+
+    SUBSECTION(Append)
+    {
+        DefaultJsonCodec codec;
+        std::string output = "prefix";
+        codec.serialize(Json::Value(1), output);
+        CHECK(output == "prefix1");
+    }
+
+    SUBSECTION(Parse)
+    {
+        DefaultJsonCodec codec;
+        // The invalid UTF-8 sequence is replaced by U+FFFD.
+        value.removeMember("invalid utf8");
+        std::string text;
+        codec.serialize(value, text);
+        Json::Value parsed;
+        std::string errs;
+        CHECK(codec.parse(text.data(), text.data() + text.size(), parsed, errs));
+        CHECK(parsed == value);
+
+        std::string invalid = "{\"key\":";
+        CHECK(codec.parse(invalid.data(),
+                          invalid.data() + invalid.size(),
+                          parsed,
+                          errs) == false);
+        CHECK(errs.empty() == false);
+    }
+}
@@ -0,0 +1,152 @@
+#include <drogon/JsonTraits.h>
+#include <drogon/drogon_test.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class Role
+{
+    Guest,
+    Admin
+};
+
+struct Address
+{
+    std::string city;
+    int zip{0};
+};
+
+struct User
+{
+    std::string name;
+    int64_t id{0};
+    double score{0.0};
+    bool active{false};
+    Role role{Role::Guest};
+    std::vector<std::string> tags;
+    std::map<std::string, int> counters;
+    std::shared_ptr<Address> address;
+    drogon::optional<int> age;
+    Json::Value extra;
+    std::string nickname_;
+};
+
+namespace drogon
+{
+template <>
+struct JsonFields<Address>
+{
+    static auto fields()
+    {
+        return std::make_tuple(DROGON_JSON_FIELD(Address, city),
+                               DROGON_JSON_FIELD(Address, zip));
+    }
+};
+
+template <>
+struct JsonFields<User>
+{
+    static auto fields()
+    {
+        return std::make_tuple(
+            DROGON_JSON_FIELD(User, name),
+            DROGON_JSON_FIELD(User, id),
+            DROGON_JSON_FIELD(User, score),
+            DROGON_JSON_FIELD(User, active),
+            DROGON_JSON_FIELD(User, role),
+            DROGON_JSON_FIELD(User, tags),
+            DROGON_JSON_FIELD(User, counters),
+            DROGON_JSON_FIELD(User, address),
+            DROGON_JSON_FIELD(User, age),
+            DROGON_JSON_FIELD(User, extra),
+            makeJsonField(
+                "nickname",
+                [](const User &user) -> const std::string & {
+                    return user.nickname_;
+                },
+                [](User &user, std::string &&nickname) {
+                    user.nickname_ = std::move(nickname);
+                }));
+    }
+};
+}  // namespace drogon
+
+using namespace drogon;
+
+DROGON_TEST(JsonTraitsTest)
+{
+    User user;
+    user.name = "Tom \"T\"";
+    user.id = -9007199254740993LL;
+    user.score = 0.5;
+    user.active = true;
+    user.role = Role::Admin;
+    user.tags = {"a", "b"};
+    user.counters["x"] = 1;
+    user.address = std::make_shared<Address>();
+    user.address->city = "\xe5\x8c\x97\xe4\xba\xac";
+    user.address->zip = 100000;
+    user.extra["k"] = Json::arrayValue;
+    user.nickname_ = "tommy";
+
+    DefaultJsonCodec codec(false);
+    std::string text;
+    JsonSerializer<User>::write(codec, user, text);
+    CHECK(text ==
+          "{\"name\":\"Tom \\\"T\\\"\",\"id\":-9007199254740993,"
+          "\"score\":0.5,\"active\":true,\"role\":1,\"tags\":[\"a\",\"b\"],"
+          "\"counters\":{\"x\":1},\"address\":{\"city\":\"\xe5\x8c\x97\xe4\xba"
+          "\xac\",\"zip\":100000},\"age\":null,\"extra\":{\"k\":[]},"
+          "\"nickname\":\"tommy\"}");
+
+    SUBSECTION(RoundTrip)
+    {
+        User parsed;
+        std::string errs;
+        CHECK(readJson(text, parsed, errs));
+        CHECK(errs.empty());
+        CHECK(parsed.name == user.name);
+        CHECK(parsed.id == user.id);
+        CHECK(parsed.score == user.score);
+        CHECK(parsed.active == true);
+        CHECK(parsed.role == Role::Admin);
+        CHECK(parsed.tags == user.tags);
+        CHECK(parsed.counters == user.counters);
+        REQUIRE(parsed.address != nullptr);
+        CHECK(parsed.address->city == user.address->city);
+        CHECK(parsed.address->zip == 100000);
+        CHECK(!parsed.age);
+        CHECK(parsed.extra == user.extra);
+        CHECK(parsed.nickname_ == "tommy");
+    }
+
+    SUBSECTION(Read)
+    {
+        User parsed;
+        std::string errs;
+        // Unknown members are skipped, escapes are decoded.
+        CHECK(readJson(" { \"unknown\" : [1, {\"a\": null}], \"age\": 30, "
+                       "\"name\": \"\\u0041\\ud83d\\ude00\\n\" } ",
+                       parsed,
+                       errs));
+        CHECK(parsed.name == "A\xf0\x9f\x98\x80\n");
+        REQUIRE(parsed.age);
+        CHECK(*parsed.age == 30);
+    }
+
+    SUBSECTION(Errors)
+    {
+        Address address;
+        std::string errs;
+        CHECK(readJson("{\"zip\": 1.5}", address, errs) == false);
+        CHECK(readJson("{\"zip\": 99999999999}", address, errs) == false);
+        CHECK(readJson("{\"city\": 1}", address, errs) == false);
+        CHECK(readJson("{\"city\": \"x\"", address, errs) == false);
+        CHECK(readJson("{\"city\": \"x\"} x", address, errs) == false);
+        CHECK(readJson("", address, errs) == false);
+        CHECK(errs.empty() == false);
+        std::string deep(2000, '[');
+        CHECK(readJson("{\"a\":" + deep, address, errs) == false);
+    }
+}
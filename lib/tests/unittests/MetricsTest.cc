@@ -0,0 +1,94 @@
+#include <drogon/Metrics.h>
+#include <drogon/drogon_test.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon::metrics;
+
+DROGON_TEST(MetricsTest)
+{
+    auto &registry = Registry::instance();
+
+    SUBSECTION(Counter)
+    {
+        auto &counter =
+            registry.counter("test_counter_total", "A counter").get();
+        counter.increment();
+        counter.increment(2);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&counter]() {
+                for (int j = 0; j < 1000; ++j)
+                    counter.increment();
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        CHECK(counter.value() == 4003);
+        CHECK(&registry.counter("test_counter_total", "A counter").get() ==
+              &counter);
+    }
+
+    SUBSECTION(Gauge)
+    {
+        auto &gauge = registry.gauge("test_gauge", "A gauge").get();
+        gauge.increment(3);
+        gauge.decrement(0.5);
+        CHECK(gauge.value() == 2.5);
+        gauge.set(10);
+        CHECK(gauge.value() == 10);
+    }
+
+    SUBSECTION(Histogram)
+    {
+        auto &histogram =
+            registry.histogram("test_histogram", "A histogram", {}, {1, 2, 5})
+                .get();
+        histogram.observe(0.5);
+        histogram.observe(1);
+        histogram.observe(3);
+        histogram.observe(100);
+        auto counts = histogram.cumulativeCounts();
+        CHECK(counts == std::vector<uint64_t>({2, 2, 3, 4}));
+        CHECK(histogram.sum() == 104.5);
+    }
+
+    SUBSECTION(Labels)
+    {
+        auto &family = registry.counter("test_labels_total",
+                                        "Counters with labels",
+                                        {"method", "path"});
+        family.get({"GET", "/a\"b"}).increment();
+        family.get({"GET", "/a\"b"}).increment();
+        family.get({"POST", "/c"}).increment();
+        CHECK(family.get({"GET", "/a\"b"}).value() == 2);
+        CHECK_THROWS_AS(family.get({"GET"}), std::invalid_argument);
+        CHECK_THROWS_AS(registry.gauge("test_labels_total", "A gauge"),
+                        std::invalid_argument);
+    }
+
+    SUBSECTION(Render)
+    {
+        std::string output;
+        registry.render(output);
+        CHECK(output.find("# HELP test_counter_total A counter\n"
+                          "# TYPE test_counter_total counter\n"
+                          "test_counter_total 4003\n") != std::string::npos);
+        CHECK(output.find("test_gauge 10\n") != std::string::npos);
+        CHECK(output.find("# TYPE test_histogram histogram\n"
+                          "test_histogram_bucket{le=\"1\"} 2\n"
+                          "test_histogram_bucket{le=\"2\"} 2\n"
+                          "test_histogram_bucket{le=\"5\"} 3\n"
+                          "test_histogram_bucket{le=\"+Inf\"} 4\n"
+                          "test_histogram_sum 104.5\n"
+                          "test_histogram_count 4\n") != std::string::npos);
+        CHECK(output.find("test_labels_total{method=\"GET\",path=\"/a\\\"b\"} "
+                          "2\n") != std::string::npos);
+        CHECK(output.find(
+                  "test_labels_total{method=\"POST\",path=\"/c\"} 1\n") !=
+              std::string::npos);
+    }
+}
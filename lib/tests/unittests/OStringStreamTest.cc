@@ -1,6 +1,8 @@
 #include <drogon/utils/OStringStream.h>
 #include <drogon/drogon_test.h>
+#include <limits>
 #include <string>
+#include <stdint.h>
 #include <iostream>
 
 DROGON_TEST(OStringStreamTest)
@@ -13,6 +15,16 @@ DROGON_TEST(OStringStreamTest)
         CHECK(ss.str() == "12345");
     }
 
+    SUBSECTION(integer_limits)
+    {
+        drogon::OStringStream ss;
+        ss << std::numeric_limits<int64_t>::min() << " ";
+        ss << std::numeric_limits<uint64_t>::max() << " ";
+        ss << static_cast<short>(-7) << " " << true;
+        CHECK(ss.str() ==
+              "-9223372036854775808 18446744073709551615 -7 1");
+    }
+
     SUBSECTION(float_number)
     {
         drogon::OStringStream ss;
@@ -21,6 +33,17 @@ DROGON_TEST(OStringStreamTest)
         CHECK(ss.str() == "3.143.1416");
     }
 
+    SUBSECTION(float_number_lvalue)
+    {
+        // The same format as std::ostream
+        drogon::OStringStream ss;
+        double d = 0.1 + 0.2;
+        const double big = 1e21;
+        float f = 100.0f;
+        ss << d << " " << big << " " << f << " " << 1.0 / 3;
+        CHECK(ss.str() == "0.3 1e+21 100 0.333333");
+    }
+
     SUBSECTION(literal_string)
     {
         drogon::OStringStream ss;
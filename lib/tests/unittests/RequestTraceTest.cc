@@ -0,0 +1,114 @@
+#include <drogon/RequestTrace.h>
+#include <drogon/drogon_test.h>
+#include <json/json.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace drogon;
+
+DROGON_TEST(RequestTraceTest)
+{
+    SUBSECTION(Ids)
+    {
+        RequestTrace trace;
+        CHECK(trace.traceId().length() == 32U);
+        CHECK(trace.spanId().length() == 16U);
+        CHECK(trace.parentSpanId().empty());
+        RequestTrace other;
+        CHECK(trace.traceId() != other.traceId());
+    }
+
+    SUBSECTION(TraceParent)
+    {
+        RequestTrace trace;
+        trace.setTraceParent(
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+        CHECK(trace.traceId() == "4bf92f3577b34da6a3ce929d0e0e4736");
+        CHECK(trace.parentSpanId() == "00f067aa0ba902b7");
+
+        // Invalid headers are ignored
+        RequestTrace invalid;
+        auto traceId = invalid.traceId();
+        invalid.setTraceParent("00-4bf92f3577b34da6a3ce929d0e0e4736");
+        invalid.setTraceParent(
+            "00-00000000000000000000000000000000-00f067aa0ba902b7-01");
+        invalid.setTraceParent(
+            "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01");
+        CHECK(invalid.traceId() == traceId);
+        CHECK(invalid.parentSpanId().empty());
+    }
+
+    SUBSECTION(Stages)
+    {
+        RequestTrace trace;
+        CHECK(trace.reached(RequestTrace::kParsed));
+        CHECK(trace.elapsed(RequestTrace::kParsed) == 0);
+        CHECK(!trace.reached(RequestTrace::kFiltering));
+        CHECK(trace.elapsed(RequestTrace::kFiltering) == -1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        trace.mark(RequestTrace::kHandling);
+        CHECK(trace.reached(RequestTrace::kHandling));
+        CHECK(trace.elapsed(RequestTrace::kHandling) >= 2000000);
+        CHECK(std::string(RequestTrace::stageName(RequestTrace::kHandling)) ==
+              "handling");
+    }
+
+    SUBSECTION(OtlpJson)
+    {
+        RequestTrace trace;
+        trace.mark(RequestTrace::kRouting);
+        trace.mark(RequestTrace::kHandling);
+        trace.mark(RequestTrace::kSent);
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/api/users");
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k503ServiceUnavailable);
+
+        Json::Value root;
+        std::string errors;
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        auto json = trace.toOtlpJson(*req, *resp);
+        REQUIRE(reader->parse(json.data(),
+                              json.data() + json.length(),
+                              &root,
+                              &errors));
+        auto &spans = root["resourceSpans"][0]["scopeSpans"][0]["spans"];
+        // The request and the parsed, routing and handling stages
+        REQUIRE(spans.size() == 4U);
+        CHECK(spans[0]["name"].asString() == "GET /api/users");
+        CHECK(spans[0]["traceId"].asString() == trace.traceId());
+        CHECK(spans[0]["spanId"].asString() == trace.spanId());
+        CHECK(spans[0]["status"]["code"].asInt() == 2);
+        CHECK(spans[2]["name"].asString() == "routing");
+        CHECK(spans[2]["parentSpanId"].asString() == trace.spanId());
+        CHECK(spans[3]["name"].asString() == "handling");
+        CHECK(spans[3]["endTimeUnixNano"].asString() ==
+              spans[0]["endTimeUnixNano"].asString());
+    }
+
+    SUBSECTION(OtlpBatch)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/api/users");
+        auto resp = HttpResponse::newHttpResponse();
+        RequestTrace first;
+        first.mark(RequestTrace::kSent);
+        RequestTrace second;
+        second.mark(RequestTrace::kHandling);
+        second.mark(RequestTrace::kSent);
+        // The spans of several traces are appended to one array, the request
+        // spans are followed by their stages.
+        Json::Value spans(Json::arrayValue);
+        first.appendOtlpSpans(spans, *req, *resp);
+        second.appendOtlpSpans(spans, *req, *resp);
+        REQUIRE(spans.size() == 5U);
+        CHECK(spans[0]["spanId"].asString() == first.spanId());
+        CHECK(spans[1]["parentSpanId"].asString() == first.spanId());
+        CHECK(spans[2]["spanId"].asString() == second.spanId());
+        CHECK(spans[3]["traceId"].asString() == second.traceId());
+        CHECK(spans[4]["name"].asString() == "handling");
+    }
+}
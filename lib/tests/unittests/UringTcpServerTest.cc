@@ -0,0 +1,263 @@
+#include "../../lib/src/IoUring.h"
+#include "../../lib/src/UringTcpServer.h"
+#include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+
+using namespace drogon;
+
+namespace
+{
+/// A blocking client connected to the server on the loopback interface.
+struct Client
+{
+    explicit Client(uint16_t port)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected = connect(fd,
+                            reinterpret_cast<struct sockaddr *>(&addr),
+                            sizeof(addr)) == 0;
+        // The tests fail instead of hanging if the server doesn't respond.
+        struct timeval timeout
+        {
+            5, 0
+        };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+    ~Client()
+    {
+        close(fd);
+    }
+    void send(const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.length())
+        {
+            auto n = ::send(
+                fd, data.data() + sent, data.length() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+    /// Receive until length bytes are received or the connection is closed.
+    std::string receive(size_t length = std::string::npos)
+    {
+        std::string data;
+        char buffer[16384];
+        while (data.length() < length)
+        {
+            auto n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                break;
+            data.append(buffer, static_cast<size_t>(n));
+        }
+        return data;
+    }
+
+    int fd;
+    bool connected;
+};
+
+/// A server in its own loop, listening on a port chosen by the system.
+struct TestServer
+{
+    explicit TestServer(trantor::RecvMessageCallback recvCallback,
+                        size_t idleTimeout = 0)
+    {
+        loopThread.run();
+        server = std::make_unique<UringTcpServer>(loopThread.getLoop(),
+                                                  trantor::InetAddress(0, true),
+                                                  "uringTest");
+        server->setRecvMessageCallback(std::move(recvCallback));
+        server->setConnectionCallback(
+            [this](const trantor::TcpConnectionPtr &conn) {
+                if (conn->connected())
+                    ++connections;
+                else if (conn->disconnected())
+                    ++disconnections;
+            });
+        server->kickoffIdleConnections(idleTimeout);
+        server->start();
+    }
+    ~TestServer()
+    {
+        server->stop();
+        std::promise<void> pro;
+        loopThread.getLoop()->runInLoop([this, &pro]() {
+            server.reset();
+            pro.set_value();
+        });
+        pro.get_future().get();
+    }
+    uint16_t port() const
+    {
+        return server->address().toPort();
+    }
+    /// Wait for the connections of the loop to be closed.
+    bool waitForDisconnections(int count)
+    {
+        for (int i = 0; i < 500 && disconnections < count; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return disconnections == count;
+    }
+
+    trantor::EventLoopThread loopThread;
+    std::unique_ptr<UringTcpServer> server;
+    std::atomic<int> connections{0};
+    std::atomic<int> disconnections{0};
+};
+
+void echo(const trantor::TcpConnectionPtr &conn, trantor::MsgBuffer *buffer)
+{
+    conn->send(buffer->peek(), buffer->readableBytes());
+    buffer->retrieveAll();
+}
+}  // namespace
+
+DROGON_TEST(UringEchoTest)
+{
+    if (!IoUring::supported())
+        return;
+    TestServer server(echo);
+    {
+        Client client(server.port());
+        REQUIRE(client.connected);
+        client.send("hello");
+        CHECK(client.receive(5) == "hello");
+
+        // The data is received in many buffers of the ring and sent back in
+        // parts.
+        std::string data;
+        for (size_t i = 0; data.length() < 1024 * 1024; ++i)
+            data += std::to_string(i) + ",";
+        client.send(data);
+        CHECK(client.receive(data.length()) == data);
+    }
+    CHECK(server.waitForDisconnections(1));
+    CHECK(server.connections == 1);
+}
+
+DROGON_TEST(UringSendFileTest)
+{
+    if (!IoUring::supported())
+        return;
+    std::string content;
+    for (size_t i = 0; content.length() < 300 * 1000; ++i)
+        content += std::to_string(i) + "\n";
+    const std::string fileName = "./uring_send_file_test.txt";
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        file << content;
+    }
+
+    // The files are spliced to the socket in order with the other data, and
+    // the connection is shut down after all of it is sent.
+    TestServer server([&fileName](const trantor::TcpConnectionPtr &conn,
+                                  trantor::MsgBuffer *buffer) {
+        buffer->retrieveAll();
+        conn->send("begin\n");
+        conn->sendFile(fileName.c_str());
+        conn->send(std::string("middle\n"));
+        conn->sendFile(fileName.c_str(), 100, 1000);
+        conn->send("end\n", 4);
+        conn->shutdown();
+        conn->send("dropped");
+    });
+    {
+        Client client(server.port());
+        REQUIRE(client.connected);
+        client.send("get");
+        auto expected = "begin\n" + content + "middle\n" +
+                        content.substr(100, 1000) + "end\n";
+        CHECK(client.receive() == expected);
+    }
+    CHECK(server.waitForDisconnections(1));
+    unlink(fileName.c_str());
+}
+
+DROGON_TEST(UringThreadSendTest)
+{
+    if (!IoUring::supported())
+        return;
+    // The data sent from other threads is queued to the loop, and what the
+    // loop sends after it doesn't overtake it.
+    TestServer server([](const trantor::TcpConnectionPtr &conn,
+                         trantor::MsgBuffer *buffer) {
+        buffer->retrieveAll();
+        std::thread thread([conn]() {
+            for (int i = 0; i < 100; ++i)
+                conn->send(std::to_string(i) + ",");
+        });
+        thread.join();
+        conn->send("end");
+    });
+    Client client(server.port());
+    REQUIRE(client.connected);
+    client.send("start");
+    std::string expected;
+    for (int i = 0; i < 100; ++i)
+        expected += std::to_string(i) + ",";
+    expected += "end";
+    CHECK(client.receive(expected.length()) == expected);
+}
+
+DROGON_TEST(UringCloseTest)
+{
+    if (!IoUring::supported())
+        return;
+    TestServer server([](const trantor::TcpConnectionPtr &conn,
+                         trantor::MsgBuffer *buffer) {
+        if (std::string(buffer->peek(), buffer->readableBytes()) == "close")
+        {
+            conn->forceClose();
+            conn->forceClose();
+        }
+        buffer->retrieveAll();
+    });
+    // Closed by the server.
+    Client client(server.port());
+    REQUIRE(client.connected);
+    client.send("close");
+    CHECK(client.receive().empty());
+    CHECK(server.waitForDisconnections(1));
+
+    // Closed by the client.
+    {
+        Client client2(server.port());
+        REQUIRE(client2.connected);
+    }
+    CHECK(server.waitForDisconnections(2));
+    CHECK(server.connections == 2);
+}
+
+DROGON_TEST(UringIdleTest)
+{
+    if (!IoUring::supported())
+        return;
+    TestServer server(echo, 1);
+    Client client(server.port());
+    REQUIRE(client.connected);
+    client.send("ping");
+    CHECK(client.receive(4) == "ping");
+    // The connection is kicked off after a second without I/O.
+    auto start = std::chrono::steady_clock::now();
+    CHECK(client.receive().empty());
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::seconds(1));
+    CHECK(server.waitForDisconnections(1));
+}
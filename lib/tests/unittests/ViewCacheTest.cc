@@ -0,0 +1,159 @@
+#include <drogon/ViewCache.h>
+#include <drogon/drogon_test.h>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(ViewCacheTest)
+{
+    int renderCount = 0;
+    HttpViewData data;
+    data.insert("user", std::string("alice"));
+    data.insert("page", 1);
+    auto render = [&]() {
+        ++renderCount;
+        return data.get<std::string>("user") + ":" +
+               std::to_string(data.get<int>("page"));
+    };
+    const std::vector<std::string> keys{"user", "page"};
+
+    SUBSECTION(Hit)
+    {
+        ViewCache::clear();
+        renderCount = 0;
+        CHECK(ViewCache::renderFragment("hit", data, keys, 0, render) ==
+              "alice:1");
+        CHECK(ViewCache::renderFragment("hit", data, keys, 0, render) ==
+              "alice:1");
+        CHECK(renderCount == 1);
+
+        // Items not selected by the keys don't matter
+        data.insert("other", std::string("x"));
+        ViewCache::renderFragment("hit", data, keys, 0, render);
+        CHECK(renderCount == 1);
+
+        data.insert("page", 2);
+        CHECK(ViewCache::renderFragment("hit", data, keys, 0, render) ==
+              "alice:2");
+        CHECK(renderCount == 2);
+        data.insert("page", 1);
+        ViewCache::renderFragment("hit", data, keys, 0, render);
+        CHECK(renderCount == 2);
+    }
+
+    SUBSECTION(CloseDoubles)
+    {
+        ViewCache::clear();
+        HttpViewData values;
+        const std::vector<std::string> valueKeys{"value"};
+        auto renderDouble = [&](double value) {
+            values.insert("value", value);
+            return ViewCache::renderFragment("double",
+                                             values,
+                                             valueKeys,
+                                             0,
+                                             [&]() {
+                                                 char buf[32];
+                                                 snprintf(buf,
+                                                          sizeof(buf),
+                                                          "%.17g",
+                                                          value);
+                                                 return std::string(buf);
+                                             });
+        };
+        CHECK(renderDouble(1e-7) != renderDouble(2e-7));
+        CHECK(renderDouble(0.1234561) != renderDouble(0.1234562));
+        CHECK(renderDouble(0.1234561) == renderDouble(0.1234561));
+    }
+
+    SUBSECTION(UnsupportedType)
+    {
+        ViewCache::clear();
+        renderCount = 0;
+        HttpViewData other = data;
+        other.insert("list", std::vector<int>{1, 2});
+        const std::vector<std::string> listKeys{"user", "list"};
+        ViewCache::renderFragment("list", other, listKeys, 0, render);
+        ViewCache::renderFragment("list", other, listKeys, 0, render);
+        CHECK(renderCount == 2);
+    }
+
+    SUBSECTION(Timeout)
+    {
+        ViewCache::clear();
+        renderCount = 0;
+        ViewCache::renderFragment("timeout", data, keys, 0.01, render);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ViewCache::renderFragment("timeout", data, keys, 0.01, render);
+        CHECK(renderCount == 2);
+    }
+
+    SUBSECTION(Invalidate)
+    {
+        ViewCache::clear();
+        renderCount = 0;
+        ViewCache::renderFragment("a", data, keys, 0, render);
+        ViewCache::renderFragment("b", data, keys, 0, render);
+        ViewCache::invalidate("a");
+        ViewCache::renderFragment("a", data, keys, 0, render);
+        ViewCache::renderFragment("b", data, keys, 0, render);
+        CHECK(renderCount == 3);
+        ViewCache::clear();
+        ViewCache::renderFragment("b", data, keys, 0, render);
+        CHECK(renderCount == 4);
+    }
+
+    SUBSECTION(OtherThread)
+    {
+        ViewCache::clear();
+        renderCount = 0;
+        auto renderInThread = [&]() {
+            std::thread thread([&]() {
+                ViewCache::renderFragment("thread", data, keys, 0, render);
+            });
+            thread.join();
+        };
+        // Every thread has its own cache
+        ViewCache::renderFragment("thread", data, keys, 0, render);
+        renderInThread();
+        CHECK(renderCount == 2);
+        ViewCache::invalidate("thread");
+        ViewCache::renderFragment("thread", data, keys, 0, render);
+        CHECK(renderCount == 3);
+    }
+
+    SUBSECTION(Capacity)
+    {
+        ViewCache::clear();
+        ViewCache::setCapacity(1000);
+        renderCount = 0;
+        std::string big(600, 'x');
+        auto renderBig = [&]() {
+            ++renderCount;
+            return big;
+        };
+        ViewCache::renderFragment("big1", data, keys, 0, renderBig);
+        // The least recently used text is removed
+        ViewCache::renderFragment("big2", data, keys, 0, renderBig);
+        ViewCache::renderFragment("big2", data, keys, 0, renderBig);
+        CHECK(renderCount == 2);
+        ViewCache::renderFragment("big1", data, keys, 0, renderBig);
+        CHECK(renderCount == 3);
+
+        // Texts larger than the capacity are not cached
+        big.assign(2000, 'y');
+        ViewCache::renderFragment("huge", data, keys, 0, renderBig);
+        ViewCache::renderFragment("huge", data, keys, 0, renderBig);
+        CHECK(renderCount == 5);
+
+        ViewCache::setCapacity(0);
+        ViewCache::renderFragment("zero", data, keys, 0, render);
+        ViewCache::renderFragment("zero", data, keys, 0, render);
+        CHECK(renderCount == 7);
+        ViewCache::setCapacity(64 * 1024 * 1024);
+    }
+}
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <drogon/exports.h>
+#include <drogon/nosql/RedisCommand.h>
 #include <drogon/nosql/RedisResult.h>
 #include <drogon/nosql/RedisException.h>
 #include <drogon/utils/string_view.h>
@@ -21,6 +22,7 @@
 #include <trantor/utils/Logger.h>
 #include <memory>
 #include <functional>
+#include <vector>
 #ifdef __cpp_impl_coroutine
 #include <drogon/utils/coroutine.h>
 #endif
@@ -76,6 +78,7 @@ struct RedisTransactionAwaiter
 #endif
 
 class RedisTransaction;
+class RedisSubscriber;
 /**
  * @brief This class represents a redis client that contains several connections
  * to a redis server.
@@ -97,6 +100,24 @@ class DROGON_EXPORT RedisClient
         size_t numberOfConnections = 1,
         const std::string &password = "",
         const unsigned int db = 0);
+    /**
+     * @brief Create a client of a redis cluster. The slots of the cluster are
+     * loaded from the seed nodes, every command is sent to the master node
+     * that serves the hash slot of its key, and MOVED and ASK redirections
+     * are followed.
+     *
+     * @param seeds The addresses of some nodes of the cluster.
+     * @param connectionsPerNode The number of connections to each master
+     * node.
+     * @param password The password to authenticate if necessary.
+     * @note The keys of a command with several keys must be in the same slot,
+     * use hash tags for that, e.g. "{user1000}.following" and
+     * "{user1000}.followers". Transactions are not supported.
+     */
+    static std::shared_ptr<RedisClient> newRedisClusterClient(
+        const std::vector<trantor::InetAddress> &seeds,
+        size_t connectionsPerNode = 1,
+        const std::string &password = "");
     /**
      * @brief Execute a redis command
      *
@@ -122,6 +143,32 @@ class DROGON_EXPORT RedisClient
                                   string_view command,
                                   ...) noexcept = 0;
 
+    /**
+     * @brief Execute a command built by RedisCommand, e.g.
+     * @code
+       redisClientPtr->execCommandAsync(std::move(resultCallback),
+                                        std::move(exceptionCallback),
+                                        RedisCommand("set", key, value));
+       @endcode
+     */
+    void execCommandAsync(RedisResultCallback &&resultCallback,
+                          RedisExceptionCallback &&exceptionCallback,
+                          RedisCommand &&command) noexcept
+    {
+        execFormattedCommandAsync(std::move(resultCallback),
+                                  std::move(exceptionCallback),
+                                  command.release());
+    }
+
+    /**
+     * @brief Execute a command that is already in the RESP format, e.g. the
+     * one returned by RedisCommand::release().
+     */
+    virtual void execFormattedCommandAsync(
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback,
+        std::string &&command) noexcept = 0;
+
     /**
      * @brief Create a redis transaction object.
      *
@@ -142,6 +189,12 @@ class DROGON_EXPORT RedisClient
     virtual void newTransactionAsync(
         const std::function<void(const std::shared_ptr<RedisTransaction> &)>
             &callback) = 0;
+
+    /**
+     * @brief Create a subscriber of redis channels, it has its own connection
+     * to the server. See RedisSubscriber.h.
+     */
+    virtual std::shared_ptr<RedisSubscriber> newSubscriber() noexcept = 0;
     /**
      * @brief Set the Timeout value of execution of a command.
      *
@@ -154,6 +207,30 @@ class DROGON_EXPORT RedisClient
      */
     virtual void setTimeout(double timeout) = 0;
 
+    /**
+     * @brief Cache the replies to GET commands in this client. A cached key
+     * is evicted when it is changed in the server, by the invalidation
+     * messages of the server-assisted client-side caching (the broadcasting
+     * mode of CLIENT TRACKING, redis 6 or later).
+     *
+     * @param capacity The maximum number of cached keys, the least recently
+     * used keys are evicted first.
+     * @param prefixes Only the keys with these prefixes are cached, all keys
+     * if it's empty. The server sends the invalidation messages of all
+     * changed keys with the prefixes, so the prefixes of hot keys, e.g.
+     * "config:", save the traffic.
+     * @note Call it once. The cache takes effect when its own connection has
+     * subscribed to the invalidation messages. A GET command served from the
+     * cache calls the result callback in the calling thread before
+     * execCommandAsync() returns.
+     */
+    virtual void enableClientSideCaching(
+        size_t /*capacity*/,
+        const std::vector<std::string> & /*prefixes*/ = {})
+    {
+        LOG_ERROR << "Client-side caching is not supported by this client";
+    }
+
     virtual ~RedisClient() = default;
 #ifdef __cpp_impl_coroutine
     /**
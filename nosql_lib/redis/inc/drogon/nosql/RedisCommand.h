@@ -0,0 +1,164 @@
+/**
+ *
+ *  @file RedisCommand.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/utils/string_view.h>
+#include <initializer_list>
+#include <stdio.h>
+#include <string>
+#include <type_traits>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief A redis command built from typed arguments. The arguments are
+ * written in the RESP format straight into one buffer, without printf-style
+ * placeholders, so they may contain any bytes. For example:
+ * @code
+   RedisCommand cmd("set", key, 42);
+   RedisCommand mset("mset");
+   for (auto &item : items)
+       mset.append(item.first).append(item.second);
+   redisClient->execCommandAsync(std::move(resultCallback),
+                                 std::move(exceptionCallback),
+                                 std::move(mset));
+   @endcode
+ */
+class RedisCommand
+{
+  public:
+    template <typename... Arguments>
+    explicit RedisCommand(string_view name, const Arguments &...args)
+    {
+        auto length = kHeaderSpace + argumentLength(name);
+        (void)std::initializer_list<int>{
+            (length += argumentLength(args), 0)...};
+        buffer_.reserve(length);
+        // The header "*<number of arguments>\r\n" is written in front of the
+        // arguments when the command is released.
+        buffer_.append(kHeaderSpace, ' ');
+        append(name);
+        (void)std::initializer_list<int>{(append(args), 0)...};
+    }
+
+    RedisCommand &append(string_view arg)
+    {
+        char buf[kNumberLength];
+        auto end = buf + kNumberLength;
+        auto p = formatNumber(end, arg.length());
+        *--p = '$';
+        buffer_.append(p, static_cast<size_t>(end - p));
+        buffer_.append("\r\n", 2);
+        buffer_.append(arg.data(), arg.length());
+        buffer_.append("\r\n", 2);
+        ++argumentsNumber_;
+        return *this;
+    }
+    RedisCommand &append(const char *arg)
+    {
+        return append(string_view(arg));
+    }
+    RedisCommand &append(const std::string &arg)
+    {
+        return append(string_view(arg));
+    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                                !std::is_same<T, bool>::value,
+                            RedisCommand &>::type
+    append(T arg)
+    {
+        return appendInteger(arg, std::is_signed<T>());
+    }
+    RedisCommand &append(double arg)
+    {
+        char buf[32];
+        auto length = snprintf(buf, sizeof(buf), "%.17g", arg);
+        return append(string_view(buf, static_cast<size_t>(length)));
+    }
+
+    size_t argumentsNumber() const
+    {
+        return argumentsNumber_;
+    }
+
+    /// Return the command in the RESP format, the builder is left empty.
+    std::string release()
+    {
+        char header[kHeaderSpace];
+        auto end = header + kHeaderSpace;
+        *--end = '\n';
+        *--end = '\r';
+        auto p = formatNumber(end, argumentsNumber_);
+        *--p = '*';
+        auto headerLength = static_cast<size_t>(header + kHeaderSpace - p);
+        // Drop the unused space in front without reallocating.
+        buffer_.erase(0, kHeaderSpace - headerLength);
+        buffer_.replace(0, headerLength, p, headerLength);
+        argumentsNumber_ = 0;
+        return std::move(buffer_);
+    }
+
+  private:
+    // The digits of a 64-bit integer and a sign.
+    static constexpr size_t kNumberLength = 24;
+    static constexpr size_t kHeaderSpace = kNumberLength + 4;
+
+    static size_t argumentLength(string_view arg)
+    {
+        return arg.length() + kNumberLength + 4;
+    }
+    template <typename T>
+    static typename std::enable_if<std::is_arithmetic<T>::value, size_t>::type
+    argumentLength(T)
+    {
+        return 2 * kNumberLength + 4;
+    }
+    // Write the digits in front of end, return the first one.
+    static char *formatNumber(char *end, unsigned long long number)
+    {
+        do
+        {
+            *--end = static_cast<char>('0' + number % 10);
+            number /= 10;
+        } while (number != 0);
+        return end;
+    }
+    RedisCommand &appendInteger(unsigned long long arg, std::false_type)
+    {
+        char buf[kNumberLength];
+        auto end = buf + kNumberLength;
+        auto p = formatNumber(end, arg);
+        return append(string_view(p, static_cast<size_t>(end - p)));
+    }
+    RedisCommand &appendInteger(long long arg, std::true_type)
+    {
+        char buf[kNumberLength];
+        auto end = buf + kNumberLength;
+        // The magnitude of the minimum value only fits in unsigned.
+        auto magnitude = arg < 0 ? 0ULL - static_cast<unsigned long long>(arg)
+                                 : static_cast<unsigned long long>(arg);
+        auto p = formatNumber(end, magnitude);
+        if (arg < 0)
+            *--p = '-';
+        return append(string_view(p, static_cast<size_t>(end - p)));
+    }
+
+    std::string buffer_;
+    size_t argumentsNumber_{0};
+};
+}  // namespace nosql
+}  // namespace drogon
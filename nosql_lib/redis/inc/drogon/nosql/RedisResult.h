@@ -15,10 +15,13 @@
 #pragma once
 
 #include <drogon/exports.h>
+#include <drogon/utils/string_view.h>
 #include <vector>
 #include <string>
 #include <memory>
 #include <functional>
+#include <iterator>
+#include <stddef.h>
 
 struct redisReply;
 namespace drogon
@@ -40,10 +43,59 @@ enum class RedisResultType
  * @note Limited by the hiredis library, the RedisResult object is only
  * available in the context of the result callback, one can't hold or copy or
  * move a RedisResult object for later use after the callback is returned.
+ * The same applies to the string views and iterators obtained from it.
+ *
+ * The RESP3 types are mapped to the RESP2 ones: doubles, big numbers and
+ * verbatim strings are kString, booleans are kInteger, and maps, sets and
+ * pushes are kArray, a map is an array of its keys and values in turn.
  */
 class DROGON_EXPORT RedisResult
 {
   public:
+    /**
+     * @brief The iterator over the elements of an array result, the elements
+     * are not copied.
+     */
+    class ConstIterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RedisResult;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = RedisResult;
+
+        explicit ConstIterator(redisReply **element) : element_(element)
+        {
+        }
+        RedisResult operator*() const
+        {
+            return RedisResult(*element_);
+        }
+        ConstIterator &operator++()
+        {
+            ++element_;
+            return *this;
+        }
+        ConstIterator operator++(int)
+        {
+            auto old = *this;
+            ++element_;
+            return old;
+        }
+        bool operator==(const ConstIterator &other) const
+        {
+            return element_ == other.element_;
+        }
+        bool operator!=(const ConstIterator &other) const
+        {
+            return element_ != other.element_;
+        }
+
+      private:
+        redisReply **element_;
+    };
+
     explicit RedisResult(redisReply *result) : result_(result)
     {
     }
@@ -74,6 +126,39 @@ class DROGON_EXPORT RedisResult
      */
     std::vector<RedisResult> asArray() const noexcept(false);
 
+    /**
+     * @brief Get the string value of the result without copying it.
+     *
+     * @note Calling the method of a result object whose type is not kString,
+     * kStatus or kError throws a runtime exception.
+     */
+    string_view asStringView() const noexcept(false);
+
+    /**
+     * @brief Get the number of the elements of an array result.
+     *
+     * @note Calling the method of a result object whose type is not kArray
+     * type throws a runtime exception.
+     */
+    size_t arraySize() const noexcept(false);
+
+    /**
+     * @brief Get an element of an array result, the index is not checked.
+     */
+    RedisResult operator[](size_t index) const noexcept(false);
+
+    /**
+     * @brief Iterate over the elements of an array result, e.g.
+     * @code
+       for (auto item : result)
+           std::cout << item.asStringView() << std::endl;
+       @endcode
+     * @note Calling the methods of a result object whose type is not kArray
+     * type throws a runtime exception.
+     */
+    ConstIterator begin() const noexcept(false);
+    ConstIterator end() const noexcept(false);
+
     /**
      * @brief Get the integer value of the result.
      *
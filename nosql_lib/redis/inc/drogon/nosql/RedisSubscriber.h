@@ -0,0 +1,126 @@
+/**
+ *
+ *  @file RedisSubscriber.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/PubSubService.h>
+#include <drogon/nosql/RedisClient.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief This class represents the subscriptions to redis channels. All
+ * subscriptions of a subscriber share one connection that is used for nothing
+ * else. The subscriptions are renewed when the connection is re-established.
+ *
+ * Use RedisClient::newSubscriber() to create a subscriber.
+ */
+class DROGON_EXPORT RedisSubscriber
+{
+  public:
+    /// The handler is called with the channel and the message.
+    using MessageHandler =
+        std::function<void(const std::string &, const std::string &)>;
+
+    /**
+     * @brief Subscribe to a channel.
+     *
+     * @param handler The handler is called in the event loop of the thread
+     * that subscribes if there is one, otherwise in the event loop of the
+     * connection. If the channel is already subscribed, the handler replaces
+     * the old one.
+     */
+    virtual void subscribe(const std::string &channel,
+                           MessageHandler &&handler) noexcept = 0;
+
+    /**
+     * @brief Subscribe to the channels matching a glob-style pattern, e.g.
+     * "news.*". The handler is called with the channel of each message.
+     */
+    virtual void psubscribe(const std::string &pattern,
+                            MessageHandler &&handler) noexcept = 0;
+
+    virtual void unsubscribe(const std::string &channel) noexcept = 0;
+    virtual void punsubscribe(const std::string &pattern) noexcept = 0;
+
+    virtual ~RedisSubscriber() = default;
+};
+using RedisSubscriberPtr = std::shared_ptr<RedisSubscriber>;
+
+/**
+ * @brief Bridge redis channels into the topics of a PubSubService, so that a
+ * message published by any node reaches the local subscribers of the topic on
+ * every node, e.g. to broadcast to the WebSocket connections of a cluster:
+ * @code
+   PubSubService<std::string> chatRooms;
+   RedisPubSubBridge bridge(app().getRedisClient(), chatRooms);
+   bridge.bridge("room1");
+   // In any node
+   bridge.publish("room1", "hello");
+   @endcode
+ * The PubSubService must outlive the bridge.
+ */
+class RedisPubSubBridge
+{
+  public:
+    RedisPubSubBridge(RedisClientPtr client,
+                      PubSubService<std::string> &service)
+        : client_(std::move(client)),
+          subscriber_(client_->newSubscriber()),
+          service_(service)
+    {
+    }
+    /// Publish the messages of the channel to the topic of the same name.
+    void bridge(const std::string &channel)
+    {
+        auto &service = service_;
+        subscriber_->subscribe(channel,
+                               [&service](const std::string &channel,
+                                          const std::string &message) {
+                                   service.publish(channel, message);
+                               });
+    }
+    void unbridge(const std::string &channel)
+    {
+        subscriber_->unsubscribe(channel);
+    }
+    /// Publish a message to the channel through redis.
+    void publish(const std::string &channel, const std::string &message)
+    {
+        client_->execCommandAsync(
+            [](const RedisResult &) {},
+            [channel](const RedisException &err) {
+                LOG_ERROR << "Failed to publish to " << channel << ": "
+                          << err.what();
+            },
+            "publish %b %b",
+            channel.data(),
+            channel.length(),
+            message.data(),
+            message.length());
+    }
+
+  private:
+    RedisClientPtr client_;
+    RedisSubscriberPtr subscriber_;
+    PubSubService<std::string> &service_;
+};
+}  // namespace nosql
+}  // namespace drogon
@@ -0,0 +1,306 @@
+/**
+ *
+ *  @file RedisClientCache.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisClientCache.h"
+#include <ctype.h>
+
+using namespace drogon::nosql;
+
+RedisClientCache::RedisClientCache(const trantor::InetAddress &serverAddress,
+                                   std::string password,
+                                   trantor::EventLoop *loop,
+                                   size_t capacity,
+                                   std::vector<std::string> prefixes)
+    : serverAddr_(serverAddress),
+      password_(std::move(password)),
+      loop_(loop),
+      capacity_(capacity),
+      prefixes_(std::move(prefixes))
+{
+}
+
+RedisClientCache::~RedisClientCache()
+{
+    RedisConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection = std::move(connection_);
+    }
+    if (connection)
+        connection->disconnect();
+}
+
+void RedisClientCache::init()
+{
+    std::weak_ptr<RedisClientCache> weakThis = shared_from_this();
+    loop_->queueInLoop([weakThis]() {
+        if (auto thisPtr = weakThis.lock())
+            thisPtr->connect();
+    });
+}
+
+void RedisClientCache::connect()
+{
+    auto connection =
+        std::make_shared<RedisConnection>(serverAddr_, password_, 0, loop_);
+    std::weak_ptr<RedisClientCache> weakThis = shared_from_this();
+    connection->setSubscribeCallback([weakThis](const RedisResult &result) {
+        if (auto thisPtr = weakThis.lock())
+            thisPtr->handleMessage(result);
+    });
+    connection->setConnectCallback([weakThis](RedisConnectionPtr &&conn) {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            thisPtr->connection_ = conn;
+        }
+        // CLIENT ID, then CLIENT TRACKING ON REDIRECT <id> BCAST, then
+        // SUBSCRIBE __redis__:invalidate
+        std::weak_ptr<RedisConnection> weakConn = conn;
+        conn->sendCommand(
+            [weakThis, weakConn](const RedisResult &result) {
+                auto thisPtr = weakThis.lock();
+                auto conn = weakConn.lock();
+                if (!thisPtr || !conn)
+                    return;
+                std::vector<std::string> args{"tracking",
+                                              "on",
+                                              "redirect",
+                                              std::to_string(
+                                                  result.asInteger()),
+                                              "bcast"};
+                for (auto &prefix : thisPtr->prefixes_)
+                {
+                    args.emplace_back("prefix");
+                    args.push_back(prefix);
+                }
+                conn->sendFormattedCommand(
+                    RedisConnection::getFormattedCommand("client", args),
+                    [weakConn](const RedisResult &) {
+                        if (auto conn = weakConn.lock())
+                            conn->sendSubscribeCommand(
+                                RedisConnection::getFormattedCommand(
+                                    "subscribe", {"__redis__:invalidate"}));
+                    },
+                    [](const RedisException &err) {
+                        LOG_ERROR << "Failed to enable the client tracking, "
+                                     "the client-side cache is disabled: "
+                                  << err.what();
+                    });
+            },
+            [](const RedisException &err) {
+                LOG_ERROR << "Failed to get the client id: " << err.what();
+            },
+            "client id");
+    });
+    connection->setDisconnectCallback([weakThis](RedisConnectionPtr &&conn) {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            if (thisPtr->connection_ == conn)
+                thisPtr->connection_.reset();
+            // The invalidation messages may be lost.
+            thisPtr->active_ = false;
+            thisPtr->dropEntries();
+        }
+        thisPtr->loop_->runAfter(2.0, [weakThis]() {
+            if (auto thisPtr = weakThis.lock())
+                thisPtr->connect();
+        });
+    });
+}
+
+void RedisClientCache::handleMessage(const RedisResult &result)
+{
+    if (result.type() != RedisResultType::kArray)
+        return;
+    try
+    {
+        auto items = result.asArray();
+        if (items.size() < 3)
+            return;
+        auto kind = items[0].asString();
+        if (kind == "subscribe")
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_ = true;
+            return;
+        }
+        if (kind != "message")
+            return;
+        // The changed keys, or nil when the database is flushed.
+        if (items[2].type() != RedisResultType::kArray)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            dropEntries();
+            return;
+        }
+        auto keys = items[2].asArray();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &item : keys)
+        {
+            auto key = item.asString();
+            fetchingKeys_.erase(key);
+            auto iter = index_.find(key);
+            if (iter != index_.end())
+            {
+                entries_.erase(iter->second);
+                index_.erase(iter);
+            }
+        }
+    }
+    catch (const RedisException &err)
+    {
+        LOG_ERROR << "Bad invalidation message: " << err.what();
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropEntries();
+    }
+}
+
+bool RedisClientCache::handleCommand(const std::string &command,
+                                     RedisResultCallback &resultCallback,
+                                     RedisExceptionCallback &exceptionCallback)
+{
+    // Only the commands that may be GETs are parsed here.
+    static const char prefix[] = "*2\r\n$3\r\n";
+    constexpr size_t prefixLength = sizeof(prefix) - 1;
+    if (command.length() < prefixLength + 3 ||
+        command.compare(0, prefixLength, prefix) != 0 ||
+        tolower(command[prefixLength]) != 'g' ||
+        tolower(command[prefixLength + 1]) != 'e' ||
+        tolower(command[prefixLength + 2]) != 't')
+        return false;
+    std::vector<string_view> arguments;
+    if (!RedisConnection::parseFormattedCommand(command, arguments) ||
+        arguments.size() != 2)
+        return false;
+    std::string key(arguments[1].data(), arguments[1].length());
+    if (!prefixes_.empty())
+    {
+        // The changes of other keys are not sent by the server.
+        bool matched = false;
+        for (auto &prefix : prefixes_)
+        {
+            if (key.compare(0, prefix.length(), prefix) == 0)
+            {
+                matched = true;
+                break;
+            }
+        }
+        if (!matched)
+            return false;
+    }
+
+    std::string value;
+    bool isNil = false;
+    uint64_t token = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_)
+            return false;
+        auto iter = index_.find(key);
+        if (iter == index_.end())
+        {
+            token = nextToken_++;
+            fetchingKeys_[key] = token;
+        }
+        else
+        {
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            value = iter->second->value;
+            isNil = iter->second->isNil;
+        }
+    }
+    if (token == 0)
+    {
+        redisReply reply{};
+        reply.type = isNil ? REDIS_REPLY_NIL : REDIS_REPLY_STRING;
+        reply.str = &value[0];
+        reply.len = static_cast<decltype(reply.len)>(value.length());
+        resultCallback(RedisResult(&reply));
+        return true;
+    }
+    std::weak_ptr<RedisClientCache> weakThis = shared_from_this();
+    resultCallback = [weakThis,
+                      key,
+                      token,
+                      callback = std::move(resultCallback)](
+                         const RedisResult &result) {
+        if (auto thisPtr = weakThis.lock())
+            thisPtr->store(key, token, result);
+        callback(result);
+    };
+    exceptionCallback = [weakThis,
+                         key,
+                         token,
+                         callback = std::move(exceptionCallback)](
+                            const RedisException &err) {
+        if (auto thisPtr = weakThis.lock())
+            thisPtr->cancelFetching(key, token);
+        callback(err);
+    };
+    return false;
+}
+
+void RedisClientCache::store(const std::string &key,
+                             uint64_t token,
+                             const RedisResult &result)
+{
+    auto isNil = result.type() == RedisResultType::kNil;
+    if (!isNil && result.type() != RedisResultType::kString)
+    {
+        cancelFetching(key, token);
+        return;
+    }
+    auto value = isNil ? std::string() : result.asString();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto fetchingIter = fetchingKeys_.find(key);
+    if (fetchingIter == fetchingKeys_.end() || fetchingIter->second != token)
+        return;
+    fetchingKeys_.erase(fetchingIter);
+    auto iter = index_.find(key);
+    if (iter != index_.end())
+    {
+        iter->second->value = std::move(value);
+        iter->second->isNil = isNil;
+        entries_.splice(entries_.begin(), entries_, iter->second);
+        return;
+    }
+    entries_.push_front(Entry{key, std::move(value), isNil});
+    index_[key] = entries_.begin();
+    while (entries_.size() > capacity_)
+    {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
+
+void RedisClientCache::cancelFetching(const std::string &key, uint64_t token)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = fetchingKeys_.find(key);
+    if (iter != fetchingKeys_.end() && iter->second == token)
+        fetchingKeys_.erase(iter);
+}
+
+void RedisClientCache::dropEntries()
+{
+    entries_.clear();
+    index_.clear();
+    fetchingKeys_.clear();
+}
@@ -0,0 +1,95 @@
+/**
+ *
+ *  @file RedisClientCache.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include "RedisConnection.h"
+#include <trantor/utils/NonCopyable.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief The client-side cache of the replies to GET commands. The cache has
+ * its own connection that enables the broadcasting mode of CLIENT TRACKING
+ * with the connection itself as the redirection target, and subscribes to the
+ * __redis__:invalidate channel, so every change of a cached key evicts it.
+ *
+ * Nothing is cached while the connection is not subscribed, and the whole
+ * cache is dropped when the connection is lost, because the invalidation
+ * messages may be lost with it.
+ */
+class RedisClientCache : public trantor::NonCopyable,
+                         public std::enable_shared_from_this<RedisClientCache>
+{
+  public:
+    RedisClientCache(const trantor::InetAddress &serverAddress,
+                     std::string password,
+                     trantor::EventLoop *loop,
+                     size_t capacity,
+                     std::vector<std::string> prefixes);
+    ~RedisClientCache();
+    void init();
+
+    /**
+     * @brief Serve a GET command, in the RESP format, from the cache if the
+     * key is cached, otherwise wrap the callbacks to cache the reply.
+     *
+     * @return true if the result callback has been called with the cached
+     * value.
+     */
+    bool handleCommand(const std::string &command,
+                       RedisResultCallback &resultCallback,
+                       RedisExceptionCallback &exceptionCallback);
+
+  private:
+    struct Entry
+    {
+        std::string key;
+        std::string value;
+        bool isNil;
+    };
+
+    void connect();
+    void handleMessage(const RedisResult &result);
+    void store(const std::string &key,
+               uint64_t token,
+               const RedisResult &result);
+    void cancelFetching(const std::string &key, uint64_t token);
+    // Called with the mutex locked.
+    void dropEntries();
+
+    const trantor::InetAddress serverAddr_;
+    const std::string password_;
+    trantor::EventLoop *loop_;
+    const size_t capacity_;
+    const std::vector<std::string> prefixes_;
+    std::mutex mutex_;
+    bool active_{false};
+    // The most recently used entry is at the front.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    // The keys being fetched, an invalidation of a key removes it, so that
+    // the reply, which may be older than the invalidation, is not cached.
+    std::unordered_map<std::string, uint64_t> fetchingKeys_;
+    uint64_t nextToken_{1};
+    RedisConnectionPtr connection_;
+};
+}  // namespace nosql
+}  // namespace drogon
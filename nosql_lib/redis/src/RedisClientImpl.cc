@@ -14,7 +14,9 @@
 
 #include "RedisClientImpl.h"
 #include "RedisTransactionImpl.h"
+#include "RedisSubscriberImpl.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
+#include "../../lib/src/BuiltinMetrics.h"
 using namespace drogon::nosql;
 std::shared_ptr<RedisClient> RedisClient::newRedisClient(
     const trantor::InetAddress &serverAddress,
@@ -113,15 +115,44 @@ void RedisClientImpl::execCommandAsync(
     string_view command,
     ...) noexcept
 {
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(resultCallback),
+                              std::move(exceptionCallback),
+                              std::move(formattedCmd));
+}
+
+void RedisClientImpl::execFormattedCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string &&command) noexcept
+{
+    if (auto metrics = drogon::internal::builtinMetrics())
+        drogon::internal::recordCallDuration(*metrics->redisCommandDuration,
+                                             resultCallback,
+                                             exceptionCallback);
+    if (auto cache = cache_.load(std::memory_order_acquire))
+    {
+        if (cache->handleCommand(command, resultCallback, exceptionCallback))
+            return;
+    }
     if (timeout_ > 0.0)
     {
-        va_list args;
-        va_start(args, command);
-        execCommandAsyncWithTimeout(command,
+        execCommandAsyncWithTimeout(std::move(command),
                                     std::move(resultCallback),
-                                    std::move(exceptionCallback),
-                                    args);
-        va_end(args);
+                                    std::move(exceptionCallback));
         return;
     }
     RedisConnectionPtr connPtr;
@@ -142,28 +173,24 @@ void RedisClientImpl::execCommandAsync(
     }
     if (connPtr)
     {
-        va_list args;
-        va_start(args, command);
-        connPtr->sendvCommand(command,
-                              std::move(resultCallback),
-                              std::move(exceptionCallback),
-                              args);
-        va_end(args);
+        connPtr->sendFormattedCommand(std::move(command),
+                                      std::move(resultCallback),
+                                      std::move(exceptionCallback));
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
-        va_list args;
-        va_start(args, command);
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, args);
-        va_end(args);
         std::lock_guard<std::mutex> lock(connectionsMutex_);
         tasks_.emplace_back(
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(resultCallback),
                  exceptionCallback = std::move(exceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(command),
+                 queuedTime = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (auto metrics = drogon::internal::builtinMetrics())
+                        metrics->redisPoolWait->observe(
+                            drogon::internal::secondsSince(queuedTime));
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -182,6 +209,33 @@ RedisClientImpl::~RedisClientImpl()
     connections_.clear();
 }
 
+void RedisClientImpl::enableClientSideCaching(
+    size_t capacity,
+    const std::vector<std::string> &prefixes)
+{
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    if (cacheHolder_)
+    {
+        LOG_WARN << "The client-side caching is already enabled";
+        return;
+    }
+    cacheHolder_ = std::make_shared<RedisClientCache>(
+        serverAddr_, password_, loops_.getNextLoop(), capacity, prefixes);
+    cacheHolder_->init();
+    cache_.store(cacheHolder_.get(), std::memory_order_release);
+}
+
+RedisSubscriberPtr RedisClientImpl::newSubscriber() noexcept
+{
+    auto subscriber =
+        std::make_shared<RedisSubscriberImpl>(serverAddr_,
+                                              password_,
+                                              loops_.getNextLoop(),
+                                              shared_from_this());
+    subscriber->init();
+    return subscriber;
+}
+
 void RedisClientImpl::newTransactionAsync(
     const std::function<void(const std::shared_ptr<RedisTransaction> &)>
         &callback)
@@ -309,10 +363,9 @@ void RedisClientImpl::handleNextTask(const RedisConnectionPtr &connPtr)
     }
 }
 void RedisClientImpl::execCommandAsyncWithTimeout(
-    string_view command,
+    std::string &&command,
     RedisResultCallback &&resultCallback,
-    RedisExceptionCallback &&exceptionCallback,
-    va_list ap)
+    RedisExceptionCallback &&exceptionCallback)
 {
     auto expCbPtr =
         std::make_shared<RedisExceptionCallback>(std::move(exceptionCallback));
@@ -381,21 +434,23 @@ void RedisClientImpl::execCommandAsyncWithTimeout(
     }
     if (connPtr)
     {
-        connPtr->sendvCommand(command,
-                              std::move(newResultCallback),
-                              std::move(newExceptionCallback),
-                              ap);
+        connPtr->sendFormattedCommand(std::move(command),
+                                      std::move(newResultCallback),
+                                      std::move(newExceptionCallback));
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, ap);
         auto bfCbPtr =
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(newResultCallback),
                  exceptionCallback = std::move(newExceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(command),
+                 queuedTime = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (auto metrics = drogon::internal::builtinMetrics())
+                        metrics->redisPoolWait->observe(
+                            drogon::internal::secondsSince(queuedTime));
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
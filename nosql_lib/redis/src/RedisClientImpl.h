@@ -14,9 +14,12 @@
 #pragma once
 
 #include "RedisConnection.h"
+#include "RedisClientCache.h"
 #include <drogon/nosql/RedisClient.h>
+#include <drogon/nosql/RedisSubscriber.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoopThreadPool.h>
+#include <atomic>
 #include <vector>
 #include <unordered_set>
 #include <list>
@@ -32,6 +35,7 @@ class RedisClientImpl final
       public std::enable_shared_from_this<RedisClientImpl>
 {
   public:
+    using RedisClient::execCommandAsync;
     RedisClientImpl(const trantor::InetAddress &serverAddress,
                     size_t numberOfConnections,
                     std::string password = "",
@@ -40,6 +44,9 @@ class RedisClientImpl final
                           RedisExceptionCallback &&exceptionCallback,
                           string_view command,
                           ...) noexcept override;
+    void execFormattedCommandAsync(RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback,
+                                   std::string &&command) noexcept override;
     ~RedisClientImpl() override;
     RedisTransactionPtr newTransaction() noexcept(false) override
     {
@@ -60,10 +67,14 @@ class RedisClientImpl final
     void newTransactionAsync(
         const std::function<void(const RedisTransactionPtr &)> &callback)
         override;
+    RedisSubscriberPtr newSubscriber() noexcept override;
     void setTimeout(double timeout) override
     {
         timeout_ = timeout;
     }
+    void enableClientSideCaching(
+        size_t capacity,
+        const std::vector<std::string> &prefixes) override;
     void init();
 
   private:
@@ -78,15 +89,17 @@ class RedisClientImpl final
     const unsigned int db_;
     const size_t numberOfConnections_;
     double timeout_{-1.0};
+    std::shared_ptr<RedisClientCache> cacheHolder_;
+    std::atomic<RedisClientCache *> cache_{nullptr};
     std::list<std::shared_ptr<std::function<void(const RedisConnectionPtr &)>>>
         tasks_;
     std::shared_ptr<RedisTransaction> makeTransaction(
         const RedisConnectionPtr &connPtr);
     void handleNextTask(const RedisConnectionPtr &connPtr);
-    void execCommandAsyncWithTimeout(string_view command,
-                                     RedisResultCallback &&resultCallback,
-                                     RedisExceptionCallback &&exceptionCallback,
-                                     va_list ap);
+    void execCommandAsyncWithTimeout(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback);
 };
 }  // namespace nosql
 }  // namespace drogon
@@ -14,7 +14,9 @@
 
 #include "RedisClientLockFree.h"
 #include "RedisTransactionImpl.h"
+#include "RedisSubscriberImpl.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
+#include "../../lib/src/BuiltinMetrics.h"
 using namespace drogon::nosql;
 
 RedisClientLockFree::RedisClientLockFree(
@@ -86,17 +88,46 @@ void RedisClientLockFree::execCommandAsync(
     RedisExceptionCallback &&exceptionCallback,
     string_view command,
     ...) noexcept
+{
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(resultCallback),
+                              std::move(exceptionCallback),
+                              std::move(formattedCmd));
+}
+
+void RedisClientLockFree::execFormattedCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string &&command) noexcept
 {
     loop_->assertInLoopThread();
+    if (auto metrics = drogon::internal::builtinMetrics())
+        drogon::internal::recordCallDuration(*metrics->redisCommandDuration,
+                                             resultCallback,
+                                             exceptionCallback);
+    if (auto cache = cache_.get())
+    {
+        if (cache->handleCommand(command, resultCallback, exceptionCallback))
+            return;
+    }
     if (timeout_ > 0.0)
     {
-        va_list args;
-        va_start(args, command);
-        execCommandAsyncWithTimeout(command,
+        execCommandAsyncWithTimeout(std::move(command),
                                     std::move(resultCallback),
-                                    std::move(exceptionCallback),
-                                    args);
-        va_end(args);
+                                    std::move(exceptionCallback));
         return;
     }
     RedisConnectionPtr connPtr;
@@ -116,29 +147,25 @@ void RedisClientLockFree::execCommandAsync(
     }
     if (connPtr)
     {
-        va_list args;
-        va_start(args, command);
-        connPtr->sendvCommand(command,
-                              std::move(resultCallback),
-                              std::move(exceptionCallback),
-                              args);
-        va_end(args);
+        connPtr->sendFormattedCommand(std::move(command),
+                                      std::move(resultCallback),
+                                      std::move(exceptionCallback));
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
         std::weak_ptr<RedisClientLockFree> thisWeakPtr = shared_from_this();
-        va_list args;
-        va_start(args, command);
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, args);
-        va_end(args);
         tasks_.emplace_back(
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [thisWeakPtr,
                  resultCallback = std::move(resultCallback),
                  exceptionCallback = std::move(exceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(command),
+                 queuedTime = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (auto metrics = drogon::internal::builtinMetrics())
+                        metrics->redisPoolWait->observe(
+                            drogon::internal::secondsSince(queuedTime));
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -156,6 +183,40 @@ RedisClientLockFree::~RedisClientLockFree()
     connections_.clear();
 }
 
+void RedisClientLockFree::enableClientSideCaching(
+    size_t capacity,
+    const std::vector<std::string> &prefixes)
+{
+    std::weak_ptr<RedisClientLockFree> thisWeakPtr = shared_from_this();
+    loop_->runInLoop([thisWeakPtr, capacity, prefixes]() {
+        auto thisPtr = thisWeakPtr.lock();
+        if (!thisPtr)
+            return;
+        if (thisPtr->cache_)
+        {
+            LOG_WARN << "The client-side caching is already enabled";
+            return;
+        }
+        thisPtr->cache_ = std::make_shared<RedisClientCache>(
+            thisPtr->serverAddr_,
+            thisPtr->password_,
+            thisPtr->loop_,
+            capacity,
+            prefixes);
+        thisPtr->cache_->init();
+    });
+}
+
+RedisSubscriberPtr RedisClientLockFree::newSubscriber() noexcept
+{
+    auto subscriber = std::make_shared<RedisSubscriberImpl>(serverAddr_,
+                                                            password_,
+                                                            loop_,
+                                                            shared_from_this());
+    subscriber->init();
+    return subscriber;
+}
+
 void RedisClientLockFree::newTransactionAsync(
     const std::function<void(const std::shared_ptr<RedisTransaction> &)>
         &callback)
@@ -276,10 +337,9 @@ void RedisClientLockFree::handleNextTask(const RedisConnectionPtr &connPtr)
 }
 
 void RedisClientLockFree::execCommandAsyncWithTimeout(
-    string_view command,
+    std::string &&command,
     RedisResultCallback &&resultCallback,
-    RedisExceptionCallback &&exceptionCallback,
-    va_list ap)
+    RedisExceptionCallback &&exceptionCallback)
 {
     auto expCbPtr =
         std::make_shared<RedisExceptionCallback>(std::move(exceptionCallback));
@@ -346,21 +406,23 @@ void RedisClientLockFree::execCommandAsyncWithTimeout(
     }
     if (connPtr)
     {
-        connPtr->sendvCommand(command,
-                              std::move(newResultCallback),
-                              std::move(newExceptionCallback),
-                              ap);
+        connPtr->sendFormattedCommand(std::move(command),
+                                      std::move(newResultCallback),
+                                      std::move(newExceptionCallback));
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, ap);
         auto bfCbPtr =
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(newResultCallback),
                  exceptionCallback = std::move(newExceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(command),
+                 queuedTime = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (auto metrics = drogon::internal::builtinMetrics())
+                        metrics->redisPoolWait->observe(
+                            drogon::internal::secondsSince(queuedTime));
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
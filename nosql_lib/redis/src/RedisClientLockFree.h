@@ -14,7 +14,9 @@
 #pragma once
 
 #include "RedisConnection.h"
+#include "RedisClientCache.h"
 #include <drogon/nosql/RedisClient.h>
+#include <drogon/nosql/RedisSubscriber.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <vector>
@@ -32,6 +34,7 @@ class RedisClientLockFree final
       public std::enable_shared_from_this<RedisClientLockFree>
 {
   public:
+    using RedisClient::execCommandAsync;
     RedisClientLockFree(const trantor::InetAddress &serverAddress,
                         size_t numberOfConnections,
                         trantor::EventLoop *loop,
@@ -41,6 +44,9 @@ class RedisClientLockFree final
                           RedisExceptionCallback &&exceptionCallback,
                           string_view command,
                           ...) noexcept override;
+    void execFormattedCommandAsync(RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback,
+                                   std::string &&command) noexcept override;
     ~RedisClientLockFree() override;
     RedisTransactionPtr newTransaction() override
     {
@@ -54,11 +60,15 @@ class RedisClientLockFree final
     void newTransactionAsync(
         const std::function<void(const RedisTransactionPtr &)> &callback)
         override;
+    RedisSubscriberPtr newSubscriber() noexcept override;
 
     void setTimeout(double timeout) override
     {
         timeout_ = timeout;
     }
+    void enableClientSideCaching(
+        size_t capacity,
+        const std::vector<std::string> &prefixes) override;
 
   private:
     trantor::EventLoop *loop_;
@@ -73,13 +83,14 @@ class RedisClientLockFree final
     std::list<std::shared_ptr<std::function<void(const RedisConnectionPtr &)>>>
         tasks_;
     double timeout_{-1.0};
+    std::shared_ptr<RedisClientCache> cache_;
     std::shared_ptr<RedisTransaction> makeTransaction(
         const RedisConnectionPtr &connPtr);
     void handleNextTask(const RedisConnectionPtr &connPtr);
-    void execCommandAsyncWithTimeout(string_view command,
-                                     RedisResultCallback &&resultCallback,
-                                     RedisExceptionCallback &&exceptionCallback,
-                                     va_list ap);
+    void execCommandAsyncWithTimeout(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback);
 };
 }  // namespace nosql
 }  // namespace drogon
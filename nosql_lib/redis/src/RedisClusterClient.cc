@@ -0,0 +1,654 @@
+/**
+ *
+ *  @file RedisClusterClient.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisClusterClient.h"
+#include "RedisSubscriberImpl.h"
+#include "../../lib/src/TaskTimeoutFlag.h"
+#include "../../lib/src/BuiltinMetrics.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+using namespace drogon::nosql;
+
+namespace
+{
+// The number of MOVED and ASK redirections a command follows before the
+// error is returned to the caller.
+constexpr int kMaxRedirections = 5;
+constexpr double kRefreshInterval = 10.0;
+
+// CRC16-CCITT (XModem) used by redis cluster to hash keys.
+uint16_t crc16(drogon::string_view data)
+{
+    uint16_t crc = 0;
+    for (auto c : data)
+    {
+        crc ^= static_cast<uint16_t>(static_cast<unsigned char>(c) << 8);
+        for (int i = 0; i < 8; ++i)
+        {
+            if (crc & 0x8000)
+                crc = static_cast<uint16_t>((crc << 1) ^ 0x1021);
+            else
+                crc = static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool equalsIgnoreCase(drogon::string_view str, const char *lowerCase)
+{
+    size_t i = 0;
+    for (; i < str.length() && lowerCase[i]; ++i)
+    {
+        if (tolower(static_cast<unsigned char>(str[i])) != lowerCase[i])
+            return false;
+    }
+    return i == str.length() && !lowerCase[i];
+}
+}  // namespace
+
+std::shared_ptr<RedisClient> RedisClient::newRedisClusterClient(
+    const std::vector<trantor::InetAddress> &seeds,
+    size_t connectionsPerNode,
+    const std::string &password)
+{
+    auto client = std::make_shared<RedisClusterClient>(seeds,
+                                                       connectionsPerNode,
+                                                       password);
+    client->init();
+    return client;
+}
+
+RedisClusterClient::RedisClusterClient(std::vector<trantor::InetAddress> seeds,
+                                       size_t connectionsPerNode,
+                                       std::string password)
+    : loops_(connectionsPerNode < std::thread::hardware_concurrency()
+                 ? connectionsPerNode
+                 : std::thread::hardware_concurrency(),
+             "RedisClusterLoop"),
+      seeds_(std::move(seeds)),
+      password_(std::move(password)),
+      connectionsPerNode_(connectionsPerNode > 0 ? connectionsPerNode : 1)
+{
+}
+
+void RedisClusterClient::init()
+{
+    loops_.start();
+    for (auto &seed : seeds_)
+    {
+        getNode(seed);
+    }
+    std::weak_ptr<RedisClusterClient> thisWeakPtr = shared_from_this();
+    refreshTimerId_ =
+        loops_.getLoop(0)->runEvery(kRefreshInterval, [thisWeakPtr]() {
+            auto thisPtr = thisWeakPtr.lock();
+            if (thisPtr)
+                thisPtr->refreshSlots();
+        });
+}
+
+RedisClusterClient::~RedisClusterClient()
+{
+    loops_.getLoop(0)->invalidateTimer(refreshTimerId_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &node : nodes_)
+    {
+        node.second->removed = true;
+        for (auto &conn : node.second->connections)
+        {
+            conn->disconnect();
+        }
+        node.second->connections.clear();
+        node.second->readyConnections.clear();
+    }
+    nodes_.clear();
+    slots_.clear();
+}
+
+uint16_t RedisClusterClient::hashSlot(string_view key)
+{
+    auto open = key.find('{');
+    if (open != string_view::npos)
+    {
+        auto close = key.find('}', open + 1);
+        if (close != string_view::npos && close != open + 1)
+            key = key.substr(open + 1, close - open - 1);
+    }
+    return static_cast<uint16_t>(crc16(key) & (kSlotsNumber - 1));
+}
+
+bool RedisClusterClient::findCommandKey(const std::string &formattedCommand,
+                                        string_view &key)
+{
+    std::vector<string_view> arguments;
+    if (!RedisConnection::parseFormattedCommand(formattedCommand, arguments) ||
+        arguments.size() < 2)
+        return false;
+    auto &name = arguments[0];
+    static const char *const keylessCommands[] = {"auth",
+                                                  "client",
+                                                  "cluster",
+                                                  "command",
+                                                  "config",
+                                                  "dbsize",
+                                                  "echo",
+                                                  "flushall",
+                                                  "flushdb",
+                                                  "function",
+                                                  "info",
+                                                  "keys",
+                                                  "lastsave",
+                                                  "ping",
+                                                  "publish",
+                                                  "randomkey",
+                                                  "role",
+                                                  "scan",
+                                                  "script",
+                                                  "select",
+                                                  "time",
+                                                  "wait"};
+    for (auto command : keylessCommands)
+    {
+        if (equalsIgnoreCase(name, command))
+            return false;
+    }
+    if (equalsIgnoreCase(name, "eval") || equalsIgnoreCase(name, "evalsha") ||
+        equalsIgnoreCase(name, "eval_ro") ||
+        equalsIgnoreCase(name, "evalsha_ro") ||
+        equalsIgnoreCase(name, "fcall") || equalsIgnoreCase(name, "fcall_ro"))
+    {
+        // EVAL script numkeys key [key ...] arg [arg ...]
+        if (arguments.size() < 4 || arguments[2] == "0")
+            return false;
+        key = arguments[3];
+        return true;
+    }
+    if (equalsIgnoreCase(name, "xread") || equalsIgnoreCase(name, "xreadgroup"))
+    {
+        // XREAD [COUNT count] [BLOCK milliseconds] STREAMS key [key ...] ...
+        for (size_t i = 1; i + 1 < arguments.size(); ++i)
+        {
+            if (equalsIgnoreCase(arguments[i], "streams"))
+            {
+                key = arguments[i + 1];
+                return true;
+            }
+        }
+        return false;
+    }
+    key = arguments[1];
+    return true;
+}
+
+RedisClusterClient::NodePtr RedisClusterClient::getNode(
+    const trantor::InetAddress &address)
+{
+    NodePtr node;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &nodeRef = nodes_[address.toIpPort()];
+        if (nodeRef)
+            return nodeRef;
+        nodeRef = std::make_shared<Node>(address);
+        node = nodeRef;
+    }
+    std::weak_ptr<RedisClusterClient> thisWeakPtr = shared_from_this();
+    for (size_t i = 0; i < connectionsPerNode_; ++i)
+    {
+        auto loop = loops_.getNextLoop();
+        loop->queueInLoop([thisWeakPtr, node, loop]() {
+            auto thisPtr = thisWeakPtr.lock();
+            if (!thisPtr)
+                return;
+            auto conn = thisPtr->newConnection(node, loop);
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            if (node->removed)
+                conn->disconnect();
+            else
+                node->connections.push_back(std::move(conn));
+        });
+    }
+    return node;
+}
+
+RedisClusterClient::NodePtr RedisClusterClient::nodeOfSlot(size_t slot)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slots_.empty())
+        return nullptr;
+    return slots_[slot];
+}
+
+RedisConnectionPtr RedisClusterClient::newConnection(const NodePtr &node,
+                                                     trantor::EventLoop *loop)
+{
+    auto conn =
+        std::make_shared<RedisConnection>(node->address, password_, 0, loop);
+    std::weak_ptr<RedisClusterClient> thisWeakPtr = shared_from_this();
+    conn->setConnectCallback([thisWeakPtr, node](RedisConnectionPtr &&conn) {
+        auto thisPtr = thisWeakPtr.lock();
+        if (!thisPtr)
+            return;
+        std::deque<std::function<void(const RedisConnectionPtr &)>> tasks;
+        bool noSlots;
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            if (node->removed)
+                return;
+            node->readyConnections.push_back(conn);
+            tasks.swap(node->tasks);
+            noSlots = thisPtr->slots_.empty();
+        }
+        for (auto &task : tasks)
+        {
+            task(conn);
+        }
+        if (noSlots)
+            thisPtr->refreshSlots();
+    });
+    conn->setDisconnectCallback([thisWeakPtr,
+                                 node](RedisConnectionPtr &&conn) {
+        auto thisPtr = thisWeakPtr.lock();
+        if (!thisPtr)
+            return;
+        std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+        for (auto connections : {&node->connections, &node->readyConnections})
+        {
+            for (auto iter = connections->begin(); iter != connections->end();
+                 ++iter)
+            {
+                if (*iter == conn)
+                {
+                    connections->erase(iter);
+                    break;
+                }
+            }
+        }
+        if (node->removed)
+            return;
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        assert(loop);
+        loop->runAfter(2.0, [thisWeakPtr, node, loop]() {
+            auto thisPtr = thisWeakPtr.lock();
+            if (!thisPtr)
+                return;
+            auto conn = thisPtr->newConnection(node, loop);
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            if (node->removed)
+                conn->disconnect();
+            else
+                node->connections.push_back(std::move(conn));
+        });
+    });
+    return conn;
+}
+
+void RedisClusterClient::runOnNode(
+    const NodePtr &node,
+    std::function<void(const RedisConnectionPtr &)> &&task)
+{
+    RedisConnectionPtr connPtr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto target = node;
+        if (!target || target->removed)
+        {
+            // The command has no key or its slot is not served by a known
+            // node, any node redirects it to the right one.
+            if (nodes_.empty())
+            {
+                target = nullptr;
+            }
+            else
+            {
+                auto iter = nodes_.begin();
+                std::advance(iter, nodePos_++ % nodes_.size());
+                target = iter->second;
+            }
+        }
+        if (target)
+        {
+            if (target->readyConnections.empty())
+            {
+                LOG_TRACE << "no connection available, push command to buffer";
+                target->tasks.emplace_back(std::move(task));
+                return;
+            }
+            auto &connections = target->readyConnections;
+            connPtr = connections[target->connectionPos++ %
+                                  connections.size()];
+        }
+    }
+    if (connPtr)
+        task(connPtr);
+}
+
+void RedisClusterClient::execCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    string_view command,
+    ...) noexcept
+{
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(resultCallback),
+                              std::move(exceptionCallback),
+                              std::move(formattedCmd));
+}
+
+void RedisClusterClient::execFormattedCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string &&command) noexcept
+{
+    if (auto metrics = drogon::internal::builtinMetrics())
+        drogon::internal::recordCallDuration(*metrics->redisCommandDuration,
+                                             resultCallback,
+                                             exceptionCallback);
+    auto formattedCmd = std::make_shared<std::string>(std::move(command));
+    if (timeout_ > 0.0)
+    {
+        // A timed out command is still sent when a connection is ready, its
+        // result is dropped.
+        auto expCbPtr = std::make_shared<RedisExceptionCallback>(
+            std::move(exceptionCallback));
+        auto timeoutFlagPtr = std::make_shared<TaskTimeoutFlag>(
+            loops_.getNextLoop(),
+            std::chrono::duration<double>(timeout_),
+            [expCbPtr]() {
+                if (*expCbPtr)
+                {
+                    (*expCbPtr)(RedisException(RedisErrorCode::kTimeout,
+                                               "Command execution timeout"));
+                }
+            });
+        resultCallback = [resultCallback = std::move(resultCallback),
+                          timeoutFlagPtr](const RedisResult &result) {
+            if (timeoutFlagPtr->done())
+                return;
+            if (resultCallback)
+                resultCallback(result);
+        };
+        exceptionCallback = [expCbPtr,
+                             timeoutFlagPtr](const RedisException &err) {
+            if (timeoutFlagPtr->done())
+                return;
+            if (*expCbPtr)
+                (*expCbPtr)(err);
+        };
+        timeoutFlagPtr->runTimer();
+    }
+    NodePtr node;
+    string_view key;
+    if (findCommandKey(*formattedCmd, key))
+        node = nodeOfSlot(hashSlot(key));
+    auto resultCbPtr =
+        std::make_shared<RedisResultCallback>(std::move(resultCallback));
+    auto expCbPtr =
+        std::make_shared<RedisExceptionCallback>(std::move(exceptionCallback));
+    sendCommand(formattedCmd, node, false, 0, resultCbPtr, expCbPtr);
+}
+
+void RedisClusterClient::sendCommand(
+    const std::shared_ptr<std::string> &command,
+    const NodePtr &node,
+    bool asking,
+    int redirections,
+    const std::shared_ptr<RedisResultCallback> &resultCbPtr,
+    const std::shared_ptr<RedisExceptionCallback> &expCbPtr)
+{
+    std::weak_ptr<RedisClusterClient> thisWeakPtr = shared_from_this();
+    runOnNode(
+        node,
+        [thisWeakPtr,
+         command,
+         asking,
+         redirections,
+         resultCbPtr,
+         expCbPtr,
+         queuedTime = trantor::Date::now()](const RedisConnectionPtr &connPtr) {
+            if (auto metrics = drogon::internal::builtinMetrics())
+                metrics->redisPoolWait->observe(
+                    drogon::internal::secondsSince(queuedTime));
+            if (asking)
+            {
+                // The slot is being migrated, the target node only serves
+                // the command right after ASKING on the same connection.
+                connPtr->sendFormattedCommand("*1\r\n$6\r\nASKING\r\n",
+                                              [](const RedisResult &) {},
+                                              [](const RedisException &) {});
+            }
+            connPtr->sendFormattedCommand(
+                std::string(*command),
+                [resultCbPtr](const RedisResult &result) {
+                    (*resultCbPtr)(result);
+                },
+                [thisWeakPtr, command, redirections, resultCbPtr, expCbPtr](
+                    const RedisException &err) {
+                    auto thisPtr = thisWeakPtr.lock();
+                    if (thisPtr && thisPtr->handleRedirection(err,
+                                                              command,
+                                                              redirections,
+                                                              resultCbPtr,
+                                                              expCbPtr))
+                        return;
+                    (*expCbPtr)(err);
+                });
+        });
+}
+
+bool RedisClusterClient::handleRedirection(
+    const RedisException &err,
+    const std::shared_ptr<std::string> &command,
+    int redirections,
+    const std::shared_ptr<RedisResultCallback> &resultCbPtr,
+    const std::shared_ptr<RedisExceptionCallback> &expCbPtr)
+{
+    if (err.code() != RedisErrorCode::kRedisError)
+        return false;
+    // MOVED <slot> <host>:<port> or ASK <slot> <host>:<port>
+    string_view message(err.what());
+    bool moved;
+    if (message.compare(0, 6, "MOVED ") == 0)
+        moved = true;
+    else if (message.compare(0, 4, "ASK ") == 0)
+        moved = false;
+    else
+        return false;
+    if (redirections >= kMaxRedirections)
+    {
+        LOG_ERROR << "Too many redirections of a redis cluster command";
+        return false;
+    }
+    auto slotPos = message.find(' ') + 1;
+    auto addrPos = message.find(' ', slotPos);
+    if (addrPos == string_view::npos)
+        return false;
+    auto slot = strtoul(std::string(message.substr(slotPos, addrPos - slotPos))
+                            .c_str(),
+                        nullptr,
+                        10);
+    auto hostPort = message.substr(addrPos + 1);
+    auto colonPos = hostPort.rfind(':');
+    if (slot >= kSlotsNumber || colonPos == string_view::npos ||
+        colonPos == 0)
+        return false;
+    auto host = std::string(hostPort.substr(0, colonPos));
+    auto port = static_cast<uint16_t>(
+        strtoul(std::string(hostPort.substr(colonPos + 1)).c_str(),
+                nullptr,
+                10));
+    auto isIpV6 = host.find(':') != std::string::npos;
+    auto node = getNode(trantor::InetAddress(host, port, isIpV6));
+    if (moved)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!slots_.empty())
+                slots_[slot] = node;
+        }
+        // Other slots may have moved together, reload the map.
+        refreshSlots();
+    }
+    sendCommand(command, node, !moved, redirections + 1, resultCbPtr, expCbPtr);
+    return true;
+}
+
+void RedisClusterClient::refreshSlots()
+{
+    if (refreshing_.exchange(true))
+        return;
+    NodePtr node;
+    RedisConnectionPtr connPtr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &item : nodes_)
+        {
+            if (!item.second->readyConnections.empty())
+            {
+                node = item.second;
+                connPtr = node->readyConnections.front();
+                break;
+            }
+        }
+    }
+    if (!connPtr)
+    {
+        // The slots are loaded when a connection is established.
+        refreshing_ = false;
+        return;
+    }
+    std::weak_ptr<RedisClusterClient> thisWeakPtr = shared_from_this();
+    connPtr->sendCommand(
+        [thisWeakPtr, node](const RedisResult &result) {
+            auto thisPtr = thisWeakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->updateSlots(result, node);
+            thisPtr->refreshing_ = false;
+        },
+        [thisWeakPtr](const RedisException &err) {
+            LOG_ERROR << "Failed to load the slots of the redis cluster: "
+                      << err.what();
+            auto thisPtr = thisWeakPtr.lock();
+            if (thisPtr)
+                thisPtr->refreshing_ = false;
+        },
+        "cluster slots");
+}
+
+void RedisClusterClient::updateSlots(const RedisResult &result,
+                                     const NodePtr &queriedNode)
+{
+    std::vector<NodePtr> slots(kSlotsNumber);
+    try
+    {
+        // Every item is [first slot, last slot, [master host, port, id], ...]
+        for (auto &range : result.asArray())
+        {
+            auto items = range.asArray();
+            if (items.size() < 3)
+                continue;
+            auto first = items[0].asInteger();
+            auto last = items[1].asInteger();
+            auto master = items[2].asArray();
+            if (master.size() < 2 || first < 0 ||
+                last >= static_cast<long long>(kSlotsNumber) || first > last)
+                continue;
+            auto host = master[0].asString();
+            auto port = static_cast<uint16_t>(master[1].asInteger());
+            // An empty host means the node we asked.
+            auto node =
+                host.empty()
+                    ? getNode(trantor::InetAddress(
+                          queriedNode->address.toIp(),
+                          port,
+                          queriedNode->address.isIpV6()))
+                    : getNode(trantor::InetAddress(
+                          host, port, host.find(':') != std::string::npos));
+            for (auto slot = first; slot <= last; ++slot)
+            {
+                slots[static_cast<size_t>(slot)] = node;
+            }
+        }
+    }
+    catch (const RedisException &err)
+    {
+        LOG_ERROR << "Bad reply of CLUSTER SLOTS: " << err.what();
+        return;
+    }
+    std::vector<RedisConnectionPtr> closedConnections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.swap(slots);
+        std::unordered_map<std::string, NodePtr> nodes;
+        for (auto &node : slots_)
+        {
+            if (node)
+                nodes[node->address.toIpPort()] = node;
+        }
+        if (nodes.empty())
+            return;
+        // Close the connections to the nodes that no longer serve any slot,
+        // unless commands are waiting for them.
+        for (auto &item : nodes_)
+        {
+            auto &node = item.second;
+            if (nodes.find(item.first) != nodes.end())
+                continue;
+            if (!node->tasks.empty())
+            {
+                nodes.insert(item);
+                continue;
+            }
+            node->removed = true;
+            closedConnections.insert(closedConnections.end(),
+                                     node->connections.begin(),
+                                     node->connections.end());
+            node->connections.clear();
+            node->readyConnections.clear();
+        }
+        nodes_.swap(nodes);
+    }
+    for (auto &conn : closedConnections)
+    {
+        conn->disconnect();
+    }
+}
+
+RedisSubscriberPtr RedisClusterClient::newSubscriber() noexcept
+{
+    // Messages published to any node are broadcast to the whole cluster.
+    assert(!seeds_.empty());
+    auto subscriber =
+        std::make_shared<RedisSubscriberImpl>(seeds_.front(),
+                                              password_,
+                                              loops_.getNextLoop(),
+                                              shared_from_this());
+    subscriber->init();
+    return subscriber;
+}
@@ -0,0 +1,144 @@
+/**
+ *
+ *  @file RedisClusterClient.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include "RedisConnection.h"
+#include <drogon/nosql/RedisClient.h>
+#include <drogon/nosql/RedisSubscriber.h>
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/net/EventLoopThreadPool.h>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief A client of a redis cluster. Every command is sent to the master
+ * node that serves the hash slot of its key, the slot map is loaded by the
+ * CLUSTER SLOTS command and is refreshed periodically and when a MOVED
+ * redirection is received.
+ */
+class RedisClusterClient final
+    : public RedisClient,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisClusterClient>
+{
+  public:
+    using RedisClient::execCommandAsync;
+    static constexpr size_t kSlotsNumber = 16384;
+
+    RedisClusterClient(std::vector<trantor::InetAddress> seeds,
+                       size_t connectionsPerNode,
+                       std::string password = "");
+    void execCommandAsync(RedisResultCallback &&resultCallback,
+                          RedisExceptionCallback &&exceptionCallback,
+                          string_view command,
+                          ...) noexcept override;
+    void execFormattedCommandAsync(RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback,
+                                   std::string &&command) noexcept override;
+    ~RedisClusterClient() override;
+    RedisTransactionPtr newTransaction() noexcept(false) override
+    {
+        throw RedisException(
+            RedisErrorCode::kInternalError,
+            "Transactions are not supported by the redis cluster client");
+    }
+    void newTransactionAsync(
+        const std::function<void(const RedisTransactionPtr &)> &callback)
+        override
+    {
+        LOG_ERROR << "Transactions are not supported by the redis cluster "
+                     "client";
+        callback(nullptr);
+    }
+    RedisSubscriberPtr newSubscriber() noexcept override;
+    void setTimeout(double timeout) override
+    {
+        timeout_ = timeout;
+    }
+    void init();
+
+    /// The hash slot of a key, only the hash tag is hashed if the key has
+    /// one, e.g. the slot of "{user1000}.following" is the slot of
+    /// "user1000".
+    static uint16_t hashSlot(string_view key);
+    /**
+     * @brief Find the key that decides the node of a formatted command.
+     *
+     * @return false if the command has no key, e.g. PING.
+     */
+    static bool findCommandKey(const std::string &formattedCommand,
+                               string_view &key);
+
+  private:
+    struct Node
+    {
+        explicit Node(const trantor::InetAddress &addr) : address(addr)
+        {
+        }
+        const trantor::InetAddress address;
+        std::vector<RedisConnectionPtr> connections;
+        std::vector<RedisConnectionPtr> readyConnections;
+        size_t connectionPos{0};
+        // The tasks waiting for a connection to the node.
+        std::deque<std::function<void(const RedisConnectionPtr &)>> tasks;
+        bool removed{false};
+    };
+    using NodePtr = std::shared_ptr<Node>;
+
+    NodePtr getNode(const trantor::InetAddress &address);
+    NodePtr nodeOfSlot(size_t slot);
+    RedisConnectionPtr newConnection(const NodePtr &node,
+                                     trantor::EventLoop *loop);
+    void runOnNode(const NodePtr &node,
+                   std::function<void(const RedisConnectionPtr &)> &&task);
+    void sendCommand(const std::shared_ptr<std::string> &command,
+                     const NodePtr &node,
+                     bool asking,
+                     int redirections,
+                     const std::shared_ptr<RedisResultCallback> &resultCbPtr,
+                     const std::shared_ptr<RedisExceptionCallback> &expCbPtr);
+    /// Follow a MOVED or ASK redirection, return false if the error is not a
+    /// redirection.
+    bool handleRedirection(
+        const RedisException &err,
+        const std::shared_ptr<std::string> &command,
+        int redirections,
+        const std::shared_ptr<RedisResultCallback> &resultCbPtr,
+        const std::shared_ptr<RedisExceptionCallback> &expCbPtr);
+    void refreshSlots();
+    void updateSlots(const RedisResult &result, const NodePtr &queriedNode);
+
+    trantor::EventLoopThreadPool loops_;
+    const std::vector<trantor::InetAddress> seeds_;
+    const std::string password_;
+    const size_t connectionsPerNode_;
+    double timeout_{-1.0};
+    std::mutex mutex_;
+    // "ip:port" -> node
+    std::unordered_map<std::string, NodePtr> nodes_;
+    // The master node of each slot, empty before the slots are loaded.
+    std::vector<NodePtr> slots_;
+    size_t nodePos_{0};
+    std::atomic<bool> refreshing_{false};
+    trantor::TimerId refreshTimerId_{0};
+};
+}  // namespace nosql
+}  // namespace drogon
@@ -15,6 +15,9 @@
 #include "RedisConnection.h"
 #include <drogon/nosql/RedisResult.h>
 #include <future>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace drogon::nosql;
 RedisConnection::RedisConnection(const trantor::InetAddress &serverAddress,
@@ -43,6 +46,7 @@ void RedisConnection::startConnectionInLoop()
             disconnectCallback_(shared_from_this());
         }
     }
+    replyArena_.attach(redisContext_);
     redisContext_->ev.addWrite = addWrite;
     redisContext_->ev.delWrite = delWrite;
     redisContext_->ev.addRead = addRead;
@@ -263,6 +267,65 @@ void RedisConnection::sendCommandInLoop(
         command.length());
 }
 
+void RedisConnection::queueCommand(std::string &&command,
+                                   RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback)
+{
+    bool needFlush;
+    {
+        std::lock_guard<std::mutex> lock(pendingCommandsMutex_);
+        needFlush = pendingCommands_.empty();
+        pendingCommands_.push_back({std::move(command),
+                                    std::move(resultCallback),
+                                    std::move(exceptionCallback)});
+    }
+    // Only the first command of a batch wakes up the event loop, the others
+    // are flushed with it.
+    if (needFlush)
+    {
+        loop_->queueInLoop([thisPtr = shared_from_this()]() {
+            thisPtr->flushPendingCommands();
+        });
+    }
+}
+
+void RedisConnection::flushPendingCommands()
+{
+    std::vector<PendingCommand> commands;
+    {
+        std::lock_guard<std::mutex> lock(pendingCommandsMutex_);
+        commands.swap(pendingCommands_);
+    }
+    // hiredis appends the commands to its output buffer, they are written to
+    // the socket at once when it is writable.
+    for (auto &cmd : commands)
+    {
+        sendCommandInLoop(cmd.command,
+                          std::move(cmd.resultCallback),
+                          std::move(cmd.exceptionCallback));
+    }
+}
+
+void RedisConnection::sendSubscribeCommandInLoop(const std::string &command)
+{
+    if (status_ != ConnectStatus::kConnected)
+        return;
+    // hiredis keeps the callback of every subscribed channel and calls it for
+    // each message, until the channel is unsubscribed.
+    redisAsyncFormattedCommand(
+        redisContext_,
+        [](redisAsyncContext *context, void *r, void * /*userData*/) {
+            auto thisPtr = static_cast<RedisConnection *>(context->ev.data);
+            if (!r || !thisPtr || !thisPtr->subscribeCallback_)
+                return;
+            thisPtr->subscribeCallback_(
+                RedisResult(static_cast<redisReply *>(r)));
+        },
+        nullptr,
+        command.c_str(),
+        command.length());
+}
+
 void RedisConnection::handleResult(redisReply *result)
 {
     auto commandCallback = std::move(resultCallbacks_.front());
@@ -308,3 +371,76 @@ void RedisConnection::disconnect()
     });
     f.get();
 }
+
+std::string RedisConnection::getFormattedCommand(
+    const char *command,
+    const std::vector<std::string> &args) noexcept(false)
+{
+    std::vector<const char *> argv;
+    std::vector<size_t> argvlen;
+    argv.reserve(args.size() + 1);
+    argvlen.reserve(args.size() + 1);
+    argv.push_back(command);
+    argvlen.push_back(strlen(command));
+    for (auto &arg : args)
+    {
+        argv.push_back(arg.data());
+        argvlen.push_back(arg.length());
+    }
+    char *cmd;
+    auto len = redisFormatCommandArgv(&cmd,
+                                      static_cast<int>(argv.size()),
+                                      argv.data(),
+                                      argvlen.data());
+    if (len < 0)
+    {
+        throw RedisException(RedisErrorCode::kInternalError, "Out of memory");
+    }
+    std::string fullCommand{cmd, static_cast<size_t>(len)};
+    free(cmd);
+    return fullCommand;
+}
+
+// Read the number after the type byte at pos of a RESP request, e.g. "*3\r\n"
+// or "$5\r\n", pos is moved to the next line.
+static bool readLength(const std::string &command,
+                       char type,
+                       size_t &pos,
+                       size_t &length)
+{
+    if (pos >= command.length() || command[pos] != type)
+        return false;
+    auto end = command.find("\r\n", pos + 1);
+    if (end == std::string::npos || end == pos + 1)
+        return false;
+    length = 0;
+    for (auto i = pos + 1; i < end; ++i)
+    {
+        if (!isdigit(static_cast<unsigned char>(command[i])))
+            return false;
+        length = length * 10 + static_cast<size_t>(command[i] - '0');
+    }
+    pos = end + 2;
+    return true;
+}
+
+bool RedisConnection::parseFormattedCommand(
+    const std::string &command,
+    std::vector<string_view> &arguments)
+{
+    size_t pos = 0;
+    size_t count;
+    if (!readLength(command, '*', pos, count))
+        return false;
+    arguments.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t length;
+        if (!readLength(command, '$', pos, length) ||
+            pos + length + 2 > command.length())
+            return false;
+        arguments.emplace_back(command.data() + pos, length);
+        pos += length + 2;
+    }
+    return true;
+}
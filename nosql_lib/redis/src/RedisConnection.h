@@ -13,6 +13,7 @@
  */
 
 #pragma once
+#include "RedisReplyArena.h"
 #include <drogon/utils/string_view.h>
 #include <drogon/nosql/RedisException.h>
 #include <drogon/nosql/RedisResult.h>
@@ -23,7 +24,10 @@
 #include <hiredis/async.h>
 #include <hiredis/hiredis.h>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <string>
+#include <vector>
 
 namespace drogon
 {
@@ -86,6 +90,18 @@ class RedisConnection : public trantor::NonCopyable,
         free(cmd);
         return fullCommand;
     }
+    /// Format a command whose arguments may contain any bytes.
+    static std::string getFormattedCommand(
+        const char *command,
+        const std::vector<std::string> &args) noexcept(false);
+    /**
+     * @brief Split a formatted command into its name and arguments.
+     *
+     * @return false if the command is not a well-formed RESP array of bulk
+     * strings.
+     */
+    static bool parseFormattedCommand(const std::string &command,
+                                      std::vector<string_view> &arguments);
     void sendFormattedCommand(std::string &&command,
                               RedisResultCallback &&resultCallback,
                               RedisExceptionCallback &&exceptionCallback)
@@ -98,15 +114,9 @@ class RedisConnection : public trantor::NonCopyable,
         }
         else
         {
-            loop_->queueInLoop(
-                [this,
-                 callback = std::move(resultCallback),
-                 exceptionCallback = std::move(exceptionCallback),
-                 command = std::move(command)]() mutable {
-                    sendCommandInLoop(command,
-                                      std::move(callback),
-                                      std::move(exceptionCallback));
-                });
+            queueCommand(std::move(command),
+                         std::move(resultCallback),
+                         std::move(exceptionCallback));
         }
     }
     void sendvCommand(string_view command,
@@ -126,15 +136,9 @@ class RedisConnection : public trantor::NonCopyable,
             }
             else
             {
-                loop_->queueInLoop(
-                    [this,
-                     callback = std::move(resultCallback),
-                     exceptionCallback = std::move(exceptionCallback),
-                     fullCommand = std::move(fullCommand)]() mutable {
-                        sendCommandInLoop(fullCommand,
-                                          std::move(callback),
-                                          std::move(exceptionCallback));
-                    });
+                queueCommand(std::move(fullCommand),
+                             std::move(resultCallback),
+                             std::move(exceptionCallback));
             }
         }
         catch (const RedisException &err)
@@ -168,7 +172,30 @@ class RedisConnection : public trantor::NonCopyable,
         return loop_;
     }
 
+    /**
+     * @brief Set the callback of the replies to the (un)subscribe commands and
+     * of the messages published to the subscribed channels.
+     */
+    void setSubscribeCallback(
+        const std::function<void(const RedisResult &)> &callback)
+    {
+        subscribeCallback_ = callback;
+    }
+    /**
+     * @brief Send a subscribe, psubscribe, unsubscribe or punsubscribe
+     * command. The connection must not be used for other commands after it
+     * has subscribed.
+     */
+    void sendSubscribeCommand(std::string &&command)
+    {
+        loop_->runInLoop(
+            [thisPtr = shared_from_this(), command = std::move(command)]() {
+                thisPtr->sendSubscribeCommandInLoop(command);
+            });
+    }
+
   private:
+    RedisReplyArena replyArena_;
     redisAsyncContext *redisContext_{nullptr};
     const trantor::InetAddress serverAddr_;
     const std::string password_;
@@ -179,9 +206,20 @@ class RedisConnection : public trantor::NonCopyable,
     std::function<void(std::shared_ptr<RedisConnection> &&)>
         disconnectCallback_;
     std::function<void(const std::shared_ptr<RedisConnection> &)> idleCallback_;
+    std::function<void(const RedisResult &)> subscribeCallback_;
     std::queue<RedisResultCallback> resultCallbacks_;
     std::queue<RedisExceptionCallback> exceptionCallbacks_;
     ConnectStatus status_{ConnectStatus::kNone};
+    struct PendingCommand
+    {
+        std::string command;
+        RedisResultCallback resultCallback;
+        RedisExceptionCallback exceptionCallback;
+    };
+    // The commands sent from other threads, they are written to the context
+    // together in one task of the event loop.
+    std::mutex pendingCommandsMutex_;
+    std::vector<PendingCommand> pendingCommands_;
     void startConnectionInLoop();
     static void addWrite(void *userData);
     static void delWrite(void *userData);
@@ -194,6 +232,11 @@ class RedisConnection : public trantor::NonCopyable,
     void sendCommandInLoop(const std::string &command,
                            RedisResultCallback &&resultCallback,
                            RedisExceptionCallback &&exceptionCallback);
+    void sendSubscribeCommandInLoop(const std::string &command);
+    void queueCommand(std::string &&command,
+                      RedisResultCallback &&resultCallback,
+                      RedisExceptionCallback &&exceptionCallback);
+    void flushPendingCommands();
     void handleDisconnect();
 };
 using RedisConnectionPtr = std::shared_ptr<RedisConnection>;
@@ -0,0 +1,205 @@
+/**
+ *
+ *  @file RedisReplyArena.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisReplyArena.h"
+#include <new>
+#include <string.h>
+
+using namespace drogon::nosql;
+
+namespace
+{
+constexpr size_t kInitialBlockSize = 4096;
+// The blocks larger than this are freed when they are not used.
+constexpr size_t kMaxKeptBlockSize = 1024 * 1024;
+}  // namespace
+
+// The reader of hiredis older than 1.0 doesn't pass its private data to the
+// functions and doesn't parse RESP3, the replies are built by hiredis there.
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+
+void RedisReplyArena::attach(redisAsyncContext *context)
+{
+    static redisReplyObjectFunctions functions{createString,
+                                               createArray,
+                                               createInteger,
+                                               createDouble,
+                                               createNil,
+                                               createBool,
+                                               freeObject};
+    auto reader = context->c.reader;
+    if (!reader)
+        return;
+    reader->fn = &functions;
+    reader->privdata = this;
+}
+
+redisReply *RedisReplyArena::createReply(const redisReadTask *task)
+{
+    auto arena = static_cast<RedisReplyArena *>(task->privdata);
+    redisReply *reply;
+    if (task->parent)
+    {
+        reply = new (arena->allocate(sizeof(redisReply), alignof(redisReply)))
+            redisReply();
+        auto parent = static_cast<redisReply *>(task->parent->obj);
+        parent->element[task->idx] = reply;
+    }
+    else
+    {
+        auto root =
+            new (arena->allocate(sizeof(RootReply), alignof(RootReply)))
+                RootReply{arena, redisReply()};
+        ++arena->liveReplies_;
+        reply = &root->reply;
+    }
+    reply->type = task->type;
+    return reply;
+}
+
+void *RedisReplyArena::createString(const redisReadTask *task,
+                                    char *str,
+                                    size_t len)
+{
+    auto reply = createReply(task);
+    auto arena = static_cast<RedisReplyArena *>(task->privdata);
+    if (task->type == REDIS_REPLY_VERB && len >= 4 && str[3] == ':')
+    {
+        // The format of a verbatim string is "txt:<the string>".
+        memcpy(reply->vtype, str, 3);
+        reply->vtype[3] = '\0';
+        str += 4;
+        len -= 4;
+    }
+    reply->str = arena->copyString(str, len);
+    reply->len = len;
+    return reply;
+}
+
+void *RedisReplyArena::createArray(const redisReadTask *task, size_t elements)
+{
+    auto reply = createReply(task);
+    if (elements > 0)
+    {
+        auto arena = static_cast<RedisReplyArena *>(task->privdata);
+        reply->element = reinterpret_cast<redisReply **>(
+            arena->allocate(elements * sizeof(redisReply *),
+                            alignof(redisReply *)));
+        memset(reply->element, 0, elements * sizeof(redisReply *));
+    }
+    reply->elements = elements;
+    return reply;
+}
+
+void *RedisReplyArena::createInteger(const redisReadTask *task,
+                                     long long value)
+{
+    auto reply = createReply(task);
+    reply->integer = value;
+    return reply;
+}
+
+void *RedisReplyArena::createDouble(const redisReadTask *task,
+                                    double value,
+                                    char *str,
+                                    size_t len)
+{
+    auto reply = createReply(task);
+    auto arena = static_cast<RedisReplyArena *>(task->privdata);
+    reply->dval = value;
+    // The text is kept, it's the exact value sent by the server.
+    reply->str = arena->copyString(str, len);
+    reply->len = len;
+    return reply;
+}
+
+void *RedisReplyArena::createNil(const redisReadTask *task)
+{
+    return createReply(task);
+}
+
+void *RedisReplyArena::createBool(const redisReadTask *task, int value)
+{
+    auto reply = createReply(task);
+    reply->integer = value != 0;
+    return reply;
+}
+
+void RedisReplyArena::freeObject(void *reply)
+{
+    // hiredis only frees the roots of replies.
+    if (!reply)
+        return;
+    auto root = reinterpret_cast<RootReply *>(static_cast<char *>(reply) -
+                                              offsetof(RootReply, reply));
+    root->arena->releaseReply();
+}
+
+#else
+
+void RedisReplyArena::attach(redisAsyncContext * /*context*/)
+{
+}
+
+#endif
+
+char *RedisReplyArena::allocate(size_t size, size_t alignment)
+{
+    if (!blocks_.empty())
+    {
+        auto offset = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= blocks_.back().size)
+        {
+            offset_ = offset + size;
+            return blocks_.back().data.get() + offset;
+        }
+    }
+    // Every new block is twice as large as the last one, unless a larger
+    // string needs more.
+    auto blockSize =
+        blocks_.empty() ? kInitialBlockSize : blocks_.back().size * 2;
+    if (blockSize < size)
+        blockSize = size;
+    blocks_.push_back(Block{std::unique_ptr<char[]>(new char[blockSize]),
+                            blockSize});
+    offset_ = size;
+    return blocks_.back().data.get();
+}
+
+char *RedisReplyArena::copyString(const char *str, size_t len)
+{
+    auto data = allocate(len + 1, 1);
+    memcpy(data, str, len);
+    data[len] = '\0';
+    return data;
+}
+
+void RedisReplyArena::releaseReply()
+{
+    if (--liveReplies_ > 0)
+        return;
+    offset_ = 0;
+    if (blocks_.size() == 1 && blocks_[0].size <= kMaxKeptBlockSize)
+        return;
+    // Replace the blocks with one block that holds a reply of the same size
+    // next time.
+    size_t total = 0;
+    for (auto &block : blocks_)
+        total += block.size;
+    if (total > kMaxKeptBlockSize)
+        total = kMaxKeptBlockSize;
+    blocks_.clear();
+    blocks_.push_back(
+        Block{std::unique_ptr<char[]>(new char[total]), total});
+}
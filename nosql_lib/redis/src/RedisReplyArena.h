@@ -0,0 +1,87 @@
+/**
+ *
+ *  @file RedisReplyArena.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <hiredis/async.h>
+#include <hiredis/hiredis.h>
+#include <memory>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief The memory of the replies received by a connection. The reader of
+ * hiredis parses the RESP2/RESP3 replies and builds them with the functions
+ * of this class, so the elements and strings of a reply are allocated in a
+ * few blocks instead of with one malloc for each, and they are freed at once
+ * when hiredis frees the reply after its callback is returned.
+ *
+ * The blocks are reused by the following replies, so a connection that
+ * receives large arrays, e.g. the replies to MGET or HGETALL, doesn't
+ * allocate memory for them after the first one.
+ */
+class RedisReplyArena : public trantor::NonCopyable
+{
+  public:
+    RedisReplyArena() = default;
+
+    /**
+     * @brief Make the reader of the context build its replies in this arena.
+     * The arena must outlive the context.
+     */
+    void attach(redisAsyncContext *context);
+
+  private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    // The root of a reply carries the arena, because hiredis frees a reply
+    // without the reader.
+    struct RootReply
+    {
+        RedisReplyArena *arena;
+        redisReply reply;
+    };
+
+    static void *createString(const redisReadTask *task,
+                              char *str,
+                              size_t len);
+    static void *createArray(const redisReadTask *task, size_t elements);
+    static void *createInteger(const redisReadTask *task, long long value);
+    static void *createDouble(const redisReadTask *task,
+                              double value,
+                              char *str,
+                              size_t len);
+    static void *createNil(const redisReadTask *task);
+    static void *createBool(const redisReadTask *task, int value);
+    static void freeObject(void *reply);
+
+    static redisReply *createReply(const redisReadTask *task);
+    char *allocate(size_t size, size_t alignment);
+    char *copyString(const char *str, size_t len);
+    void releaseReply();
+
+    std::vector<Block> blocks_;
+    size_t offset_{0};
+    // The number of replies that are built but not freed yet, the blocks are
+    // reused when it drops to zero.
+    size_t liveReplies_{0};
+};
+}  // namespace nosql
+}  // namespace drogon
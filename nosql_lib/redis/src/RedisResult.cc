@@ -29,8 +29,15 @@ std::string RedisResult::getStringForDisplayingWithIndent(
     switch (result_->type)
     {
         case REDIS_REPLY_STRING:
+#ifdef REDIS_REPLY_VERB
+        case REDIS_REPLY_VERB:
+#endif
             return "\"" + std::string{result_->str, result_->len} + "\"";
         case REDIS_REPLY_STATUS:
+#ifdef REDIS_REPLY_DOUBLE
+        case REDIS_REPLY_DOUBLE:
+        case REDIS_REPLY_BIGNUM:
+#endif
             return std::string{result_->str, result_->len};
         case REDIS_REPLY_ERROR:
             return "'ERROR:" + std::string{result_->str, result_->len} + "'";
@@ -38,7 +45,17 @@ std::string RedisResult::getStringForDisplayingWithIndent(
             return "(nil)";
         case REDIS_REPLY_INTEGER:
             return std::to_string(result_->integer);
+#ifdef REDIS_REPLY_BOOL
+        case REDIS_REPLY_BOOL:
+            return result_->integer ? "(true)" : "(false)";
+#endif
         case REDIS_REPLY_ARRAY:
+#ifdef REDIS_REPLY_MAP
+        case REDIS_REPLY_MAP:
+        case REDIS_REPLY_SET:
+        case REDIS_REPLY_ATTR:
+        case REDIS_REPLY_PUSH:
+#endif
         {
             std::string ret;
             for (size_t i = 0; i < result_->elements; ++i)
@@ -86,10 +103,24 @@ RedisResultType RedisResult::type() const noexcept
     switch (result_->type)
     {
         case REDIS_REPLY_STRING:
+#ifdef REDIS_REPLY_DOUBLE
+        case REDIS_REPLY_DOUBLE:
+        case REDIS_REPLY_BIGNUM:
+        case REDIS_REPLY_VERB:
+#endif
             return RedisResultType::kString;
         case REDIS_REPLY_ARRAY:
+#ifdef REDIS_REPLY_MAP
+        case REDIS_REPLY_MAP:
+        case REDIS_REPLY_SET:
+        case REDIS_REPLY_ATTR:
+        case REDIS_REPLY_PUSH:
+#endif
             return RedisResultType::kArray;
         case REDIS_REPLY_INTEGER:
+#ifdef REDIS_REPLY_BOOL
+        case REDIS_REPLY_BOOL:
+#endif
             return RedisResultType::kInteger;
         case REDIS_REPLY_NIL:
             return RedisResultType::kNil;
@@ -107,6 +138,7 @@ std::vector<RedisResult> RedisResult::asArray() const noexcept(false)
     if (rtype == RedisResultType::kArray)
     {
         std::vector<RedisResult> array;
+        array.reserve(result_->elements);
         for (size_t i = 0; i < result_->elements; ++i)
         {
             array.emplace_back(result_->element[i]);
@@ -115,6 +147,45 @@ std::vector<RedisResult> RedisResult::asArray() const noexcept(false)
     }
     throw RedisException(RedisErrorCode::kBadType, "bad type");
 }
+drogon::string_view RedisResult::asStringView() const noexcept(false)
+{
+    auto rtype = type();
+    if (rtype == RedisResultType::kString ||
+        rtype == RedisResultType::kStatus || rtype == RedisResultType::kError)
+    {
+        return string_view(result_->str, result_->len);
+    }
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+size_t RedisResult::arraySize() const noexcept(false)
+{
+    if (type() == RedisResultType::kArray)
+        return result_->elements;
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+RedisResult RedisResult::operator[](size_t index) const noexcept(false)
+{
+    if (type() == RedisResultType::kArray)
+        return RedisResult(result_->element[index]);
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+RedisResult::ConstIterator RedisResult::begin() const noexcept(false)
+{
+    if (type() == RedisResultType::kArray)
+        return ConstIterator(result_->element);
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+RedisResult::ConstIterator RedisResult::end() const noexcept(false)
+{
+    if (type() == RedisResultType::kArray)
+        return ConstIterator(result_->element + result_->elements);
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
 long long RedisResult::asInteger() const noexcept(false)
 {
     if (type() == RedisResultType::kInteger)
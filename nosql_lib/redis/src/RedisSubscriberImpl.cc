@@ -0,0 +1,208 @@
+/**
+ *
+ *  @file RedisSubscriberImpl.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisSubscriberImpl.h"
+
+using namespace drogon::nosql;
+
+RedisSubscriberImpl::RedisSubscriberImpl(
+    const trantor::InetAddress &serverAddress,
+    std::string password,
+    trantor::EventLoop *loop,
+    std::shared_ptr<void> owner)
+    : serverAddr_(serverAddress),
+      password_(std::move(password)),
+      loop_(loop),
+      owner_(std::move(owner))
+{
+}
+
+RedisSubscriberImpl::~RedisSubscriberImpl()
+{
+    RedisConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection = std::move(connection_);
+    }
+    if (connection)
+        connection->disconnect();
+}
+
+void RedisSubscriberImpl::init()
+{
+    std::weak_ptr<RedisSubscriberImpl> weakThis = shared_from_this();
+    loop_->queueInLoop([weakThis]() {
+        if (auto thisPtr = weakThis.lock())
+            thisPtr->connect();
+    });
+}
+
+void RedisSubscriberImpl::connect()
+{
+    // Pub/Sub channels don't belong to any database, so no db is selected.
+    auto connection =
+        std::make_shared<RedisConnection>(serverAddr_, password_, 0, loop_);
+    std::weak_ptr<RedisSubscriberImpl> weakThis = shared_from_this();
+    connection->setSubscribeCallback([weakThis](const RedisResult &result) {
+        if (auto thisPtr = weakThis.lock())
+            thisPtr->handleReply(result);
+    });
+    connection->setConnectCallback([weakThis](RedisConnectionPtr &&conn) {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        std::vector<std::string> channels, patterns;
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            thisPtr->connection_ = conn;
+            for (auto &subscription : thisPtr->channels_)
+                channels.push_back(subscription.first);
+            for (auto &subscription : thisPtr->patterns_)
+                patterns.push_back(subscription.first);
+        }
+        // Renew all subscriptions after reconnecting.
+        if (!channels.empty())
+            conn->sendSubscribeCommand(
+                RedisConnection::getFormattedCommand("subscribe", channels));
+        if (!patterns.empty())
+            conn->sendSubscribeCommand(
+                RedisConnection::getFormattedCommand("psubscribe", patterns));
+    });
+    connection->setDisconnectCallback([weakThis](RedisConnectionPtr &&conn) {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+            if (thisPtr->connection_ == conn)
+                thisPtr->connection_.reset();
+        }
+        thisPtr->loop_->runAfter(2.0, [weakThis, conn]() {
+            if (auto thisPtr = weakThis.lock())
+                thisPtr->connect();
+        });
+    });
+}
+
+void RedisSubscriberImpl::subscribe(const std::string &channel,
+                                    MessageHandler &&handler) noexcept
+{
+    addSubscription(channels_, "subscribe", channel, std::move(handler));
+}
+
+void RedisSubscriberImpl::psubscribe(const std::string &pattern,
+                                     MessageHandler &&handler) noexcept
+{
+    addSubscription(patterns_, "psubscribe", pattern, std::move(handler));
+}
+
+void RedisSubscriberImpl::unsubscribe(const std::string &channel) noexcept
+{
+    removeSubscription(channels_, "unsubscribe", channel);
+}
+
+void RedisSubscriberImpl::punsubscribe(const std::string &pattern) noexcept
+{
+    removeSubscription(patterns_, "punsubscribe", pattern);
+}
+
+void RedisSubscriberImpl::addSubscription(SubscriptionMap &subscriptions,
+                                          const char *command,
+                                          const std::string &name,
+                                          MessageHandler &&handler)
+{
+    auto subscription = std::make_shared<Subscription>();
+    subscription->handler = std::move(handler);
+    subscription->loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!subscription->loop)
+        subscription->loop = loop_;
+    RedisConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &item = subscriptions[name];
+        // A new handler of a subscribed name doesn't need a new command.
+        if (!item)
+            connection = connection_;
+        item = std::move(subscription);
+    }
+    if (connection)
+        connection->sendSubscribeCommand(
+            RedisConnection::getFormattedCommand(command, {name}));
+}
+
+void RedisSubscriberImpl::removeSubscription(SubscriptionMap &subscriptions,
+                                             const char *command,
+                                             const std::string &name)
+{
+    RedisConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (subscriptions.erase(name) == 0)
+            return;
+        connection = connection_;
+    }
+    if (connection)
+        connection->sendSubscribeCommand(
+            RedisConnection::getFormattedCommand(command, {name}));
+}
+
+void RedisSubscriberImpl::handleReply(const RedisResult &result)
+{
+    if (result.type() != RedisResultType::kArray)
+        return;
+    auto items = result.asArray();
+    if (items.size() < 3)
+        return;
+    // ["message", channel, message] or
+    // ["pmessage", pattern, channel, message], the replies to the
+    // (un)subscribe commands are ignored.
+    auto kind = items[0].asString();
+    if (kind == "message")
+    {
+        auto channel = items[1].asString();
+        dispatch(channels_, channel, channel, items[2].asString());
+    }
+    else if (kind == "pmessage" && items.size() >= 4)
+    {
+        dispatch(patterns_,
+                 items[1].asString(),
+                 items[2].asString(),
+                 items[3].asString());
+    }
+}
+
+void RedisSubscriberImpl::dispatch(SubscriptionMap &subscriptions,
+                                   const std::string &name,
+                                   std::string channel,
+                                   std::string message)
+{
+    std::shared_ptr<Subscription> subscription;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = subscriptions.find(name);
+        if (iter == subscriptions.end())
+            return;
+        subscription = iter->second;
+    }
+    if (subscription->loop->isInLoopThread())
+    {
+        subscription->handler(channel, message);
+        return;
+    }
+    subscription->loop->queueInLoop([subscription,
+                                     channel = std::move(channel),
+                                     message = std::move(message)]() {
+        subscription->handler(channel, message);
+    });
+}
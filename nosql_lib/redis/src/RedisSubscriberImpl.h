@@ -0,0 +1,87 @@
+/**
+ *
+ *  @file RedisSubscriberImpl.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "RedisConnection.h"
+#include <drogon/nosql/RedisSubscriber.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+class RedisSubscriberImpl final
+    : public RedisSubscriber,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisSubscriberImpl>
+{
+  public:
+    /**
+     * @param owner The object that owns the event loop, it is kept alive
+     * until the subscriber is destroyed.
+     */
+    RedisSubscriberImpl(const trantor::InetAddress &serverAddress,
+                        std::string password,
+                        trantor::EventLoop *loop,
+                        std::shared_ptr<void> owner);
+    ~RedisSubscriberImpl() override;
+    void init();
+    void subscribe(const std::string &channel,
+                   MessageHandler &&handler) noexcept override;
+    void psubscribe(const std::string &pattern,
+                    MessageHandler &&handler) noexcept override;
+    void unsubscribe(const std::string &channel) noexcept override;
+    void punsubscribe(const std::string &pattern) noexcept override;
+
+  private:
+    struct Subscription
+    {
+        MessageHandler handler;
+        trantor::EventLoop *loop;
+    };
+    using SubscriptionMap =
+        std::unordered_map<std::string, std::shared_ptr<Subscription>>;
+
+    void connect();
+    void handleReply(const RedisResult &result);
+    void addSubscription(SubscriptionMap &subscriptions,
+                         const char *command,
+                         const std::string &name,
+                         MessageHandler &&handler);
+    void removeSubscription(SubscriptionMap &subscriptions,
+                            const char *command,
+                            const std::string &name);
+    void dispatch(SubscriptionMap &subscriptions,
+                  const std::string &name,
+                  std::string channel,
+                  std::string message);
+
+    const trantor::InetAddress serverAddr_;
+    const std::string password_;
+    trantor::EventLoop *loop_;
+    std::shared_ptr<void> owner_;
+    std::mutex mutex_;
+    SubscriptionMap channels_;
+    SubscriptionMap patterns_;
+    // The connection that has subscribed, or nullptr when it's not connected.
+    RedisConnectionPtr connection_;
+};
+}  // namespace nosql
+}  // namespace drogon
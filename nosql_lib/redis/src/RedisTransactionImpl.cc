@@ -39,6 +39,30 @@ void RedisTransactionImpl::execCommandAsync(
     RedisExceptionCallback &&exceptionCallback,
     string_view command,
     ...) noexcept
+{
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(resultCallback),
+                              std::move(exceptionCallback),
+                              std::move(formattedCmd));
+}
+
+void RedisTransactionImpl::execFormattedCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string &&command) noexcept
 {
     if (isExecutedOrCancelled_)
     {
@@ -48,10 +72,8 @@ void RedisTransactionImpl::execCommandAsync(
     }
     if (timeout_ <= 0.0)
     {
-        va_list args;
-        va_start(args, command);
-        connPtr_->sendvCommand(
-            command,
+        connPtr_->sendFormattedCommand(
+            std::move(command),
             std::move(resultCallback),
             [thisPtr = shared_from_this(),
              exceptionCallback =
@@ -59,9 +81,7 @@ void RedisTransactionImpl::execCommandAsync(
                 LOG_ERROR << err.what();
                 thisPtr->isExecutedOrCancelled_ = true;
                 exceptionCallback(err);
-            },
-            args);
-        va_end(args);
+            });
     }
     else
     {
@@ -77,10 +97,8 @@ void RedisTransactionImpl::execCommandAsync(
                                                "Command execution timeout"));
                 }
             });
-        va_list args;
-        va_start(args, command);
-        connPtr_->sendvCommand(
-            command,
+        connPtr_->sendFormattedCommand(
+            std::move(command),
             [resultCallback = std::move(resultCallback),
              timeoutFlagPtr](const RedisResult &result) {
                 if (timeoutFlagPtr->done())
@@ -99,9 +117,7 @@ void RedisTransactionImpl::execCommandAsync(
                 thisPtr->isExecutedOrCancelled_ = true;
                 if (*expCbPtr)
                     (*expCbPtr)(err);
-            },
-            args);
-        va_end(args);
+            });
         timeoutFlagPtr->runTimer();
     }
 }
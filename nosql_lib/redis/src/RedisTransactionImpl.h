@@ -26,6 +26,7 @@ class RedisTransactionImpl final
       public std::enable_shared_from_this<RedisTransactionImpl>
 {
   public:
+    using RedisClient::execCommandAsync;
     explicit RedisTransactionImpl(RedisConnectionPtr connection) noexcept;
     // virtual void cancel() override;
     void execute(RedisResultCallback &&resultCallback,
@@ -34,6 +35,9 @@ class RedisTransactionImpl final
                           RedisExceptionCallback &&exceptionCallback,
                           string_view command,
                           ...) noexcept override;
+    void execFormattedCommandAsync(RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback,
+                                   std::string &&command) noexcept override;
     std::shared_ptr<RedisTransaction> newTransaction() override
     {
         return shared_from_this();
@@ -44,6 +48,11 @@ class RedisTransactionImpl final
     {
         callback(shared_from_this());
     }
+    std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override
+    {
+        LOG_ERROR << "You can't create a subscriber in a transaction";
+        return nullptr;
+    }
     void setTimeout(double timeout) override
     {
         timeout_ = timeout;
@@ -0,0 +1,92 @@
+#define DROGON_TEST_MAIN
+#include <drogon/nosql/RedisClient.h>
+#include <drogon/drogon_test.h>
+#include <drogon/drogon.h>
+#include <string>
+#include <thread>
+
+using namespace drogon::nosql;
+
+// Run ./start_cluster.sh first, it starts a cluster of three masters on the
+// ports 7000, 7001 and 7002.
+RedisClientPtr redisClient;
+DROGON_TEST(RedisClusterTest)
+{
+    redisClient = RedisClient::newRedisClusterClient(
+        {trantor::InetAddress("127.0.0.1", 7000)}, 2);
+    REQUIRE(redisClient != nullptr);
+    // 1 The keys are spread over the slots of all nodes
+    for (int i = 0; i < 100; ++i)
+    {
+        auto key = "drogon_key_" + std::to_string(i);
+        auto value = std::to_string(i * i);
+        redisClient->execCommandAsync(
+            [TEST_CTX, key, value](const RedisResult &) {
+                redisClient->execCommandAsync(
+                    [TEST_CTX, value](const RedisResult &r) {
+                        MANDATE(r.asString() == value);
+                    },
+                    [TEST_CTX](const RedisException &err) {
+                        FAULT(err.what());
+                    },
+                    "get %s",
+                    key.c_str());
+            },
+            [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+            "set %s %s",
+            key.c_str(),
+            value.c_str());
+    }
+    // 2 The keys with the same hash tag are in the same slot
+    redisClient->execCommandAsync(
+        [TEST_CTX](const RedisResult &) {
+            redisClient->execCommandAsync(
+                [TEST_CTX](const RedisResult &r) {
+                    MANDATE(r.type() == RedisResultType::kArray);
+                    auto values = r.asArray();
+                    MANDATE(values.size() == 2UL);
+                    CHECK(values[0].asString() == "a");
+                    CHECK(values[1].asString() == "b");
+                },
+                [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+                "mget {drogon}.first {drogon}.second");
+        },
+        [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+        "mset {drogon}.first a {drogon}.second b");
+    // 3 Commands without keys are sent to any node
+    redisClient->execCommandAsync(
+        [TEST_CTX](const RedisResult &r) { MANDATE(r.asString() == "PONG"); },
+        [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+        "ping");
+    // 4 The keys of a script
+    redisClient->execCommandAsync(
+        [TEST_CTX](const RedisResult &r) { MANDATE(r.asInteger() == 1); },
+        [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+        "eval %s 1 %s",
+        "return redis.call('exists', KEYS[1])",
+        "drogon_key_42");
+    // 5
+    CHECK_THROWS_AS(redisClient->newTransaction(), RedisException);
+}
+
+int main(int argc, char **argv)
+{
+#ifndef USE_REDIS
+    LOG_DEBUG << "Drogon is built without Redis. No tests executed.";
+    return 0;
+#endif
+    std::promise<void> p1;
+    std::future<void> f1 = p1.get_future();
+
+    std::thread thr([&]() {
+        p1.set_value();
+        drogon::app().run();
+    });
+
+    f1.get();
+    int testStatus = drogon::test::run(argc, argv);
+    redisClient.reset();
+    drogon::app().getLoop()->queueInLoop([]() { drogon::app().quit(); });
+    thr.join();
+    return testStatus;
+}
@@ -1,5 +1,6 @@
 #define DROGON_TEST_MAIN
 #include <drogon/nosql/RedisClient.h>
+#include <drogon/nosql/RedisSubscriber.h>
 #include <drogon/drogon_test.h>
 #include <drogon/drogon.h>
 #include <iostream>
@@ -9,6 +10,7 @@ using namespace std::chrono_literals;
 using namespace drogon::nosql;
 
 RedisClientPtr redisClient;
+RedisSubscriberPtr redisSubscriber;
 DROGON_TEST(RedisTest)
 {
     redisClient = drogon::nosql::RedisClient::newRedisClient(
@@ -64,10 +66,28 @@ DROGON_TEST(RedisTest)
         [TEST_CTX](const RedisException &err) { MANDATE(err.what()); },
         "get %s",
         "xxxxx");
+    // 8
+    redisSubscriber = redisClient->newSubscriber();
+    redisSubscriber->subscribe("drogon_test_channel",
+                               [TEST_CTX](const std::string &channel,
+                                          const std::string &message) {
+                                   MANDATE(channel == "drogon_test_channel");
+                                   MANDATE(message == "hello");
+                                   // Release the test context
+                                   redisSubscriber->unsubscribe(channel);
+                               });
+    // Publish after the subscription is made
+    drogon::app().getLoop()->runAfter(1.0, []() {
+        redisClient->execCommandAsync([](const RedisResult &) {},
+                                      [](const RedisException &) {},
+                                      "publish %s %s",
+                                      "drogon_test_channel",
+                                      "hello");
+    });
 
 #ifdef __cpp_impl_coroutine
     auto coro_test = [TEST_CTX]() -> drogon::Task<> {
-        // 8
+        // 9
         try
         {
             auto r = co_await redisClient->execCommandCoro("get %s", "haha");
@@ -82,6 +102,107 @@ DROGON_TEST(RedisTest)
 #endif
 }
 
+DROGON_TEST(RedisCommandTest)
+{
+    // After the flushall of RedisTest.
+    drogon::app().getLoop()->runAfter(1.0, [TEST_CTX]() {
+        // 1 The arguments may contain spaces and line breaks
+        const std::string value = "hello world\r\n%s";
+        redisClient->execCommandAsync(
+            [TEST_CTX](const RedisResult &r) {
+                MANDATE(r.asString() == "OK");
+            },
+            [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+            RedisCommand("set", "drogon_cmd:key", value));
+        redisClient->execCommandAsync(
+            [TEST_CTX, value](const RedisResult &r) {
+                MANDATE(r.asString() == value);
+            },
+            [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+            RedisCommand("get", "drogon_cmd:key"));
+        // 2 The commands sent in a burst keep their order
+        for (int i = 0; i < 10; ++i)
+        {
+            redisClient->execCommandAsync(
+                [TEST_CTX, i](const RedisResult &r) {
+                    MANDATE(r.asInteger() == i + 1);
+                },
+                [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+                RedisCommand("rpush", "drogon_cmd:list", i));
+        }
+        redisClient->execCommandAsync(
+            [TEST_CTX](const RedisResult &r) {
+                auto items = r.asArray();
+                MANDATE(items.size() == 10UL);
+                for (size_t i = 0; i < items.size(); ++i)
+                    CHECK(items[i].asString() == std::to_string(i));
+                // The elements are viewed without copying
+                MANDATE(r.arraySize() == 10UL);
+                size_t i = 0;
+                for (auto item : r)
+                {
+                    CHECK(item.asStringView() == std::to_string(i));
+                    ++i;
+                }
+                CHECK(i == 10UL);
+                CHECK(r[9].asStringView() == "9");
+            },
+            [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+            RedisCommand("lrange", "drogon_cmd:list", 0, -1));
+    });
+}
+
+RedisClientPtr cachedRedisClient;
+DROGON_TEST(RedisClientCacheTest)
+{
+    cachedRedisClient = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    cachedRedisClient->enableClientSideCaching(100, {"drogon_cache:"});
+    // Wait for the cache to subscribe and for the flushall of RedisTest.
+    drogon::app().getLoop()->runAfter(2.0, [TEST_CTX]() {
+        redisClient->execCommandAsync(
+            [TEST_CTX](const RedisResult &) {
+                // 1 The reply is cached, 2 then served from the cache
+                cachedRedisClient->execCommandAsync(
+                    [TEST_CTX](const RedisResult &r) {
+                        MANDATE(r.asString() == "v1");
+                        cachedRedisClient->execCommandAsync(
+                            [TEST_CTX](const RedisResult &r) {
+                                MANDATE(r.asString() == "v1");
+                            },
+                            [TEST_CTX](const RedisException &err) {
+                                FAULT(err.what());
+                            },
+                            "get drogon_cache:key");
+                    },
+                    [TEST_CTX](const RedisException &err) {
+                        FAULT(err.what());
+                    },
+                    "get drogon_cache:key");
+            },
+            [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+            "set drogon_cache:key v1");
+    });
+    // 3 The change of the key evicts it from the cache
+    drogon::app().getLoop()->runAfter(3.0, [TEST_CTX]() {
+        redisClient->execCommandAsync(
+            [TEST_CTX](const RedisResult &) {
+                drogon::app().getLoop()->runAfter(0.5, [TEST_CTX]() {
+                    cachedRedisClient->execCommandAsync(
+                        [TEST_CTX](const RedisResult &r) {
+                            MANDATE(r.asString() == "v2");
+                        },
+                        [TEST_CTX](const RedisException &err) {
+                            FAULT(err.what());
+                        },
+                        "get drogon_cache:key");
+                });
+            },
+            [TEST_CTX](const RedisException &err) { FAULT(err.what()); },
+            "set drogon_cache:key v2");
+    });
+}
+
 int main(int argc, char **argv)
 {
 #ifndef USE_REDIS
@@ -98,6 +219,8 @@ int main(int argc, char **argv)
 
     f1.get();
     int testStatus = drogon::test::run(argc, argv);
+    redisSubscriber.reset();
+    cachedRedisClient.reset();
     drogon::app().getLoop()->queueInLoop([]() { drogon::app().quit(); });
     thr.join();
     return testStatus;
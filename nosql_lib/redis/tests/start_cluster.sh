@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+
+# Start a redis cluster of three masters on the ports 7000, 7001 and 7002 for
+# redis_cluster_test, run "./start_cluster.sh stop" to stop it.
+
+ports="7000 7001 7002"
+dir=${REDIS_CLUSTER_DIR:-/tmp/drogon_redis_cluster}
+
+if [ "$1" == "stop" ]; then
+    for port in $ports; do
+        redis-cli -p $port shutdown nosave >/dev/null 2>&1
+    done
+    rm -rf $dir
+    exit 0
+fi
+
+nodes=""
+for port in $ports; do
+    mkdir -p $dir/$port
+    redis-server --port $port --cluster-enabled yes \
+        --cluster-config-file nodes.conf --dir $dir/$port \
+        --save "" --appendonly no --daemonize yes || exit 1
+    nodes="$nodes 127.0.0.1:$port"
+done
+
+for port in $ports; do
+    until redis-cli -p $port ping >/dev/null 2>&1; do
+        sleep 0.1
+    done
+done
+
+redis-cli --cluster create $nodes --cluster-replicas 0 --cluster-yes || exit 1
+
+until redis-cli -p 7000 cluster info | grep -q "cluster_state:ok"; do
+    sleep 0.1
+done
@@ -320,6 +320,19 @@ class CoroMapper : public Mapper<T>
             };
         return internal::MapperAwaiter<T>(std::move(lb));
     }
+    inline internal::MapperAwaiter<size_t> insertBatch(
+        const std::vector<T> &objs)
+    {
+        auto lb =
+            [this, objsPtr = std::make_shared<std::vector<T>>(objs)](
+                std::function<void(const size_t)> &&callback,
+                std::function<void(const std::exception_ptr &)> &&errCallback) {
+                Mapper<T>::insertBatch(objsPtr,
+                                       std::move(callback),
+                                       std::move(errCallback));
+            };
+        return internal::MapperAwaiter<size_t>(std::move(lb));
+    }
     inline internal::MapperAwaiter<size_t> update(const T &obj)
     {
         auto lb =
@@ -42,6 +42,24 @@ using ExceptionCallback = std::function<void(const DrogonDbException &)>;
 
 class Transaction;
 class DbClient;
+class DbClientRouter;
+
+/// Statistics of the SQL commands dispatched by a database client
+struct QueryQueueStats
+{
+    /// The number of SQL commands waiting for idle connections
+    size_t pendingQueries{0};
+    /// The number of SQL commands that have been sent to connections
+    uint64_t dispatchedQueries{0};
+    /// The number of SQL commands rejected because the queue is full
+    uint64_t rejectedQueries{0};
+    /// The sum of the time dispatched commands spent in the queue, in
+    /// microseconds
+    uint64_t totalWaitTime{0};
+    /// The longest time a dispatched command spent in the queue, in
+    /// microseconds
+    uint64_t maxWaitTime{0};
+};
 
 namespace internal
 {
@@ -82,10 +100,143 @@ struct TransactionAwaiter
     DbClient *client_;
 };
 
+/// The state shared by a SqlStream object and the callbacks of its query
+struct SqlStreamState
+{
+    std::mutex mutex_;
+    optional<Result> rows_;
+    std::exception_ptr exception_;
+    // The function reading the batch after the one in rows_
+    std::function<void(bool)> resume_;
+    // The function reading the batch after the one returned last
+    std::function<void(bool)> nextResume_;
+    std::coroutine_handle<> handle_;
+    bool isEnd_{false};
+    bool isCancelled_{false};
+
+    void push(const Result &rows, std::function<void(bool)> &&resume)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (isCancelled_)
+        {
+            lock.unlock();
+            if (rows.size() > 0)
+                resume(false);
+            return;
+        }
+        rows_.emplace(rows);
+        isEnd_ = rows.size() == 0;
+        if (!isEnd_)
+            resume_ = std::move(resume);
+        resumeHandle(lock);
+    }
+    void fail(const std::exception_ptr &e)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        exception_ = e;
+        resumeHandle(lock);
+    }
+    void resumeHandle(std::unique_lock<std::mutex> &lock)
+    {
+        auto handle = handle_;
+        handle_ = nullptr;
+        lock.unlock();
+        if (handle)
+            handle.resume();
+    }
+};
+
+struct SqlStreamAwaiter
+{
+    SqlStreamAwaiter(const std::shared_ptr<SqlStreamState> &state)
+        : state_(state)
+    {
+    }
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        std::function<void(bool)> resume;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex_);
+            if (state_->rows_ || state_->exception_)
+                return false;
+            state_->handle_ = handle;
+            resume = std::move(state_->nextResume_);
+        }
+        if (resume)
+            resume(true);
+        return true;
+    }
+    Result await_resume() noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex_);
+        if (state_->exception_)
+            std::rethrow_exception(state_->exception_);
+        assert(state_->rows_);
+        if (state_->isEnd_)
+            return *state_->rows_;
+        Result rows = std::move(*state_->rows_);
+        state_->rows_.reset();
+        state_->nextResume_ = std::move(state_->resume_);
+        return rows;
+    }
+
+  private:
+    std::shared_ptr<SqlStreamState> state_;
+};
+
 #endif
 
 }  // namespace internal
 
+#ifdef __cpp_impl_coroutine
+/// The rows of a streamed query read by a coroutine
+/**
+ * The next batch is read from the server when next() is awaited, so a slow
+ * consumer never buffers more than one batch. Destroying the object before
+ * the end of the stream cancels it.
+ */
+class SqlStream : public trantor::NonCopyable
+{
+  public:
+    explicit SqlStream(const std::shared_ptr<internal::SqlStreamState> &state)
+        : state_(state)
+    {
+    }
+    SqlStream(SqlStream &&) noexcept = default;
+    SqlStream &operator=(SqlStream &&) = delete;
+    ~SqlStream()
+    {
+        if (!state_)
+            return;
+        std::function<void(bool)> resume, nextResume;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex_);
+            state_->isCancelled_ = true;
+            resume = std::move(state_->resume_);
+            nextResume = std::move(state_->nextResume_);
+        }
+        if (resume)
+            resume(false);
+        if (nextResume)
+            nextResume(false);
+    }
+
+    /// Get the next batch of rows, an empty result marks the end of the
+    /// stream.
+    internal::SqlStreamAwaiter next()
+    {
+        return internal::SqlStreamAwaiter(state_);
+    }
+
+  private:
+    std::shared_ptr<internal::SqlStreamState> state_;
+};
+#endif
+
 /// Database client abstract class
 class DROGON_EXPORT DbClient : public trantor::NonCopyable
 {
@@ -125,6 +276,29 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
         const std::string &connInfo,
         const size_t connNum);
 
+    /// Create a database client for a primary server and its replicas;
+    /**
+     * @param primary: The client of the primary server, it executes all
+     * statements that may change data and all transactions.
+     * @param replicas: The clients of the replica servers, read-only select
+     * statements (including the find* methods of Mapper) are sent to the
+     * replica with the least outstanding queries. A select that calls a
+     * function other than the built-in ones without side effects is sent to
+     * the primary, unless it has a block comment that contains only
+     * "drogon:read-only".
+     * @param maxReplicationLag: The threshold in seconds. Replicas whose
+     * replication lag exceeds it, or whose lag can't be checked, receive no
+     * queries until they catch up. Zero or negative value disables the
+     * checks.
+     *
+     * @note Replicas may not see the latest writes, use a transaction to read
+     * data that must be up to date.
+     */
+    static std::shared_ptr<DbClient> newReplicatedClient(
+        const std::shared_ptr<DbClient> &primary,
+        const std::vector<std::shared_ptr<DbClient>> &replicas,
+        double maxReplicationLag = 0.0);
+
     /// Async and nonblocking method
     /**
      * @param sql is the SQL statement to be executed;
@@ -212,6 +386,61 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
     }
 #endif
 
+    /// Async and nonblocking method that delivers the rows in batches
+    /**
+     * @param sql is the SQL statement to be executed;
+     * @param batchSize is the maximum number of rows in a batch;
+     * @param streamCallback is called with each batch of rows and a function
+     * object. No more rows are read from the server until the function object
+     * is called with true, calling it with false cancels the stream. An empty
+     * batch marks the end of the stream.
+     * @param exceptCallback is usually the ExceptionCallback type;
+     * @param args are parameters that are bound to placeholders in the sql
+     * parameter;
+     *
+     * @note The rows are read with server-side cursors (the single-row mode of
+     * PostgreSQL, unbuffered results of MySQL and stepwise evaluation of
+     * Sqlite3), so the memory used is bounded by the batch size. The statement
+     * is executed in a transaction which holds a connection until the stream
+     * ends. When called on a transaction object, the following statements of
+     * the transaction wait for the end of the stream.
+     */
+    template <typename FUNCTION, typename... Arguments>
+    void execSqlStream(const std::string &sql,
+                       size_t batchSize,
+                       StreamCallback streamCallback,
+                       FUNCTION &&exceptCallback,
+                       Arguments &&...args) noexcept
+    {
+        auto binder = *this << sql;
+        (void)std::initializer_list<int>{
+            (binder << std::forward<Arguments>(args), 0)...};
+        binder.setStreamCallback(batchSize, std::move(streamCallback));
+        binder >> std::forward<FUNCTION>(exceptCallback);
+    }
+
+#ifdef __cpp_impl_coroutine
+    /// Read the rows of a query in batches from a coroutine, see
+    /// execSqlStream().
+    template <typename... Arguments>
+    SqlStream execSqlStreamCoro(const std::string &sql,
+                                size_t batchSize,
+                                Arguments &&...args) noexcept
+    {
+        auto state = std::make_shared<internal::SqlStreamState>();
+        auto binder = *this << sql;
+        (void)std::initializer_list<int>{
+            (binder << std::forward<Arguments>(args), 0)...};
+        binder.setStreamCallback(
+            batchSize,
+            [state](const Result &rows, std::function<void(bool)> &&resume) {
+                state->push(rows, std::move(resume));
+            });
+        binder >> [state](const std::exception_ptr &e) { state->fail(e); };
+        return SqlStream(state);
+    }
+#endif
+
     /// Streaming-like method for sql execution. For more information, see the
     /// wiki page.
     internal::SqlBinder operator<<(const std::string &sql);
@@ -288,8 +517,27 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
      */
     virtual void setTimeout(double timeout) = 0;
 
+    /**
+     * @brief Set the maximum number of SQL commands that can wait for idle
+     * connections.
+     *
+     * @param num When the number of waiting commands reaches this value, new
+     * commands fail immediately with a Failure exception ("Too many queries in
+     * buffer") instead of being queued. Zero means the default value of the
+     * client is used (200000 for normal clients and 20000 per IO thread for
+     * fast clients).
+     */
+    virtual void setMaxPendingQueries(size_t num) = 0;
+
+    /**
+     * @brief Get the statistics of the commands dispatched by the client, such
+     * as the time commands spent waiting for idle connections.
+     */
+    virtual QueryQueueStats queueStats() const = 0;
+
   private:
     friend internal::SqlBinder;
+    friend DbClientRouter;
     virtual void execSql(
         const char *sql,
         size_t sqlLength,
@@ -299,6 +547,18 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
         std::vector<int> &&format,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
+    // Execute the statement in a new transaction by default, so that the
+    // stream holds a connection on its own.
+    virtual void streamSql(
+        const char *sql,
+        size_t sqlLength,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        size_t batchSize,
+        StreamCallback &&scb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback);
 
   protected:
     ClientType type_;
@@ -16,6 +16,9 @@
 #include <drogon/orm/Criteria.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -500,6 +503,41 @@ class Mapper
      */
     std::future<T> insertFuture(const T &) noexcept;
 
+    /**
+     * @brief Insert rows into the table with as few statements as possible.
+     *
+     * @param objs The objects to be inserted.
+     * @return size_t The number of inserted rows.
+     * @note Objects that set the same columns are inserted by multi-row insert
+     * statements on PostgreSQL and MySQL. On Sqlite3 every object is inserted
+     * by the same prepared statement. All rows are inserted in a single
+     * transaction (or in the transaction of the mapper if it's created with
+     * one). Unlike insert(), the auto-increased primary keys are not returned.
+     */
+    size_t insertBatch(const std::vector<T> &objs) noexcept(false);
+
+    /**
+     * @brief Asynchronously insert rows into the table with as few statements
+     * as possible.
+     *
+     * @param objs The objects to be inserted.
+     * @param rcb is called with the number of inserted rows after the
+     * transaction is committed.
+     * @param ecb is called when an error occurs, no rows are inserted then.
+     */
+    void insertBatch(const std::vector<T> &objs,
+                     const CountCallback &rcb,
+                     const ExceptionCallback &ecb) noexcept;
+
+    /**
+     * @brief Asynchronously insert rows into the table with as few statements
+     * as possible.
+     *
+     * @return std::future<size_t> The future object with which user can get
+     * the number of inserted rows.
+     */
+    std::future<size_t> insertBatchFuture(const std::vector<T> &objs) noexcept;
+
     /**
      * @brief Update a record.
      *
@@ -696,6 +734,17 @@ class Mapper
 
     std::string replaceSqlPlaceHolder(const std::string &sqlStr,
                                       const std::string &holderStr) const;
+
+    void insertBatch(
+        const std::shared_ptr<std::vector<T>> &objs,
+        std::function<void(const size_t)> &&rcb,
+        std::function<void(const std::exception_ptr &)> &&ecb) noexcept;
+    static void insertBatchInTransaction(
+        const std::shared_ptr<Transaction> &trans,
+        const std::vector<T> &objs,
+        bool commitTransaction,
+        const std::function<void(const size_t)> &rcb,
+        const std::function<void(const std::exception_ptr &)> &ecb);
 };
 
 template <typename T>
@@ -1235,6 +1284,216 @@ inline std::future<T> Mapper<T>::insertFuture(const T &obj) noexcept
     return prom->get_future();
 }
 template <typename T>
+inline size_t Mapper<T>::insertBatch(const std::vector<T> &objs) noexcept(
+    false)
+{
+    return insertBatchFuture(objs).get();
+}
+template <typename T>
+inline void Mapper<T>::insertBatch(const std::vector<T> &objs,
+                                   const CountCallback &rcb,
+                                   const ExceptionCallback &ecb) noexcept
+{
+    insertBatch(std::make_shared<std::vector<T>>(objs),
+                [rcb](const size_t count) { rcb(count); },
+                [ecb](const std::exception_ptr &exception) {
+                    try
+                    {
+                        std::rethrow_exception(exception);
+                    }
+                    catch (const DrogonDbException &e)
+                    {
+                        ecb(e);
+                    }
+                });
+}
+template <typename T>
+inline std::future<size_t> Mapper<T>::insertBatchFuture(
+    const std::vector<T> &objs) noexcept
+{
+    std::shared_ptr<std::promise<size_t>> prom =
+        std::make_shared<std::promise<size_t>>();
+    insertBatch(std::make_shared<std::vector<T>>(objs),
+                [prom](const size_t count) { prom->set_value(count); },
+                [prom](const std::exception_ptr &e) {
+                    prom->set_exception(e);
+                });
+    return prom->get_future();
+}
+template <typename T>
+inline void Mapper<T>::insertBatch(
+    const std::shared_ptr<std::vector<T>> &objs,
+    std::function<void(const size_t)> &&rcb,
+    std::function<void(const std::exception_ptr &)> &&ecb) noexcept
+{
+    clear();
+    if (objs->empty())
+    {
+        rcb(0);
+        return;
+    }
+    auto trans = std::dynamic_pointer_cast<Transaction>(client_);
+    if (trans)
+    {
+        insertBatchInTransaction(trans, *objs, false, rcb, ecb);
+        return;
+    }
+    client_->newTransactionAsync(
+        [objs, rcb = std::move(rcb), ecb = std::move(ecb)](
+            const std::shared_ptr<Transaction> &trans) {
+            if (!trans)
+            {
+                ecb(std::make_exception_ptr(
+                    TimeoutError("Timeout when creating a transaction")));
+                return;
+            }
+            insertBatchInTransaction(trans, *objs, true, rcb, ecb);
+        });
+}
+template <typename T>
+inline void Mapper<T>::insertBatchInTransaction(
+    const std::shared_ptr<Transaction> &trans,
+    const std::vector<T> &objs,
+    bool commitTransaction,
+    const std::function<void(const size_t)> &rcb,
+    const std::function<void(const std::exception_ptr &)> &ecb)
+{
+    struct BatchState
+    {
+        std::atomic<size_t> insertedRows_{0};
+        // One more than the number of statements being executed until all
+        // statements are sent.
+        std::atomic<size_t> pendingStatements_{1};
+        std::atomic<bool> failed_{false};
+    };
+    auto state = std::make_shared<BatchState>();
+    if (commitTransaction)
+    {
+        // The transaction is committed when the last statement is done. It
+        // is rolled back on errors and this callback isn't called then.
+        trans->setCommitCallback([state, rcb, ecb](bool committed) {
+            if (committed)
+            {
+                rcb(state->insertedRows_);
+            }
+            else
+            {
+                ecb(std::make_exception_ptr(
+                    Failure("Failed to commit the batch insertion")));
+            }
+        });
+    }
+    auto finishStatement = [state, commitTransaction, rcb]() {
+        if (--state->pendingStatements_ == 0 && !state->failed_ &&
+            !commitTransaction)
+        {
+            rcb(state->insertedRows_);
+        }
+    };
+    auto resultCallback = [state, finishStatement](const Result &r) {
+        state->insertedRows_ += r.affectedRows();
+        finishStatement();
+    };
+    auto exceptionCallback = [state, ecb](const std::exception_ptr &e) {
+        --state->pendingStatements_;
+        if (!state->failed_.exchange(true))
+        {
+            ecb(e);
+        }
+    };
+    auto insertingSql = [](const T &obj) {
+        bool needSelection = false;
+        auto sql = obj.sqlForInserting(needSelection);
+        static const std::string returning = " returning *";
+        if (sql.length() > returning.length() &&
+            sql.compare(sql.length() - returning.length(),
+                        returning.length(),
+                        returning) == 0)
+        {
+            sql.resize(sql.length() - returning.length());
+        }
+        return sql;
+    };
+    // The number of parameters of a statement is limited to 65535, and the
+    // number of rows is limited to keep statements in a reasonable size.
+    const size_t maxRowsPerStatement = 1000;
+    const size_t maxParametersPerStatement = 65535;
+    auto isSqlite3 = trans->type() == ClientType::Sqlite3;
+    auto placeholder = trans->type() == ClientType::PostgreSQL ? '$' : '?';
+    auto sql = insertingSql(objs[0]);
+    size_t begin = 0;
+    while (begin < objs.size())
+    {
+        size_t parametersNumber =
+            std::count(sql.begin(), sql.end(), placeholder);
+        size_t maxRows = maxRowsPerStatement;
+        if (isSqlite3)
+        {
+            // The connection reuses the prepared statement for every row.
+            maxRows = 1;
+        }
+        else if (parametersNumber > 0)
+        {
+            maxRows = (std::min)(maxRows,
+                                 maxParametersPerStatement / parametersNumber);
+        }
+        // Adjacent objects that set the same columns share a statement.
+        size_t end = begin + 1;
+        std::string nextSql;
+        while (end < objs.size())
+        {
+            nextSql = insertingSql(objs[end]);
+            if (end - begin >= maxRows || nextSql != sql)
+                break;
+            ++end;
+        }
+        if (end - begin > 1)
+        {
+            auto valuesPos = sql.find(" values (");
+            assert(valuesPos != std::string::npos);
+            auto rowSql = sql.substr(valuesPos + 8);
+            for (size_t row = 1; row < end - begin; ++row)
+            {
+                sql += ',';
+                if (placeholder == '?')
+                {
+                    sql += rowSql;
+                    continue;
+                }
+                // Renumber the placeholders ($1, $2, ...) of PostgreSQL.
+                for (size_t pos = 0; pos < rowSql.length(); ++pos)
+                {
+                    if (rowSql[pos] != '$')
+                    {
+                        sql += rowSql[pos];
+                        continue;
+                    }
+                    size_t number = 0;
+                    while (pos + 1 < rowSql.length() &&
+                           isdigit(static_cast<unsigned char>(rowSql[pos + 1])))
+                    {
+                        number = number * 10 + (rowSql[++pos] - '0');
+                    }
+                    sql += '$';
+                    sql += std::to_string(number + row * parametersNumber);
+                }
+            }
+        }
+        ++state->pendingStatements_;
+        auto binder = *trans << std::move(sql);
+        for (size_t i = begin; i < end; ++i)
+        {
+            objs[i].outputArgs(binder);
+        }
+        binder >> resultCallback;
+        binder >> exceptionCallback;
+        binder.exec();
+        begin = end;
+        sql = std::move(nextSql);
+    }
+    finishStatement();
+}
+template <typename T>
 inline size_t Mapper<T>::update(const T &obj) noexcept(false)
 {
     clear();
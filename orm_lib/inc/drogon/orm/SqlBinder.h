@@ -102,6 +102,12 @@ enum Sqlite3Type
 class DbClient;
 using QueryCallback = std::function<void(const Result &)>;
 using ExceptPtrCallback = std::function<void(const std::exception_ptr &)>;
+/// The callback receiving the rows of a streamed query in batches. The
+/// function object passed to it must be called with true to get the next
+/// batch or with false to cancel the stream. An empty result marks the end of
+/// the stream.
+using StreamCallback =
+    std::function<void(const Result &, std::function<void(bool)> &&)>;
 enum class Mode
 {
     NonBlocking,
@@ -315,6 +321,8 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
           execed_(that.execed_),
           destructed_(that.destructed_),
           isExceptionPtr_(that.isExceptionPtr_),
+          streamCallback_(std::move(that.streamCallback_)),
+          streamBatchSize_(that.streamBatchSize_),
           type_(that.type_)
     {
         // set the execed_ to true to avoid the same sql being executed twice.
@@ -356,6 +364,15 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
         return *this;
     }
 
+    /// Deliver the rows of the result in batches of at most batchSize rows
+    /// instead of calling a result callback once.
+    self &setStreamCallback(size_t batchSize, StreamCallback &&callback)
+    {
+        streamBatchSize_ = batchSize > 0 ? batchSize : 1;
+        streamCallback_ = std::move(callback);
+        return *this;
+    }
+
     template <typename T>
     typename std::enable_if<
         !std::is_same<typename std::remove_cv<
@@ -571,6 +588,8 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
     bool execed_{false};
     bool destructed_{false};
     bool isExceptionPtr_{false};
+    StreamCallback streamCallback_;
+    size_t streamBatchSize_{0};
     ClientType type_;
 };
 
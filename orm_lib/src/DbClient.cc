@@ -13,6 +13,7 @@
  */
 
 #include "DbClientImpl.h"
+#include "DbClientRouter.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
 using namespace drogon::orm;
@@ -77,3 +78,60 @@ std::shared_ptr<DbClient> DbClient::newSqlite3Client(
     (void)(connNum);
 #endif
 }
+
+std::shared_ptr<DbClient> DbClient::newReplicatedClient(
+    const std::shared_ptr<DbClient> &primary,
+    const std::vector<std::shared_ptr<DbClient>> &replicas,
+    double maxReplicationLag)
+{
+    auto client =
+        std::make_shared<DbClientRouter>(primary, replicas, maxReplicationLag);
+    client->init();
+    return client;
+}
+
+void DbClient::streamSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    newTransactionAsync(
+        [sql,
+         sqlLength,
+         paraNum,
+         parameters = std::move(parameters),
+         length = std::move(length),
+         format = std::move(format),
+         batchSize,
+         scb = std::move(scb),
+         exceptCallback = std::move(exceptCallback)](
+            const std::shared_ptr<Transaction> &trans) mutable {
+            if (!trans)
+            {
+                exceptCallback(std::make_exception_ptr(TimeoutError(
+                    "Timeout, no connection available for the stream")));
+                return;
+            }
+            // The transaction is committed when the stream callbacks are
+            // released.
+            trans->streamSql(
+                sql,
+                sqlLength,
+                paraNum,
+                std::move(parameters),
+                std::move(length),
+                std::move(format),
+                batchSize,
+                [scb = std::move(scb), trans](
+                    const Result &r, std::function<void(bool)> &&resume) {
+                    scb(r, std::move(resume));
+                },
+                std::move(exceptCallback));
+        });
+}
@@ -31,6 +31,7 @@
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/Exception.h>
 #include <iostream>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <stdio.h>
@@ -69,12 +70,16 @@ void DbClientImpl::init()
     loops_.start();
     if (type_ == ClientType::PostgreSQL || type_ == ClientType::Mysql)
     {
+        for (size_t i = 0; i < loops_.size(); ++i)
+        {
+            slots_.emplace_back(new ConnectionSlot(loops_.getLoop(i)));
+        }
         for (size_t i = 0; i < numberOfConnections_; ++i)
         {
-            auto loop = loops_.getNextLoop();
-            loop->runInLoop([this, loop]() {
+            auto slot = slots_[i % slots_.size()].get();
+            slot->loop_->runInLoop([this, slot]() {
                 std::lock_guard<std::mutex> lock(connectionsMutex_);
-                connections_.insert(newConnection(loop));
+                connections_.insert(newConnection(slot));
             });
         }
     }
@@ -82,11 +87,13 @@ void DbClientImpl::init()
     {
         sharedMutexPtr_ = std::make_shared<SharedMutex>();
         assert(sharedMutexPtr_);
-
+        // Every sqlite3 connection runs in its own thread, all of them share
+        // one slot whose bookkeeping is done in the DbLoop.
+        slots_.emplace_back(new ConnectionSlot(loops_.getNextLoop()));
         std::lock_guard<std::mutex> lock(connectionsMutex_);
         for (size_t i = 0; i < numberOfConnections_; ++i)
         {
-            connections_.insert(newConnection(nullptr));
+            connections_.insert(newConnection(slots_[0].get()));
         }
     }
 }
@@ -98,8 +105,6 @@ DbClientImpl::~DbClientImpl() noexcept
         conn->disconnect();
     }
     connections_.clear();
-    readyConnections_.clear();
-    busyConnections_.clear();
 }
 
 void DbClientImpl::execSql(
@@ -147,132 +152,226 @@ void DbClientImpl::execSql(
                            std::move(exceptCallback));
         return;
     }
-    DbConnectionPtr conn;
-    bool busy = false;
-    {
-        std::lock_guard<std::mutex> guard(connectionsMutex_);
+    pushCommand(std::make_shared<SqlCmd>(string_view{sql, sqlLength},
+                                         paraNum,
+                                         std::move(parameters),
+                                         std::move(length),
+                                         std::move(format),
+                                         std::move(rcb),
+                                         std::move(exceptCallback)),
+                nullptr);
+}
 
-        if (readyConnections_.size() == 0)
+DbClientImpl::ConnectionSlot *DbClientImpl::selectSlot()
+{
+    if (slots_.size() == 1)
+        return slots_[0].get();
+    // Prefer the connections living in the current thread, so that queries
+    // issued in result callbacks don't have to cross threads.
+    auto currentLoop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (currentLoop)
+    {
+        for (auto &slot : slots_)
         {
-            if (sqlCmdBuffer_.size() > 200000)
-            {
-                // too many queries in buffer;
-                busy = true;
-            }
-            else
-            {
-                // LOG_TRACE << "Push query to buffer";
-                std::shared_ptr<SqlCmd> cmd =
-                    std::make_shared<SqlCmd>(string_view{sql, sqlLength},
-                                             paraNum,
-                                             std::move(parameters),
-                                             std::move(length),
-                                             std::move(format),
-                                             std::move(rcb),
-                                             std::move(exceptCallback));
-                sqlCmdBuffer_.push_back(std::move(cmd));
-            }
+            if (slot->loop_ == currentLoop &&
+                slot->readyNumber_.load(std::memory_order_relaxed) >
+                    slot->pendingNumber_.load(std::memory_order_relaxed))
+                return slot.get();
         }
-        else
+    }
+    // Otherwise pick a slot with idle connections, or the one with the least
+    // pending commands per connection.
+    auto start = slotIndex_.fetch_add(1, std::memory_order_relaxed);
+    ConnectionSlot *candidate = nullptr;
+    size_t candidatePending = 0;
+    size_t candidateConnections = 0;
+    for (size_t i = 0; i < slots_.size(); ++i)
+    {
+        auto slot = slots_[(start + i) % slots_.size()].get();
+        auto pending = slot->pendingNumber_.load(std::memory_order_relaxed);
+        if (slot->readyNumber_.load(std::memory_order_relaxed) > pending)
+            return slot;
+        auto connNum = slot->connectionNumber_.load(std::memory_order_relaxed);
+        if (connNum == 0)
+            continue;
+        if (!candidate ||
+            pending * candidateConnections < candidatePending * connNum)
         {
-            auto iter = readyConnections_.begin();
-            busyConnections_.insert(*iter);
-            conn = *iter;
-            readyConnections_.erase(iter);
+            candidate = slot;
+            candidatePending = pending;
+            candidateConnections = connNum;
         }
     }
-    if (conn)
+    if (candidate)
+        return candidate;
+    return slots_[start % slots_.size()].get();
+}
+
+void DbClientImpl::pushCommand(std::shared_ptr<SqlCmd> &&cmd,
+                               std::shared_ptr<std::atomic<bool>> &&queued)
+{
+    if (!queueCounters_.tryPush(maxPendingQueries_))
     {
-        execSql(conn,
-                string_view{sql, sqlLength},
-                paraNum,
-                std::move(parameters),
-                std::move(length),
-                std::move(format),
-                std::move(rcb),
-                std::move(exceptCallback));
+        // too many queries in buffer;
+        auto exceptPtr =
+            std::make_exception_ptr(Failure("Too many queries in buffer"));
+        cmd->exceptionCallback_(exceptPtr);
         return;
     }
-    if (busy)
+    cmd->queuedTime_ = trantor::Date::now();
+    enqueueCommand(selectSlot(),
+                   PendingCommand{std::move(cmd), std::move(queued)});
+}
+
+void DbClientImpl::enqueueCommand(ConnectionSlot *slot,
+                                  PendingCommand &&pending)
+{
+    slot->pendingNumber_.fetch_add(1, std::memory_order_relaxed);
+    slot->pendingCommands_.enqueue(std::move(pending));
+    std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
+    slot->loop_->runInLoop([weakThis, slot]() {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->dispatchCommands(slot);
+    });
+}
+
+void DbClientImpl::dispatchCommands(ConnectionSlot *slot)
+{
+    slot->loop_->assertInLoopThread();
+    while (!slot->readyConnections_.empty() &&
+           (slot->pendingNumber_.load(std::memory_order_relaxed) > 0 ||
+            transCallbacksNumber_.load(std::memory_order_acquire) > 0))
     {
-        auto exceptPtr =
-            std::make_exception_ptr(Failure("Too many queries in buffer"));
-        exceptCallback(exceptPtr);
+        auto conn = std::move(slot->readyConnections_.back());
+        slot->readyConnections_.pop_back();
+        slot->readyNumber_.fetch_sub(1, std::memory_order_relaxed);
+        if (!handleNewTask(conn, slot))
+            return;
+    }
+}
+
+void DbClientImpl::handleIdleConnection(const DbConnectionPtr &connPtr,
+                                        ConnectionSlot *slot)
+{
+    std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
+    slot->loop_->runInLoop([weakThis, connPtr, slot]() {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        if (slot->okConnections_.find(connPtr) == slot->okConnections_.end())
+        {
+            // The connection is broken and removed
+            return;
+        }
+        thisPtr->handleNewTask(connPtr, slot);
+    });
+}
+
+void DbClientImpl::redispatchCommands(ConnectionSlot *slot)
+{
+    // The slot has lost all its connections, move its commands to the slots
+    // which can execute them instead of waiting for the reconnection.
+    slot->loop_->assertInLoopThread();
+    if (std::none_of(slots_.begin(),
+                     slots_.end(),
+                     [slot](const std::unique_ptr<ConnectionSlot> &s) {
+                         return s.get() != slot &&
+                                s->connectionNumber_.load(
+                                    std::memory_order_relaxed) > 0;
+                     }))
         return;
+    PendingCommand pending;
+    while (slot->pendingCommands_.dequeue(pending))
+    {
+        slot->pendingNumber_.fetch_sub(1, std::memory_order_relaxed);
+        if (pending.queued_ &&
+            !pending.queued_->load(std::memory_order_acquire))
+        {
+            // Timed out, the timer has released its place.
+            continue;
+        }
+        auto target = selectSlot();
+        enqueueCommand(target, std::move(pending));
+        if (target == slot)
+        {
+            // The other slots have lost their connections meanwhile.
+            return;
+        }
     }
 }
+
 void DbClientImpl::newTransactionAsync(
     const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
 {
-    DbConnectionPtr conn;
     {
         std::lock_guard<std::mutex> lock(connectionsMutex_);
-        if (!readyConnections_.empty())
-        {
-            auto iter = readyConnections_.begin();
-            busyConnections_.insert(*iter);
-            conn = *iter;
-            readyConnections_.erase(iter);
-        }
-        else
+        auto callbackPtr = std::make_shared<
+            std::function<void(const std::shared_ptr<Transaction> &)>>(
+            callback);
+        if (timeout_ > 0.0)
         {
-            auto callbackPtr = std::make_shared<
-                std::function<void(const std::shared_ptr<Transaction> &)>>(
-                callback);
-            if (timeout_ > 0.0)
-            {
-                auto newCallbackPtr =
-                    std::make_shared<std::weak_ptr<std::function<void(
-                        const std::shared_ptr<Transaction> &)>>>();
-                auto timeoutFlagPtr = std::make_shared<TaskTimeoutFlag>(
-                    loops_.getNextLoop(),
-                    std::chrono::duration<double>(timeout_),
-                    [newCallbackPtr, callbackPtr, this]() {
-                        auto cbPtr = (*newCallbackPtr).lock();
-                        if (cbPtr)
+            auto newCallbackPtr = std::make_shared<std::weak_ptr<
+                std::function<void(const std::shared_ptr<Transaction> &)>>>();
+            auto timeoutFlagPtr = std::make_shared<TaskTimeoutFlag>(
+                loops_.getNextLoop(),
+                std::chrono::duration<double>(timeout_),
+                [newCallbackPtr, callbackPtr, this]() {
+                    auto cbPtr = (*newCallbackPtr).lock();
+                    if (cbPtr)
+                    {
+                        std::lock_guard<std::mutex> lock(connectionsMutex_);
+                        for (auto iter = transCallbacks_.begin();
+                             iter != transCallbacks_.end();
+                             ++iter)
                         {
-                            std::lock_guard<std::mutex> lock(connectionsMutex_);
-                            for (auto iter = transCallbacks_.begin();
-                                 iter != transCallbacks_.end();
-                                 ++iter)
+                            if (cbPtr == *iter)
                             {
-                                if (cbPtr == *iter)
-                                {
-                                    transCallbacks_.erase(iter);
-                                    break;
-                                }
+                                transCallbacks_.erase(iter);
+                                transCallbacksNumber_.fetch_sub(
+                                    1, std::memory_order_release);
+                                break;
                             }
                         }
-                        (*callbackPtr)(nullptr);
-                    });
-                callbackPtr = std::make_shared<
-                    std::function<void(const std::shared_ptr<Transaction> &)>>(
-                    [callbackPtr, timeoutFlagPtr](
-                        const std::shared_ptr<Transaction> &trans) {
-                        if (timeoutFlagPtr->done())
-                            return;
-                        (*callbackPtr)(trans);
-                    });
-                (*newCallbackPtr) = callbackPtr;
-                timeoutFlagPtr->runTimer();
-            }
-            transCallbacks_.push_back(callbackPtr);
+                    }
+                    (*callbackPtr)(nullptr);
+                });
+            callbackPtr = std::make_shared<
+                std::function<void(const std::shared_ptr<Transaction> &)>>(
+                [callbackPtr,
+                 timeoutFlagPtr](const std::shared_ptr<Transaction> &trans) {
+                    if (timeoutFlagPtr->done())
+                        return;
+                    (*callbackPtr)(trans);
+                });
+            (*newCallbackPtr) = callbackPtr;
+            timeoutFlagPtr->runTimer();
         }
+        transCallbacks_.push_back(callbackPtr);
+        transCallbacksNumber_.fetch_add(1, std::memory_order_release);
     }
-    if (conn)
+    // Any slot with an idle connection can serve the transaction.
+    std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
+    for (auto &slotPtr : slots_)
     {
-        makeTrans(conn,
-                  std::function<void(const std::shared_ptr<Transaction> &)>(
-                      callback));
+        auto slot = slotPtr.get();
+        slot->loop_->runInLoop([weakThis, slot]() {
+            auto thisPtr = weakThis.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->dispatchCommands(slot);
+        });
     }
 }
 void DbClientImpl::makeTrans(
     const DbConnectionPtr &conn,
+    ConnectionSlot *slot,
     std::function<void(const std::shared_ptr<Transaction> &)> &&callback)
 {
     std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
     auto trans = std::shared_ptr<TransactionImpl>(new TransactionImpl(
-        type_, conn, std::function<void(bool)>(), [weakThis, conn]() {
+        type_, conn, std::function<void(bool)>(), [weakThis, conn, slot]() {
             auto thisPtr = weakThis.lock();
             if (!thisPtr)
                 return;
@@ -286,29 +385,24 @@ void DbClientImpl::makeTrans(
                     thisPtr->connections_.end())
                 {
                     // connection is broken and removed
-                    assert(thisPtr->busyConnections_.find(conn) ==
-                               thisPtr->busyConnections_.end() &&
-                           thisPtr->readyConnections_.find(conn) ==
-                               thisPtr->readyConnections_.end());
-
                     return;
                 }
             }
-            conn->loop()->queueInLoop([weakThis, conn]() {
+            conn->loop()->queueInLoop([weakThis, conn, slot]() {
                 auto thisPtr = weakThis.lock();
                 if (!thisPtr)
                     return;
                 std::weak_ptr<DbConnection> weakConn = conn;
-                conn->setIdleCallback([weakThis, weakConn]() {
+                conn->setIdleCallback([weakThis, weakConn, slot]() {
                     auto thisPtr = weakThis.lock();
                     if (!thisPtr)
                         return;
                     auto connPtr = weakConn.lock();
                     if (!connPtr)
                         return;
-                    thisPtr->handleNewTask(connPtr);
+                    thisPtr->handleIdleConnection(connPtr, slot);
                 });
-                thisPtr->handleNewTask(conn);
+                thisPtr->handleIdleConnection(conn, slot);
             });
         }));
     trans->doBegin();
@@ -336,36 +430,42 @@ std::shared_ptr<Transaction> DbClientImpl::newTransaction(
     return trans;
 }
 
-void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
+bool DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr,
+                                 ConnectionSlot *slot)
 {
-    std::function<void(const std::shared_ptr<Transaction> &)> transCallback;
-    std::shared_ptr<SqlCmd> cmd;
+    slot->loop_->assertInLoopThread();
+    if (transCallbacksNumber_.load(std::memory_order_acquire) > 0)
     {
-        std::lock_guard<std::mutex> guard(connectionsMutex_);
-        if (!transCallbacks_.empty())
+        std::function<void(const std::shared_ptr<Transaction> &)>
+            transCallback;
         {
-            transCallback = std::move(*(transCallbacks_.front()));
-            transCallbacks_.pop_front();
-        }
-        else if (!sqlCmdBuffer_.empty())
-        {
-            cmd = std::move(sqlCmdBuffer_.front());
-            sqlCmdBuffer_.pop_front();
+            std::lock_guard<std::mutex> guard(connectionsMutex_);
+            if (!transCallbacks_.empty())
+            {
+                transCallback = std::move(*(transCallbacks_.front()));
+                transCallbacks_.pop_front();
+                transCallbacksNumber_.fetch_sub(1, std::memory_order_release);
+            }
         }
-        else
+        if (transCallback)
         {
-            // Connection is idle, put it into the readyConnections_ set;
-            busyConnections_.erase(connPtr);
-            readyConnections_.insert(connPtr);
+            makeTrans(connPtr, slot, std::move(transCallback));
+            return true;
         }
     }
-    if (transCallback)
-    {
-        makeTrans(connPtr, std::move(transCallback));
-        return;
-    }
-    if (cmd)
+    PendingCommand pending;
+    while (slot->pendingCommands_.dequeue(pending))
     {
+        slot->pendingNumber_.fetch_sub(1, std::memory_order_relaxed);
+        auto &cmd = pending.command_;
+        if (pending.queued_ &&
+            !pending.queued_->exchange(false, std::memory_order_acq_rel))
+        {
+            // The command timed out while waiting for a connection, the timer
+            // has released its place.
+            continue;
+        }
+        queueCounters_.pop(*cmd);
         execSql(connPtr,
                 std::move(cmd->sql_),
                 cmd->parametersNumber_,
@@ -374,17 +474,21 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
                 std::move(cmd->formats_),
                 std::move(cmd->callback_),
                 std::move(cmd->exceptionCallback_));
-        return;
+        return true;
     }
+    // Connection is idle, put it into the readyConnections_ of the slot;
+    slot->readyConnections_.push_back(connPtr);
+    slot->readyNumber_.fetch_add(1, std::memory_order_relaxed);
+    return false;
 }
 
-DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
+DbConnectionPtr DbClientImpl::newConnection(ConnectionSlot *slot)
 {
     DbConnectionPtr connPtr;
     if (type_ == ClientType::PostgreSQL)
     {
 #if USE_POSTGRESQL
-        connPtr = std::make_shared<PgConnection>(loop, connectionInfo_);
+        connPtr = std::make_shared<PgConnection>(slot->loop_, connectionInfo_);
 #else
         return nullptr;
 #endif
@@ -392,7 +496,8 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     else if (type_ == ClientType::Mysql)
     {
 #if USE_MYSQL
-        connPtr = std::make_shared<MysqlConnection>(loop, connectionInfo_);
+        connPtr =
+            std::make_shared<MysqlConnection>(slot->loop_, connectionInfo_);
 #else
         return nullptr;
 #endif
@@ -401,7 +506,7 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     {
 #if USE_SQLITE3
         auto sqlite3ConnPtr =
-            std::make_shared<Sqlite3Connection>(loop,
+            std::make_shared<Sqlite3Connection>(nullptr,
                                                 connectionInfo_,
                                                 sharedMutexPtr_);
         sqlite3ConnPtr->init();
@@ -413,54 +518,73 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     else
     {
         return nullptr;
-        (void)(loop);
     }
     std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
-    connPtr->setCloseCallback([weakPtr](const DbConnectionPtr &closeConnPtr) {
-        // Erase the connection
-        auto thisPtr = weakPtr.lock();
-        if (!thisPtr)
-            return;
-        {
-            std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
-            thisPtr->readyConnections_.erase(closeConnPtr);
-            thisPtr->busyConnections_.erase(closeConnPtr);
-            assert(thisPtr->connections_.find(closeConnPtr) !=
-                   thisPtr->connections_.end());
-            thisPtr->connections_.erase(closeConnPtr);
-        }
-        // Reconnect after 1 second
-        auto loop = closeConnPtr->loop();
-        loop->runAfter(1, [weakPtr, loop, closeConnPtr] {
+    connPtr->setCloseCallback(
+        [weakPtr, slot](const DbConnectionPtr &closeConnPtr) {
+            // Erase the connection
             auto thisPtr = weakPtr.lock();
             if (!thisPtr)
                 return;
-            std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
-            thisPtr->connections_.insert(thisPtr->newConnection(loop));
+            {
+                std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
+                assert(thisPtr->connections_.find(closeConnPtr) !=
+                       thisPtr->connections_.end());
+                thisPtr->connections_.erase(closeConnPtr);
+            }
+            slot->loop_->runInLoop([weakPtr, slot, closeConnPtr]() {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr)
+                    return;
+                if (slot->okConnections_.erase(closeConnPtr) > 0 &&
+                    slot->connectionNumber_.fetch_sub(
+                        1, std::memory_order_relaxed) == 1)
+                {
+                    thisPtr->redispatchCommands(slot);
+                }
+                auto &readyConns = slot->readyConnections_;
+                auto iter = std::find(readyConns.begin(),
+                                      readyConns.end(),
+                                      closeConnPtr);
+                if (iter != readyConns.end())
+                {
+                    readyConns.erase(iter);
+                    slot->readyNumber_.fetch_sub(1, std::memory_order_relaxed);
+                }
+                // Reconnect after 1 second
+                slot->loop_->runAfter(1, [weakPtr, slot] {
+                    auto thisPtr = weakPtr.lock();
+                    if (!thisPtr)
+                        return;
+                    std::lock_guard<std::mutex> guard(
+                        thisPtr->connectionsMutex_);
+                    thisPtr->connections_.insert(thisPtr->newConnection(slot));
+                });
+            });
         });
-    });
-    connPtr->setOkCallback([weakPtr](const DbConnectionPtr &okConnPtr) {
+    connPtr->setOkCallback([weakPtr, slot](const DbConnectionPtr &okConnPtr) {
         LOG_TRACE << "connected!";
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
-        {
-            std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
-            thisPtr->busyConnections_.insert(
-                okConnPtr);  // For new connections, this sentence is
-                             // necessary
-        }
-        thisPtr->handleNewTask(okConnPtr);
+        slot->loop_->runInLoop([weakPtr, slot, okConnPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            slot->okConnections_.insert(okConnPtr);
+            slot->connectionNumber_.fetch_add(1, std::memory_order_relaxed);
+            thisPtr->handleNewTask(okConnPtr, slot);
+        });
     });
     std::weak_ptr<DbConnection> weakConn = connPtr;
-    connPtr->setIdleCallback([weakPtr, weakConn]() {
+    connPtr->setIdleCallback([weakPtr, weakConn, slot]() {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
         auto connPtr = weakConn.lock();
         if (!connPtr)
             return;
-        thisPtr->handleNewTask(connPtr);
+        thisPtr->handleIdleConnection(connPtr, slot);
     });
     // std::cout<<"newConn end"<<connPtr<<std::endl;
     return connPtr;
@@ -468,8 +592,12 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
 
 bool DbClientImpl::hasAvailableConnections() const noexcept
 {
-    std::lock_guard<std::mutex> lock(connectionsMutex_);
-    return (!readyConnections_.empty()) || (!busyConnections_.empty());
+    for (auto const &slot : slots_)
+    {
+        if (slot->connectionNumber_.load(std::memory_order_relaxed) > 0)
+            return true;
+    }
+    return false;
 }
 
 void DbClientImpl::execSqlWithTimeout(
@@ -482,30 +610,28 @@ void DbClientImpl::execSqlWithTimeout(
     ResultCallback &&rcb,
     std::function<void(const std::exception_ptr &)> &&ecb)
 {
-    DbConnectionPtr conn;
     assert(timeout_ > 0.0);
-    auto cmd = std::make_shared<std::weak_ptr<SqlCmd>>();
-    bool busy = false;
     auto ecpPtr =
         std::make_shared<std::function<void(const std::exception_ptr &)>>(
             std::move(ecb));
+    auto queuedPtr = std::make_shared<std::atomic<bool>>(true);
+    auto weakCmdPtr = std::make_shared<std::weak_ptr<SqlCmd>>();
+    std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
     auto timeoutFlagPtr = std::make_shared<drogon::TaskTimeoutFlag>(
         loops_.getNextLoop(),
         std::chrono::duration<double>(timeout_),
-        [cmd, ecpPtr, thisPtr = shared_from_this()]() {
-            auto cbPtr = (*cmd).lock();
-            if (cbPtr)
+        [ecpPtr, queuedPtr, weakCmdPtr, weakThis]() {
+            if (queuedPtr->exchange(false, std::memory_order_acq_rel))
             {
-                std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
-                for (auto iter = thisPtr->sqlCmdBuffer_.begin();
-                     iter != thisPtr->sqlCmdBuffer_.end();
-                     ++iter)
+                // The command is still in the queue, release its place and
+                // what it holds now, it's skipped when it's dequeued.
+                if (auto thisPtr = weakThis.lock())
+                    thisPtr->queueCounters_.drop();
+                if (auto cmdPtr = weakCmdPtr->lock())
                 {
-                    if (*iter == cbPtr)
-                    {
-                        thisPtr->sqlCmdBuffer_.erase(iter);
-                        break;
-                    }
+                    cmdPtr->parameters_.clear();
+                    cmdPtr->callback_ = nullptr;
+                    cmdPtr->exceptionCallback_ = nullptr;
                 }
             }
             (*ecpPtr)(
@@ -524,60 +650,16 @@ void DbClientImpl::execSqlWithTimeout(
             return;
         (*ecpPtr)(err);
     };
-
-    {
-        std::lock_guard<std::mutex> guard(connectionsMutex_);
-
-        if (readyConnections_.size() == 0)
-        {
-            if (sqlCmdBuffer_.size() > 200000)
-            {
-                // too many queries in buffer;
-                busy = true;
-            }
-            else
-            {
-                // LOG_TRACE << "Push query to buffer";
-                auto command =
-                    std::make_shared<SqlCmd>(string_view{sql, sqlLength},
-                                             paraNum,
-                                             std::move(parameters),
-                                             std::move(length),
-                                             std::move(format),
-                                             std::move(resultCallback),
-                                             std::move(exceptionCallback));
-                sqlCmdBuffer_.emplace_back(command);
-                *cmd = command;
-            }
-        }
-        else
-        {
-            auto iter = readyConnections_.begin();
-            busyConnections_.insert(*iter);
-            conn = *iter;
-            readyConnections_.erase(iter);
-        }
-    }
-    if (conn)
-    {
-        execSql(conn,
-                string_view{sql, sqlLength},
-                paraNum,
-                std::move(parameters),
-                std::move(length),
-                std::move(format),
-                std::move(resultCallback),
-                std::move(exceptionCallback));
-        timeoutFlagPtr->runTimer();
-        return;
-    }
-
-    if (busy)
-    {
-        exceptionCallback(
-            std::make_exception_ptr(Failure("Too many queries in buffer")));
-        return;
-    }
-
+    auto cmdPtr = std::make_shared<SqlCmd>(string_view{sql, sqlLength},
+                                           paraNum,
+                                           std::move(parameters),
+                                           std::move(length),
+                                           std::move(format),
+                                           std::move(resultCallback),
+                                           std::move(exceptionCallback));
+    *weakCmdPtr = cmdPtr;
+    pushCommand(std::move(cmdPtr), std::move(queuedPtr));
+    // If the command was rejected, the flag is done and the timer does
+    // nothing.
     timeoutFlagPtr->runTimer();
 }
@@ -17,12 +17,15 @@
 #include "DbConnection.h"
 #include <drogon/orm/DbClient.h>
 #include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/utils/LockFreeQueue.h>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 namespace drogon
 {
@@ -56,13 +59,55 @@ class DbClientImpl : public DbClient,
     {
         timeout_ = timeout;
     }
+    void setMaxPendingQueries(size_t num) override
+    {
+        maxPendingQueries_ = (num == 0 ? 200000 : num);
+    }
+    QueryQueueStats queueStats() const override
+    {
+        return queueCounters_.stats();
+    }
     void init();
 
   private:
+    struct PendingCommand
+    {
+        std::shared_ptr<SqlCmd> command_;
+        // Set if the command has a timeout, whichever of the connection and
+        // the timer clears it first releases the place of the command in the
+        // queue.
+        std::shared_ptr<std::atomic<bool>> queued_;
+    };
+
+    /// The connections living in the same event loop.
+    /**
+     * Commands are pushed into the lock-free queue of a slot from any thread,
+     * the idle connections of the slot are only accessed in its loop, so
+     * dispatching a command never takes a lock shared by all IO threads.
+     */
+    struct ConnectionSlot
+    {
+        explicit ConnectionSlot(trantor::EventLoop *loop) : loop_(loop)
+        {
+        }
+        trantor::EventLoop *loop_;
+        trantor::MpscQueue<PendingCommand> pendingCommands_;
+        std::vector<DbConnectionPtr> readyConnections_;
+        std::unordered_set<DbConnectionPtr> okConnections_;
+        std::atomic<size_t> pendingNumber_{0};
+        std::atomic<size_t> readyNumber_{0};
+        std::atomic<size_t> connectionNumber_{0};
+    };
+
     size_t numberOfConnections_;
     trantor::EventLoopThreadPool loops_;
     std::shared_ptr<SharedMutex> sharedMutexPtr_;
     double timeout_{-1.0};
+    size_t maxPendingQueries_{200000};
+    QueryQueueCounters queueCounters_;
+    std::vector<std::unique_ptr<ConnectionSlot>> slots_;
+    std::atomic<size_t> slotIndex_{0};
+
     void execSql(
         const DbConnectionPtr &conn,
         string_view &&sql,
@@ -73,24 +118,30 @@ class DbClientImpl : public DbClient,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback);
 
-    DbConnectionPtr newConnection(trantor::EventLoop *loop);
+    DbConnectionPtr newConnection(ConnectionSlot *slot);
 
     void makeTrans(
         const DbConnectionPtr &conn,
+        ConnectionSlot *slot,
         std::function<void(const std::shared_ptr<Transaction> &)> &&callback);
 
     mutable std::mutex connectionsMutex_;
     std::unordered_set<DbConnectionPtr> connections_;
-    std::unordered_set<DbConnectionPtr> readyConnections_;
-    std::unordered_set<DbConnectionPtr> busyConnections_;
 
     std::list<std::shared_ptr<
         std::function<void(const std::shared_ptr<Transaction> &)>>>
         transCallbacks_;
+    std::atomic<size_t> transCallbacksNumber_{0};
 
-    std::deque<std::shared_ptr<SqlCmd>> sqlCmdBuffer_;
-
-    void handleNewTask(const DbConnectionPtr &connPtr);
+    ConnectionSlot *selectSlot();
+    void pushCommand(std::shared_ptr<SqlCmd> &&cmd,
+                     std::shared_ptr<std::atomic<bool>> &&queued);
+    void enqueueCommand(ConnectionSlot *slot, PendingCommand &&pending);
+    void dispatchCommands(ConnectionSlot *slot);
+    void redispatchCommands(ConnectionSlot *slot);
+    void handleIdleConnection(const DbConnectionPtr &connPtr,
+                              ConnectionSlot *slot);
+    bool handleNewTask(const DbConnectionPtr &connPtr, ConnectionSlot *slot);
     void execSqlWithTimeout(
         const char *sql,
         size_t sqlLength,
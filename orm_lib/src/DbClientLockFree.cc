@@ -111,6 +111,7 @@ void DbClientLockFree::execSql(
             if (!conn->isWorking() &&
                 (transSet_.empty() || transSet_.find(conn) == transSet_.end()))
             {
+                queueCounters_.dispatched(rcb, exceptCallback);
                 conn->execSql(
                     string_view{sql, sqlLength},
                     paraNum,
@@ -141,6 +142,7 @@ void DbClientLockFree::execSql(
                     (transSet_.empty() ||
                      transSet_.find(conn) == transSet_.end()))
                 {
+                    queueCounters_.dispatched(rcb, exceptCallback);
                     conn->execSql(
                         string_view{sql, sqlLength},
                         paraNum,
@@ -174,6 +176,7 @@ void DbClientLockFree::execSql(
                 if (transSet_.empty() ||
                     transSet_.find(conn) == transSet_.end())
                 {
+                    queueCounters_.dispatched(rcb, exceptCallback);
                     conn->execSql(string_view{sql, sqlLength},
                                   paraNum,
                                   std::move(parameters),
@@ -189,7 +192,7 @@ void DbClientLockFree::execSql(
 #endif
     }
 
-    if (sqlCmdBuffer_.size() > 20000)
+    if (!queueCounters_.tryPush(maxPendingQueries_))
     {
         // too many queries in buffer;
         auto exceptPtr =
@@ -199,7 +202,7 @@ void DbClientLockFree::execSql(
     }
 
     // LOG_TRACE << "Push query to buffer";
-    sqlCmdBuffer_.emplace_back(std::make_shared<SqlCmd>(
+    auto cmdPtr = std::make_shared<SqlCmd>(
         string_view{sql, sqlLength},
         paraNum,
         std::move(parameters),
@@ -215,7 +218,9 @@ void DbClientLockFree::execSql(
                 loop_->queueInLoop([rcb = std::move(rcb), r]() { rcb(r); });
             }
         },
-        std::move(exceptCallback)));
+        std::move(exceptCallback));
+    cmdPtr->queuedTime_ = trantor::Date::now();
+    sqlCmdBuffer_.emplace_back(std::move(cmdPtr));
 }
 
 std::shared_ptr<Transaction> DbClientLockFree::newTransaction(
@@ -362,6 +367,7 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
         {
             std::shared_ptr<SqlCmd> cmd = std::move(sqlCmdBuffer_.front());
             sqlCmdBuffer_.pop_front();
+            queueCounters_.pop(*cmd);
             conn->execSql(std::move(cmd->sql_),
                           cmd->parametersNumber_,
                           std::move(cmd->parameters_),
@@ -375,11 +381,16 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
             std::deque<std::shared_ptr<SqlCmd>> cmds;
             using std::swap;
             swap(cmds, sqlCmdBuffer_);
+            for (auto const &cmd : cmds)
+            {
+                queueCounters_.pop(*cmd);
+            }
             conn->batchSql(std::move(cmds));
         }
 #else
         std::shared_ptr<SqlCmd> cmd = std::move(sqlCmdBuffer_.front());
         sqlCmdBuffer_.pop_front();
+        queueCounters_.pop(*cmd);
         conn->execSql(std::move(cmd->sql_),
                       cmd->parametersNumber_,
                       std::move(cmd->parameters_),
@@ -508,6 +519,7 @@ void DbClientLockFree::execSqlWithTimeout(
                     if (*iter == cbPtr)
                     {
                         thisPtr->sqlCmdBuffer_.erase(iter);
+                        thisPtr->queueCounters_.drop();
                         break;
                     }
                 }
@@ -515,19 +527,19 @@ void DbClientLockFree::execSqlWithTimeout(
             (*ecpPtr)(
                 std::make_exception_ptr(TimeoutError("SQL execution timeout")));
         });
-    auto resultCallback = [rcb = std::move(rcb),
-                           timeoutFlagPtr](const Result &result) {
+    ResultCallback resultCallback = [rcb = std::move(rcb),
+                                     timeoutFlagPtr](const Result &result) {
         if (timeoutFlagPtr->done())
             return;
         rcb(result);
     };
 
-    auto exceptionCallback = [ecpPtr,
-                              timeoutFlagPtr](const std::exception_ptr &err) {
-        if (timeoutFlagPtr->done())
-            return;
-        (*ecpPtr)(err);
-    };
+    std::function<void(const std::exception_ptr &)> exceptionCallback =
+        [ecpPtr, timeoutFlagPtr](const std::exception_ptr &err) {
+            if (timeoutFlagPtr->done())
+                return;
+            (*ecpPtr)(err);
+        };
     if (!connections_.empty() && sqlCmdBuffer_.empty() &&
         transCallbacks_.empty())
     {
@@ -537,6 +549,7 @@ void DbClientLockFree::execSqlWithTimeout(
             if (!conn->isWorking() &&
                 (transSet_.empty() || transSet_.find(conn) == transSet_.end()))
             {
+                queueCounters_.dispatched(resultCallback, exceptionCallback);
                 conn->execSql(
                     string_view{sql, sqlLength},
                     paraNum,
@@ -570,6 +583,8 @@ void DbClientLockFree::execSqlWithTimeout(
                     (transSet_.empty() ||
                      transSet_.find(conn) == transSet_.end()))
                 {
+                    queueCounters_.dispatched(resultCallback,
+                                              exceptionCallback);
                     conn->execSql(
                         string_view{sql, sqlLength},
                         paraNum,
@@ -606,6 +621,8 @@ void DbClientLockFree::execSqlWithTimeout(
                 if (transSet_.empty() ||
                     transSet_.find(conn) == transSet_.end())
                 {
+                    queueCounters_.dispatched(resultCallback,
+                                              exceptionCallback);
                     conn->execSql(string_view{sql, sqlLength},
                                   paraNum,
                                   std::move(parameters),
@@ -622,7 +639,7 @@ void DbClientLockFree::execSqlWithTimeout(
 #endif
     }
 
-    if (sqlCmdBuffer_.size() > 20000)
+    if (!queueCounters_.tryPush(maxPendingQueries_))
     {
         // too many queries in buffer;
         exceptionCallback(
@@ -649,6 +666,7 @@ void DbClientLockFree::execSqlWithTimeout(
             }
         },
         std::move(exceptionCallback));
+    cmdPtr->queuedTime_ = trantor::Date::now();
     sqlCmdBuffer_.emplace_back(cmdPtr);
     *commandPtr = cmdPtr;
     timeoutFlagPtr->runTimer();
@@ -58,6 +58,14 @@ class DbClientLockFree : public DbClient,
     {
         timeout_ = timeout;
     }
+    void setMaxPendingQueries(size_t num) override
+    {
+        maxPendingQueries_ = (num == 0 ? 20000 : num);
+    }
+    QueryQueueStats queueStats() const override
+    {
+        return queueCounters_.stats();
+    }
 
   private:
     std::string connectionInfo_;
@@ -74,6 +82,8 @@ class DbClientLockFree : public DbClient,
         transCallbacks_;
 
     double timeout_{-1.0};
+    size_t maxPendingQueries_{20000};
+    QueryQueueCounters queueCounters_;
 
     void makeTrans(
         const DbConnectionPtr &conn,
@@ -14,6 +14,7 @@
 
 #include "../../lib/src/DbClientManager.h"
 #include "DbClientLockFree.h"
+#include "DbClientRouter.h"
 #include <drogon/config.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/utils/Utilities.h>
@@ -72,10 +73,33 @@ void DbClientManager::createDbClients(
                             ioloops[idx],
                             dbInfo.dbType_,
                             dbInfo.connectionNumber_));
+                    if (!dbInfo.replicaConnectionInfos_.empty())
+                    {
+                        std::vector<orm::DbClientPtr> replicas;
+                        for (auto const &connInfo :
+                             dbInfo.replicaConnectionInfos_)
+                        {
+                            replicas.emplace_back(
+                                new drogon::orm::DbClientLockFree(
+                                    connInfo,
+                                    ioloops[idx],
+                                    dbInfo.dbType_,
+                                    dbInfo.connectionNumber_));
+                        }
+                        auto router =
+                            std::make_shared<drogon::orm::DbClientRouter>(
+                                c,
+                                replicas,
+                                dbInfo.maxReplicationLag_,
+                                ioloops[idx]);
+                        router->init();
+                        c = router;
+                    }
                     if (dbInfo.timeout_ > 0.0)
                     {
                         c->setTimeout(dbInfo.timeout_);
                     }
+                    c->setMaxPendingQueries(dbInfo.maxPendingQueries_);
                 });
             }
         }
@@ -91,6 +115,8 @@ void DbClientManager::createDbClients(
                 {
                     dbClientsMap_[dbInfo.name_]->setTimeout(dbInfo.timeout_);
                 }
+                dbClientsMap_[dbInfo.name_]->setMaxPendingQueries(
+                    dbInfo.maxPendingQueries_);
 #endif
             }
             else if (dbInfo.dbType_ == drogon::orm::ClientType::Mysql)
@@ -103,6 +129,8 @@ void DbClientManager::createDbClients(
                 {
                     dbClientsMap_[dbInfo.name_]->setTimeout(dbInfo.timeout_);
                 }
+                dbClientsMap_[dbInfo.name_]->setMaxPendingQueries(
+                    dbInfo.maxPendingQueries_);
 #endif
             }
             else if (dbInfo.dbType_ == drogon::orm::ClientType::Sqlite3)
@@ -115,8 +143,34 @@ void DbClientManager::createDbClients(
                 {
                     dbClientsMap_[dbInfo.name_]->setTimeout(dbInfo.timeout_);
                 }
+                dbClientsMap_[dbInfo.name_]->setMaxPendingQueries(
+                    dbInfo.maxPendingQueries_);
 #endif
             }
+            if (!dbInfo.replicaConnectionInfos_.empty())
+            {
+                std::vector<orm::DbClientPtr> replicas;
+                for (auto const &connInfo : dbInfo.replicaConnectionInfos_)
+                {
+                    auto replica =
+                        dbInfo.dbType_ == drogon::orm::ClientType::PostgreSQL
+                            ? drogon::orm::DbClient::newPgClient(
+                                  connInfo, dbInfo.connectionNumber_)
+                            : drogon::orm::DbClient::newMysqlClient(
+                                  connInfo, dbInfo.connectionNumber_);
+                    if (dbInfo.timeout_ > 0.0)
+                    {
+                        replica->setTimeout(dbInfo.timeout_);
+                    }
+                    replica->setMaxPendingQueries(dbInfo.maxPendingQueries_);
+                    replicas.push_back(std::move(replica));
+                }
+                dbClientsMap_[dbInfo.name_] =
+                    drogon::orm::DbClient::newReplicatedClient(
+                        dbClientsMap_[dbInfo.name_],
+                        replicas,
+                        dbInfo.maxReplicationLag_);
+            }
         }
     }
 }
@@ -136,32 +190,55 @@ void DbClientManager::createDbClient(const std::string &dbType,
                                      const std::string &name,
                                      const bool isFast,
                                      const std::string &characterSet,
-                                     double timeout)
+                                     double timeout,
+                                     size_t maxPendingQueries,
+                                     const std::vector<
+                                         std::pair<std::string, unsigned short>>
+                                         &replicas,
+                                     double maxReplicationLag)
 {
-    auto connStr =
-        utils::formattedString("host=%s port=%u dbname=%s user=%s",
-                               escapeConnString(host).c_str(),
-                               port,
-                               escapeConnString(databaseName).c_str(),
-                               escapeConnString(userName).c_str());
-    if (!password.empty())
-    {
-        connStr += " password=";
-        connStr += escapeConnString(password);
-    }
+    auto makeConnString = [&](const std::string &host,
+                              unsigned short port) {
+        auto connStr =
+            utils::formattedString("host=%s port=%u dbname=%s user=%s",
+                                   escapeConnString(host).c_str(),
+                                   port,
+                                   escapeConnString(databaseName).c_str(),
+                                   escapeConnString(userName).c_str());
+        if (!password.empty())
+        {
+            connStr += " password=";
+            connStr += escapeConnString(password);
+        }
+        if (!characterSet.empty())
+        {
+            connStr += " client_encoding=";
+            connStr += escapeConnString(characterSet);
+        }
+        return connStr;
+    };
     std::string type = dbType;
     std::transform(type.begin(), type.end(), type.begin(), tolower);
-    if (!characterSet.empty())
-    {
-        connStr += " client_encoding=";
-        connStr += escapeConnString(characterSet);
-    }
     DbInfo info;
-    info.connectionInfo_ = connStr;
+    info.connectionInfo_ = makeConnString(host, port);
     info.connectionNumber_ = connectionNum;
     info.isFast_ = isFast;
     info.name_ = name;
     info.timeout_ = timeout;
+    info.maxPendingQueries_ = maxPendingQueries;
+    info.maxReplicationLag_ = maxReplicationLag;
+    if (type != "sqlite3")
+    {
+        for (auto const &replica : replicas)
+        {
+            info.replicaConnectionInfos_.push_back(
+                makeConnString(replica.first, replica.second));
+        }
+    }
+    else if (!replicas.empty())
+    {
+        LOG_WARN << "Replicas are ignored for the sqlite3 client " << name;
+    }
 
     if (type == "postgresql")
     {
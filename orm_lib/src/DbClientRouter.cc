@@ -0,0 +1,600 @@
+/**
+ *
+ *  @file DbClientRouter.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "DbClientRouter.h"
+#include <drogon/orm/Exception.h>
+#include <trantor/utils/Logger.h>
+#include <drogon/utils/string_view.h>
+#include <algorithm>
+#include <ctype.h>
+#include <unordered_set>
+
+using namespace drogon;
+using namespace drogon::orm;
+
+static const double lagCheckInterval = 1.0;
+
+DbClientRouter::DbClientRouter(const DbClientPtr &primary,
+                               const std::vector<DbClientPtr> &replicas,
+                               double maxReplicationLag,
+                               trantor::EventLoop *loop)
+    : primary_(primary), maxReplicationLag_(maxReplicationLag), loop_(loop)
+{
+    assert(primary_);
+    type_ = primary_->type();
+    connectionInfo_ = primary_->connectionInfo();
+    for (auto const &replica : replicas)
+    {
+        replicas_.emplace_back(std::make_shared<Replica>(replica));
+    }
+    if (!loop_ && maxReplicationLag_ > 0.0 && !replicas_.empty())
+    {
+        loopThread_ = std::make_unique<trantor::EventLoopThread>(
+            "ReplicationLagLoop");
+        loopThread_->run();
+        loop_ = loopThread_->getLoop();
+    }
+}
+
+DbClientRouter::~DbClientRouter() noexcept
+{
+    if (lagCheckTimerId_ != 0)
+    {
+        loop_->invalidateTimer(lagCheckTimerId_);
+    }
+}
+
+void DbClientRouter::init()
+{
+    if (maxReplicationLag_ <= 0.0 || replicas_.empty() ||
+        type_ == ClientType::Sqlite3)
+        return;
+    std::weak_ptr<DbClientRouter> weakPtr = shared_from_this();
+    lagCheckTimerId_ = loop_->runEvery(lagCheckInterval, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->checkReplicationLag();
+    });
+}
+
+namespace
+{
+struct SqlToken
+{
+    // A lowercase word, or ";" for the end of a statement.
+    std::string word_;
+    bool isQualified_{false};
+    bool isCall_{false};
+};
+
+bool isWordChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+/// Find the end of a quoted literal or identifier starting at pos.
+size_t skipQuoted(const char *sql,
+                  size_t sqlLength,
+                  size_t pos,
+                  bool backslashEscapes)
+{
+    auto quote = sql[pos++];
+    while (pos < sqlLength)
+    {
+        if (sql[pos] == '\\' && backslashEscapes)
+        {
+            pos += 2;
+            continue;
+        }
+        if (sql[pos] == quote)
+        {
+            // A doubled quote stands for itself.
+            if (pos + 1 < sqlLength && sql[pos + 1] == quote)
+            {
+                pos += 2;
+                continue;
+            }
+            return pos + 1;
+        }
+        ++pos;
+    }
+    return sqlLength;
+}
+
+/**
+ * Split the statement into words, skipping comments, literals and quoted
+ * identifiers. The hint in a comment is returned in the hint parameter.
+ */
+std::vector<SqlToken> tokenize(const char *sql,
+                               size_t sqlLength,
+                               ClientType type,
+                               string_view &hint)
+{
+    std::vector<SqlToken> tokens;
+    bool isMysql = type == ClientType::Mysql;
+    bool qualified = false;
+    size_t pos = 0;
+    while (pos < sqlLength)
+    {
+        auto c = sql[pos];
+        auto next = pos + 1 < sqlLength ? sql[pos + 1] : '\0';
+        if (isspace(static_cast<unsigned char>(c)))
+        {
+            ++pos;
+        }
+        else if ((c == '-' && next == '-') || (c == '#' && isMysql))
+        {
+            while (pos < sqlLength && sql[pos] != '\n')
+                ++pos;
+        }
+        else if (c == '/' && next == '*')
+        {
+            // PostgreSQL allows nested comments.
+            auto begin = pos + 2;
+            auto end = sqlLength;
+            int depth = 0;
+            while (pos < sqlLength)
+            {
+                if (sql[pos] == '/' && pos + 1 < sqlLength &&
+                    sql[pos + 1] == '*')
+                {
+                    ++depth;
+                    pos += 2;
+                }
+                else if (sql[pos] == '*' && pos + 1 < sqlLength &&
+                         sql[pos + 1] == '/')
+                {
+                    pos += 2;
+                    if (--depth == 0 || isMysql)
+                    {
+                        end = pos - 2;
+                        break;
+                    }
+                }
+                else
+                {
+                    ++pos;
+                }
+            }
+            string_view comment(sql + begin, end - begin);
+            while (!comment.empty() &&
+                   isspace(static_cast<unsigned char>(comment.front())))
+                comment.remove_prefix(1);
+            while (!comment.empty() &&
+                   isspace(static_cast<unsigned char>(comment.back())))
+                comment.remove_suffix(1);
+            if (comment == "drogon:read-only" || comment == "drogon:primary")
+                hint = comment;
+        }
+        else if (c == '\'' || c == '"' || c == '`')
+        {
+            pos = skipQuoted(sql, sqlLength, pos, isMysql && c != '`');
+            qualified = false;
+        }
+        else if (c == '$' && !isMysql)
+        {
+            // A dollar-quoted string ($tag$...$tag$) or a parameter ($1).
+            auto tagEnd = pos + 1;
+            while (tagEnd < sqlLength && sql[tagEnd] != '$' &&
+                   isWordChar(sql[tagEnd]) &&
+                   !(tagEnd == pos + 1 &&
+                     isdigit(static_cast<unsigned char>(sql[tagEnd]))))
+                ++tagEnd;
+            if (tagEnd < sqlLength && sql[tagEnd] == '$')
+            {
+                string_view tag(sql + pos, tagEnd - pos + 1);
+                string_view rest(sql + tagEnd + 1, sqlLength - tagEnd - 1);
+                auto close = rest.find(tag);
+                pos = close == string_view::npos
+                          ? sqlLength
+                          : tagEnd + 1 + close + tag.length();
+            }
+            else
+            {
+                ++pos;
+                while (pos < sqlLength && isWordChar(sql[pos]))
+                    ++pos;
+            }
+        }
+        else if (isWordChar(c))
+        {
+            auto begin = pos;
+            while (pos < sqlLength && isWordChar(sql[pos]))
+                ++pos;
+            if (isdigit(static_cast<unsigned char>(c)))
+                continue;
+            if (!isMysql && pos == begin + 1 && (c == 'e' || c == 'E') &&
+                pos < sqlLength && sql[pos] == '\'')
+            {
+                // The E'...' strings escape quotes with backslashes.
+                pos = skipQuoted(sql, sqlLength, pos, true);
+                qualified = false;
+                continue;
+            }
+            SqlToken token;
+            token.word_.reserve(pos - begin);
+            for (auto i = begin; i < pos; ++i)
+                token.word_.push_back(static_cast<char>(
+                    tolower(static_cast<unsigned char>(sql[i]))));
+            token.isQualified_ = qualified;
+            qualified = false;
+            tokens.emplace_back(std::move(token));
+        }
+        else
+        {
+            if (c == '(' && !tokens.empty() && !qualified)
+                tokens.back().isCall_ = true;
+            else if (c == ';')
+                tokens.emplace_back(SqlToken{";"});
+            qualified = c == '.';
+            ++pos;
+        }
+    }
+    return tokens;
+}
+
+/**
+ * The words that may be followed by a parenthesis in a read-only statement,
+ * that is, keywords and built-in functions without side effects. Other
+ * functions may write data, statements calling them run on the primary.
+ */
+const std::unordered_set<std::string> &readOnlyCalls()
+{
+    static const std::unordered_set<std::string> calls{
+        // keywords
+        "select", "from", "where", "in", "exists", "any", "all", "some", "as",
+        "on", "using", "and", "or", "not", "over", "filter", "within",
+        "values", "array", "row", "join", "lateral", "distinct", "by",
+        "having", "union", "except", "intersect", "is", "like", "ilike",
+        "between", "when", "then", "else", "case", "cast", "convert",
+        "interval", "limit", "offset", "partition", "window",
+        // aggregate and window functions
+        "count", "sum", "avg", "min", "max", "array_agg", "string_agg",
+        "group_concat", "json_agg", "jsonb_agg", "json_object_agg",
+        "jsonb_object_agg", "bool_and", "bool_or", "every", "row_number",
+        "rank", "dense_rank", "ntile", "lag", "lead", "first_value",
+        "last_value", "nth_value",
+        // conditional expressions
+        "coalesce", "nullif", "greatest", "least", "if", "ifnull", "isnull",
+        // strings
+        "lower", "upper", "length", "char_length", "character_length",
+        "octet_length", "substr", "substring", "trim", "ltrim", "rtrim",
+        "btrim", "replace", "concat", "concat_ws", "position", "strpos",
+        "instr", "locate", "left", "right", "lpad", "rpad", "reverse",
+        "repeat", "split_part", "format", "md5", "encode", "decode", "ascii",
+        "chr", "char", "hex",
+        // numbers
+        "abs", "ceil", "ceiling", "floor", "round", "trunc", "truncate",
+        "mod", "power", "pow", "sqrt", "exp", "ln", "log", "log10", "sign",
+        "random", "rand", "to_number",
+        // dates
+        "now", "date", "time", "timestamp", "date_trunc", "date_part",
+        "extract", "age", "to_char", "to_date", "to_timestamp",
+        "date_format", "date_add", "date_sub", "datediff", "from_unixtime",
+        "unix_timestamp",
+        // json and arrays
+        "to_json", "to_jsonb", "row_to_json", "json_build_object",
+        "jsonb_build_object", "json_build_array", "jsonb_build_array",
+        "json_object", "json_array", "json_extract", "json_unquote",
+        "array_length", "unnest", "generate_series"};
+    return calls;
+}
+}  // namespace
+
+bool DbClientRouter::isReadOnlySql(const char *sql,
+                                   size_t sqlLength,
+                                   ClientType type)
+{
+    string_view hint;
+    auto tokens = tokenize(sql, sqlLength, type, hint);
+    if (!hint.empty())
+        return hint == "drogon:read-only";
+    if (tokens.empty() || tokens[0].word_ != "select")
+        return false;
+    auto &calls = readOnlyCalls();
+    // Statements that lock rows or write data must run on the primary.
+    for (size_t i = 0; i < tokens.size(); ++i)
+    {
+        auto &token = tokens[i];
+        auto nextWord = [&tokens, i](size_t n) -> const std::string & {
+            static const std::string empty;
+            return i + n < tokens.size() ? tokens[i + n].word_ : empty;
+        };
+        if (token.word_ == ";")
+        {
+            // Only a single statement is accepted.
+            if (i + 1 < tokens.size())
+                return false;
+        }
+        else if (token.word_ == "into")
+        {
+            return false;
+        }
+        else if (token.word_ == "for" &&
+                 (nextWord(1) == "update" || nextWord(1) == "share" ||
+                  nextWord(1) == "no" || nextWord(1) == "key"))
+        {
+            return false;
+        }
+        else if (token.word_ == "lock" && nextWord(1) == "in" &&
+                 nextWord(2) == "share")
+        {
+            return false;
+        }
+        else if (token.isCall_ &&
+                 (token.isQualified_ || calls.find(token.word_) == calls.end()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<DbClientRouter::Replica> DbClientRouter::selectReplica()
+{
+    std::shared_ptr<Replica> selected;
+    size_t minQueries = 0;
+    for (auto &replica : replicas_)
+    {
+        if (replica->drained_ || !replica->client_->hasAvailableConnections())
+            continue;
+        auto queries = replica->outstandingQueries_.load();
+        if (!selected || queries < minQueries)
+        {
+            selected = replica;
+            minQueries = queries;
+        }
+    }
+    return selected;
+}
+
+void DbClientRouter::execSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    if (!replicas_.empty() && isReadOnlySql(sql, sqlLength, type_))
+    {
+        auto replica = selectReplica();
+        if (replica)
+        {
+            ++replica->outstandingQueries_;
+            replica->client_->execSql(
+                sql,
+                sqlLength,
+                paraNum,
+                std::move(parameters),
+                std::move(length),
+                std::move(format),
+                [rcb = std::move(rcb), replica](const Result &r) {
+                    --replica->outstandingQueries_;
+                    rcb(r);
+                },
+                [exceptCallback = std::move(exceptCallback),
+                 replica](const std::exception_ptr &e) {
+                    --replica->outstandingQueries_;
+                    exceptCallback(e);
+                });
+            return;
+        }
+    }
+    primary_->execSql(sql,
+                      sqlLength,
+                      paraNum,
+                      std::move(parameters),
+                      std::move(length),
+                      std::move(format),
+                      std::move(rcb),
+                      std::move(exceptCallback));
+}
+
+void DbClientRouter::streamSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    if (!replicas_.empty() && isReadOnlySql(sql, sqlLength, type_))
+    {
+        auto replica = selectReplica();
+        if (replica)
+        {
+            // The stream is outstanding until its last batch is delivered.
+            ++replica->outstandingQueries_;
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            auto finish = [replica, done]() {
+                if (!done->exchange(true))
+                    --replica->outstandingQueries_;
+            };
+            replica->client_->streamSql(
+                sql,
+                sqlLength,
+                paraNum,
+                std::move(parameters),
+                std::move(length),
+                std::move(format),
+                batchSize,
+                [scb = std::move(scb), finish](
+                    const Result &r, std::function<void(bool)> &&resume) {
+                    if (r.size() == 0)
+                    {
+                        finish();
+                        scb(r, std::move(resume));
+                        return;
+                    }
+                    scb(r,
+                        [resume = std::move(resume),
+                         finish](bool more) mutable {
+                            if (!more)
+                                finish();
+                            resume(more);
+                        });
+                },
+                [exceptCallback = std::move(exceptCallback),
+                 finish](const std::exception_ptr &e) {
+                    finish();
+                    exceptCallback(e);
+                });
+            return;
+        }
+    }
+    primary_->streamSql(sql,
+                        sqlLength,
+                        paraNum,
+                        std::move(parameters),
+                        std::move(length),
+                        std::move(format),
+                        batchSize,
+                        std::move(scb),
+                        std::move(exceptCallback));
+}
+
+std::shared_ptr<Transaction> DbClientRouter::newTransaction(
+    const std::function<void(bool)> &commitCallback) noexcept(false)
+{
+    return primary_->newTransaction(commitCallback);
+}
+
+void DbClientRouter::newTransactionAsync(
+    const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
+{
+    primary_->newTransactionAsync(callback);
+}
+
+bool DbClientRouter::hasAvailableConnections() const noexcept
+{
+    // The replicas can still serve reads when the primary is down.
+    if (primary_->hasAvailableConnections())
+        return true;
+    for (auto &replica : replicas_)
+    {
+        if (!replica->drained_ && replica->client_->hasAvailableConnections())
+            return true;
+    }
+    return false;
+}
+
+void DbClientRouter::setTimeout(double timeout)
+{
+    primary_->setTimeout(timeout);
+    for (auto &replica : replicas_)
+    {
+        replica->client_->setTimeout(timeout);
+    }
+}
+
+void DbClientRouter::setMaxPendingQueries(size_t num)
+{
+    primary_->setMaxPendingQueries(num);
+    for (auto &replica : replicas_)
+    {
+        replica->client_->setMaxPendingQueries(num);
+    }
+}
+
+QueryQueueStats DbClientRouter::queueStats() const
+{
+    auto stats = primary_->queueStats();
+    for (auto &replica : replicas_)
+    {
+        auto replicaStats = replica->client_->queueStats();
+        stats.pendingQueries += replicaStats.pendingQueries;
+        stats.dispatchedQueries += replicaStats.dispatchedQueries;
+        stats.rejectedQueries += replicaStats.rejectedQueries;
+        stats.totalWaitTime += replicaStats.totalWaitTime;
+        stats.maxWaitTime =
+            (std::max)(stats.maxWaitTime, replicaStats.maxWaitTime);
+    }
+    return stats;
+}
+
+static void setReplicaLag(size_t index,
+                          std::atomic<bool> &drained,
+                          bool isLagging)
+{
+    if (drained.exchange(isLagging) != isLagging)
+    {
+        if (isLagging)
+        {
+            LOG_WARN << "Drain the lagging replica #" << index;
+        }
+        else
+        {
+            LOG_INFO << "The replica #" << index << " has caught up";
+        }
+    }
+}
+
+void DbClientRouter::checkReplicationLag()
+{
+    std::string sql;
+    if (type_ == ClientType::PostgreSQL)
+    {
+        // The replay timestamp doesn't advance on an idle primary, so a
+        // replica that has replayed all received WAL is never lagging.
+        sql =
+            "select case when not pg_is_in_recovery() or "
+            "pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() then 0 else "
+            "coalesce(extract(epoch from now() - "
+            "pg_last_xact_replay_timestamp()), 0) end";
+    }
+    else
+    {
+        sql = "show slave status";
+    }
+    auto maxLag = maxReplicationLag_;
+    auto isPg = type_ == ClientType::PostgreSQL;
+    for (size_t i = 0; i < replicas_.size(); ++i)
+    {
+        auto replicaPtr = replicas_[i];
+        if (replicaPtr->checkingLag_.exchange(true))
+        {
+            // The last check hasn't returned within the interval.
+            setReplicaLag(i, replicaPtr->drained_, true);
+            continue;
+        }
+        replicaPtr->client_->execSqlAsync(
+            sql,
+            [replicaPtr, i, maxLag, isPg](const Result &r) {
+                replicaPtr->checkingLag_ = false;
+                double lag = 0.0;
+                if (!r.empty())
+                {
+                    auto field = isPg ? r[0][0] : r[0]["Seconds_Behind_Master"];
+                    // MySQL reports NULL when the replication is stopped.
+                    lag = field.isNull() ? maxLag + 1.0 : field.as<double>();
+                }
+                setReplicaLag(i, replicaPtr->drained_, lag > maxLag);
+            },
+            [replicaPtr, i](const DrogonDbException &e) {
+                replicaPtr->checkingLag_ = false;
+                LOG_ERROR << "Failed to check the replication lag of the "
+                             "replica #"
+                          << i << ": " << e.base().what();
+                setReplicaLag(i, replicaPtr->drained_, true);
+            });
+    }
+}
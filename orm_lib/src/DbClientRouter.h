@@ -0,0 +1,117 @@
+/**
+ *
+ *  @file DbClientRouter.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/EventLoopThread.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief A client that sends read-only statements to replicas and all other
+ * statements and transactions to the primary database.
+ *
+ * The replica with the least outstanding queries is selected for each
+ * statement. Replicas whose replication lag exceeds the threshold, or whose
+ * lag can't be checked, are drained until they catch up. Statements go to the
+ * primary when no replica is available.
+ */
+class DbClientRouter : public DbClient,
+                       public std::enable_shared_from_this<DbClientRouter>
+{
+  public:
+    /**
+     * @param loop The event loop on which the lag of replicas is checked. If
+     * it's nullptr, the client creates a thread for the checks.
+     */
+    DbClientRouter(const DbClientPtr &primary,
+                   const std::vector<DbClientPtr> &replicas,
+                   double maxReplicationLag,
+                   trantor::EventLoop *loop = nullptr);
+    ~DbClientRouter() noexcept override;
+    void init();
+    void execSql(const char *sql,
+                 size_t sqlLength,
+                 size_t paraNum,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 std::function<void(const std::exception_ptr &)>
+                     &&exceptCallback) override;
+    void streamSql(const char *sql,
+                   size_t sqlLength,
+                   size_t paraNum,
+                   std::vector<const char *> &&parameters,
+                   std::vector<int> &&length,
+                   std::vector<int> &&format,
+                   size_t batchSize,
+                   StreamCallback &&scb,
+                   std::function<void(const std::exception_ptr &)>
+                       &&exceptCallback) override;
+    std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> &commitCallback =
+            std::function<void(bool)>()) noexcept(false) override;
+    void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override;
+    bool hasAvailableConnections() const noexcept override;
+    void setTimeout(double timeout) override;
+    void setMaxPendingQueries(size_t num) override;
+    QueryQueueStats queueStats() const override;
+
+    /**
+     * @brief Check if the statement can be executed on a replica, that is,
+     * a select statement that neither locks rows, writes data nor calls a
+     * function other than the built-in ones without side effects.
+     *
+     * A block comment that contains only "drogon:read-only" sends the
+     * statement to a replica, one that contains only "drogon:primary" sends
+     * it to the primary, whatever the statement is.
+     */
+    static bool isReadOnlySql(const char *sql,
+                              size_t sqlLength,
+                              ClientType type);
+
+  private:
+    struct Replica
+    {
+        explicit Replica(const DbClientPtr &client) : client_(client)
+        {
+        }
+        DbClientPtr client_;
+        std::atomic<size_t> outstandingQueries_{0};
+        std::atomic<bool> drained_{false};
+        std::atomic<bool> checkingLag_{false};
+    };
+    DbClientPtr primary_;
+    std::vector<std::shared_ptr<Replica>> replicas_;
+    double maxReplicationLag_;
+    std::unique_ptr<trantor::EventLoopThread> loopThread_;
+    trantor::EventLoop *loop_;
+    trantor::TimerId lagCheckTimerId_{0};
+    std::shared_ptr<Replica> selectReplica();
+    void checkReplicationLag();
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include "../../lib/src/BuiltinMetrics.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/utils/string_view.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/utils/NonCopyable.h>
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -55,8 +57,13 @@ struct SqlCmd
     QueryCallback callback_;
     ExceptPtrCallback exceptionCallback_;
     std::string preparingStatement_;
+    trantor::Date queuedTime_;
 #if LIBPQ_SUPPORTS_BATCH_MODE
-    bool isChanging_{false};
+    bool isFailed_{false};
+    // The rows of the command are streamed, they are read in the single-row
+    // mode once it is enabled.
+    bool isStreaming_{false};
+    bool isSingleRowMode_{false};
 #endif
     SqlCmd(string_view &&sql,
            const size_t paraNum,
@@ -76,6 +83,91 @@ struct SqlCmd
     }
 };
 
+/// Counters of the commands buffered by a database client while they are
+/// waiting for idle connections. They can be read from any thread.
+class QueryQueueCounters : public trantor::NonCopyable
+{
+  public:
+    /// Reserve a place for a new command, return false if the queue already
+    /// holds more than limit commands.
+    bool tryPush(size_t limit)
+    {
+        if (pendingNumber_.fetch_add(1, std::memory_order_relaxed) > limit)
+        {
+            pendingNumber_.fetch_sub(1, std::memory_order_relaxed);
+            rejectedNumber_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    /// Release the place of a command that leaves the queue without being
+    /// executed, e.g. because it timed out.
+    void drop()
+    {
+        pendingNumber_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    /// Release the place of a command that is sent to a connection, record
+    /// the time it waited and start timing its execution.
+    void pop(SqlCmd &cmd)
+    {
+        pendingNumber_.fetch_sub(1, std::memory_order_relaxed);
+        auto waitTime = trantor::Date::now().microSecondsSinceEpoch() -
+                        cmd.queuedTime_.microSecondsSinceEpoch();
+        if (waitTime < 0)
+            waitTime = 0;
+        dispatched(cmd.callback_, cmd.exceptionCallback_, (uint64_t)waitTime);
+    }
+    /// Record a command that is sent to a connection, waitTime is in
+    /// microseconds. The callbacks are wrapped to record the query duration
+    /// from now on, so the time spent in the queue is only counted in the
+    /// pool wait histogram.
+    void dispatched(ResultCallback &rcb,
+                    std::function<void(const std::exception_ptr &)> &exceptCb,
+                    uint64_t waitTime = 0)
+    {
+        dispatchedNumber_.fetch_add(1, std::memory_order_relaxed);
+        if (auto metrics = drogon::internal::builtinMetrics())
+        {
+            metrics->dbPoolWait->observe(waitTime / 1000000.0);
+            drogon::internal::recordCallDuration(*metrics->dbQueryDuration,
+                                                 rcb,
+                                                 exceptCb);
+        }
+        if (waitTime == 0)
+            return;
+        totalWaitTime_.fetch_add(waitTime, std::memory_order_relaxed);
+        auto maxTime = maxWaitTime_.load(std::memory_order_relaxed);
+        while (waitTime > maxTime &&
+               !maxWaitTime_.compare_exchange_weak(maxTime,
+                                                   waitTime,
+                                                   std::memory_order_relaxed))
+        {
+        }
+    }
+    size_t pendingNumber() const
+    {
+        return pendingNumber_.load(std::memory_order_relaxed);
+    }
+    QueryQueueStats stats() const
+    {
+        QueryQueueStats stats;
+        stats.pendingQueries = pendingNumber_.load(std::memory_order_relaxed);
+        stats.dispatchedQueries =
+            dispatchedNumber_.load(std::memory_order_relaxed);
+        stats.rejectedQueries = rejectedNumber_.load(std::memory_order_relaxed);
+        stats.totalWaitTime = totalWaitTime_.load(std::memory_order_relaxed);
+        stats.maxWaitTime = maxWaitTime_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+  private:
+    std::atomic<size_t> pendingNumber_{0};
+    std::atomic<uint64_t> dispatchedNumber_{0};
+    std::atomic<uint64_t> rejectedNumber_{0};
+    std::atomic<uint64_t> totalWaitTime_{0};
+    std::atomic<uint64_t> maxWaitTime_{0};
+};
+
 class DbConnection;
 using DbConnectionPtr = std::shared_ptr<DbConnection>;
 class DbConnection : public trantor::NonCopyable
@@ -105,6 +197,19 @@ class DbConnection : public trantor::NonCopyable
         std::vector<int> &&format,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
+    /// Execute the statement and deliver the rows in batches of at most
+    /// batchSize rows. The connection reads no more rows until the consumer
+    /// resumes the stream and it becomes idle when the stream ends or is
+    /// cancelled.
+    virtual void execSqlStream(
+        string_view &&sql,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        size_t batchSize,
+        StreamCallback &&scb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
     virtual void batchSql(
         std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands) = 0;
     virtual ~DbConnection()
@@ -28,26 +28,12 @@ using namespace drogon::orm::internal;
 void SqlBinder::exec()
 {
     execed_ = true;
-    if (mode_ == Mode::NonBlocking)
+    // Streamed results are always delivered asynchronously.
+    if (mode_ == Mode::NonBlocking || streamCallback_)
     {
         // nonblocking mode,default mode
         // Retain shared_ptrs of parameters until we get the result;
-        client_.execSql(
-            sqlViewPtr_,
-            sqlViewLength_,
-            parametersNumber_,
-            std::move(parameters_),
-            std::move(lengths_),
-            std::move(formats_),
-            [holder = std::move(callbackHolder_),
-             objs = std::move(objs_),
-             sqlptr = std::move(sqlPtr_)](const Result &r) mutable {
-                objs.clear();
-                if (holder)
-                {
-                    holder->execCallback(r);
-                }
-            },
+        auto exceptCallback =
             [exceptCb = std::move(exceptionCallback_),
              exceptPtrCb = std::move(exceptionPtrCallback_),
              isExceptPtr =
@@ -72,7 +58,43 @@ void SqlBinder::exec()
                     if (exceptPtrCb)
                         exceptPtrCb(exception);
                 }
-            });
+            };
+        if (streamCallback_)
+        {
+            client_.streamSql(
+                sqlViewPtr_,
+                sqlViewLength_,
+                parametersNumber_,
+                std::move(parameters_),
+                std::move(lengths_),
+                std::move(formats_),
+                streamBatchSize_,
+                [callback = std::move(streamCallback_),
+                 objs = std::move(objs_),
+                 sqlptr = std::move(sqlPtr_)](
+                    const Result &r, std::function<void(bool)> &&resume) {
+                    callback(r, std::move(resume));
+                },
+                std::move(exceptCallback));
+            return;
+        }
+        client_.execSql(
+            sqlViewPtr_,
+            sqlViewLength_,
+            parametersNumber_,
+            std::move(parameters_),
+            std::move(lengths_),
+            std::move(formats_),
+            [holder = std::move(callbackHolder_),
+             objs = std::move(objs_),
+             sqlptr = std::move(sqlPtr_)](const Result &r) mutable {
+                objs.clear();
+                if (holder)
+                {
+                    holder->execCallback(r);
+                }
+            },
+            std::move(exceptCallback));
     }
     else
     {
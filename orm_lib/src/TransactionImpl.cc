@@ -149,6 +149,58 @@ void TransactionImpl::execSqlInLoop(
     }
 }
 
+void TransactionImpl::streamSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    auto cmdPtr = std::make_shared<SqlCmd>();
+    cmdPtr->sql_ = string_view{sql, sqlLength};
+    cmdPtr->parametersNumber_ = paraNum;
+    cmdPtr->parameters_ = std::move(parameters);
+    cmdPtr->lengths_ = std::move(length);
+    cmdPtr->formats_ = std::move(format);
+    cmdPtr->exceptionCallback_ = std::move(exceptCallback);
+    cmdPtr->streamCallback_ = std::move(scb);
+    cmdPtr->streamBatchSize_ = batchSize;
+    loop_->runInLoop([thisPtr = shared_from_this(), cmdPtr]() {
+        if (thisPtr->isCommitedOrRolledback_)
+        {
+            auto exceptPtr = std::make_exception_ptr(
+                TransactionRollback("The transaction has been rolled back"));
+            cmdPtr->exceptionCallback_(exceptPtr);
+            return;
+        }
+        if (thisPtr->isWorking_)
+        {
+            cmdPtr->thisPtr_ = thisPtr;
+            thisPtr->sqlCmdBuffer_.push_back(cmdPtr);
+            return;
+        }
+        thisPtr->isWorking_ = true;
+        thisPtr->thisPtr_ = thisPtr;
+        thisPtr->connectionPtr_->execSqlStream(
+            std::move(cmdPtr->sql_),
+            cmdPtr->parametersNumber_,
+            std::move(cmdPtr->parameters_),
+            std::move(cmdPtr->lengths_),
+            std::move(cmdPtr->formats_),
+            cmdPtr->streamBatchSize_,
+            std::move(cmdPtr->streamCallback_),
+            [cmdPtr, thisPtr](const std::exception_ptr &ePtr) {
+                thisPtr->rollback();
+                if (cmdPtr->exceptionCallback_)
+                    cmdPtr->exceptionCallback_(ePtr);
+            });
+    });
+}
+
 void TransactionImpl::rollback()
 {
     auto thisPtr = shared_from_this();
@@ -211,6 +263,23 @@ void TransactionImpl::execNewTask()
             auto cmd = std::move(sqlCmdBuffer_.front());
             sqlCmdBuffer_.pop_front();
             auto conn = connectionPtr_;
+            if (cmd->streamCallback_)
+            {
+                conn->execSqlStream(
+                    std::move(cmd->sql_),
+                    cmd->parametersNumber_,
+                    std::move(cmd->parameters_),
+                    std::move(cmd->lengths_),
+                    std::move(cmd->formats_),
+                    cmd->streamBatchSize_,
+                    std::move(cmd->streamCallback_),
+                    [cmd, thisPtr](const std::exception_ptr &ePtr) {
+                        thisPtr->rollback();
+                        if (cmd->exceptionCallback_)
+                            cmd->exceptionCallback_(ePtr);
+                    });
+                return;
+            }
             conn->execSql(
                 std::move(cmd->sql_),
                 cmd->parametersNumber_,
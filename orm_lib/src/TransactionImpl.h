@@ -46,6 +46,14 @@ class TransactionImpl : public Transaction,
     {
         timeout_ = timeout;
     }
+    void setMaxPendingQueries(size_t) override
+    {
+        // All commands of a transaction are executed on its own connection
+    }
+    QueryQueueStats queueStats() const override
+    {
+        return QueryQueueStats();
+    }
 
   private:
     DbConnectionPtr connectionPtr_;
@@ -91,6 +99,16 @@ class TransactionImpl : public Transaction,
         }
     }
 
+    void streamSql(const char *sql,
+                   size_t sqlLength,
+                   size_t paraNum,
+                   std::vector<const char *> &&parameters,
+                   std::vector<int> &&length,
+                   std::vector<int> &&format,
+                   size_t batchSize,
+                   StreamCallback &&scb,
+                   std::function<void(const std::exception_ptr &)>
+                       &&exceptCallback) override;
     void execSqlInLoop(
         string_view &&sql,
         size_t paraNum,
@@ -133,6 +151,9 @@ class TransactionImpl : public Transaction,
         QueryCallback callback_;
         ExceptPtrCallback exceptionCallback_;
         bool isRollbackCmd_{false};
+        // Set if the rows of the command are streamed
+        StreamCallback streamCallback_;
+        size_t streamBatchSize_{0};
         std::shared_ptr<TransactionImpl> thisPtr_;
     };
     using SqlCmdPtr = std::shared_ptr<SqlCmd>;
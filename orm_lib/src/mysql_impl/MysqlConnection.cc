@@ -280,6 +280,12 @@ void MysqlConnection::handleEvent()
                         outputError();
                         return;
                     }
+                    if (streamBatchSize_ > 0)
+                    {
+                        execStatus_ = ExecStatus::None;
+                        startStream();
+                        return;
+                    }
                     execStatus_ = ExecStatus::StoreResult;
                     MYSQL_RES *ret;
                     waitStatus_ =
@@ -320,6 +326,24 @@ void MysqlConnection::handleEvent()
                 setChannel();
                 break;
             }
+            case ExecStatus::FetchRow:
+            {
+                MYSQL_ROW row;
+                waitStatus_ = mysql_fetch_row_cont(&row,
+                                                   streamResult_.get(),
+                                                   status);
+                if (waitStatus_ == 0)
+                {
+                    execStatus_ = ExecStatus::None;
+                    if (handleStreamRow(row))
+                    {
+                        fetchStreamRows();
+                    }
+                    return;
+                }
+                setChannel();
+                break;
+            }
             case ExecStatus::None:
             {
                 // Connection closed!
@@ -500,6 +524,13 @@ void MysqlConnection::execSqlInLoop(
                 [thisPtr = shared_from_this()] { thisPtr->outputError(); });
             return;
         }
+        if (streamBatchSize_ > 0)
+        {
+            execStatus_ = ExecStatus::None;
+            loop_->queueInLoop(
+                [thisPtr = shared_from_this()] { thisPtr->startStream(); });
+            return;
+        }
 
         MYSQL_RES *ret;
         waitStatus_ = mysql_store_result_start(&ret, mysqlPtr_.get());
@@ -531,6 +562,10 @@ void MysqlConnection::outputError()
     LOG_ERROR << "Error(" << errorNo << ") [" << mysql_sqlstate(mysqlPtr_.get())
               << "] \"" << mysql_error(mysqlPtr_.get()) << "\"";
 
+    streamCallback_ = nullptr;
+    streamBatchSize_ = 0;
+    streamRows_.reset();
+    streamResult_.reset();
     if (isWorking_)
     {
         // TODO: exception type
@@ -569,3 +604,168 @@ void MysqlConnection::getResult(MYSQL_RES *res)
         idleCb_();
     }
 }
+
+void MysqlConnection::execSqlStream(
+    string_view &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    loop_->runInLoop([thisPtr = shared_from_this(),
+                      sql = std::move(sql),
+                      paraNum,
+                      parameters = std::move(parameters),
+                      length = std::move(length),
+                      format = std::move(format),
+                      batchSize,
+                      scb = std::move(scb),
+                      exceptCallback = std::move(exceptCallback)]() mutable {
+        thisPtr->streamCallback_ = std::move(scb);
+        thisPtr->streamBatchSize_ = batchSize;
+        thisPtr->execSqlInLoop(std::move(sql),
+                               paraNum,
+                               std::move(parameters),
+                               std::move(length),
+                               std::move(format),
+                               [](const Result &) {},
+                               std::move(exceptCallback));
+    });
+}
+
+void MysqlConnection::startStream()
+{
+    // The rows are not buffered by the client, the server sends them as they
+    // are fetched.
+    auto res = mysql_use_result(mysqlPtr_.get());
+    if (!res)
+    {
+        if (mysql_errno(mysqlPtr_.get()))
+        {
+            LOG_ERROR << "error in: " << sql_;
+            outputError();
+            return;
+        }
+        // The statement doesn't return rows.
+        streamColumns_ = std::make_shared<MysqlStreamResultImpl::Columns>();
+        streamRows_ = std::make_shared<MysqlStreamResultImpl>(streamColumns_);
+        finishStream();
+        return;
+    }
+    streamResult_ = std::shared_ptr<MYSQL_RES>(res, [](MYSQL_RES *r) {
+        mysql_free_result(r);
+    });
+    streamColumns_ = MysqlStreamResultImpl::makeColumns(res);
+    streamRows_ = std::make_shared<MysqlStreamResultImpl>(streamColumns_);
+    fetchStreamRows();
+}
+
+void MysqlConnection::fetchStreamRows()
+{
+    while (!streamPaused_)
+    {
+        MYSQL_ROW row;
+        waitStatus_ = mysql_fetch_row_start(&row, streamResult_.get());
+        if (waitStatus_ != 0)
+        {
+            execStatus_ = ExecStatus::FetchRow;
+            setChannel();
+            return;
+        }
+        if (!handleStreamRow(row))
+            return;
+    }
+}
+
+bool MysqlConnection::handleStreamRow(MYSQL_ROW row)
+{
+    if (!row)
+    {
+        if (mysql_errno(mysqlPtr_.get()))
+        {
+            outputError();
+            return false;
+        }
+        finishStream();
+        return false;
+    }
+    if (!streamCallback_)
+    {
+        // The stream is cancelled, drop the remaining rows.
+        return true;
+    }
+    streamRows_->addRow(row, mysql_fetch_lengths(streamResult_.get()));
+    if (streamRows_->size() < streamBatchSize_)
+        return true;
+    Result rows(std::move(streamRows_));
+    streamRows_ = std::make_shared<MysqlStreamResultImpl>(streamColumns_);
+    // Stop reading the socket, the server blocks when the buffers are full.
+    streamPaused_ = true;
+    channelPtr_->disableReading();
+    std::weak_ptr<MysqlConnection> weakPtr = shared_from_this();
+    auto loop = loop_;
+    streamCallback_(rows, [weakPtr, loop](bool more) {
+        loop->queueInLoop([weakPtr, more]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->resumeStream(more);
+        });
+    });
+    return false;
+}
+
+void MysqlConnection::finishStream()
+{
+    // All rows have been fetched, so freeing the result doesn't block.
+    streamResult_.reset();
+    auto callback = std::move(streamCallback_);
+    streamCallback_ = nullptr;
+    streamBatchSize_ = 0;
+    auto lastRows = std::move(streamRows_);
+    Result end(std::make_shared<MysqlStreamResultImpl>(
+        streamColumns_,
+        mysql_affected_rows(mysqlPtr_.get()),
+        mysql_insert_id(mysqlPtr_.get())));
+    streamColumns_.reset();
+    callback_ = nullptr;
+    exceptionCallback_ = nullptr;
+    isWorking_ = false;
+    if (callback)
+    {
+        if (!lastRows || lastRows->size() == 0)
+        {
+            callback(end, [](bool) {});
+        }
+        else
+        {
+            auto loop = loop_;
+            callback(Result(lastRows), [loop, callback, end](bool more) {
+                if (more)
+                {
+                    loop->queueInLoop(
+                        [callback, end]() { callback(end, [](bool) {}); });
+                }
+            });
+        }
+    }
+    idleCb_();
+}
+
+void MysqlConnection::resumeStream(bool more)
+{
+    loop_->assertInLoopThread();
+    if (!streamPaused_)
+        return;
+    streamPaused_ = false;
+    if (!more)
+    {
+        // The remaining rows are fetched and dropped.
+        streamCallback_ = nullptr;
+    }
+    if (status_ != ConnectStatus::Ok)
+        return;
+    fetchStreamRows();
+}
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "../DbConnection.h"
+#include "MysqlResultImpl.h"
 #include <drogon/orm/DbClient.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/Channel.h>
@@ -80,6 +81,15 @@ class MysqlConnection : public DbConnection,
                 });
         }
     }
+    void execSqlStream(string_view &&sql,
+                       size_t paraNum,
+                       std::vector<const char *> &&parameters,
+                       std::vector<int> &&length,
+                       std::vector<int> &&format,
+                       size_t batchSize,
+                       StreamCallback &&scb,
+                       std::function<void(const std::exception_ptr &)>
+                           &&exceptCallback) override;
     virtual void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&) override
     {
         LOG_FATAL << "The mysql library does not support batch mode";
@@ -112,10 +122,25 @@ class MysqlConnection : public DbConnection,
     {
         None = 0,
         RealQuery,
-        StoreResult
+        StoreResult,
+        FetchRow
     };
     ExecStatus execStatus_{ExecStatus::None};
 
+    // The state of a streamed query, its rows are fetched one by one from an
+    // unbuffered result.
+    StreamCallback streamCallback_;
+    size_t streamBatchSize_{0};
+    std::shared_ptr<MYSQL_RES> streamResult_;
+    std::shared_ptr<MysqlStreamResultImpl::Columns> streamColumns_;
+    std::shared_ptr<MysqlStreamResultImpl> streamRows_;
+    bool streamPaused_{false};
+    void startStream();
+    void fetchStreamRows();
+    bool handleStreamRow(MYSQL_ROW row);
+    void finishStream();
+    void resumeStream(bool more);
+
     void outputError();
     std::string sql_;
     std::string host_, user_, passwd_, dbname_, port_;
@@ -81,3 +81,95 @@ unsigned long long MysqlResultImpl::insertId() const noexcept
 {
     return insertId_;
 }
+
+std::shared_ptr<MysqlStreamResultImpl::Columns>
+MysqlStreamResultImpl::makeColumns(MYSQL_RES *r)
+{
+    auto columns = std::make_shared<Columns>();
+    auto fieldsNumber = mysql_num_fields(r);
+    auto fieldArray = mysql_fetch_fields(r);
+    for (RowSizeType i = 0; i < fieldsNumber; ++i)
+    {
+        std::string fieldName = fieldArray[i].name;
+        columns->names_.push_back(fieldName);
+        std::transform(fieldName.begin(),
+                       fieldName.end(),
+                       fieldName.begin(),
+                       tolower);
+        columns->numbers_[fieldName] = i;
+    }
+    return columns;
+}
+
+void MysqlStreamResultImpl::addRow(MYSQL_ROW row, const unsigned long *lengths)
+{
+    for (size_t i = 0; i < columns_->names_.size(); ++i)
+    {
+        values_.push_back(row[i] ? std::make_shared<std::string>(row[i],
+                                                                 lengths[i])
+                                 : nullptr);
+    }
+}
+
+Result::SizeType MysqlStreamResultImpl::size() const noexcept
+{
+    return columns_->names_.empty()
+               ? 0
+               : values_.size() / columns_->names_.size();
+}
+
+Result::RowSizeType MysqlStreamResultImpl::columns() const noexcept
+{
+    return static_cast<RowSizeType>(columns_->names_.size());
+}
+
+const char *MysqlStreamResultImpl::columnName(RowSizeType number) const
+{
+    assert(number < columns_->names_.size());
+    return columns_->names_[number].c_str();
+}
+
+Result::SizeType MysqlStreamResultImpl::affectedRows() const noexcept
+{
+    return affectedRows_;
+}
+
+Result::RowSizeType MysqlStreamResultImpl::columnNumber(
+    const char colName[]) const
+{
+    std::string col(colName);
+    std::transform(col.begin(), col.end(), col.begin(), tolower);
+    auto iter = columns_->numbers_.find(col);
+    if (iter != columns_->numbers_.end())
+        return iter->second;
+    throw RangeError(std::string("no column named ") + colName);
+}
+
+const char *MysqlStreamResultImpl::getValue(SizeType row,
+                                            RowSizeType column) const
+{
+    assert(row < size());
+    assert(column < columns_->names_.size());
+    auto &value = values_[row * columns_->names_.size() + column];
+    return value ? value->c_str() : NULL;
+}
+
+bool MysqlStreamResultImpl::isNull(SizeType row, RowSizeType column) const
+{
+    return getValue(row, column) == NULL;
+}
+
+Result::FieldSizeType MysqlStreamResultImpl::getLength(
+    SizeType row,
+    RowSizeType column) const
+{
+    assert(row < size());
+    assert(column < columns_->names_.size());
+    auto &value = values_[row * columns_->names_.size() + column];
+    return value ? value->length() : 0;
+}
+
+unsigned long long MysqlStreamResultImpl::insertId() const noexcept
+{
+    return insertId_;
+}
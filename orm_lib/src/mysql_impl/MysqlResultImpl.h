@@ -94,5 +94,44 @@ class MysqlResultImpl : public ResultImpl
         rowsPtr_;
 };
 
+/// A batch of rows of an unbuffered result. The values are copied because
+/// the buffers of a row are reused when the next row is fetched.
+class MysqlStreamResultImpl : public ResultImpl
+{
+  public:
+    struct Columns
+    {
+        std::vector<std::string> names_;
+        std::unordered_map<std::string, RowSizeType> numbers_;
+    };
+    static std::shared_ptr<Columns> makeColumns(MYSQL_RES *r);
+
+    MysqlStreamResultImpl(const std::shared_ptr<Columns> &columns,
+                          SizeType affectedRows = 0,
+                          unsigned long long insertId = 0) noexcept
+        : columns_(columns), affectedRows_(affectedRows), insertId_(insertId)
+    {
+    }
+    void addRow(MYSQL_ROW row, const unsigned long *lengths);
+    virtual SizeType size() const noexcept override;
+    virtual RowSizeType columns() const noexcept override;
+    virtual const char *columnName(RowSizeType number) const override;
+    virtual SizeType affectedRows() const noexcept override;
+    virtual RowSizeType columnNumber(const char colName[]) const override;
+    virtual const char *getValue(SizeType row,
+                                 RowSizeType column) const override;
+    virtual bool isNull(SizeType row, RowSizeType column) const override;
+    virtual FieldSizeType getLength(SizeType row,
+                                    RowSizeType column) const override;
+    virtual unsigned long long insertId() const noexcept override;
+
+  private:
+    std::shared_ptr<Columns> columns_;
+    // The values of all rows in row-major order, nullptr for NULL values
+    std::vector<std::shared_ptr<std::string>> values_;
+    const SizeType affectedRows_;
+    const unsigned long long insertId_;
+};
+
 }  // namespace orm
 }  // namespace drogon
@@ -28,7 +28,8 @@ namespace drogon
 {
 namespace orm
 {
-static const unsigned int maxBatchCount = 256;
+static const size_t minBatchLimit = 16;
+static const size_t maxBatchLimit = 1024;
 Result makeResult(
     const std::shared_ptr<PGresult> &r = std::shared_ptr<PGresult>(nullptr))
 {
@@ -36,22 +37,6 @@ Result makeResult(
         std::shared_ptr<PostgreSQLResultImpl>(new PostgreSQLResultImpl(r)));
 }
 
-bool checkSql(const string_view &sql_)
-{
-    if (sql_.length() > 1024)
-        return true;
-    std::string sql{sql_.data(), sql_.length()};
-    std::transform(sql.begin(), sql.end(), sql.begin(), tolower);
-    return (sql.find("update") != std::string::npos ||
-            sql.find("into") != std::string::npos ||
-            sql.find("delete") != std::string::npos ||
-            sql.find("drop") != std::string::npos ||
-            sql.find("truncate") != std::string::npos ||
-            sql.find("lock") != std::string::npos ||
-            sql.find("create") != std::string::npos ||
-            sql.find("alter") != std::string::npos);
-}
-
 }  // namespace orm
 }  // namespace drogon
 
@@ -136,6 +121,12 @@ void PgConnection::handleClosed()
     status_ = ConnectStatus::Bad;
     channel_.disableAll();
     channel_.remove();
+    if (streamCallback_)
+    {
+        // The consumer of the stream may wait for a batch that never comes.
+        isWorking_ = false;
+        handleFatalError(true);
+    }
     assert(closeCallback_);
     auto thisPtr = shared_from_this();
     closeCallback_(thisPtr);
@@ -186,7 +177,7 @@ void PgConnection::pgPoll()
             if (status_ != ConnectStatus::Ok)
             {
                 status_ = ConnectStatus::Ok;
-                if (!PQbeginBatchMode(connectionPtr_.get()))
+                if (!PQenterPipelineMode(connectionPtr_.get()))
                 {
                     handleClosed();
                     return;
@@ -232,25 +223,58 @@ void PgConnection::execSqlInLoop(
             [thisPtr = shared_from_this()]() { thisPtr->sendBatchedSql(); });
     }
 }
-int PgConnection::sendBatchEnd()
+void PgConnection::execSqlStream(
+    string_view &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    loop_->runInLoop([thisPtr = shared_from_this(),
+                      sql = std::move(sql),
+                      paraNum,
+                      parameters = std::move(parameters),
+                      length = std::move(length),
+                      format = std::move(format),
+                      batchSize,
+                      scb = std::move(scb),
+                      exceptCallback = std::move(exceptCallback)]() mutable {
+        thisPtr->streamCallback_ = std::move(scb);
+        thisPtr->streamBatchSize_ = batchSize;
+        thisPtr->execSqlInLoop(std::move(sql),
+                               paraNum,
+                               std::move(parameters),
+                               std::move(length),
+                               std::move(format),
+                               [](const Result &) {},
+                               std::move(exceptCallback));
+        thisPtr->batchSqlCommands_.back()->isStreaming_ = true;
+    });
+}
+
+int PgConnection::sendPipelineSync()
 {
-    if (!PQsendEndBatch(connectionPtr_.get()))
+    if (!PQpipelineSync(connectionPtr_.get()))
     {
         isWorking_ = false;
         handleFatalError(true);
         handleClosed();
         return 0;
     }
+    pipelineSyncs_.push_back(trantor::Date::now());
     return 1;
 }
 void PgConnection::sendBatchedSql()
 {
     if (isWorking_)
     {
-        if (sendBatchEnd_)
+        if (sendPipelineSync_)
         {
-            sendBatchEnd_ = false;
-            if (!sendBatchEnd())
+            sendPipelineSync_ = false;
+            if (!sendPipelineSync())
             {
                 return;
             }
@@ -270,6 +294,13 @@ void PgConnection::sendBatchedSql()
     while (!batchSqlCommands_.empty())
     {
         auto &cmd = batchSqlCommands_.front();
+        if (cmd->preparingStatement_.empty() &&
+            batchCommandsForWaitingResults_.size() >= batchLimit_)
+        {
+            // The pipeline is full, the commands left are sent when the
+            // results of the sent ones arrive.
+            return;
+        }
         std::string statName;
         if (cmd->preparingStatement_.empty())
         {
@@ -292,7 +323,6 @@ void PgConnection::sendBatchedSql()
                     return;
                 }
                 cmd->preparingStatement_ = statName;
-                cmd->isChanging_ = checkSql(cmd->sql_);
                 if (flush())
                 {
                     return;
@@ -300,26 +330,18 @@ void PgConnection::sendBatchedSql()
             }
             else
             {
-                statName = iter->second.first;
-                cmd->isChanging_ = iter->second.second;
+                statName = iter->second;
             }
         }
         else
         {
             statName = cmd->preparingStatement_;
         }
-        if (batchSqlCommands_.size() == 1 || cmd->sql_.length() > 1024 ||
-            batchCount_ > maxBatchCount)
-        {
-            sendBatchEnd_ = true;
-            batchCount_ = 0;
-        }
-        else if (cmd->isChanging_)
-        {
-            sendBatchEnd_ = true;
-            batchCount_ = 0;
-        }
-        ++batchCount_;
+        // A failing command aborts all the following commands until the
+        // next sync point, so every command is followed by one. It also
+        // runs each command in its own implicit transaction, as without
+        // pipelining.
+        sendPipelineSync_ = true;
         if (PQsendQueryPrepared(connectionPtr_.get(),
                                 statName.c_str(),
                                 cmd->parametersNumber_,
@@ -335,14 +357,20 @@ void PgConnection::sendBatchedSql()
         }
         batchCommandsForWaitingResults_.push_back(std::move(cmd));
         batchSqlCommands_.pop_front();
+        if (batchCommandsForWaitingResults_.size() == 1 &&
+            pipelineSyncs_.empty())
+        {
+            // The query is the first one in the pipeline.
+            setSingleRowMode();
+        }
         if (flush())
         {
             return;
         }
-        if (sendBatchEnd_)
+        if (sendPipelineSync_)
         {
-            sendBatchEnd_ = false;
-            if (!sendBatchEnd())
+            sendPipelineSync_ = false;
+            if (!sendPipelineSync())
             {
                 return;
             }
@@ -379,6 +407,7 @@ void PgConnection::handleRead()
     // assert((!batchCommandsForWaitingResults_.empty() ||
     //         !batchSqlCommands_.empty()));
 
+    bool lastResultIsNull = false;
     while (!PQisBusy(connectionPtr_.get()))
     {
         res = std::shared_ptr<PGresult>(PQgetResult(connectionPtr_.get()),
@@ -386,31 +415,52 @@ void PgConnection::handleRead()
         if (!res)
         {
             /*
-             * No more results from this query, advance to
-             * the next result
+             * No more results from this query, the next call advances to
+             * the results of the next query in the pipeline. Two nulls in a
+             * row mean that the pipeline is idle.
              */
-            if (!PQgetNextQuery(connectionPtr_.get()))
+            if (lastResultIsNull || (batchCommandsForWaitingResults_.empty() &&
+                                     pipelineSyncs_.empty()))
             {
                 return;
             }
+            lastResultIsNull = true;
+            setSingleRowMode();
             continue;
         }
+        lastResultIsNull = false;
         auto type = PQresultStatus(res.get());
-        if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR ||
-            type == PGRES_BATCH_ABORTED)
+        if (type == PGRES_SINGLE_TUPLE)
+        {
+            if (streamCallback_)
+            {
+                streamRows_.push_back(std::move(res));
+                if (streamRows_.size() >= streamBatchSize_)
+                {
+                    deliverStreamRows();
+                    return;
+                }
+            }
+            continue;
+        }
+        if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR)
         {
             handleFatalError(false);
             continue;
         }
-        if (type == PGRES_BATCH_END)
+        if (type == PGRES_PIPELINE_ABORTED)
+        {
+            handleAbortedCommand();
+            continue;
+        }
+        if (type == PGRES_PIPELINE_SYNC)
         {
-            if (batchCommandsForWaitingResults_.empty() &&
-                batchSqlCommands_.empty())
+            handlePipelineSync();
+            if (!isWorking_)
             {
-                isWorking_ = false;
-                idleCb_();
                 return;
             }
+            setSingleRowMode();
             continue;
         }
         if (!batchCommandsForWaitingResults_.empty())
@@ -421,13 +471,20 @@ void PgConnection::handleRead()
                 auto r = preparedStatements_.insert(
                     std::string{cmd->sql_.data(), cmd->sql_.length()});
                 preparedStatementsMap_[string_view{r.first->c_str(),
-                                                   r.first->length()}] = {
-                    std::move(cmd->preparingStatement_), cmd->isChanging_};
+                                                   r.first->length()}] =
+                    std::move(cmd->preparingStatement_);
                 cmd->preparingStatement_.clear();
                 continue;
             }
-            auto r = makeResult(res);
-            cmd->callback_(r);
+            if (cmd->isStreaming_)
+            {
+                finishStream(res);
+            }
+            else
+            {
+                auto r = makeResult(res);
+                cmd->callback_(r);
+            }
             batchCommandsForWaitingResults_.pop_front();
             continue;
         }
@@ -439,8 +496,8 @@ void PgConnection::handleRead()
             auto r = preparedStatements_.insert(
                 std::string{cmd->sql_.data(), cmd->sql_.length()});
             preparedStatementsMap_[string_view{r.first->c_str(),
-                                               r.first->length()}] = {
-                std::move(cmd->preparingStatement_), cmd->isChanging_};
+                                               r.first->length()}] =
+                std::move(cmd->preparingStatement_);
             cmd->preparingStatement_.clear();
             continue;
         }
@@ -451,6 +508,179 @@ void PgConnection::doAfterPreparing()
 {
 }
 
+void PgConnection::handleAbortedCommand()
+{
+    if (batchCommandsForWaitingResults_.empty())
+    {
+        // Only the statement has been sent for the first command.
+        assert(!batchSqlCommands_.empty());
+        batchSqlCommands_.front()->preparingStatement_.clear();
+        return;
+    }
+    auto &cmd = batchCommandsForWaitingResults_.front();
+    if (!cmd->preparingStatement_.empty())
+    {
+        // The statement was not prepared, the execution of the command is
+        // aborted as well and reported with the next result.
+        cmd->preparingStatement_.clear();
+        return;
+    }
+    if (!cmd->isFailed_)
+    {
+        // Every command has its own pipeline segment, so only the execution
+        // of a statement that failed to prepare is aborted. Anything else
+        // is reported instead of being resent out of order.
+        if (cmd->isStreaming_)
+        {
+            streamCallback_ = nullptr;
+            streamRows_.clear();
+        }
+        auto exceptPtr = std::make_exception_ptr(
+            Failure("The command was aborted by an earlier error in the "
+                    "same pipeline"));
+        cmd->exceptionCallback_(exceptPtr);
+    }
+    batchCommandsForWaitingResults_.pop_front();
+}
+
+void PgConnection::setSingleRowMode()
+{
+    // The mode must be set before the first result of the query is read,
+    // libpq rejects the call if the query is not the current one.
+    if (batchCommandsForWaitingResults_.empty())
+        return;
+    auto &cmd = batchCommandsForWaitingResults_.front();
+    if (cmd->isStreaming_ && !cmd->isSingleRowMode_ &&
+        cmd->preparingStatement_.empty())
+    {
+        cmd->isSingleRowMode_ = PQsetSingleRowMode(connectionPtr_.get()) == 1;
+    }
+}
+
+void PgConnection::handlePipelineSync()
+{
+    if (!pipelineSyncs_.empty())
+    {
+        auto now = trantor::Date::now();
+        adjustBatchLimit(now.microSecondsSinceEpoch() -
+                         pipelineSyncs_.front().microSecondsSinceEpoch());
+        pipelineSyncs_.pop_front();
+    }
+    if (batchCommandsForWaitingResults_.empty() && batchSqlCommands_.empty() &&
+        pipelineSyncs_.empty())
+    {
+        isWorking_ = false;
+        idleCb_();
+    }
+    else if (!batchSqlCommands_.empty() && !channel_.isWriting())
+    {
+        // There is room in the pipeline for the commands left.
+        sendBatchedSql();
+    }
+}
+
+void PgConnection::adjustBatchLimit(int64_t syncLatency)
+{
+    // The shortest round trip seen recently approximates the network
+    // latency. It drifts up slowly so that the baseline follows changes of
+    // the route to the server.
+    if (minSyncLatency_ == 0 || syncLatency < minSyncLatency_)
+    {
+        minSyncLatency_ = syncLatency;
+    }
+    else
+    {
+        minSyncLatency_ += (syncLatency - minSyncLatency_) / 64;
+    }
+    if (syncLatency <= 2 * minSyncLatency_)
+    {
+        // The server keeps up with the pipeline, more commands in flight
+        // save round trips.
+        batchLimit_ = (std::min)(batchLimit_ + batchLimit_ / 4, maxBatchLimit);
+    }
+    else
+    {
+        // Commands are queueing on the server, fewer commands in flight
+        // keep them in the client queue, where they can still go to other
+        // connections, and return results sooner.
+        batchLimit_ = (std::max)(batchLimit_ / 2, minBatchLimit);
+    }
+}
+
+void PgConnection::deliverStreamRows()
+{
+    auto header = streamRows_.front();
+    Result rows(std::make_shared<PostgreSQLStreamResultImpl>(
+        std::move(streamRows_), header));
+    streamRows_.clear();
+    // Stop reading the socket, the server blocks when the buffers are full.
+    streamPaused_ = true;
+    channel_.disableReading();
+    std::weak_ptr<PgConnection> weakPtr = shared_from_this();
+    auto loop = loop_;
+    streamCallback_(rows, [weakPtr, loop](bool more) {
+        loop->queueInLoop([weakPtr, more]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->resumeStream(more);
+        });
+    });
+}
+
+void PgConnection::finishStream(const std::shared_ptr<PGresult> &res)
+{
+    if (!streamCallback_)
+        return;
+    auto callback = std::move(streamCallback_);
+    streamCallback_ = nullptr;
+    std::shared_ptr<ResultImpl> lastRows;
+    if (!streamRows_.empty())
+    {
+        auto header = streamRows_.front();
+        lastRows = std::make_shared<PostgreSQLStreamResultImpl>(
+            std::move(streamRows_), header);
+        streamRows_.clear();
+    }
+    else if (PQntuples(res.get()) > 0)
+    {
+        // The single-row mode could not be enabled for the query.
+        lastRows = std::make_shared<PostgreSQLResultImpl>(res);
+    }
+    Result end(std::make_shared<PostgreSQLStreamResultImpl>(
+        std::vector<std::shared_ptr<PGresult>>(), res));
+    if (!lastRows)
+    {
+        callback(end, [](bool) {});
+        return;
+    }
+    auto loop = loop_;
+    callback(Result(lastRows), [loop, callback, end](bool more) {
+        if (more)
+        {
+            loop->queueInLoop(
+                [callback, end]() { callback(end, [](bool) {}); });
+        }
+    });
+}
+
+void PgConnection::resumeStream(bool more)
+{
+    loop_->assertInLoopThread();
+    if (!streamPaused_)
+        return;
+    streamPaused_ = false;
+    if (!more)
+    {
+        // The remaining rows are read and dropped.
+        streamCallback_ = nullptr;
+    }
+    if (status_ != ConnectStatus::Ok)
+        return;
+    channel_.enableReading();
+    // Results may have been buffered by libpq before the stream was paused.
+    handleRead();
+}
+
 void PgConnection::handleFatalError(bool clearAll)
 {
     LOG_ERROR << PQerrorMessage(connectionPtr_.get());
@@ -458,6 +688,8 @@ void PgConnection::handleFatalError(bool clearAll)
         std::make_exception_ptr(Failure(PQerrorMessage(connectionPtr_.get())));
     if (clearAll)
     {
+        streamCallback_ = nullptr;
+        streamRows_.clear();
         for (auto &cmd : batchCommandsForWaitingResults_)
         {
             cmd->exceptionCallback_(exceptPtr);
@@ -468,21 +700,39 @@ void PgConnection::handleFatalError(bool clearAll)
         }
         batchCommandsForWaitingResults_.clear();
         batchSqlCommands_.clear();
+        pipelineSyncs_.clear();
     }
     else
     {
         if (!batchSqlCommands_.empty() &&
             !batchSqlCommands_.front()->preparingStatement_.empty())
         {
+            if (batchSqlCommands_.front()->isStreaming_)
+            {
+                streamCallback_ = nullptr;
+            }
             batchSqlCommands_.front()->exceptionCallback_(exceptPtr);
             batchSqlCommands_.pop_front();
         }
         else if (!batchCommandsForWaitingResults_.empty())
         {
             auto &cmd = batchCommandsForWaitingResults_.front();
+            if (cmd->isStreaming_ && !cmd->isFailed_)
+            {
+                streamCallback_ = nullptr;
+                streamRows_.clear();
+            }
             if (!cmd->preparingStatement_.empty())
             {
+                // The execution of the statement is aborted by this error,
+                // report it now and drop the aborted result later.
                 cmd->preparingStatement_.clear();
+                cmd->isFailed_ = true;
+                cmd->exceptionCallback_(exceptPtr);
+            }
+            else if (cmd->isFailed_)
+            {
+                batchCommandsForWaitingResults_.pop_front();
             }
             else
             {
@@ -500,6 +750,18 @@ void PgConnection::handleFatalError(bool clearAll)
 void PgConnection::batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands)
 {
     loop_->assertInLoopThread();
-    batchSqlCommands_ = std::move(sqlCommands);
-    sendBatchedSql();
+    if (batchSqlCommands_.empty())
+    {
+        batchSqlCommands_ = std::move(sqlCommands);
+    }
+    else
+    {
+        batchSqlCommands_.insert(batchSqlCommands_.end(),
+                                 std::make_move_iterator(sqlCommands.begin()),
+                                 std::make_move_iterator(sqlCommands.end()));
+    }
+    if (!channel_.isWriting())
+    {
+        sendBatchedSql();
+    }
 }
@@ -118,6 +118,12 @@ void PgConnection::handleClosed()
     status_ = ConnectStatus::Bad;
     channel_.disableAll();
     channel_.remove();
+    if (streamCallback_)
+    {
+        // The consumer of the stream may wait for a batch that never comes.
+        isWorking_ = false;
+        handleFatalError();
+    }
     assert(closeCallback_);
     auto thisPtr = shared_from_this();
     closeCallback_(thisPtr);
@@ -222,6 +228,8 @@ void PgConnection::execSqlInLoop(
             }
             return;
         }
+        if (streamBatchSize_ > 0)
+            PQsetSingleRowMode(connectionPtr_.get());
         flush();
     }
     else
@@ -250,6 +258,8 @@ void PgConnection::execSqlInLoop(
                 }
                 return;
             }
+            if (streamBatchSize_ > 0)
+                PQsetSingleRowMode(connectionPtr_.get());
         }
         else
         {
@@ -299,6 +309,11 @@ void PgConnection::handleRead()
         handleClosed();
         return;
     }
+    if (streamBatchSize_ > 0 && !isRreparingStatement_)
+    {
+        handleStreamRead();
+        return;
+    }
     if (PQisBusy(connectionPtr_.get()))
     {
         // need read more data from socket;
@@ -371,17 +386,174 @@ void PgConnection::doAfterPreparing()
         }
         return;
     }
+    if (streamBatchSize_ > 0)
+        PQsetSingleRowMode(connectionPtr_.get());
     flush();
 }
 
+void PgConnection::deliverStreamRows()
+{
+    auto header = streamRows_.front();
+    Result rows(std::make_shared<PostgreSQLStreamResultImpl>(
+        std::move(streamRows_), header));
+    streamRows_.clear();
+    // Stop reading the socket, the server blocks when the buffers are full.
+    streamPaused_ = true;
+    channel_.disableReading();
+    std::weak_ptr<PgConnection> weakPtr = shared_from_this();
+    auto loop = loop_;
+    streamCallback_(rows, [weakPtr, loop](bool more) {
+        loop->queueInLoop([weakPtr, more]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->resumeStream(more);
+        });
+    });
+}
+
+void PgConnection::finishStream(const std::shared_ptr<PGresult> &res)
+{
+    if (!streamCallback_)
+        return;
+    auto callback = std::move(streamCallback_);
+    streamCallback_ = nullptr;
+    std::shared_ptr<ResultImpl> lastRows;
+    if (!streamRows_.empty())
+    {
+        auto header = streamRows_.front();
+        lastRows = std::make_shared<PostgreSQLStreamResultImpl>(
+            std::move(streamRows_), header);
+        streamRows_.clear();
+    }
+    else if (PQntuples(res.get()) > 0)
+    {
+        // The single-row mode could not be enabled for the query.
+        lastRows = std::make_shared<PostgreSQLResultImpl>(res);
+    }
+    Result end(std::make_shared<PostgreSQLStreamResultImpl>(
+        std::vector<std::shared_ptr<PGresult>>(), res));
+    if (!lastRows)
+    {
+        callback(end, [](bool) {});
+        return;
+    }
+    auto loop = loop_;
+    callback(Result(lastRows), [loop, callback, end](bool more) {
+        if (more)
+        {
+            loop->queueInLoop(
+                [callback, end]() { callback(end, [](bool) {}); });
+        }
+    });
+}
+
+void PgConnection::resumeStream(bool more)
+{
+    loop_->assertInLoopThread();
+    if (!streamPaused_)
+        return;
+    streamPaused_ = false;
+    if (!more)
+    {
+        // The remaining rows are read and dropped.
+        streamCallback_ = nullptr;
+    }
+    if (status_ != ConnectStatus::Ok)
+        return;
+    channel_.enableReading();
+    // Results may have been buffered by libpq before the stream was paused.
+    handleRead();
+}
+
 void PgConnection::handleFatalError()
 {
+    streamCallback_ = nullptr;
+    streamRows_.clear();
+    streamBatchSize_ = 0;
     auto exceptPtr =
         std::make_exception_ptr(Failure(PQerrorMessage(connectionPtr_.get())));
     exceptionCallback_(exceptPtr);
     exceptionCallback_ = nullptr;
 }
 
+void PgConnection::execSqlStream(
+    string_view &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    loop_->runInLoop([thisPtr = shared_from_this(),
+                      sql = std::move(sql),
+                      paraNum,
+                      parameters = std::move(parameters),
+                      length = std::move(length),
+                      format = std::move(format),
+                      batchSize,
+                      scb = std::move(scb),
+                      exceptCallback = std::move(exceptCallback)]() mutable {
+        thisPtr->streamCallback_ = std::move(scb);
+        thisPtr->streamBatchSize_ = batchSize;
+        thisPtr->execSqlInLoop(std::move(sql),
+                               paraNum,
+                               std::move(parameters),
+                               std::move(length),
+                               std::move(format),
+                               [](const Result &) {},
+                               std::move(exceptCallback));
+    });
+}
+
+void PgConnection::handleStreamRead()
+{
+    // Every row is a result in the single-row mode, so check if a result is
+    // available before getting it to avoid blocking on the socket.
+    while (!streamPaused_ && !PQisBusy(connectionPtr_.get()))
+    {
+        auto res = std::shared_ptr<PGresult>(PQgetResult(connectionPtr_.get()),
+                                             [](PGresult *p) { PQclear(p); });
+        if (!res)
+        {
+            streamBatchSize_ = 0;
+            streamCallback_ = nullptr;
+            callback_ = nullptr;
+            exceptionCallback_ = nullptr;
+            isWorking_ = false;
+            idleCb_();
+            return;
+        }
+        auto type = PQresultStatus(res.get());
+        if (type == PGRES_SINGLE_TUPLE)
+        {
+            if (!streamCallback_)
+            {
+                // The stream is cancelled, drop the remaining rows.
+                continue;
+            }
+            streamRows_.push_back(std::move(res));
+            if (streamRows_.size() >= streamBatchSize_)
+            {
+                deliverStreamRows();
+            }
+        }
+        else if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR)
+        {
+            LOG_WARN << PQerrorMessage(connectionPtr_.get());
+            if (streamCallback_)
+            {
+                handleFatalError();
+            }
+        }
+        else
+        {
+            finishStream(res);
+        }
+    }
+}
+
 void PgConnection::batchSql(std::deque<std::shared_ptr<SqlCmd>> &&)
 {
     assert(false);
@@ -82,6 +82,16 @@ class PgConnection : public DbConnection,
         }
     }
 
+    void execSqlStream(string_view &&sql,
+                       size_t paraNum,
+                       std::vector<const char *> &&parameters,
+                       std::vector<int> &&length,
+                       std::vector<int> &&format,
+                       size_t batchSize,
+                       StreamCallback &&scb,
+                       std::function<void(const std::exception_ptr &)>
+                           &&exceptCallback) override;
+
     virtual void batchSql(
         std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands) override;
 
@@ -119,19 +129,35 @@ class PgConnection : public DbConnection,
     void handleFatalError();
     std::set<std::string> preparedStatements_;
     string_view sql_;
+    // The state of a streamed query, its rows are read in the single-row
+    // mode of libpq.
+    StreamCallback streamCallback_;
+    size_t streamBatchSize_{0};
+    std::vector<std::shared_ptr<PGresult>> streamRows_;
+    bool streamPaused_{false};
+    void deliverStreamRows();
+    void finishStream(const std::shared_ptr<PGresult> &res);
+    void resumeStream(bool more);
 #if LIBPQ_SUPPORTS_BATCH_MODE
     void handleFatalError(bool clearAll);
+    void handleAbortedCommand();
+    void handlePipelineSync();
+    void setSingleRowMode();
+    void adjustBatchLimit(int64_t syncLatency);
     std::list<std::shared_ptr<SqlCmd>> batchCommandsForWaitingResults_;
     std::deque<std::shared_ptr<SqlCmd>> batchSqlCommands_;
     void sendBatchedSql();
-    int sendBatchEnd();
-    bool sendBatchEnd_{false};
-    unsigned int batchCount_{0};
-    std::unordered_map<string_view, std::pair<std::string, bool>>
-        preparedStatementsMap_;
+    int sendPipelineSync();
+    bool sendPipelineSync_{false};
+    // The maximum number of commands in flight, adapted to the observed
+    // round-trip time of the sync points.
+    size_t batchLimit_{256};
+    int64_t minSyncLatency_{0};
+    std::deque<trantor::Date> pipelineSyncs_;
 #else
-    std::unordered_map<string_view, std::string> preparedStatementsMap_;
+    void handleStreamRead();
 #endif
+    std::unordered_map<string_view, std::string> preparedStatementsMap_;
 };
 
 }  // namespace orm
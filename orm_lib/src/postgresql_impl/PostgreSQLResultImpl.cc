@@ -85,3 +85,60 @@ int PostgreSQLResultImpl::oid(RowSizeType column) const
 {
     return PQftype(result_.get(), (int)column);
 }
+
+Result::SizeType PostgreSQLStreamResultImpl::size() const noexcept
+{
+    return rows_.size();
+}
+
+Result::RowSizeType PostgreSQLStreamResultImpl::columns() const noexcept
+{
+    return Result::RowSizeType(PQnfields(header_.get()));
+}
+
+const char *PostgreSQLStreamResultImpl::columnName(RowSizeType number) const
+{
+    auto N = PQfname(header_.get(), int(number));
+    assert(N);
+    return N;
+}
+
+Result::SizeType PostgreSQLStreamResultImpl::affectedRows() const noexcept
+{
+    char *str = PQcmdTuples(header_.get());
+    if (str == nullptr || str[0] == '\0')
+        return 0;
+    return atol(str);
+}
+
+Result::RowSizeType PostgreSQLStreamResultImpl::columnNumber(
+    const char colName[]) const
+{
+    auto N = PQfnumber(header_.get(), colName);
+    if (N == -1)
+        throw RangeError(std::string("there is no column named ") + colName);
+    return N;
+}
+
+const char *PostgreSQLStreamResultImpl::getValue(SizeType row,
+                                                 RowSizeType column) const
+{
+    return PQgetvalue(rows_[row].get(), 0, int(column));
+}
+
+bool PostgreSQLStreamResultImpl::isNull(SizeType row, RowSizeType column) const
+{
+    return PQgetisnull(rows_[row].get(), 0, int(column)) != 0;
+}
+
+Result::FieldSizeType PostgreSQLStreamResultImpl::getLength(
+    SizeType row,
+    RowSizeType column) const
+{
+    return PQgetlength(rows_[row].get(), 0, int(column));
+}
+
+int PostgreSQLStreamResultImpl::oid(RowSizeType column) const
+{
+    return PQftype(header_.get(), (int)column);
+}
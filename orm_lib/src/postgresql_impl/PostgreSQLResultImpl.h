@@ -19,6 +19,7 @@
 #include <libpq-fe.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace drogon
 {
@@ -47,5 +48,36 @@ class PostgreSQLResultImpl : public ResultImpl
     std::shared_ptr<PGresult> result_;
 };
 
+/// A batch of rows of a streamed query, each row is a result of the
+/// single-row mode.
+class PostgreSQLStreamResultImpl : public ResultImpl
+{
+  public:
+    /**
+     * @param header The result describing the columns, it's the first row or
+     * the final result of the query.
+     */
+    PostgreSQLStreamResultImpl(std::vector<std::shared_ptr<PGresult>> &&rows,
+                               const std::shared_ptr<PGresult> &header)
+        : rows_(std::move(rows)), header_(header)
+    {
+    }
+    virtual SizeType size() const noexcept override;
+    virtual RowSizeType columns() const noexcept override;
+    virtual const char *columnName(RowSizeType number) const override;
+    virtual SizeType affectedRows() const noexcept override;
+    virtual RowSizeType columnNumber(const char colName[]) const override;
+    virtual const char *getValue(SizeType row,
+                                 RowSizeType column) const override;
+    virtual bool isNull(SizeType row, RowSizeType column) const override;
+    virtual FieldSizeType getLength(SizeType row,
+                                    RowSizeType column) const override;
+    virtual int oid(RowSizeType column) const override;
+
+  private:
+    std::vector<std::shared_ptr<PGresult>> rows_;
+    std::shared_ptr<PGresult> header_;
+};
+
 }  // namespace orm
 }  // namespace drogon
@@ -111,18 +111,17 @@ void Sqlite3Connection::execSql(
         });
 }
 
-void Sqlite3Connection::execSqlInQueue(
+std::shared_ptr<sqlite3_stmt> Sqlite3Connection::prepareStatement(
     const string_view &sql,
     size_t paraNum,
     const std::vector<const char *> &parameters,
     const std::vector<int> &length,
     const std::vector<int> &format,
-    const ResultCallback &rcb,
-    const std::function<void(const std::exception_ptr &)> &exceptCallback)
+    const std::function<void(const std::exception_ptr &)> &exceptCallback,
+    bool &newStmt)
 {
     LOG_TRACE << "sql:" << sql;
     std::shared_ptr<sqlite3_stmt> stmtPtr;
-    bool newStmt = false;
     if (paraNum > 0)
     {
         auto iter = stmtsMap_.find(sql);
@@ -147,7 +146,7 @@ void Sqlite3Connection::execSqlInQueue(
         {
             onError(sql, exceptCallback);
             idleCb_();
-            return;
+            return nullptr;
         }
         if (!std::all_of(remaining, sql.data() + sql.size(), [](char ch) {
                 return std::isspace(ch);
@@ -158,7 +157,7 @@ void Sqlite3Connection::execSqlInQueue(
                 std::string{sql}));
             exceptCallback(exceptPtr);
             idleCb_();
-            return;
+            return nullptr;
         }
     }
     assert(stmtPtr);
@@ -207,20 +206,31 @@ void Sqlite3Connection::execSqlInQueue(
             onError(sql, exceptCallback);
             sqlite3_reset(stmt);
             idleCb_();
-            return;
+            return nullptr;
         }
     }
+    return stmtPtr;
+}
+
+void Sqlite3Connection::execSqlInQueue(
+    const string_view &sql,
+    size_t paraNum,
+    const std::vector<const char *> &parameters,
+    const std::vector<int> &length,
+    const std::vector<int> &format,
+    const ResultCallback &rcb,
+    const std::function<void(const std::exception_ptr &)> &exceptCallback)
+{
+    bool newStmt = false;
+    auto stmtPtr = prepareStatement(
+        sql, paraNum, parameters, length, format, exceptCallback, newStmt);
+    if (!stmtPtr)
+        return;
+    auto stmt = stmtPtr.get();
     int r;
     int columnNum = sqlite3_column_count(stmt);
     auto resultPtr = std::make_shared<Sqlite3ResultImpl>();
-    for (int i = 0; i < columnNum; ++i)
-    {
-        auto name = std::string(sqlite3_column_name(stmt, i));
-        std::transform(name.begin(), name.end(), name.begin(), tolower);
-        LOG_TRACE << "column name:" << name;
-        resultPtr->columnNames_.push_back(name);
-        resultPtr->columnNamesMap_.insert({name, i});
-    }
+    setColumnNames(stmt, *resultPtr);
 
     if (sqlite3_stmt_readonly(stmt))
     {
@@ -259,10 +269,157 @@ void Sqlite3Connection::execSqlInQueue(
     idleCb_();
 }
 
+void Sqlite3Connection::setColumnNames(sqlite3_stmt *stmt,
+                                       Sqlite3ResultImpl &result)
+{
+    int columnNum = sqlite3_column_count(stmt);
+    for (int i = 0; i < columnNum; ++i)
+    {
+        auto name = std::string(sqlite3_column_name(stmt, i));
+        std::transform(name.begin(), name.end(), name.begin(), tolower);
+        LOG_TRACE << "column name:" << name;
+        result.columnNames_.push_back(name);
+        result.columnNamesMap_.insert({name, i});
+    }
+}
+
+void Sqlite3Connection::execSqlStream(
+    string_view &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    size_t batchSize,
+    StreamCallback &&scb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    auto thisPtr = shared_from_this();
+    loopThread_.getLoop()->queueInLoop(
+        [thisPtr,
+         sql = std::move(sql),
+         paraNum,
+         parameters = std::move(parameters),
+         length = std::move(length),
+         format = std::move(format),
+         batchSize,
+         scb = std::move(scb),
+         exceptCallback = std::move(exceptCallback)]() mutable {
+            bool newStmt = false;
+            auto stmtPtr = thisPtr->prepareStatement(sql,
+                                                     paraNum,
+                                                     parameters,
+                                                     length,
+                                                     format,
+                                                     exceptCallback,
+                                                     newStmt);
+            if (!stmtPtr)
+                return;
+            if (paraNum > 0 && newStmt)
+            {
+                auto r = thisPtr->stmts_.insert(std::string{sql});
+                thisPtr->stmtsMap_[string_view{r.first->data(),
+                                               r.first->length()}] = stmtPtr;
+            }
+            thisPtr->stepStream(
+                sql, stmtPtr, batchSize, scb, exceptCallback);
+        });
+}
+
+void Sqlite3Connection::stepStream(
+    const string_view &sql,
+    const std::shared_ptr<sqlite3_stmt> &stmtPtr,
+    size_t batchSize,
+    const StreamCallback &scb,
+    const std::function<void(const std::exception_ptr &)> &exceptCallback)
+{
+    auto stmt = stmtPtr.get();
+    auto resultPtr = std::make_shared<Sqlite3ResultImpl>();
+    setColumnNames(stmt, *resultPtr);
+    int columnNum = static_cast<int>(resultPtr->columnNames_.size());
+    int r;
+    bool readonly = sqlite3_stmt_readonly(stmt) != 0;
+    // The lock is held for one batch at a time, so that a slow consumer
+    // doesn't block other connections.
+    if (readonly)
+    {
+        std::shared_lock<SharedMutex> lock(*sharedMutexPtr_);
+        r = stmtStep(stmt, resultPtr, columnNum, batchSize);
+    }
+    else
+    {
+        std::unique_lock<SharedMutex> lock(*sharedMutexPtr_);
+        r = stmtStep(stmt, resultPtr, columnNum, batchSize);
+    }
+    if (r != SQLITE_ROW && r != SQLITE_DONE)
+    {
+        onError(sql, exceptCallback);
+        sqlite3_reset(stmt);
+        idleCb_();
+        return;
+    }
+    if (r == SQLITE_DONE)
+    {
+        auto endPtr = std::make_shared<Sqlite3ResultImpl>();
+        setColumnNames(stmt, *endPtr);
+        if (!readonly)
+        {
+            endPtr->affectedRows_ = sqlite3_changes(connectionPtr_.get());
+            endPtr->insertId_ = sqlite3_last_insert_rowid(connectionPtr_.get());
+        }
+        sqlite3_reset(stmt);
+        Result end(endPtr);
+        if (resultPtr->result_.empty())
+        {
+            scb(end, [](bool) {});
+        }
+        else
+        {
+            auto loop = loopThread_.getLoop();
+            scb(Result(resultPtr), [loop, scb, end](bool more) {
+                if (more)
+                {
+                    loop->queueInLoop(
+                        [scb, end]() { scb(end, [](bool) {}); });
+                }
+            });
+        }
+        idleCb_();
+        return;
+    }
+    // The batch is full, the next one is stepped when the consumer resumes
+    // the stream.
+    std::weak_ptr<Sqlite3Connection> weakPtr = shared_from_this();
+    auto loop = loopThread_.getLoop();
+    scb(Result(resultPtr),
+        [weakPtr, loop, sql, stmtPtr, batchSize, scb, exceptCallback](
+            bool more) {
+            loop->queueInLoop([weakPtr,
+                               more,
+                               sql,
+                               stmtPtr,
+                               batchSize,
+                               scb,
+                               exceptCallback]() {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr)
+                    return;
+                if (!more)
+                {
+                    sqlite3_reset(stmtPtr.get());
+                    thisPtr->idleCb_();
+                    return;
+                }
+                thisPtr->stepStream(
+                    sql, stmtPtr, batchSize, scb, exceptCallback);
+            });
+        });
+}
+
 int Sqlite3Connection::stmtStep(
     sqlite3_stmt *stmt,
     const std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
-    int columnNum)
+    int columnNum,
+    size_t maxRows)
 {
     int r;
     while ((r = sqlite3_step(stmt)) == SQLITE_ROW)
@@ -300,6 +457,8 @@ int Sqlite3Connection::stmtStep(
             }
         }
         resultPtr->result_.push_back(std::move(row));
+        if (resultPtr->result_.size() == maxRows)
+            break;
     }
     return r;
 }
@@ -51,6 +51,15 @@ class Sqlite3Connection : public DbConnection,
                  ResultCallback &&rcb,
                  std::function<void(const std::exception_ptr &)>
                      &&exceptCallback) override;
+    void execSqlStream(string_view &&sql,
+                       size_t paraNum,
+                       std::vector<const char *> &&parameters,
+                       std::vector<int> &&length,
+                       std::vector<int> &&format,
+                       size_t batchSize,
+                       StreamCallback &&scb,
+                       std::function<void(const std::exception_ptr &)>
+                           &&exceptCallback) override;
     void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&) override
     {
         LOG_FATAL << "The mysql library does not support batch mode";
@@ -69,12 +78,31 @@ class Sqlite3Connection : public DbConnection,
         const std::vector<int> &format,
         const ResultCallback &rcb,
         const std::function<void(const std::exception_ptr &)> &exceptCallback);
+    // Return nullptr and make the connection idle if the statement can't be
+    // prepared or bound.
+    std::shared_ptr<sqlite3_stmt> prepareStatement(
+        const string_view &sql,
+        size_t paraNum,
+        const std::vector<const char *> &parameters,
+        const std::vector<int> &length,
+        const std::vector<int> &format,
+        const std::function<void(const std::exception_ptr &)> &exceptCallback,
+        bool &newStmt);
+    void stepStream(
+        const string_view &sql,
+        const std::shared_ptr<sqlite3_stmt> &stmtPtr,
+        size_t batchSize,
+        const StreamCallback &scb,
+        const std::function<void(const std::exception_ptr &)> &exceptCallback);
     void onError(
         const string_view &sql,
         const std::function<void(const std::exception_ptr &)> &exceptCallback);
+    void setColumnNames(sqlite3_stmt *stmt, Sqlite3ResultImpl &result);
+    // Step at most maxRows rows if it's not zero.
     int stmtStep(sqlite3_stmt *stmt,
                  const std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
-                 int columnNum);
+                 int columnNum,
+                 size_t maxRows = 0);
     trantor::EventLoopThread loopThread_;
     std::shared_ptr<sqlite3> connectionPtr_;
     std::shared_ptr<SharedMutex> sharedMutexPtr_;
@@ -583,6 +583,17 @@ DROGON_TEST(PostgreTest)
     {
         auto user = mapper.findByPrimaryKey(2);
         SUCCESS();
+        // The typed JSON is the same as the one built by toJson().
+        std::string typedJson;
+        drogon::writeJson(user, typedJson);
+        std::string treeJson;
+        drogon::internal::getDefaultJsonCodec().writeValue(user.toJson(),
+                                                           treeJson);
+        MANDATE(typedJson == treeJson);
+        Users parsedUser;
+        std::string errs;
+        MANDATE(drogon::readJson(typedJson, parsedUser, errs));
+        MANDATE(parsedUser.toJson() == user.toJson());
         Users newUser;
         newUser.setId(user.getValueOfId());
         newUser.setSalt("xxx");
@@ -594,6 +605,66 @@ DROGON_TEST(PostgreTest)
         FAULT("postgresql - ORM mapper synchronous interface(0) what():" +
               std::string(e.base().what()));
     }
+    /// 6.5 replicated client, the replica is the same server here
+    try
+    {
+        auto replicatedClient = DbClient::newReplicatedClient(
+            clientPtr,
+            {DbClient::newPgClient(clientPtr->connectionInfo(), 1)},
+            10.0);
+        Mapper<Users> replicatedMapper(replicatedClient);
+        auto count = replicatedMapper.count();
+        Users newUser;
+        newUser.setUserId("replica");
+        newUser.setUserName("replica");
+        replicatedMapper.insert(newUser);
+        MANDATE(replicatedMapper.count() == count + 1);
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("postgresql - replicated client what():" +
+              std::string(e.base().what()));
+    }
+    /// 6.6 batch insertion
+    try
+    {
+        std::vector<Users> users(3);
+        for (size_t i = 0; i < users.size(); ++i)
+        {
+            users[i].setUserId("batch" + std::to_string(i));
+            users[i].setUserName("batch");
+            users[i].setOrgName("batch");
+        }
+        MANDATE(mapper.insertBatch(users) == 3UL);
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("postgresql - ORM mapper batch insertion what():" +
+              std::string(e.base().what()));
+    }
+    /// 6.7 streamed query
+    {
+        auto rowCount = std::make_shared<size_t>(0);
+        clientPtr->execSqlStream(
+            "select * from users where user_id like $1",
+            2,
+            [TEST_CTX, rowCount](const Result &r,
+                                 std::function<void(bool)> &&resume) {
+                if (r.size() == 0)
+                {
+                    MANDATE(*rowCount == 3UL);
+                    return;
+                }
+                MANDATE(r.size() <= 2UL);
+                *rowCount += r.size();
+                resume(true);
+            },
+            [TEST_CTX](const DrogonDbException &e) {
+                FAULT("postgresql - DbClient stream interface what():" +
+                      std::string(e.base().what()));
+            },
+            "batch%");
+    }
 #ifdef __cpp_impl_coroutine
     auto coro_test = [clientPtr, TEST_CTX]() -> drogon::Task<> {
         /// 7 Test coroutines.
@@ -672,6 +743,24 @@ DROGON_TEST(PostgreTest)
                 "what():" +
                 std::string(e.base().what()));
         }
+        /// 7.5 Streamed query
+        try
+        {
+            auto stream = clientPtr->execSqlStreamCoro(
+                "select * from users where user_id like $1", 2, "batch%");
+            size_t rowCount = 0;
+            for (auto rows = co_await stream.next(); rows.size() != 0;
+                 rows = co_await stream.next())
+            {
+                rowCount += rows.size();
+            }
+            MANDATE(rowCount == 3UL);
+        }
+        catch (const DrogonDbException &e)
+        {
+            FAULT("postgresql - DbClient coroutine stream interface what():" +
+                  std::string(e.base().what()));
+        }
     };
     drogon::sync_wait(coro_test());
 #endif
@@ -1229,6 +1318,46 @@ DROGON_TEST(MySQLTest)
         FAULT("mysql - ORM mapper synchronous interface(0) what():" +
               std::string(e.base().what()));
     }
+    /// 6.5 batch insertion
+    try
+    {
+        std::vector<Users> users(3);
+        for (size_t i = 0; i < users.size(); ++i)
+        {
+            users[i].setUserId("batch" + std::to_string(i));
+            users[i].setUserName("batch");
+            users[i].setOrgName("batch");
+        }
+        MANDATE(mapper.insertBatch(users) == 3UL);
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("mysql - ORM mapper batch insertion what():" +
+              std::string(e.base().what()));
+    }
+    /// 6.6 streamed query
+    {
+        auto rowCount = std::make_shared<size_t>(0);
+        clientPtr->execSqlStream(
+            "select * from users where user_id like ?",
+            2,
+            [TEST_CTX, rowCount](const Result &r,
+                                 std::function<void(bool)> &&resume) {
+                if (r.size() == 0)
+                {
+                    MANDATE(*rowCount == 3UL);
+                    return;
+                }
+                MANDATE(r.size() <= 2UL);
+                *rowCount += r.size();
+                resume(true);
+            },
+            [TEST_CTX](const DrogonDbException &e) {
+                FAULT("mysql - DbClient stream interface what():" +
+                      std::string(e.base().what()));
+            },
+            "batch%");
+    }
 #ifdef __cpp_impl_coroutine
     auto coro_test = [clientPtr, TEST_CTX]() -> drogon::Task<> {
         /// 7 Test coroutines.
@@ -1700,6 +1829,10 @@ DROGON_TEST(SQLite3Test)
         FAULT("sqlite3 - DbClient future interface(5.2) what():" +
               std::string(e.base().what()));
     }
+    /// 4.7 statistics of the query queue
+    auto queueStats = clientPtr->queueStats();
+    MANDATE(queueStats.dispatchedQueries > 0UL);
+    CHECK(queueStats.rejectedQueries == 0UL);
 
     /// 5 Test Result and Row exception throwing
     // 5.1 query for none and try to access
@@ -1831,12 +1964,63 @@ DROGON_TEST(SQLite3Test)
     {
         auto user = mapper.findByPrimaryKey(1);
         SUCCESS();
+        // The typed JSON is the same as the one built by toJson().
+        std::string typedJson;
+        drogon::writeJson(user, typedJson);
+        std::string treeJson;
+        drogon::internal::getDefaultJsonCodec().writeValue(user.toJson(),
+                                                           treeJson);
+        MANDATE(typedJson == treeJson);
+        Users parsedUser;
+        std::string errs;
+        MANDATE(drogon::readJson(typedJson, parsedUser, errs));
+        MANDATE(parsedUser.toJson() == user.toJson());
     }
     catch (const DrogonDbException &e)
     {
         FAULT("sqlite3 - ORM mapper synchronous interface(0) what():" +
               std::string(e.base().what()));
     }
+    /// 5.5 batch insertion
+    try
+    {
+        std::vector<Users> users(3);
+        for (size_t i = 0; i < users.size(); ++i)
+        {
+            users[i].setUserId("batch" + std::to_string(i));
+            users[i].setUserName("batch");
+            users[i].setOrgName("batch");
+        }
+        MANDATE(mapper.insertBatch(users) == 3UL);
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("sqlite3 - ORM mapper batch insertion what():" +
+              std::string(e.base().what()));
+    }
+    /// 5.6 streamed query
+    {
+        auto rowCount = std::make_shared<size_t>(0);
+        clientPtr->execSqlStream(
+            "select * from users where user_id like ?",
+            2,
+            [TEST_CTX, rowCount](const Result &r,
+                                 std::function<void(bool)> &&resume) {
+                if (r.size() == 0)
+                {
+                    MANDATE(*rowCount == 3UL);
+                    return;
+                }
+                MANDATE(r.size() <= 2UL);
+                *rowCount += r.size();
+                resume(true);
+            },
+            [TEST_CTX](const DrogonDbException &e) {
+                FAULT("sqlite3 - DbClient stream interface what():" +
+                      std::string(e.base().what()));
+            },
+            "batch%");
+    }
 #ifdef __cpp_impl_coroutine
     auto coro_test = [clientPtr, TEST_CTX]() -> drogon::Task<> {
         /// 7 Test coroutines.
@@ -1902,6 +2086,24 @@ DROGON_TEST(SQLite3Test)
             FAULT("sqlite3 - CoroMapper coroutine interface(2) what():" +
                   std::string(e.base().what()));
         }
+        /// 7.4 Streamed query
+        try
+        {
+            auto stream = clientPtr->execSqlStreamCoro(
+                "select * from users where user_id like ?", 2, "batch%");
+            size_t rowCount = 0;
+            for (auto rows = co_await stream.next(); rows.size() != 0;
+                 rows = co_await stream.next())
+            {
+                rowCount += rows.size();
+            }
+            MANDATE(rowCount == 3UL);
+        }
+        catch (const DrogonDbException &e)
+        {
+            FAULT("sqlite3 - DbClient coroutine stream interface what():" +
+                  std::string(e.base().what()));
+        }
         co_await drogon::sleepCoro(
             trantor::EventLoop::getEventLoopOfCurrentThread(), 1.0s);
     };
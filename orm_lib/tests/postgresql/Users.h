@@ -11,6 +11,7 @@
 #include <drogon/orm/Field.h>
 #include <drogon/orm/SqlBinder.h>
 #include <drogon/orm/Mapper.h>
+#include <drogon/JsonTraits.h>
 #ifdef __cpp_impl_coroutine
 #include <drogon/orm/CoroMapper.h>
 #endif
@@ -234,6 +235,7 @@ class Users
     /// Relationship interfaces
   private:
     friend Mapper<Users>;
+    friend struct drogon::JsonFields<Users>;
 #ifdef __cpp_impl_coroutine
     friend CoroMapper<Users>;
 #endif
@@ -402,3 +404,98 @@ class Users
 };
 }  // namespace postgres
 }  // namespace drogon_model
+
+namespace drogon
+{
+/// Write the model straight to JSON text in the same format as toJson()
+template <>
+struct JsonFields<drogon_model::postgres::Users>
+{
+    static auto fields()
+    {
+        using Model = drogon_model::postgres::Users;
+        return std::make_tuple(
+            makeJsonField(
+                "user_id",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.userId_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.userId_ = std::move(value);
+                    obj.dirtyFlag_[0] = true;
+                }),
+            makeJsonField(
+                "user_name",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.userName_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.userName_ = std::move(value);
+                    obj.dirtyFlag_[1] = true;
+                }),
+            makeJsonField(
+                "password",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.password_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.password_ = std::move(value);
+                    obj.dirtyFlag_[2] = true;
+                }),
+            makeJsonField(
+                "org_name",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.orgName_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.orgName_ = std::move(value);
+                    obj.dirtyFlag_[3] = true;
+                }),
+            makeJsonField(
+                "signature",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.signature_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.signature_ = std::move(value);
+                    obj.dirtyFlag_[4] = true;
+                }),
+            makeJsonField(
+                "avatar_id",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.avatarId_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.avatarId_ = std::move(value);
+                    obj.dirtyFlag_[5] = true;
+                }),
+            makeJsonField(
+                "id",
+                [](const Model &obj) -> const std::shared_ptr<int32_t> & {
+                    return obj.id_;
+                },
+                [](Model &obj, std::shared_ptr<int32_t> &&value) {
+                    obj.id_ = std::move(value);
+                    obj.dirtyFlag_[6] = true;
+                }),
+            makeJsonField(
+                "salt",
+                [](const Model &obj) -> const std::shared_ptr<std::string> & {
+                    return obj.salt_;
+                },
+                [](Model &obj, std::shared_ptr<std::string> &&value) {
+                    obj.salt_ = std::move(value);
+                    obj.dirtyFlag_[7] = true;
+                }),
+            makeJsonField(
+                "admin",
+                [](const Model &obj) -> const std::shared_ptr<bool> & {
+                    return obj.admin_;
+                },
+                [](Model &obj, std::shared_ptr<bool> &&value) {
+                    obj.admin_ = std::move(value);
+                    obj.dirtyFlag_[8] = true;
+                }));
+    }
+};
+}  // namespace drogon
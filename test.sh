@@ -189,6 +189,18 @@ if [ "$1" = "-t" ]; then
             exit -1
         fi
     fi
+    if [ -f "./nosql_lib/redis/tests/redis_cluster_test" ] &&
+        [ -x "$(command -v redis-server)" ]; then
+        echo "Test redis cluster"
+        $src_dir/nosql_lib/redis/tests/start_cluster.sh
+        ./nosql_lib/redis/tests/redis_cluster_test -s
+        result=$?
+        $src_dir/nosql_lib/redis/tests/start_cluster.sh stop
+        if [ $result -ne 0 ]; then
+            echo "Error in testing"
+            exit -1
+        fi
+    fi
 fi
 
 echo "Everything is ok!"